@@ -5,10 +5,53 @@ LOCAL_MODULE := glutils
 LOCAL_MODULE_FILENAME := glutils
 LOCAL_SRC_FILES := \
   file.cpp \
+  AsyncLog.cpp \
   GLUtils.cpp \
   Framebuffer.cpp \
+  GpuMemory.cpp \
+  Timing.cpp \
+  Parallel.cpp \
+  TestPattern.cpp \
+  CpuScaler.cpp \
+  ColorSpace.cpp \
+  ImageQuality.cpp \
+  ImageStats.cpp \
+  PixelConvert.cpp \
+  YuvConvert.cpp \
+  AtlasPacker.cpp \
+  Etc1.cpp \
+  ScaleCache.cpp \
+  ImageTransform.cpp \
+  ShaderVariants.cpp \
+  Program.cpp \
+  RenderGraph.cpp \
+  SpriteBatch.cpp \
+  DynamicResolution.cpp \
+  GlTrace.cpp \
+  ImageFile.cpp \
   
-LOCAL_LDLIBS := -llog -landroid -lEGL -lGLESv2
+LOCAL_CFLAGS := -O3 -ftree-vectorize
+ifdef LOG_MIN_LEVEL
+LOCAL_CFLAGS += -DLOG_MIN_LEVEL=$(LOG_MIN_LEVEL)
+endif
+ifdef GPU_MEMORY_BUDGET_MB
+LOCAL_CFLAGS += -DGPU_MEMORY_BUDGET_MB=$(GPU_MEMORY_BUDGET_MB)
+endif
+# ndk-build GLUTILS_TRACE=1 routes the GL calls of glutils and the modules
+# using it through the recorders of GlTrace.h
+ifeq ($(GLUTILS_TRACE),1)
+LOCAL_CFLAGS += -DGLUTILS_TRACE -include $(LOCAL_PATH)/GlTrace.h
+LOCAL_EXPORT_CFLAGS := -DGLUTILS_TRACE -include $(LOCAL_PATH)/GlTrace.h
+endif
+ifeq ($(TARGET_ARCH_ABI),armeabi-v7a)
+LOCAL_ARM_NEON := true
+endif
+# the x86 ABI guarantees SSSE3, which the PixelConvert shuffles use
+ifeq ($(TARGET_ARCH_ABI),x86)
+LOCAL_CFLAGS += -mssse3
+endif
+
+LOCAL_LDLIBS := -llog -landroid -lEGL -lGLESv2 -lz
   
 LOCAL_EXPORT_C_INCLUDES := $(LOCAL_PATH)
 include $(BUILD_STATIC_LIBRARY)
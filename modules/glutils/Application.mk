@@ -1 +1,2 @@
 APP_ABI := armeabi armeabi-v7a x86 
+APP_STL := gnustl_static
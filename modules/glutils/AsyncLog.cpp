@@ -0,0 +1,248 @@
+/*
+ * AsyncLog.cpp
+ *
+ *  Created on: 19-10-2026
+ */
+
+#include "AsyncLog.h"
+#include "Timing.h"
+#include <android/log.h>
+#include <pthread.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include <vector>
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+// Sinks
+
+static const char levelLetters[] = "VDIWE";
+
+static const char* newlineFor(const char* message) {
+	size_t length = strlen(message);
+	return length && message[length - 1] == '\n' ? "" : "\n";
+}
+
+void AndroidLogSink::write(int level,double,const char* message) {
+	// logcat stamps the line itself
+	static const int priorities[] = { ANDROID_LOG_VERBOSE, ANDROID_LOG_DEBUG, ANDROID_LOG_INFO, ANDROID_LOG_WARN, ANDROID_LOG_ERROR };
+	__android_log_write(priorities[level],"TextureLoader",message);
+}
+
+void StderrLogSink::write(int level,double timeMs,const char* message) {
+	fprintf(stderr,"%.3f %c %s%s",timeMs,levelLetters[level],message,newlineFor(message));
+}
+
+FileLogSink::FileLogSink(const char* path) {
+	file = fopen(path,"a");
+	if(!file)
+		fprintf(stderr,"FileLogSink: cannot open %s\n",path);
+}
+
+FileLogSink::~FileLogSink() {
+	if(file)
+		fclose((FILE*)file);
+}
+
+void FileLogSink::write(int level,double timeMs,const char* message) {
+	if(file)
+		fprintf((FILE*)file,"%.3f %c %s%s",timeMs,levelLetters[level],message,newlineFor(message));
+}
+
+void FileLogSink::flush() {
+	if(file)
+		fflush((FILE*)file);
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+// Rings
+
+struct LogRecord {
+	int level;
+	double time;
+	char text[LOG_MESSAGE_SIZE];
+};
+
+/*
+ * Single producer, single consumer: the owning thread only advances head,
+ * the drain side (always under logMutex) only advances tail.
+ */
+struct LogRing {
+	LogRecord records[LOG_RING_SLOTS];
+	volatile unsigned int head;
+	volatile unsigned int tail;
+	volatile bool orphaned;		// owner exited, freed once drained
+	LogRing* next;
+};
+
+// guards the ring list, the sinks and the tails
+static pthread_mutex_t logMutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_once_t logOnce = PTHREAD_ONCE_INIT;
+static pthread_key_t ringKey;
+static LogRing* rings = NULL;
+static std::vector<LogSink*> sinks;
+static AndroidLogSink defaultSink;
+static volatile bool synchronous = false;
+static volatile bool running = false;
+static pthread_t drainThread;
+static volatile unsigned int dropped = 0;
+static unsigned int reportedDropped = 0;
+
+static void writeToSinks(int level,double time,const char* message) {
+	if(sinks.empty())
+		defaultSink.write(level,time,message);
+	for(unsigned int i=0;i<sinks.size();i++)
+		sinks[i]->write(level,time,message);
+}
+
+// Called with logMutex held
+static void drainRings() {
+	for(LogRing** link = &rings; *link;) {
+		LogRing* ring = *link;
+		bool orphaned = ring->orphaned;
+		unsigned int head = ring->head;
+		__sync_synchronize();
+		for(unsigned int t = ring->tail; t != head; t++) {
+			const LogRecord& record = ring->records[t % LOG_RING_SLOTS];
+			writeToSinks(record.level,record.time,record.text);
+		}
+		__sync_synchronize();
+		ring->tail = head;
+		if(orphaned) {
+			*link = ring->next;
+			delete ring;
+		}
+		else {
+			link = &ring->next;
+		}
+	}
+	unsigned int lost = dropped;
+	if(lost != reportedDropped) {
+		char text[64];
+		snprintf(text,sizeof(text),"log: %u messages dropped, rings full",lost - reportedDropped);
+		writeToSinks(LOG_LEVEL_WARN,nowMs(),text);
+		reportedDropped = lost;
+	}
+}
+
+static void releaseRing(void* ring) {
+	// the last head update is visible before the flag
+	__sync_synchronize();
+	((LogRing*)ring)->orphaned = true;
+}
+
+static void* drainMain(void*) {
+	while(running) {
+		pthread_mutex_lock(&logMutex);
+		drainRings();
+		pthread_mutex_unlock(&logMutex);
+		struct timespec pause = { 0, 10 * 1000000 };
+		nanosleep(&pause,NULL);
+	}
+	return NULL;
+}
+
+static void startLogger() {
+	pthread_key_create(&ringKey,releaseRing);
+	running = true;
+	if(pthread_create(&drainThread,NULL,drainMain,NULL) != 0) {
+		running = false;
+		synchronous = true;
+	}
+}
+
+static LogRing* getRing() {
+	LogRing* ring = (LogRing*)pthread_getspecific(ringKey);
+	if(ring)
+		return ring;
+	ring = new LogRing;
+	ring->head = ring->tail = 0;
+	ring->orphaned = false;
+	pthread_mutex_lock(&logMutex);
+	ring->next = rings;
+	rings = ring;
+	pthread_mutex_unlock(&logMutex);
+	pthread_setspecific(ringKey,ring);
+	return ring;
+}
+
+void logMessage(int level,const char* format,...) {
+	pthread_once(&logOnce,startLogger);
+	double time = nowMs();
+	va_list args;
+	va_start(args,format);
+	if(level >= LOG_LEVEL_ERROR || synchronous) {
+		char text[1024];
+		vsnprintf(text,sizeof(text),format,args);
+		va_end(args);
+		// everything queued before this message goes out first
+		pthread_mutex_lock(&logMutex);
+		drainRings();
+		writeToSinks(level,time,text);
+		pthread_mutex_unlock(&logMutex);
+		return;
+	}
+
+	LogRing* ring = getRing();
+	unsigned int head = ring->head;
+	if(head - ring->tail >= LOG_RING_SLOTS) {
+		va_end(args);
+		__sync_fetch_and_add(&dropped,1);
+		return;
+	}
+	LogRecord& record = ring->records[head % LOG_RING_SLOTS];
+	record.level = level;
+	record.time = time;
+	vsnprintf(record.text,sizeof(record.text),format,args);
+	va_end(args);
+	__sync_synchronize();
+	ring->head = head + 1;
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+
+void logAddSink(LogSink* sink) {
+	pthread_mutex_lock(&logMutex);
+	drainRings();
+	sinks.push_back(sink);
+	pthread_mutex_unlock(&logMutex);
+}
+
+void logClearSinks() {
+	pthread_mutex_lock(&logMutex);
+	drainRings();
+	for(unsigned int i=0;i<sinks.size();i++) {
+		sinks[i]->flush();
+		delete sinks[i];
+	}
+	sinks.clear();
+	pthread_mutex_unlock(&logMutex);
+}
+
+void logSetSynchronous(bool value) {
+	logFlush();
+	synchronous = value;
+}
+
+void logFlush() {
+	pthread_mutex_lock(&logMutex);
+	drainRings();
+	for(unsigned int i=0;i<sinks.size();i++)
+		sinks[i]->flush();
+	pthread_mutex_unlock(&logMutex);
+}
+
+void logShutdown() {
+	if(running) {
+		running = false;
+		pthread_join(drainThread,NULL);
+	}
+	// late messages are written directly
+	synchronous = true;
+	logClearSinks();
+}
+
+unsigned int logGetDropped() {
+	return dropped;
+}
@@ -0,0 +1,81 @@
+/*
+ * AsyncLog.h
+ *
+ *  Created on: 19-10-2026
+ */
+
+#ifndef ASYNCLOG_H_
+#define ASYNCLOG_H_
+
+/*
+ * Logging behind the Log* macros of logger.h. A message is formatted into a
+ * ring buffer owned by the calling thread, without locks or system calls,
+ * and a background thread drains all rings into the sinks. A full ring drops
+ * the message and counts it, so the render thread never waits for logcat.
+ * Errors skip the rings and are written at once, so they survive a crash.
+ */
+
+// Plain numbers, so LOG_MIN_LEVEL can be given on the command line
+#define LOG_LEVEL_VERBOSE 0
+#define LOG_LEVEL_DEBUG 1
+#define LOG_LEVEL_INFO 2
+#define LOG_LEVEL_WARN 3
+#define LOG_LEVEL_ERROR 4
+#define LOG_LEVEL_NONE 5
+
+// Messages longer than this, terminator included, are truncated in the ring
+#define LOG_MESSAGE_SIZE 240
+// Per-thread ring capacity in messages
+#define LOG_RING_SLOTS 256
+
+class LogSink {
+public:
+	virtual ~LogSink() {}
+	// Called from the drain thread, or from the logging thread for errors
+	// and in synchronous mode; never from two threads at once
+	virtual void write(int level,double timeMs,const char* message) = 0;
+	virtual void flush() {}
+};
+
+// __android_log_print with the "TextureLoader" tag; the default sink
+class AndroidLogSink : public LogSink {
+public:
+	void write(int level,double timeMs,const char* message);
+};
+
+class StderrLogSink : public LogSink {
+public:
+	void write(int level,double timeMs,const char* message);
+};
+
+// Appends "<ms> <level> <message>" lines to path
+class FileLogSink : public LogSink {
+public:
+	FileLogSink(const char* path);
+	virtual ~FileLogSink();
+	void write(int level,double timeMs,const char* message);
+	void flush();
+private:
+	void* file;
+};
+
+void logMessage(int level,const char* format,...)
+#ifdef __GNUC__
+	__attribute__((format(printf,2,3)))
+#endif
+	;
+
+// The logger owns added sinks. AndroidLogSink is used while none are added.
+void logAddSink(LogSink* sink);
+void logClearSinks();
+// Writes every message on the calling thread under a lock, like a direct
+// __android_log_print; for comparisons and debugging
+void logSetSynchronous(bool synchronous);
+// Drains every ring into the sinks before returning
+void logFlush();
+// Flushes, stops the drain thread and deletes the sinks
+void logShutdown();
+// Messages lost to full rings so far
+unsigned int logGetDropped();
+
+#endif /* ASYNCLOG_H_ */
@@ -0,0 +1,116 @@
+/*
+ * AtlasPacker.cpp
+ *
+ *  Created on: 19-10-2026
+ */
+
+#include "AtlasPacker.h"
+
+AtlasPacker::AtlasPacker(GLuint w,GLuint h):width(w),height(h) {
+	reset();
+}
+
+AtlasPacker::~AtlasPacker() {
+}
+
+void AtlasPacker::reset() {
+	skyline.clear();
+	SkylineNode node = { 0, 0, width };
+	skyline.push_back(node);
+	usedHeight = 0;
+	usedArea = 0;
+}
+
+bool AtlasPacker::fits(unsigned int index,GLuint w,GLuint h,GLuint* y) {
+	GLuint x = skyline[index].x;
+	if(x + w > width)
+		return false;
+	// the rectangle rests on the highest node it spans
+	GLuint top = 0;
+	GLuint remaining = w;
+	for(unsigned int i=index;remaining > 0;i++) {
+		if(i >= skyline.size())
+			return false;
+		if(skyline[i].y > top)
+			top = skyline[i].y;
+		if(top + h > height)
+			return false;
+		remaining = skyline[i].width >= remaining ? 0 : remaining - skyline[i].width;
+	}
+	*y = top;
+	return true;
+}
+
+bool AtlasPacker::insert(GLuint w,GLuint h,AtlasRect* rect) {
+	if(w == 0 || h == 0)
+		return false;
+
+	int best = -1;
+	GLuint bestTop = ~0u, bestWidth = ~0u, bestY = 0;
+	for(unsigned int i=0;i<skyline.size();i++) {
+		GLuint y;
+		if(!fits(i,w,h,&y))
+			continue;
+		if(y + h < bestTop || (y + h == bestTop && skyline[i].width < bestWidth)) {
+			best = i;
+			bestTop = y + h;
+			bestWidth = skyline[i].width;
+			bestY = y;
+		}
+	}
+	if(best < 0)
+		return false;
+
+	rect->x = skyline[best].x;
+	rect->y = bestY;
+	rect->width = w;
+	rect->height = h;
+	addNode(best,*rect);
+
+	if(bestTop > usedHeight)
+		usedHeight = bestTop;
+	usedArea += (unsigned long long)w * h;
+	return true;
+}
+
+void AtlasPacker::addNode(unsigned int index,const AtlasRect& rect) {
+	SkylineNode node = { rect.x, rect.y + rect.height, rect.width };
+	skyline.insert(skyline.begin() + index,node);
+
+	// trim the nodes now covered by the new one
+	for(unsigned int i=index+1;i<skyline.size();) {
+		SkylineNode& prev = skyline[i-1];
+		SkylineNode& cur = skyline[i];
+		if(cur.x >= prev.x + prev.width)
+			break;
+		GLuint shrink = prev.x + prev.width - cur.x;
+		if(cur.width <= shrink) {
+			skyline.erase(skyline.begin() + i);
+			continue;
+		}
+		cur.x += shrink;
+		cur.width -= shrink;
+		break;
+	}
+
+	// merge neighbours at the same height
+	for(unsigned int i=0;i+1<skyline.size();) {
+		if(skyline[i].y == skyline[i+1].y) {
+			skyline[i].width += skyline[i+1].width;
+			skyline.erase(skyline.begin() + i + 1);
+		}
+		else {
+			i++;
+		}
+	}
+}
+
+GLuint AtlasPacker::getUsedHeight() {
+	return usedHeight;
+}
+
+float AtlasPacker::getOccupancy() {
+	if(usedHeight == 0)
+		return 0.0f;
+	return (float)usedArea / ((float)usedHeight * width);
+}
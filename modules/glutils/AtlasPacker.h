@@ -0,0 +1,54 @@
+/*
+ * AtlasPacker.h
+ *
+ *  Created on: 19-10-2026
+ */
+
+#ifndef ATLASPACKER_H_
+#define ATLASPACKER_H_
+
+#include <GLES2/gl2.h>
+#include <vector>
+
+typedef struct
+{
+	GLuint x;
+	GLuint y;
+	GLuint width;
+	GLuint height;
+} AtlasRect;
+
+/*
+ * Skyline bottom-left rectangle packer. Each rectangle goes where its top
+ * edge ends up lowest, ties broken by the narrowest wasted gap.
+ */
+class AtlasPacker {
+public:
+	AtlasPacker(GLuint width,GLuint height);
+	virtual ~AtlasPacker();
+
+	void reset();
+	// Returns false when the rectangle does not fit anywhere
+	bool insert(GLuint width,GLuint height,AtlasRect* rect);
+	// Rows from 0 that contain at least one rectangle
+	GLuint getUsedHeight();
+	// Packed area divided by getUsedHeight() * width
+	float getOccupancy();
+private:
+	typedef struct
+	{
+		GLuint x;
+		GLuint y;
+		GLuint width;
+	} SkylineNode;
+
+	bool fits(unsigned int index,GLuint width,GLuint height,GLuint* y);
+	void addNode(unsigned int index,const AtlasRect& rect);
+
+	GLuint width,height;
+	std::vector<SkylineNode> skyline;
+	GLuint usedHeight;
+	unsigned long long usedArea;
+};
+
+#endif /* ATLASPACKER_H_ */
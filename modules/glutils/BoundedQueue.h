@@ -0,0 +1,85 @@
+/*
+ * BoundedQueue.h
+ *
+ *  Created on: 19-10-2026
+ */
+
+#ifndef BOUNDEDQUEUE_H_
+#define BOUNDEDQUEUE_H_
+
+#include <pthread.h>
+#include <deque>
+
+/*
+ * Blocking FIFO between pipeline stages. push waits while the queue holds
+ * capacity items, pop waits while it is empty. After close, push refuses new
+ * items and pop drains what is left, then returns false.
+ */
+template <typename T>
+class BoundedQueue {
+public:
+	BoundedQueue(unsigned int capacity):capacity(capacity ? capacity : 1),closed(false),pushWaits(0),popWaits(0) {
+		pthread_mutex_init(&mutex,NULL);
+		pthread_cond_init(&notFull,NULL);
+		pthread_cond_init(&notEmpty,NULL);
+	}
+
+	~BoundedQueue() {
+		pthread_cond_destroy(&notEmpty);
+		pthread_cond_destroy(&notFull);
+		pthread_mutex_destroy(&mutex);
+	}
+
+	bool push(const T& item) {
+		pthread_mutex_lock(&mutex);
+		if(!closed && items.size() >= capacity)
+			pushWaits++;
+		while(!closed && items.size() >= capacity)
+			pthread_cond_wait(&notFull,&mutex);
+		bool accepted = !closed;
+		if(accepted) {
+			items.push_back(item);
+			pthread_cond_signal(&notEmpty);
+		}
+		pthread_mutex_unlock(&mutex);
+		return accepted;
+	}
+
+	bool pop(T* item) {
+		pthread_mutex_lock(&mutex);
+		if(!closed && items.empty())
+			popWaits++;
+		while(!closed && items.empty())
+			pthread_cond_wait(&notEmpty,&mutex);
+		bool popped = !items.empty();
+		if(popped) {
+			*item = items.front();
+			items.pop_front();
+			pthread_cond_signal(&notFull);
+		}
+		pthread_mutex_unlock(&mutex);
+		return popped;
+	}
+
+	void close() {
+		pthread_mutex_lock(&mutex);
+		closed = true;
+		pthread_cond_broadcast(&notFull);
+		pthread_cond_broadcast(&notEmpty);
+		pthread_mutex_unlock(&mutex);
+	}
+
+	// Times push found the queue full and pop found it empty
+	unsigned int getPushWaits() { return pushWaits; }
+	unsigned int getPopWaits() { return popWaits; }
+private:
+	pthread_mutex_t mutex;
+	pthread_cond_t notFull;
+	pthread_cond_t notEmpty;
+	std::deque<T> items;
+	unsigned int capacity;
+	bool closed;
+	unsigned int pushWaits,popWaits;
+};
+
+#endif /* BOUNDEDQUEUE_H_ */
@@ -0,0 +1,268 @@
+/*
+ * ColorSpace.cpp
+ *
+ *  Created on: 19-10-2026
+ */
+
+#include "ColorSpace.h"
+#include <math.h>
+#include <pthread.h>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#elif defined(__ARM_NEON__) || defined(__ARM_NEON)
+#include <arm_neon.h>
+#define COLOR_NEON
+#endif
+
+const char* getColorModeName(int mode) {
+	switch(mode) {
+		case COLOR_MODE_DIRECT: return "direct";
+		case COLOR_MODE_LINEAR: return "linear";
+		case COLOR_MODE_PREMULTIPLIED: return "premultiplied";
+		case COLOR_MODE_LINEAR | COLOR_MODE_PREMULTIPLIED: return "linear+premultiplied";
+		default: return "unknown";
+	}
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+// Tables
+
+static GLushort srgbDecode[256];
+static GLubyte srgbEncode[4097];
+// 255 / a in 16.16 fixed point for unpremultiplyAlpha
+static GLuint alphaReciprocal[256];
+static pthread_once_t tablesOnce = PTHREAD_ONCE_INIT;
+
+static void buildTables() {
+	for(int i=0;i<256;i++) {
+		double c = i / 255.0;
+		double linear = c <= 0.04045 ? c / 12.92 : pow((c + 0.055) / 1.055, 2.4);
+		srgbDecode[i] = (GLushort)(linear * 65535.0 + 0.5);
+		alphaReciprocal[i] = i ? (255u * 65536u + i / 2) / i : 0;
+	}
+	for(int i=0;i<=4096;i++) {
+		double linear = i / 4096.0;
+		double c = linear <= 0.0031308 ? linear * 12.92 : 1.055 * pow(linear, 1.0 / 2.4) - 0.055;
+		srgbEncode[i] = (GLubyte)(c * 255.0 + 0.5);
+	}
+}
+
+const GLushort* getSrgbDecodeTable() {
+	pthread_once(&tablesOnce,buildTables);
+	return srgbDecode;
+}
+
+const GLubyte* getSrgbEncodeTable() {
+	pthread_once(&tablesOnce,buildTables);
+	return srgbEncode;
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+// 16 bit working format
+
+// x * 257, the byte repeated in both halves
+static void widenComponents(const GLubyte* src,GLushort* dst,size_t n) {
+	size_t i = 0;
+#if defined(__SSE2__)
+	for(;i+16<=n;i+=16) {
+		__m128i px = _mm_loadu_si128((const __m128i*)(src + i));
+		_mm_storeu_si128((__m128i*)(dst + i),_mm_unpacklo_epi8(px,px));
+		_mm_storeu_si128((__m128i*)(dst + i + 8),_mm_unpackhi_epi8(px,px));
+	}
+#elif defined(COLOR_NEON)
+	for(;i+16<=n;i+=16) {
+		uint8x16_t px = vld1q_u8(src + i);
+		uint8x16x2_t both = vzipq_u8(px,px);
+		vst1q_u16(dst + i,vreinterpretq_u16_u8(both.val[0]));
+		vst1q_u16(dst + i + 8,vreinterpretq_u16_u8(both.val[1]));
+	}
+#endif
+	for(;i<n;i++)
+		dst[i] = src[i] * 257;
+}
+
+// (x + 128) / 257 rounded down, as x - (x + 128) / 256 + 128 >> 8 so that
+// nothing leaves 16 bits
+static void narrowComponents(const GLushort* src,GLubyte* dst,size_t n) {
+	size_t i = 0;
+#if defined(__SSE2__)
+	const __m128i round = _mm_set1_epi16(64);
+	const __m128i half = _mm_set1_epi16(128);
+	for(;i+16<=n;i+=16) {
+		__m128i v[2] = { _mm_loadu_si128((const __m128i*)(src + i)), _mm_loadu_si128((const __m128i*)(src + i + 8)) };
+		for(int h=0;h<2;h++) {
+			__m128i q = _mm_srli_epi16(_mm_add_epi16(_mm_srli_epi16(v[h],1),round),7);
+			v[h] = _mm_srli_epi16(_mm_add_epi16(_mm_sub_epi16(v[h],q),half),8);
+		}
+		_mm_storeu_si128((__m128i*)(dst + i),_mm_packus_epi16(v[0],v[1]));
+	}
+#elif defined(COLOR_NEON)
+	const uint16x8_t round = vdupq_n_u16(64);
+	const uint16x8_t half = vdupq_n_u16(128);
+	for(;i+8<=n;i+=8) {
+		uint16x8_t v = vld1q_u16(src + i);
+		uint16x8_t q = vshrq_n_u16(vaddq_u16(vshrq_n_u16(v,1),round),7);
+		vst1_u8(dst + i,vmovn_u16(vshrq_n_u16(vaddq_u16(vsubq_u16(v,q),half),8)));
+	}
+#endif
+	for(;i<n;i++)
+		dst[i] = (src[i] + 128) / 257;
+}
+
+// c * a / 65535 rounded on RGBA, alpha kept
+static void premultiplyComponents(GLushort* rgba,size_t count) {
+	size_t i = 0;
+#if defined(__SSE2__)
+	// the alpha lane is multiplied by 65535, which keeps it; the 32 bit
+	// results are biased into signed range to pack back without saturating
+	const __m128i colorMask = _mm_set_epi16(0,-1,-1,-1,0,-1,-1,-1);
+	const __m128i alphaOne = _mm_set_epi16(-1,0,0,0,-1,0,0,0);
+	const __m128i round = _mm_set1_epi32(32768);
+	const __m128i bias = _mm_set1_epi16(-32768);
+	for(;i+2<=count;i+=2) {
+		__m128i c = _mm_loadu_si128((const __m128i*)(rgba + i*4));
+		__m128i a = _mm_shufflehi_epi16(_mm_shufflelo_epi16(c,_MM_SHUFFLE(3,3,3,3)),_MM_SHUFFLE(3,3,3,3));
+		a = _mm_or_si128(_mm_and_si128(a,colorMask),alphaOne);
+		__m128i lo = _mm_mullo_epi16(c,a), hi = _mm_mulhi_epu16(c,a);
+		__m128i x[2] = { _mm_unpacklo_epi16(lo,hi), _mm_unpackhi_epi16(lo,hi) };
+		for(int h=0;h<2;h++) {
+			x[h] = _mm_srli_epi32(_mm_add_epi32(_mm_add_epi32(x[h],_mm_srli_epi32(x[h],16)),round),16);
+			x[h] = _mm_sub_epi32(x[h],round);
+		}
+		_mm_storeu_si128((__m128i*)(rgba + i*4),_mm_xor_si128(_mm_packs_epi32(x[0],x[1]),bias));
+	}
+#elif defined(COLOR_NEON)
+	for(;i+8<=count;i+=8) {
+		uint16x8x4_t px = vld4q_u16(rgba + i*4);
+		for(int k=0;k<3;k++) {
+			uint32x4_t lo = vmull_u16(vget_low_u16(px.val[k]),vget_low_u16(px.val[3]));
+			uint32x4_t hi = vmull_u16(vget_high_u16(px.val[k]),vget_high_u16(px.val[3]));
+			px.val[k] = vcombine_u16(vraddhn_u32(lo,vshrq_n_u32(lo,16)),vraddhn_u32(hi,vshrq_n_u32(hi,16)));
+		}
+		vst4q_u16(rgba + i*4,px);
+	}
+#endif
+	for(;i<count;i++) {
+		GLushort* p = rgba + i*4;
+		GLuint a = p[3];
+		for(GLuint k=0;k<3;k++) {
+			GLuint x = p[k] * a;
+			p[k] = (x + (x >> 16) + 32768) >> 16;
+		}
+	}
+}
+
+/*
+ * The sRGB paths read a table per color component, which SSE2 and ARMv7
+ * NEON cannot gather from (vtbl reaches 32 bytes), and narrowing
+ * premultiplied pixels divides by alpha per pixel, which ARMv7 NEON has no
+ * exact instruction for; those loops stay scalar. Everything else goes
+ * through the kernels above.
+ */
+void expandPixels(const GLubyte* src,GLushort* dst,size_t count,GLuint channels,int mode) {
+	const size_t n = count * channels;
+	if(!(mode & COLOR_MODE_LINEAR))
+		widenComponents(src,dst,n);
+	else {
+		const GLushort* decode = getSrgbDecodeTable();
+		// luminance-alpha and RGBA keep alpha in the last channel
+		const bool alpha = channels == 2 || channels == 4;
+		const GLuint colors = alpha ? channels - 1 : channels;
+		for(size_t i=0;i<n;i+=channels) {
+			for(GLuint k=0;k<colors;k++)
+				dst[i+k] = decode[src[i+k]];
+			if(alpha)
+				dst[i+colors] = src[i+colors] * 257;
+		}
+	}
+	if((mode & COLOR_MODE_PREMULTIPLIED) && channels == 4)
+		premultiplyComponents(dst,count);
+}
+
+void narrowPixels(const GLushort* src,GLubyte* dst,size_t count,GLuint channels,int mode) {
+	const size_t n = count * channels;
+	const bool premultiplied = (mode & COLOR_MODE_PREMULTIPLIED) && channels == 4;
+	const bool alpha = channels == 2 || channels == 4;
+	const GLubyte* encode = (mode & COLOR_MODE_LINEAR) ? getSrgbEncodeTable() : NULL;
+	const GLuint colors = alpha ? channels - 1 : channels;
+	if(!premultiplied) {
+		if(!encode) {
+			narrowComponents(src,dst,n);
+			return;
+		}
+		for(size_t i=0;i<n;i+=channels) {
+			for(GLuint k=0;k<colors;k++)
+				dst[i+k] = encode[(src[i+k] + 8) >> 4];
+			if(alpha)
+				dst[i+colors] = (src[i+colors] + 128) / 257;
+		}
+		return;
+	}
+	for(size_t i=0;i<n;i+=channels) {
+		float scale = src[i+3] ? 65535.0f / src[i+3] : 0.0f;
+		for(GLuint k=0;k<colors;k++) {
+			float c = src[i+k] * scale + 0.5f;
+			GLuint v = c < 65535.0f ? (GLuint)c : 65535;
+			dst[i+k] = encode ? encode[(v + 8) >> 4] : (v + 128) / 257;
+		}
+		dst[i+3] = (src[i+3] + 128) / 257;
+	}
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+// Premultiplied alpha
+
+static inline GLubyte multiplyByAlpha(GLuint c,GLuint a) {
+	GLuint t = c * a + 128;
+	return (t + (t >> 8)) >> 8;
+}
+
+void premultiplyAlpha(GLubyte* rgba,size_t count) {
+	size_t i = 0;
+#if defined(__SSE2__)
+	const __m128i zero = _mm_setzero_si128();
+	const __m128i round = _mm_set1_epi16(128);
+	// multiply color lanes by alpha and the alpha lane by 255, which keeps it
+	const __m128i colorMask = _mm_set_epi16(0,-1,-1,-1,0,-1,-1,-1);
+	const __m128i alphaOne = _mm_set_epi16(255,0,0,0,255,0,0,0);
+	for(;i+4<=count;i+=4) {
+		__m128i px = _mm_loadu_si128((const __m128i*)(rgba + i*4));
+		__m128i half[2] = { _mm_unpacklo_epi8(px,zero), _mm_unpackhi_epi8(px,zero) };
+		for(int h=0;h<2;h++) {
+			__m128i a = _mm_shufflehi_epi16(_mm_shufflelo_epi16(half[h],_MM_SHUFFLE(3,3,3,3)),_MM_SHUFFLE(3,3,3,3));
+			a = _mm_or_si128(_mm_and_si128(a,colorMask),alphaOne);
+			__m128i t = _mm_add_epi16(_mm_mullo_epi16(half[h],a),round);
+			half[h] = _mm_srli_epi16(_mm_add_epi16(t,_mm_srli_epi16(t,8)),8);
+		}
+		_mm_storeu_si128((__m128i*)(rgba + i*4),_mm_packus_epi16(half[0],half[1]));
+	}
+#elif defined(COLOR_NEON)
+	for(;i+8<=count;i+=8) {
+		uint8x8x4_t px = vld4_u8(rgba + i*4);
+		for(int k=0;k<3;k++) {
+			uint16x8_t t = vmull_u8(px.val[k],px.val[3]);
+			px.val[k] = vraddhn_u16(t,vrshrq_n_u16(t,8));
+		}
+		vst4_u8(rgba + i*4,px);
+	}
+#endif
+	for(;i<count;i++) {
+		GLubyte* p = rgba + i*4;
+		p[0] = multiplyByAlpha(p[0],p[3]);
+		p[1] = multiplyByAlpha(p[1],p[3]);
+		p[2] = multiplyByAlpha(p[2],p[3]);
+	}
+}
+
+void unpremultiplyAlpha(GLubyte* rgba,size_t count) {
+	pthread_once(&tablesOnce,buildTables);
+	for(size_t i=0;i<count;i++) {
+		GLubyte* p = rgba + i*4;
+		GLuint r = alphaReciprocal[p[3]];
+		for(int k=0;k<3;k++) {
+			GLuint c = (p[k] * r + 32768) >> 16;
+			p[k] = c > 255 ? 255 : c;
+		}
+	}
+}
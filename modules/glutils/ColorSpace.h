@@ -0,0 +1,58 @@
+/*
+ * ColorSpace.h
+ *
+ *  Created on: 19-10-2026
+ */
+
+#ifndef COLORSPACE_H_
+#define COLORSPACE_H_
+
+#include <GLES2/gl2.h>
+#include <stddef.h>
+
+/*
+ * How color is filtered while scaling; the flags combine. COLOR_MODE_DIRECT
+ * filters the stored 8 bit values, which darkens edges between bright and
+ * dark areas and lets the color of fully transparent pixels bleed into
+ * their neighbours.
+ */
+enum ColorMode {
+	COLOR_MODE_DIRECT = 0,
+	COLOR_MODE_LINEAR = 1,			// decode sRGB, filter in linear light, encode
+	COLOR_MODE_PREMULTIPLIED = 2	// weight color by alpha while filtering
+};
+
+// Flag names joined by '+', "direct" for COLOR_MODE_DIRECT
+const char* getColorModeName(int mode);
+
+/*
+ * sRGB transfer function tables. Linear light is stored in 16 bits; the
+ * encode table is indexed by linear >> 4 and has 4097 entries so that the
+ * rounded index needs no clamping.
+ */
+const GLushort* getSrgbDecodeTable();
+const GLubyte* getSrgbEncodeTable();
+
+static inline GLubyte encodeSrgb(GLushort linear) {
+	return getSrgbEncodeTable()[(linear + 8) >> 4];
+}
+
+/*
+ * Widen count pixels of 8 bit components to 16 bits and back. With
+ * COLOR_MODE_LINEAR the color channels go through the sRGB tables and alpha
+ * is scaled linearly; with COLOR_MODE_PREMULTIPLIED and 4 channels the color
+ * is multiplied by alpha after decoding and divided by it before encoding.
+ * The table lookups are scalar, the rest uses SSE2 or NEON when available.
+ */
+void expandPixels(const GLubyte* src,GLushort* dst,size_t count,GLuint channels,int mode);
+void narrowPixels(const GLushort* src,GLubyte* dst,size_t count,GLuint channels,int mode);
+
+/*
+ * In-place conversion of RGBA pixels between straight and premultiplied
+ * alpha, in the stored (usually sRGB) encoding. Both round to nearest;
+ * premultiplyAlpha uses SSE2 or NEON when available.
+ */
+void premultiplyAlpha(GLubyte* rgba,size_t count);
+void unpremultiplyAlpha(GLubyte* rgba,size_t count);
+
+#endif /* COLORSPACE_H_ */
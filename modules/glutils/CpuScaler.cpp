@@ -0,0 +1,401 @@
+/*
+ * CpuScaler.cpp
+ *
+ *  Created on: 19-10-2026
+ */
+
+#include "CpuScaler.h"
+#include "Parallel.h"
+#include "logger.h"
+#include <math.h>
+#include <algorithm>
+#include <vector>
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+// Bilinear
+
+struct BilinearTap {
+	GLuint i0,i1;
+	GLuint w1;	// weight of i1 in 1/256, weight of i0 is 256 - w1
+};
+
+static void buildBilinearTaps(GLuint srcSize,GLuint dstSize,BilinearTap* taps) {
+	double step = (double)srcSize / dstSize;
+	for(GLuint i=0;i<dstSize;i++) {
+		double pos = (i + 0.5) * step - 0.5;
+		if(pos < 0.0)
+			pos = 0.0;
+		GLuint i0 = (GLuint)pos;
+		if(i0 > srcSize - 1)
+			i0 = srcSize - 1;
+		taps[i].i0 = i0;
+		taps[i].i1 = i0 + 1 < srcSize ? i0 + 1 : i0;
+		taps[i].w1 = (GLuint)((pos - i0) * 256.0 + 0.5);
+		if(taps[i].w1 > 256)
+			taps[i].w1 = 256;
+	}
+}
+
+// T is GLubyte or GLushort; 16 bit samples still fit the 32 bit accumulators
+template <typename T>
+struct BilinearContext {
+	const T* src;
+	GLuint srcWidth;
+	T* dst;
+	GLuint dstWidth;
+	GLuint channels;
+	const BilinearTap* xTaps;
+	const BilinearTap* yTaps;
+};
+
+template <typename T>
+static void bilinearRows(int begin,int end,void* arg) {
+	const BilinearContext<T>* ctx = (const BilinearContext<T>*)arg;
+	const GLuint c = ctx->channels;
+	const GLuint srcStride = ctx->srcWidth * c;
+	// horizontally filtered rows in 8.8 fixed point
+	std::vector<GLuint> row0(ctx->dstWidth * c),row1(ctx->dstWidth * c);
+
+	for(int y=begin;y<end;y++) {
+		const BilinearTap& ty = ctx->yTaps[y];
+		const T* s0 = ctx->src + ty.i0 * srcStride;
+		const T* s1 = ctx->src + ty.i1 * srcStride;
+		for(GLuint x=0;x<ctx->dstWidth;x++) {
+			const BilinearTap& tx = ctx->xTaps[x];
+			GLuint a = tx.i0 * c, b = tx.i1 * c;
+			for(GLuint k=0;k<c;k++) {
+				row0[x*c+k] = s0[a+k] * (256 - tx.w1) + s0[b+k] * tx.w1;
+				row1[x*c+k] = s1[a+k] * (256 - tx.w1) + s1[b+k] * tx.w1;
+			}
+		}
+		T* d = ctx->dst + (size_t)y * ctx->dstWidth * c;
+		GLuint w0 = 256 - ty.w1, w1 = ty.w1;
+		for(GLuint i=0;i<ctx->dstWidth*c;i++)
+			d[i] = (row0[i] * w0 + row1[i] * w1 + 32768) >> 16;
+	}
+}
+
+void scaleImageBilinear(const GLubyte* src,GLuint srcWidth,GLuint srcHeight,
+		GLubyte* dst,GLuint dstWidth,GLuint dstHeight,GLuint channels) {
+	if(!srcWidth || !srcHeight || !dstWidth || !dstHeight)
+		return;
+	std::vector<BilinearTap> xTaps(dstWidth),yTaps(dstHeight);
+	buildBilinearTaps(srcWidth,dstWidth,&xTaps[0]);
+	buildBilinearTaps(srcHeight,dstHeight,&yTaps[0]);
+
+	BilinearContext<GLubyte> ctx = { src, srcWidth, dst, dstWidth, channels, &xTaps[0], &yTaps[0] };
+	parallelFor(0,dstHeight,bilinearRows<GLubyte>,&ctx,16);
+}
+
+struct ColorConvertContext {
+	const GLubyte* bytes;
+	GLushort* words;
+	GLubyte* out;
+	GLuint width;
+	GLuint channels;
+	int mode;
+};
+
+static void expandRows(int begin,int end,void* arg) {
+	const ColorConvertContext* ctx = (const ColorConvertContext*)arg;
+	size_t offset = (size_t)begin * ctx->width * ctx->channels;
+	expandPixels(ctx->bytes + offset,ctx->words + offset,(size_t)(end - begin) * ctx->width,ctx->channels,ctx->mode);
+}
+
+static void narrowRows(int begin,int end,void* arg) {
+	const ColorConvertContext* ctx = (const ColorConvertContext*)arg;
+	size_t offset = (size_t)begin * ctx->width * ctx->channels;
+	narrowPixels(ctx->words + offset,ctx->out + offset,(size_t)(end - begin) * ctx->width,ctx->channels,ctx->mode);
+}
+
+void scaleImageBilinearColor(const GLubyte* src,GLuint srcWidth,GLuint srcHeight,
+		GLubyte* dst,GLuint dstWidth,GLuint dstHeight,GLuint channels,int mode) {
+	if(mode == COLOR_MODE_DIRECT) {
+		scaleImageBilinear(src,srcWidth,srcHeight,dst,dstWidth,dstHeight,channels);
+		return;
+	}
+	if(!srcWidth || !srcHeight || !dstWidth || !dstHeight)
+		return;
+	std::vector<GLushort> wideSrc((size_t)srcWidth * srcHeight * channels);
+	std::vector<GLushort> wideDst((size_t)dstWidth * dstHeight * channels);
+	ColorConvertContext expand = { src, &wideSrc[0], NULL, srcWidth, channels, mode };
+	parallelFor(0,srcHeight,expandRows,&expand,16);
+
+	std::vector<BilinearTap> xTaps(dstWidth),yTaps(dstHeight);
+	buildBilinearTaps(srcWidth,dstWidth,&xTaps[0]);
+	buildBilinearTaps(srcHeight,dstHeight,&yTaps[0]);
+	BilinearContext<GLushort> ctx = { &wideSrc[0], srcWidth, &wideDst[0], dstWidth, channels, &xTaps[0], &yTaps[0] };
+	parallelFor(0,dstHeight,bilinearRows<GLushort>,&ctx,16);
+
+	ColorConvertContext narrow = { NULL, &wideDst[0], dst, dstWidth, channels, mode };
+	parallelFor(0,dstHeight,narrowRows,&narrow,16);
+}
+
+void scaleYuvImageBilinear(const YuvFrame& frame,GLubyte* dst,GLuint dstWidth,GLuint dstHeight,GLuint channels,
+		YuvColorSpace colorSpace,YuvRange range) {
+	std::vector<GLubyte> rgb((size_t)frame.width * frame.height * channels);
+	convertYuvToRgb(frame,&rgb[0],channels,colorSpace,range);
+	scaleImageBilinear(&rgb[0],frame.width,frame.height,dst,dstWidth,dstHeight,channels);
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+// Sharpen and dither
+
+struct PostScaleContext {
+	const GLubyte* src;
+	GLuint srcWidth;
+	GLvoid* dst;
+	GLuint dstWidth,dstHeight;
+	GLuint channels;
+	const BilinearTap* xTaps;
+	const BilinearTap* yTaps;
+	const PostScaleOptions* options;
+};
+
+// The fragmentShader's ditherThreshold for the pixel at (x,y)
+static inline float ditherThreshold(int mode,GLuint x,GLuint y) {
+	if(mode == DITHER_ORDERED) {
+		static const GLubyte bayer[16] = { 0, 8, 2, 10, 12, 4, 14, 6, 3, 11, 1, 9, 15, 7, 13, 5 };
+		return (bayer[(y & 3) * 4 + (x & 3)] + 0.5f) / 16.0f;
+	}
+	float f = 0.06711056f * (x + 0.5f) + 0.00583715f * (y + 0.5f);
+	f = 52.9829189f * (f - floorf(f));
+	return f - floorf(f);
+}
+
+// value is 8.8 fixed point, levels the largest output code
+static inline GLuint quantize(GLuint value,GLuint levels,float threshold) {
+	GLuint q = (GLuint)(value * (levels / 65280.0f) + threshold);
+	return q > levels ? levels : q;
+}
+
+// Output row y, bilinear filtered in 8.8 fixed point
+static void filterRow(const PostScaleContext* ctx,GLuint y,GLuint* row) {
+	const GLuint c = ctx->channels;
+	const GLuint srcStride = ctx->srcWidth * c;
+	const BilinearTap& ty = ctx->yTaps[y];
+	const GLubyte* s0 = ctx->src + ty.i0 * srcStride;
+	const GLubyte* s1 = ctx->src + ty.i1 * srcStride;
+	const GLuint w0 = 256 - ty.w1, w1 = ty.w1;
+	for(GLuint x=0;x<ctx->dstWidth;x++) {
+		const BilinearTap& tx = ctx->xTaps[x];
+		GLuint a = tx.i0 * c, b = tx.i1 * c;
+		for(GLuint k=0;k<c;k++) {
+			GLuint r0 = s0[a+k] * (256 - tx.w1) + s0[b+k] * tx.w1;
+			GLuint r1 = s1[a+k] * (256 - tx.w1) + s1[b+k] * tx.w1;
+			row[x*c+k] = (r0 * w0 + r1 * w1 + 128) >> 8;
+		}
+	}
+}
+
+static void postScaleRows(int begin,int end,void* arg) {
+	const PostScaleContext* ctx = (const PostScaleContext*)arg;
+	const PostScaleOptions& options = *ctx->options;
+	const GLuint c = ctx->channels;
+	const GLuint width = ctx->dstWidth;
+	const GLuint rowSize = width * c;
+	const bool sharpen = options.sharpen != 0.0f;
+	const int amount = (int)floorf(options.sharpen * 256.0f + 0.5f);
+	// filtered rows y-1, y and y+1, row r in slot r % 3
+	std::vector<GLuint> rows(rowSize * 3);
+	std::vector<GLuint> sharpened(sharpen ? rowSize : 0);
+	int filtered = -1;
+
+	for(int y=begin;y<end;y++) {
+		int above = sharpen ? std::max(y - 1,0) : y;
+		int below = sharpen ? std::min(y + 1,(int)ctx->dstHeight - 1) : y;
+		for(int r=std::max(filtered + 1,above);r<=below;r++)
+			filterRow(ctx,r,&rows[(r % 3) * rowSize]);
+		filtered = below;
+
+		const GLuint* value = &rows[(y % 3) * rowSize];
+		if(sharpen) {
+			const GLuint* up = &rows[(above % 3) * rowSize];
+			const GLuint* down = &rows[(below % 3) * rowSize];
+			for(GLuint x=0;x<width;x++) {
+				GLuint left = (x > 0 ? x - 1 : 0) * c, right = (x + 1 < width ? x + 1 : x) * c;
+				for(GLuint k=0;k<c;k++) {
+					int center = value[x*c+k];
+					int sum = value[left+k] + value[right+k] + up[x*c+k] + down[x*c+k];
+					// center + amount * (center - sum / 4), amount in 1/256
+					int v = center + (4 * center - sum) * amount / 1024;
+					sharpened[x*c+k] = v < 0 ? 0 : (v > 65280 ? 65280 : v);
+				}
+			}
+			value = &sharpened[0];
+		}
+
+		if(options.rgb565) {
+			GLushort* d = (GLushort*)ctx->dst + (size_t)y * width;
+			for(GLuint x=0;x<width;x++,value+=3) {
+				float t = options.dither ? ditherThreshold(options.dither,x,y) : 0.5f;
+				d[x] = (quantize(value[0],31,t) << 11) | (quantize(value[1],63,t) << 5) | quantize(value[2],31,t);
+			}
+		}
+		else if(options.dither) {
+			GLubyte* d = (GLubyte*)ctx->dst + (size_t)y * rowSize;
+			for(GLuint x=0;x<width;x++) {
+				float t = ditherThreshold(options.dither,x,y);
+				for(GLuint k=0;k<c;k++)
+					d[x*c+k] = quantize(value[x*c+k],255,t);
+			}
+		}
+		else {
+			GLubyte* d = (GLubyte*)ctx->dst + (size_t)y * rowSize;
+			for(GLuint i=0;i<rowSize;i++)
+				d[i] = (value[i] + 128) >> 8;
+		}
+	}
+}
+
+void scaleImageBilinearPost(const GLubyte* src,GLuint srcWidth,GLuint srcHeight,
+		GLvoid* dst,GLuint dstWidth,GLuint dstHeight,GLuint channels,const PostScaleOptions& options) {
+	if(!srcWidth || !srcHeight || !dstWidth || !dstHeight)
+		return;
+	if(options.rgb565 && channels != 3) {
+		LogError("scaleImageBilinearPost: 5_6_5 output needs 3 channels, not %u",channels);
+		return;
+	}
+	std::vector<BilinearTap> xTaps(dstWidth),yTaps(dstHeight);
+	buildBilinearTaps(srcWidth,dstWidth,&xTaps[0]);
+	buildBilinearTaps(srcHeight,dstHeight,&yTaps[0]);
+
+	PostScaleContext ctx = { src, srcWidth, dst, dstWidth, dstHeight, channels, &xTaps[0], &yTaps[0], &options };
+	parallelFor(0,dstHeight,postScaleRows,&ctx,16);
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+// Affine
+
+struct TransformContext {
+	const GLubyte* src;
+	GLuint srcWidth,srcHeight;
+	GLubyte* dst;
+	GLuint dstWidth,dstHeight;
+	GLuint channels;
+	const float* m;
+};
+
+// Texel position of a normalized coordinate, clamped like buildBilinearTaps
+static inline void bilinearTap(double pos,GLuint size,GLuint* i0,GLuint* i1,GLuint* w1) {
+	if(pos < 0.0)
+		pos = 0.0;
+	if(pos > size - 1)
+		pos = size - 1;
+	*i0 = (GLuint)pos;
+	*i1 = *i0 + 1 < size ? *i0 + 1 : *i0;
+	*w1 = (GLuint)((pos - *i0) * 256.0 + 0.5);
+}
+
+static void transformRows(int begin,int end,void* arg) {
+	const TransformContext* ctx = (const TransformContext*)arg;
+	const GLuint c = ctx->channels;
+	const GLuint srcStride = ctx->srcWidth * c;
+	const float* m = ctx->m;
+
+	for(int y=begin;y<end;y++) {
+		double t = (y + 0.5) / ctx->dstHeight;
+		GLubyte* d = ctx->dst + (size_t)y * ctx->dstWidth * c;
+		for(GLuint x=0;x<ctx->dstWidth;x++,d+=c) {
+			double s = (x + 0.5) / ctx->dstWidth;
+			double u = m[0] * s + m[4] * t + m[12];
+			double v = m[1] * s + m[5] * t + m[13];
+			GLuint x0,x1,wx,y0,y1,wy;
+			bilinearTap(u * ctx->srcWidth - 0.5,ctx->srcWidth,&x0,&x1,&wx);
+			bilinearTap(v * ctx->srcHeight - 0.5,ctx->srcHeight,&y0,&y1,&wy);
+			const GLubyte* s0 = ctx->src + y0 * srcStride;
+			const GLubyte* s1 = ctx->src + y1 * srcStride;
+			for(GLuint k=0;k<c;k++) {
+				GLuint r0 = s0[x0*c+k] * (256 - wx) + s0[x1*c+k] * wx;
+				GLuint r1 = s1[x0*c+k] * (256 - wx) + s1[x1*c+k] * wx;
+				d[k] = (r0 * (256 - wy) + r1 * wy + 32768) >> 16;
+			}
+		}
+	}
+}
+
+void transformImageBilinear(const GLubyte* src,GLuint srcWidth,GLuint srcHeight,
+		GLubyte* dst,GLuint dstWidth,GLuint dstHeight,GLuint channels,const float* matrix) {
+	if(!srcWidth || !srcHeight || !dstWidth || !dstHeight)
+		return;
+	TransformContext ctx = { src, srcWidth, srcHeight, dst, dstWidth, dstHeight, channels, matrix };
+	parallelFor(0,dstHeight,transformRows,&ctx,16);
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+// Reference
+
+struct AxisWeights {
+	std::vector<GLuint> first;		// first tap of each output sample
+	std::vector<GLuint> count;		// taps per output sample
+	std::vector<GLuint> index;
+	std::vector<double> weight;
+};
+
+static void buildAxisWeights(GLuint srcSize,GLuint dstSize,AxisWeights& axis) {
+	double step = (double)srcSize / dstSize;
+	for(GLuint i=0;i<dstSize;i++) {
+		axis.first.push_back(axis.index.size());
+		if(step > 1.0) {
+			// box filter over the exact footprint [i*step, (i+1)*step)
+			double begin = i * step, end = (i + 1) * step;
+			for(GLuint s=(GLuint)begin;s<srcSize && s<end;s++) {
+				double lo = s > begin ? s : begin;
+				double hi = s + 1 < end ? s + 1 : end;
+				if(hi > lo) {
+					axis.index.push_back(s);
+					axis.weight.push_back((hi - lo) / step);
+				}
+			}
+		}
+		else {
+			double pos = (i + 0.5) * step - 0.5;
+			if(pos < 0.0)
+				pos = 0.0;
+			GLuint i0 = (GLuint)pos;
+			if(i0 > srcSize - 1)
+				i0 = srcSize - 1;
+			GLuint i1 = i0 + 1 < srcSize ? i0 + 1 : i0;
+			double f = pos - i0;
+			axis.index.push_back(i0);
+			axis.weight.push_back(1.0 - f);
+			axis.index.push_back(i1);
+			axis.weight.push_back(f);
+		}
+		axis.count.push_back(axis.index.size() - axis.first.back());
+	}
+}
+
+void scaleImageReference(const GLubyte* src,GLuint srcWidth,GLuint srcHeight,
+		GLubyte* dst,GLuint dstWidth,GLuint dstHeight,GLuint channels) {
+	if(!srcWidth || !srcHeight || !dstWidth || !dstHeight)
+		return;
+	AxisWeights xw,yw;
+	buildAxisWeights(srcWidth,dstWidth,xw);
+	buildAxisWeights(srcHeight,dstHeight,yw);
+
+	const GLuint c = channels;
+	std::vector<double> horizontal((size_t)srcHeight * dstWidth * c);
+	for(GLuint y=0;y<srcHeight;y++) {
+		const GLubyte* s = src + (size_t)y * srcWidth * c;
+		double* h = &horizontal[(size_t)y * dstWidth * c];
+		for(GLuint x=0;x<dstWidth;x++) {
+			for(GLuint k=0;k<c;k++) {
+				double sum = 0.0;
+				for(GLuint t=xw.first[x];t<xw.first[x]+xw.count[x];t++)
+					sum += s[xw.index[t]*c+k] * xw.weight[t];
+				h[x*c+k] = sum;
+			}
+		}
+	}
+	for(GLuint y=0;y<dstHeight;y++) {
+		GLubyte* d = dst + (size_t)y * dstWidth * c;
+		for(GLuint i=0;i<dstWidth*c;i++) {
+			double sum = 0.0;
+			for(GLuint t=yw.first[y];t<yw.first[y]+yw.count[y];t++)
+				sum += horizontal[(size_t)yw.index[t] * dstWidth * c + i] * yw.weight[t];
+			int v = (int)floor(sum + 0.5);
+			d[i] = v < 0 ? 0 : (v > 255 ? 255 : v);
+		}
+	}
+}
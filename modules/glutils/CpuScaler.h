@@ -0,0 +1,84 @@
+/*
+ * CpuScaler.h
+ *
+ *  Created on: 19-10-2026
+ */
+
+#ifndef CPUSCALER_H_
+#define CPUSCALER_H_
+
+#include <GLES2/gl2.h>
+#include "YuvConvert.h"
+#include "ColorSpace.h"
+
+/*
+ * Software scalers for GL_UNSIGNED_BYTE images with 1 to 4 channels and
+ * tightly packed rows. Row 0 is the first row in memory for both source and
+ * destination, matching the data passed to and returned by Scene::scaleTexture.
+ */
+
+/*
+ * Fallback scaler with the same sampling as a GL_LINEAR, GL_CLAMP_TO_EDGE
+ * texture drawn over the whole destination: pixel centers map to
+ * (x + 0.5) * srcWidth / dstWidth - 0.5. Uses 8 bit fixed point weights and
+ * runs across all cores.
+ */
+void scaleImageBilinear(const GLubyte* src,GLuint srcWidth,GLuint srcHeight,
+		GLubyte* dst,GLuint dstWidth,GLuint dstHeight,GLuint channels);
+
+/*
+ * scaleImageBilinear with a ColorMode: the image is widened to 16 bits per
+ * channel through the sRGB and premultiply tables, filtered with the same
+ * taps and narrowed back. COLOR_MODE_DIRECT is scaleImageBilinear.
+ */
+void scaleImageBilinearColor(const GLubyte* src,GLuint srcWidth,GLuint srcHeight,
+		GLubyte* dst,GLuint dstWidth,GLuint dstHeight,GLuint channels,int mode);
+
+enum DitherMode {
+	DITHER_NONE,
+	DITHER_ORDERED,		// 4x4 Bayer matrix
+	DITHER_NOISE		// interleaved gradient noise
+};
+
+typedef struct
+{
+	float sharpen;		// unsharp mask amount against the 4 neighbouring output pixels, 0 for none
+	int dither;			// DitherMode, applied when rounding to the output precision
+	bool rgb565;		// 3 channels only: output is GL_UNSIGNED_SHORT_5_6_5, 2 bytes per pixel
+} PostScaleOptions;
+
+/*
+ * scaleImageBilinear with the SHARPEN and DITHER_* stages of the
+ * fragmentShader fused in: each band of rows keeps the last 3 filtered rows
+ * at 8 extra bits of precision, sharpens and dithers them and writes the
+ * rounded result, so neither stage makes a pass over the output. Matches the
+ * shader except at the borders, where the shader's neighbour taps clamp in
+ * the source and these clamp in the output.
+ */
+void scaleImageBilinearPost(const GLubyte* src,GLuint srcWidth,GLuint srcHeight,
+		GLvoid* dst,GLuint dstWidth,GLuint dstHeight,GLuint channels,const PostScaleOptions& options);
+
+/*
+ * Fallback for Scene::transformTexture: samples the source through an
+ * ImageTransform.h matrix with the same GL_LINEAR, GL_CLAMP_TO_EDGE rules
+ * and 8 bit weights as scaleImageBilinear.
+ */
+void transformImageBilinear(const GLubyte* src,GLuint srcWidth,GLuint srcHeight,
+		GLubyte* dst,GLuint dstWidth,GLuint dstHeight,GLuint channels,const float* matrix);
+
+/*
+ * High precision reference: separable resampling in double precision,
+ * averaging the exact source footprint when shrinking an axis and
+ * interpolating linearly when enlarging it. Slow; meant for quality checks.
+ */
+void scaleImageReference(const GLubyte* src,GLuint srcWidth,GLuint srcHeight,
+		GLubyte* dst,GLuint dstWidth,GLuint dstHeight,GLuint channels);
+
+/*
+ * Fallback for Scene::scaleYuvTexture: converts the frame with
+ * convertYuvToRgb, then scales it with scaleImageBilinear.
+ */
+void scaleYuvImageBilinear(const YuvFrame& frame,GLubyte* dst,GLuint dstWidth,GLuint dstHeight,GLuint channels,
+		YuvColorSpace colorSpace,YuvRange range);
+
+#endif /* CPUSCALER_H_ */
@@ -0,0 +1,151 @@
+/*
+ * DynamicResolution.cpp
+ *
+ *  Created on: 19-10-2026
+ */
+
+#include "DynamicResolution.h"
+#include "GpuMemory.h"
+#include "logger.h"
+#include <math.h>
+#include <algorithm>
+
+// Windows on time before the first probe, and the most a missed probe backs off to
+#define PROBE_WINDOWS 6
+#define MAX_PROBE_WINDOWS (16 * PROBE_WINDOWS)
+// Fraction of the target a scale change aims at, leaving room for noise
+#define TARGET_AIM 0.9
+
+DynamicResolution::DynamicResolution(double t,float minS,float maxS):enabled(true),targetMs(t),
+		minScale(std::min(minS,maxS)),maxScale(maxS),scale(maxS),onTimeWindows(0),probeWindows(PROBE_WINDOWS),probing(false),
+		changes(0),target(NULL),renderWidth(0),renderHeight(0),savedFramebuffer(0) {
+}
+
+DynamicResolution::~DynamicResolution() {
+	releaseGlResources();
+}
+
+void DynamicResolution::setEnabled(bool e) {
+	enabled = e;
+}
+
+bool DynamicResolution::isEnabled() {
+	return enabled;
+}
+
+void DynamicResolution::setTargetMs(double t) {
+	targetMs = t;
+	window.clear();
+	onTimeWindows = 0;
+}
+
+double DynamicResolution::getTargetMs() {
+	return targetMs;
+}
+
+float DynamicResolution::getScale() {
+	return scale;
+}
+
+unsigned int DynamicResolution::getChangeCount() {
+	return changes;
+}
+
+void DynamicResolution::setScale(float s) {
+	s = std::max(minScale,std::min(maxScale,s));
+	if(fabsf(s - scale) < 0.001f)
+		return;
+	LogDebug("DynamicResolution: scale %.3f to %.3f",scale,s);
+	scale = s;
+	changes++;
+}
+
+void DynamicResolution::addFrameTime(double ms) {
+	window.add(ms);
+	if(window.count() < DYNAMIC_RESOLUTION_WINDOW)
+		return;
+	const double p90 = window.percentile(90.0);
+	window.clear();
+	if(p90 > targetMs * 1.1) {
+		// the pixel count goes with the square of the scale
+		setScale(scale * sqrt(targetMs * TARGET_AIM / p90));
+		if(probing)
+			probeWindows = std::min(probeWindows * 2,MAX_PROBE_WINDOWS);
+		probing = false;
+		onTimeWindows = 0;
+	}
+	else if(p90 < targetMs * 0.8) {
+		setScale(scale * std::min(1.1,sqrt(targetMs * TARGET_AIM / p90)));
+		probing = false;
+		onTimeWindows = 0;
+	}
+	else if(probing) {
+		// the probe held
+		probing = false;
+		probeWindows = PROBE_WINDOWS;
+	}
+	else if(++onTimeWindows >= probeWindows && scale < maxScale) {
+		setScale(scale + DYNAMIC_RESOLUTION_STEP * maxScale);
+		probing = true;
+		onTimeWindows = 0;
+	}
+}
+
+bool DynamicResolution::begin(GLuint width,GLuint height) {
+	if(!enabled || !width || !height)
+		return false;
+	// before the target is made: a new Framebuffer leaves framebuffer 0 bound
+	glGetIntegerv(GL_FRAMEBUFFER_BINDING, &savedFramebuffer);
+	glGetIntegerv(GL_VIEWPORT, savedViewport);
+	const GLuint targetWidth = std::max(1.0f,maxScale * width + 0.5f), targetHeight = std::max(1.0f,maxScale * height + 0.5f);
+	if(!target || (GLuint)target->getWidth() != targetWidth || (GLuint)target->getHeight() != targetHeight) {
+		delete target;
+		target = new Framebuffer(targetWidth,targetHeight,0,GL_RGBA,GL_UNSIGNED_BYTE,0,"DynamicResolution");
+		if(!target->getTexture()) {
+			// e.g. over the GPU memory budget
+			LogWarn("DynamicResolution: no %ux%u target, drawing at full size",targetWidth,targetHeight);
+			delete target;
+			target = NULL;
+			glBindFramebuffer(GL_FRAMEBUFFER, savedFramebuffer);
+			return false;
+		}
+	}
+	renderWidth = std::max(1.0f,scale * width + 0.5f);
+	renderHeight = std::max(1.0f,scale * height + 0.5f);
+	target->bind();
+	glViewport(0, 0, renderWidth, renderHeight);
+	return true;
+}
+
+void DynamicResolution::end(Program* program) {
+	if(!target)
+		return;
+	glBindFramebuffer(GL_FRAMEBUFFER, savedFramebuffer);
+	glViewport(savedViewport[0], savedViewport[1], savedViewport[2], savedViewport[3]);
+	if(!program)
+		return;
+	// from the centre of the first rendered texel to that of the last, so
+	// GL_LINEAR never blends in the unused part of the target
+	const GLfloat u0 = 0.5f / target->getWidth(), v0 = 0.5f / target->getHeight();
+	const GLfloat u1 = (renderWidth - 0.5f) / target->getWidth(), v1 = (renderHeight - 0.5f) / target->getHeight();
+	const GLfloat positions[] = { -1.0f, -1.0f, 1.0f, -1.0f, -1.0f, 1.0f, 1.0f, 1.0f };
+	const GLfloat texCoords[] = { u0, v0, u1, v0, u0, v1, u1, v1 };
+	program->setUniform1i("sTexture", 0);
+	program->use();
+	glActiveTexture(GL_TEXTURE0);
+	glBindTexture(GL_TEXTURE_2D, target->getTexture());
+	glEnableVertexAttribArray(ATTRIB_POSITION);
+	glEnableVertexAttribArray(ATTRIB_TEXCOORD);
+	glVertexAttribPointer(ATTRIB_POSITION, 2, GL_FLOAT, GL_FALSE, 0, positions);
+	glVertexAttribPointer(ATTRIB_TEXCOORD, 2, GL_FLOAT, GL_FALSE, 0, texCoords);
+	glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
+	glBindTexture(GL_TEXTURE_2D, 0);
+	CheckGlError("DynamicResolution::end");
+}
+
+size_t DynamicResolution::releaseGlResources() {
+	size_t before = gpuMemoryGetUsed();
+	delete target;
+	target = NULL;
+	return before - gpuMemoryGetUsed();
+}
@@ -0,0 +1,83 @@
+/*
+ * DynamicResolution.h
+ *
+ *  Created on: 19-10-2026
+ */
+
+#ifndef DYNAMICRESOLUTION_H_
+#define DYNAMICRESOLUTION_H_
+
+#include <GLES2/gl2.h>
+#include <stddef.h>
+#include "Framebuffer.h"
+#include "Program.h"
+#include "Timing.h"
+
+// Frames whose times are looked at together before the scale moves
+#define DYNAMIC_RESOLUTION_WINDOW 10
+// Of the maximum scale: the step a probe for headroom takes
+#define DYNAMIC_RESOLUTION_STEP 0.0625f
+
+/*
+ * Renders a frame into an offscreen target at a fraction of the output size
+ * and upscales it, the fraction following the frame times to hold a target.
+ * Every DYNAMIC_RESOLUTION_WINDOW frames the 90th percentile of their times
+ * is compared with the target:
+ *  - over it by 10%, the scale drops at once to where the pixel count
+ *    (scale squared) would meet it,
+ *  - under 80% of it, the scale grows the same way, at most 10% a window,
+ *  - in between the frames are on time, but a vsync'd swap hides how much
+ *    headroom is left, so after a number of on time windows the scale is
+ *    raised one DYNAMIC_RESOLUTION_STEP. A probe that misses drops back and
+ *    doubles the windows before the next one (up to 16).
+ * The target is allocated once at the maximum scale; smaller scales render
+ * into its lower left corner and the upscale samples that corner, so moving
+ * the scale never reallocates. GL thread only.
+ */
+class DynamicResolution {
+public:
+	// targetMs is the frame time to hold, e.g. a little over the vsync period
+	// for frame times taken between swaps
+	DynamicResolution(double targetMs,float minScale = 0.5f,float maxScale = 1.0f);
+	virtual ~DynamicResolution();
+
+	// Disabled, begin() returns false and the frame is drawn as it would be
+	// without this class; the frame times still move the scale
+	void setEnabled(bool enabled);
+	bool isEnabled();
+	void setTargetMs(double targetMs);
+	double getTargetMs();
+	// Time of the frame just finished, e.g. between two swap returns
+	void addFrameTime(double ms);
+	float getScale();
+	// Times the scale moved since construction
+	unsigned int getChangeCount();
+
+	// Binds the offscreen target with the viewport over getScale() of a
+	// width x height output, remembering the bound framebuffer and viewport.
+	// False when disabled or the target cannot be made: draw as usual then.
+	bool begin(GLuint width,GLuint height);
+	// After a begin() that returned true: binds the remembered framebuffer
+	// and viewport back and draws the rendered corner over it through program
+	// (sTexture on unit 0, ATTRIB_POSITION and ATTRIB_TEXCOORD). GL_LINEAR
+	// filtering does the upscale; row 0 stays at the bottom.
+	void end(Program* program);
+	// Deletes the target, made again by the next begin(); returns the bytes freed
+	size_t releaseGlResources();
+private:
+	void setScale(float scale);
+
+	bool enabled;
+	double targetMs;
+	float minScale,maxScale,scale;
+	SampleStats window;
+	int onTimeWindows,probeWindows;	// on time in a row, and needed before a probe
+	bool probing;					// the scale was last raised by a probe
+	unsigned int changes;
+	Framebuffer* target;
+	GLuint renderWidth,renderHeight;
+	GLint savedFramebuffer;
+	GLint savedViewport[4];
+};
+
+#endif /* DYNAMICRESOLUTION_H_ */
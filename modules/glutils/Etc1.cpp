@@ -0,0 +1,260 @@
+/*
+ * Etc1.cpp
+ *
+ *  Created on: 19-10-2026
+ */
+
+#include "Etc1.h"
+#include "Parallel.h"
+#include <limits.h>
+#include <string.h>
+
+static const int modifierTable[8][2] = {
+	{ 2, 8 }, { 5, 17 }, { 9, 29 }, { 13, 42 },
+	{ 18, 60 }, { 24, 80 }, { 33, 106 }, { 47, 183 }
+};
+
+// pixel index 0..3 -> modifier: +small, +large, -small, -large
+static inline int modifier(int table,int index) {
+	int m = modifierTable[table][index & 1];
+	return index & 2 ? -m : m;
+}
+
+static inline int clamp255(int v) {
+	return v < 0 ? 0 : (v > 255 ? 255 : v);
+}
+
+static inline int expand4(int c) {
+	return (c << 4) | c;
+}
+
+static inline int expand5(int c) {
+	return (c << 3) | (c >> 2);
+}
+
+GLuint etc1GetEncodedDataSize(GLuint width,GLuint height) {
+	return ((width + 3) / 4) * ((height + 3) / 4) * 8;
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+// Decoder
+
+static void decodeBlock(const GLubyte* in,GLubyte block[16][3]) {
+	unsigned int high = (in[0] << 24) | (in[1] << 16) | (in[2] << 8) | in[3];
+	unsigned int low = (in[4] << 24) | (in[5] << 16) | (in[6] << 8) | in[7];
+	bool diff = high & 2;
+	bool flip = high & 1;
+	int base[2][3];
+	for(int c=0;c<3;c++) {
+		int shift = 27 - c * 8;
+		if(diff) {
+			int c1 = (high >> shift) & 31;
+			int d = (high >> (shift - 3)) & 7;
+			d = d >= 4 ? d - 8 : d;
+			base[0][c] = expand5(c1);
+			base[1][c] = expand5((c1 + d) & 31);
+		}
+		else {
+			base[0][c] = expand4((high >> (shift + 1)) & 15);
+			base[1][c] = expand4((high >> (shift - 3)) & 15);
+		}
+	}
+	int table[2] = { (int)(high >> 5) & 7, (int)(high >> 2) & 7 };
+
+	for(int x=0;x<4;x++) {
+		for(int y=0;y<4;y++) {
+			int p = x * 4 + y;
+			int sub = flip ? (y >= 2) : (x >= 2);
+			int index = (((low >> (16 + p)) & 1) << 1) | ((low >> p) & 1);
+			int m = modifier(table[sub],index);
+			for(int c=0;c<3;c++)
+				block[y*4+x][c] = clamp255(base[sub][c] + m);
+		}
+	}
+}
+
+void etc1DecodeImage(const GLubyte* in,GLubyte* pixels,GLuint width,GLuint height,GLuint pixelSize) {
+	GLubyte block[16][3];
+	for(GLuint by=0;by<height;by+=4) {
+		for(GLuint bx=0;bx<width;bx+=4,in+=8) {
+			decodeBlock(in,block);
+			for(GLuint y=0;y<4 && by+y<height;y++) {
+				GLubyte* dst = pixels + ((by + y) * width + bx) * pixelSize;
+				for(GLuint x=0;x<4 && bx+x<width;x++,dst+=pixelSize) {
+					dst[0] = block[y*4+x][0];
+					dst[1] = block[y*4+x][1];
+					dst[2] = block[y*4+x][2];
+					if(pixelSize == 4)
+						dst[3] = 255;
+				}
+			}
+		}
+	}
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+// Encoder
+
+typedef struct
+{
+	int base[3];
+	int table;
+	int indices[8];
+	int error;
+} SubBlockFit;
+
+// The 8 pixel positions (x*4+y) of each half for both orientations
+static const int subBlockPixels[2][2][8] = {
+	{ { 0, 1, 2, 3, 4, 5, 6, 7 }, { 8, 9, 10, 11, 12, 13, 14, 15 } },		// flip 0: left / right
+	{ { 0, 1, 4, 5, 8, 9, 12, 13 }, { 2, 3, 6, 7, 10, 11, 14, 15 } }		// flip 1: top / bottom
+};
+
+static void fitSubBlock(const GLubyte block[16][3],const int* pixelIndex,const int base[3],SubBlockFit* fit) {
+	// all 32 candidate colors, clamped once up front
+	int candidates[8][4][3];
+	for(int t=0;t<8;t++)
+		for(int k=0;k<4;k++)
+			for(int c=0;c<3;c++)
+				candidates[t][k][c] = clamp255(base[c] + modifier(t,k));
+
+	fit->error = INT_MAX;
+	for(int t=0;t<8;t++) {
+		int error = 0;
+		int indices[8];
+		for(int i=0;i<8 && error < fit->error;i++) {
+			const GLubyte* px = block[(pixelIndex[i] & 3) * 4 + (pixelIndex[i] >> 2)];
+			int best = INT_MAX;
+			for(int k=0;k<4;k++) {
+				int dr = candidates[t][k][0] - px[0];
+				int dg = candidates[t][k][1] - px[1];
+				int db = candidates[t][k][2] - px[2];
+				int e = dr*dr + dg*dg + db*db;
+				if(e < best) {
+					best = e;
+					indices[i] = k;
+				}
+			}
+			error += best;
+		}
+		if(error < fit->error) {
+			fit->error = error;
+			fit->table = t;
+			memcpy(fit->indices,indices,sizeof(indices));
+		}
+	}
+	memcpy(fit->base,base,sizeof(fit->base));
+}
+
+static void writeBlock(GLubyte* out,bool diff,bool flip,const int q[2][3],const SubBlockFit fits[2]) {
+	unsigned int high = 0, low = 0;
+	for(int c=0;c<3;c++) {
+		int shift = 27 - c * 8;
+		if(diff)
+			high |= (q[0][c] << shift) | (((q[1][c] - q[0][c]) & 7) << (shift - 3));
+		else
+			high |= (q[0][c] << (shift + 1)) | (q[1][c] << (shift - 3));
+	}
+	high |= (fits[0].table << 5) | (fits[1].table << 2) | (diff ? 2 : 0) | (flip ? 1 : 0);
+
+	for(int s=0;s<2;s++) {
+		for(int i=0;i<8;i++) {
+			int p = subBlockPixels[flip][s][i];
+			int index = fits[s].indices[i];
+			low |= ((index >> 1) << (16 + p)) | ((index & 1) << p);
+		}
+	}
+	for(int i=0;i<4;i++) {
+		out[i] = high >> (24 - 8 * i);
+		out[4 + i] = low >> (24 - 8 * i);
+	}
+}
+
+static void encodeBlock(const GLubyte block[16][3],GLubyte* out) {
+	int bestError = INT_MAX;
+	for(int flip=0;flip<2;flip++) {
+		int avg[2][3];
+		for(int s=0;s<2;s++) {
+			for(int c=0;c<3;c++) {
+				int sum = 0;
+				for(int i=0;i<8;i++) {
+					int p = subBlockPixels[flip][s][i];
+					sum += block[(p & 3) * 4 + (p >> 2)][c];
+				}
+				avg[s][c] = sum;
+			}
+		}
+
+		// differential mode: 5 bit bases, second within [-4,3] of the first
+		int q[2][3];
+		bool diffOk = true;
+		for(int s=0;s<2;s++)
+			for(int c=0;c<3;c++)
+				q[s][c] = (avg[s][c] * 31 + 1020) / 2040;
+		for(int c=0;c<3;c++) {
+			int d = q[1][c] - q[0][c];
+			if(d < -4 || d > 3)
+				diffOk = false;
+		}
+		if(diffOk) {
+			SubBlockFit fits[2];
+			for(int s=0;s<2;s++) {
+				int base[3] = { expand5(q[s][0]), expand5(q[s][1]), expand5(q[s][2]) };
+				fitSubBlock(block,subBlockPixels[flip][s],base,&fits[s]);
+			}
+			if(fits[0].error + fits[1].error < bestError) {
+				bestError = fits[0].error + fits[1].error;
+				writeBlock(out,true,flip,q,fits);
+			}
+		}
+
+		// individual mode: two independent 4 bit bases
+		for(int s=0;s<2;s++)
+			for(int c=0;c<3;c++)
+				q[s][c] = (avg[s][c] * 15 + 1020) / 2040;
+		SubBlockFit fits[2];
+		for(int s=0;s<2;s++) {
+			int base[3] = { expand4(q[s][0]), expand4(q[s][1]), expand4(q[s][2]) };
+			fitSubBlock(block,subBlockPixels[flip][s],base,&fits[s]);
+		}
+		if(fits[0].error + fits[1].error < bestError) {
+			bestError = fits[0].error + fits[1].error;
+			writeBlock(out,false,flip,q,fits);
+		}
+	}
+}
+
+struct Etc1EncodeContext {
+	const GLubyte* pixels;
+	GLuint width,height,pixelSize;
+	GLubyte* out;
+};
+
+static void encodeBlockRows(int begin,int end,void* arg) {
+	const Etc1EncodeContext* ctx = (const Etc1EncodeContext*)arg;
+	const GLuint blocksWide = (ctx->width + 3) / 4;
+	GLubyte block[16][3];
+
+	for(int by=begin;by<end;by++) {
+		GLubyte* out = ctx->out + (size_t)by * blocksWide * 8;
+		for(GLuint bx=0;bx<blocksWide;bx++,out+=8) {
+			for(GLuint y=0;y<4;y++) {
+				GLuint sy = by * 4 + y < ctx->height ? by * 4 + y : ctx->height - 1;
+				for(GLuint x=0;x<4;x++) {
+					GLuint sx = bx * 4 + x < ctx->width ? bx * 4 + x : ctx->width - 1;
+					const GLubyte* px = ctx->pixels + ((size_t)sy * ctx->width + sx) * ctx->pixelSize;
+					block[y*4+x][0] = px[0];
+					block[y*4+x][1] = px[1];
+					block[y*4+x][2] = px[2];
+				}
+			}
+			encodeBlock(block,out);
+		}
+	}
+}
+
+void etc1EncodeImage(const GLubyte* pixels,GLuint width,GLuint height,GLuint pixelSize,GLubyte* out) {
+	if(!width || !height)
+		return;
+	Etc1EncodeContext ctx = { pixels, width, height, pixelSize, out };
+	parallelFor(0,(height + 3) / 4,encodeBlockRows,&ctx,4);
+}
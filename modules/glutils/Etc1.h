@@ -0,0 +1,27 @@
+/*
+ * Etc1.h
+ *
+ *  Created on: 19-10-2026
+ */
+
+#ifndef ETC1_H_
+#define ETC1_H_
+
+#include <GLES2/gl2.h>
+
+/*
+ * ETC1 codec on the CPU, no GL calls involved. Images are tightly packed
+ * GL_UNSIGNED_BYTE RGB (pixelSize 3) or RGBA (pixelSize 4, alpha ignored on
+ * encode and set to 255 on decode). Blocks are 4x4 pixels, 8 bytes each,
+ * stored row by row; partial edge blocks repeat the last row/column.
+ * ETC1 data is also valid GL_COMPRESSED_RGB8_ETC2 data.
+ */
+
+GLuint etc1GetEncodedDataSize(GLuint width,GLuint height);
+
+// Encodes block rows in parallel; out must hold etc1GetEncodedDataSize bytes
+void etc1EncodeImage(const GLubyte* pixels,GLuint width,GLuint height,GLuint pixelSize,GLubyte* out);
+
+void etc1DecodeImage(const GLubyte* in,GLubyte* pixels,GLuint width,GLuint height,GLuint pixelSize);
+
+#endif /* ETC1_H_ */
@@ -6,9 +6,12 @@
  */
 
 #include "Framebuffer.h"
+#include "GpuMemory.h"
+#include "PixelConvert.h"
 #include "logger.h"
+#include <vector>
 
-Framebuffer::Framebuffer(GLuint w,GLuint h, GLvoid* pixels,GLenum f,GLenum t):width(w),height(h),format(f),type(t) {
+Framebuffer::Framebuffer(GLuint w,GLuint h, GLvoid* pixels,GLenum f,GLenum t,GLenum tf,const char* o):width(w),height(h),format(f),type(t),textureFormat(tf ? tf : f),owner(o),readFormat(0),readType(0) {
 	initFbo(pixels);
 }
 
@@ -27,6 +30,7 @@ GLuint Framebuffer::initRenderbuffer(GLuint width, GLuint height, GLenum format)
 
     glRenderbufferStorage(GL_RENDERBUFFER, format, width, height);
     CheckGlError("init_renderbuffer: glRenderbufferStorage");
+    gpuMemoryTrack(GPU_RESOURCE_RENDERBUFFER, renderbuffer, gpuMemoryGetRenderbufferSize(width, height, format), owner);
 
     glBindRenderbuffer(GL_RENDERBUFFER, 0);
     CheckGlError("init_renderbuffer: glBindRenderbuffer");
@@ -36,11 +40,12 @@ GLuint Framebuffer::initRenderbuffer(GLuint width, GLuint height, GLenum format)
 
 void Framebuffer::initFbo(GLvoid* pixels) {
     // create renderable texture
-	initTexture(&renderableTexture,width,height,format,type,pixels);
+	initTexture(&renderableTexture,width,height,textureFormat,type,pixels,owner);
 
     // create framebuffer object
     glGenFramebuffers(1, &framebufferObject);
     CheckGlError("Framebuffer::initFbo: glGenFramebuffers");
+    gpuMemoryTrack(GPU_RESOURCE_FRAMEBUFFER, framebufferObject, 0, owner);
 
     this->bind();
 
@@ -48,6 +53,9 @@ void Framebuffer::initFbo(GLvoid* pixels) {
     CheckGlError("Framebuffer::initFbo: glFramebufferTexture2D");
 
     checkFBOStatus();
+    // the pair glReadPixels takes besides GL_RGBA, GL_UNSIGNED_BYTE
+    glGetIntegerv(GL_IMPLEMENTATION_COLOR_READ_FORMAT, &readFormat);
+    glGetIntegerv(GL_IMPLEMENTATION_COLOR_READ_TYPE, &readType);
 
     glBindTexture(GL_TEXTURE_2D, 0);
     CheckGlError("Framebuffer::initFbo: glBindTexture");
@@ -59,10 +67,10 @@ void Framebuffer::initFbo(GLvoid* pixels) {
 }
 
 void Framebuffer::destroyFbo() {
+    gpuMemoryRelease(GPU_RESOURCE_FRAMEBUFFER, framebufferObject);
     glDeleteFramebuffers(1, &framebufferObject);
-    glDeleteTextures(1, &renderableTexture);
+    deleteTexture(&renderableTexture);
     framebufferObject = 0;
-    renderableTexture = 0;
 }
 
 int Framebuffer::checkFBOStatus() {
@@ -72,28 +80,28 @@ int Framebuffer::checkFBOStatus() {
 	if(status != GL_FRAMEBUFFER_COMPLETE) {
 		switch(status) {
 			case GL_FRAMEBUFFER_INCOMPLETE_ATTACHMENT:
-				Log("Framebuffer::checkFBOStatus: FBO error: FRAMEBUFFER_INCOMPLETE_ATTACHMENT");
+				LogError("Framebuffer::checkFBOStatus: FBO error: FRAMEBUFFER_INCOMPLETE_ATTACHMENT");
 				break;
 
 			case GL_FRAMEBUFFER_INCOMPLETE_MISSING_ATTACHMENT:
-				Log("Framebuffer::checkFBOStatus: FBO error: FRAMEBUFFER_INCOMPLETE_MISSING_ATTACHMENT");
+				LogError("Framebuffer::checkFBOStatus: FBO error: FRAMEBUFFER_INCOMPLETE_MISSING_ATTACHMENT");
 				break;
 
 			case GL_FRAMEBUFFER_INCOMPLETE_DIMENSIONS:
-				Log("Framebuffer::checkFBOStatus: FBO error: FRAMEBUFFER_INCOMPLETE_DIMENSIONS");
+				LogError("Framebuffer::checkFBOStatus: FBO error: FRAMEBUFFER_INCOMPLETE_DIMENSIONS");
 				break;
 
 			case GL_FRAMEBUFFER_UNSUPPORTED:
-				Log("Framebuffer::checkFBOStatus: FBO error: FRAMEBUFFER_UNSUPPORTED");
+				LogError("Framebuffer::checkFBOStatus: FBO error: FRAMEBUFFER_UNSUPPORTED");
 				break;
 
 			default:
-				Log("Framebuffer::checkFBOStatus: Unknown FBO error");
+				LogError("Framebuffer::checkFBOStatus: Unknown FBO error");
 				break;
 		}
 	}
 	else {
-		Log("Framebuffer::checkFBOStatus: FBO has been successfully initialized");
+		LogDebug("Framebuffer::checkFBOStatus: FBO has been successfully initialized");
 	}
 	return status;
 }
@@ -111,41 +119,44 @@ void Framebuffer::unbind()
 }
 
 GLvoid* Framebuffer::grabDataPointer() {
-	int i;
-	GLuint pixelFormat,typeSize;
-	switch(format){
-		case GL_RGB:
-			pixelFormat = 3;
-			break;
-		case GL_LUMINANCE:
-			pixelFormat = 1;
-			break;
-		case GL_RGBA:
-			pixelFormat = 4;
-			break;
-		default:
-			pixelFormat = 3;
-			break;
-	}
-	switch(type){
-		case GL_UNSIGNED_BYTE:
-			typeSize = 1;
-			break;
-		default:
-			break;
-	}
-	Log("Width %d Height %d typeSize %d pixelFormat %d",width,height,typeSize,pixelFormat);
-	GLubyte* pixels = new GLubyte[width * height * pixelFormat * typeSize];
+	GLuint pixelSize = getPixelSize(format,type);
+	LogDebug("Width %d Height %d pixelSize %d",width,height,pixelSize);
+	GLubyte* pixels = new GLubyte[width * height * pixelSize];
 
+	grabData(pixels);
+
+	return pixels;
+}
+
+void Framebuffer::grabData(GLvoid* pixels) {
+	grabRows(pixels,0,height);
+}
+
+void Framebuffer::grabRows(GLvoid* pixels,GLint firstRow,GLsizei rowCount) {
 	bind();
 
-	CheckGlError("scalePointer BindTexture");
-	glReadPixels(0,0,width,height,format,type,pixels);
-	CheckGlError("scalePointer glReadPixels");
+	// rows are tightly packed in the destination buffer
+	glPixelStorei(GL_PACK_ALIGNMENT, 1);
+	if((format == GL_RGBA && type == GL_UNSIGNED_BYTE) || (format == (GLenum)readFormat && type == (GLenum)readType)) {
+		glReadPixels(0,firstRow,width,rowCount,format,type,pixels);
+		CheckGlError("Framebuffer::grabRows: glReadPixels");
+	}
+	else {
+		// GLES2 drivers need not return GL_RGB, e.g. Mesa; read GL_RGBA and convert
+		const GLuint count = width * rowCount;
+		std::vector<GLubyte> rgba((size_t)count * 4);
+		glReadPixels(0,firstRow,width,rowCount,GL_RGBA,GL_UNSIGNED_BYTE,&rgba[0]);
+		CheckGlError("Framebuffer::grabRows: glReadPixels");
+		if(type == GL_UNSIGNED_SHORT_5_6_5) {
+			GLushort* out = (GLushort*)pixels;
+			for(GLuint i=0;i<count;i++)
+				out[i] = (rgba[i*4] >> 3) << 11 | (rgba[i*4+1] >> 2) << 5 | rgba[i*4+2] >> 3;
+		}
+		else if(type != GL_UNSIGNED_BYTE || !convertPixels(&rgba[0],0,GL_RGBA,(GLubyte*)pixels,0,format,width,rowCount))
+			LogError("Framebuffer::grabRows: cannot read format 0x%x type 0x%x",format,type);
+	}
 
 	unbind();
-
-	return pixels;
 }
 
 void Framebuffer::bindTexture() {
@@ -164,6 +175,25 @@ void Framebuffer::setViewPort() {
 }
 
 void Framebuffer::recoverSavedViewPort() {
-    glGetIntegerv(GL_VIEWPORT, savedViewport);
     glViewport(savedViewport[0],savedViewport[1],savedViewport[2],savedViewport[3]);
 }
+
+GLuint Framebuffer::getTexture() {
+	return renderableTexture;
+}
+
+int Framebuffer::getWidth() {
+	return width;
+}
+
+int Framebuffer::getHeight() {
+	return height;
+}
+
+GLenum Framebuffer::getFormat() {
+	return format;
+}
+
+GLenum Framebuffer::getType() {
+	return type;
+}
@@ -12,7 +12,11 @@
 
 class Framebuffer {
 public:
-	Framebuffer(GLuint width,GLuint height,GLvoid* pixels = 0,GLenum format = GL_RGB,GLenum type = GL_UNSIGNED_BYTE);
+	// textureFormat overrides format for the texture storage only, e.g.
+	// GL_SRGB_ALPHA_EXT read back as GL_RGBA. owner names the allocations
+	// in gpuMemoryLogReport and must outlive the framebuffer.
+	Framebuffer(GLuint width,GLuint height,GLvoid* pixels = 0,GLenum format = GL_RGB,GLenum type = GL_UNSIGNED_BYTE,
+			GLenum textureFormat = 0,const char* owner = "Framebuffer");
 	virtual ~Framebuffer();
 
 	void initFbo(GLvoid* pixels = 0);
@@ -23,16 +27,26 @@ public:
 	void bindTexture();
 	void unbindTexture();
 	GLvoid* grabDataPointer();
+	void grabData(GLvoid* pixels);
+	// Reads rowCount full rows starting at firstRow (row 0 is read back first)
+	void grabRows(GLvoid* pixels,GLint firstRow,GLsizei rowCount);
 	void setViewPort();
 	void recoverSavedViewPort();
+	GLuint getTexture();
+	int getWidth();
+	int getHeight();
+	GLenum getFormat();
+	GLenum getType();
 private:
 	GLuint initRenderbuffer(GLuint width, GLuint height, GLenum format);
 
     GLuint renderableTexture,framebufferObject;
     int height,width;
     GLuint inputTextureHandler;
-    GLenum format,type;
+    GLenum format,type,textureFormat;
+    const char* owner;
     GLint savedViewport[4];
+    GLint readFormat,readType;		// GL_IMPLEMENTATION_COLOR_READ_* of the object
 };
 
 #endif /* FRAMEBUFFER_H_ */
@@ -8,6 +8,11 @@
 #include "GLUtils.h"
 #include "logger.h"
 #include "file.h"
+#include "Program.h"
+#include "GpuMemory.h"
+#include "PixelConvert.h"
+#include <string.h>
+#include <vector>
 
 ///////////////////////////////////////////////////////////////////////////////////////////////////
 // CompileShader - Compiles the passed in string for the given shaderType
@@ -55,33 +60,91 @@ GLuint CompileShader( GLenum shaderType, const char* pSource, GLint * fileSize )
 }
 
 
+///////////////////////////////////////////////////////////////////////////////////////////////////
+// injectDefines - Returns source with a #define line per entry of defines
+// ("NAME" or "NAME=VALUE", separated by ';'), placed after any #version line
+std::string injectDefines( const char* pSource, GLint sourceSize, const char* defines )
+{
+    std::string source( pSource, sourceSize );
+    if( !defines || !*defines )
+        return source;
+
+    std::string lines;
+    const char* p = defines;
+    while( *p )
+    {
+        const char* end = strchr( p, ';' );
+        if( !end )
+            end = p + strlen( p );
+        std::string define( p, end - p );
+        if( !define.empty() )
+        {
+            size_t eq = define.find( '=' );
+            if( eq != std::string::npos )
+                define[eq] = ' ';
+            lines += "#define " + define + "\n";
+        }
+        p = *end ? end + 1 : end;
+    }
+
+    size_t insertAt = 0;
+    size_t version = source.find( "#version" );
+    if( version != std::string::npos && source.find_first_not_of( " \t\r\n" ) == version )
+    {
+        insertAt = source.find( '\n', version );
+        insertAt = insertAt == std::string::npos ? source.size() : insertAt + 1;
+    }
+    source.insert( insertAt, lines );
+    return source;
+}
+
 ///////////////////////////////////////////////////////////////////////////////////////////////////
 // createProgram - Creates a new program with the given vertex and pixel shader
 GLuint createProgram( const char* pVertexPath, const char* pFragmentPath )
+{
+    return createProgram( pVertexPath, pFragmentPath, NULL );
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+// createProgram - Same, compiling both shaders with the given defines
+GLuint createProgram( const char* pVertexPath, const char* pFragmentPath, const char* defines )
 {
     char* pVertexData = NULL;
     GLint vertexFileSize = 0;
     char* pFragmenData = NULL;
     GLint fragmentFileSize = 0;
     ReadFile( pVertexPath, &pVertexData, (unsigned int*)&vertexFileSize );
-	Log("Shader size %d ",vertexFileSize);
-	Log("Shader val \n%s",pVertexData);
-    // Compile the vertex shader
-    GLuint vertexShaderHandle = CompileShader( GL_VERTEX_SHADER, pVertexData , &vertexFileSize );
-    delete pVertexData;
-    ReadFile(pFragmentPath,&pFragmenData,(unsigned int*)&fragmentFileSize);
-    Log("Shader size %d ",fragmentFileSize);
-    Log("Shader val \n%s",pFragmenData);
-    GLuint pixelShaderHandle  = CompileShader( GL_FRAGMENT_SHADER, pFragmenData , &fragmentFileSize );
+    ReadFile( pFragmentPath, &pFragmenData, (unsigned int*)&fragmentFileSize );
+    if( !pVertexData || !pFragmenData )
+    {
+        LogError( "createProgram: cannot read %s or %s", pVertexPath, pFragmentPath );
+        delete[] pVertexData;
+        delete[] pFragmenData;
+        return 0;
+    }
 
-    delete pFragmenData;
+    std::string vertexSource = injectDefines( pVertexData, vertexFileSize, defines );
+    std::string fragmentSource = injectDefines( pFragmenData, fragmentFileSize, defines );
+    delete[] pVertexData;
+    delete[] pFragmenData;
+    vertexFileSize = vertexSource.size();
+    fragmentFileSize = fragmentSource.size();
+	LogVerbose("Shader size %d ",vertexFileSize);
+	LogVerbose("Shader val \n%s",vertexSource.c_str());
+    // Compile the vertex shader
+    GLuint vertexShaderHandle = CompileShader( GL_VERTEX_SHADER, vertexSource.c_str() , &vertexFileSize );
+    LogVerbose("Shader size %d ",fragmentFileSize);
+    LogVerbose("Shader val \n%s",fragmentSource.c_str());
+    GLuint pixelShaderHandle  = CompileShader( GL_FRAGMENT_SHADER, fragmentSource.c_str() , &fragmentFileSize );
 
     if( !vertexShaderHandle || !pixelShaderHandle )
     {
+        glDeleteShader( vertexShaderHandle );
+        glDeleteShader( pixelShaderHandle );
         return 0;
     }
-    Log("Vertex file compiled");
-    Log("Fragment file compiled");
+    LogDebug("Vertex file compiled");
+    LogDebug("Fragment file compiled");
 
     // Create a new handle for this program
     GLuint programHandle = glCreateProgram();
@@ -97,9 +160,17 @@ GLuint createProgram( const char* pVertexPath, const char* pFragmentPath )
         glAttachShader( programHandle, pixelShaderHandle );
         CheckGlError( "glAttachShader" );
 
+        // Same vertex layout for every program
+        glBindAttribLocation( programHandle, ATTRIB_POSITION, "aPosition" );
+        glBindAttribLocation( programHandle, ATTRIB_TEXCOORD, "aTexCoord" );
+
         // Link the program
         glLinkProgram( programHandle );
 
+        // Flagged for deletion, freed together with the program
+        glDeleteShader( vertexShaderHandle );
+        glDeleteShader( pixelShaderHandle );
+
         // Check the link status
         GLint linkStatus = 0;
         glGetProgramiv( programHandle, GL_LINK_STATUS, &linkStatus );
@@ -130,41 +201,214 @@ GLuint createProgram( const char* pVertexPath, const char* pFragmentPath )
     return programHandle;
 }
 
-GLvoid* scalePointer(float ratio,GLvoid* inPointer,GLuint width,GLuint height,GLenum format,GLenum type) {
-	GLuint textureID;
-	int i;
-	Framebuffer* fb = new Framebuffer(ratio*width,ratio*height,0,format,type);
-	//	struct framebuffer fb;
-//	init_fbo(fb,0,ratio*width,ratio*height);
-	initTexture(&textureID,format,type,width,height,inPointer);
-//	fb->inputTextureHandler = textureID;
-//	renderToFBO(fb,drawTextureOnUniformQuad);
-//	destroy_fbo(&fb);
-//	glDeleteTextures(1,&textureID);
+GLint getUnpackAlignment(GLuint rowBytes,GLuint stride) {
+	// the largest first: drivers copy aligned rows a word at a time
+	for(GLint alignment=8;alignment>=1;alignment/=2) {
+		if(((rowBytes + alignment - 1) & ~(alignment - 1)) == stride)
+			return alignment;
+	}
+	return 0;
+}
+
+static bool isUnpackSubimageSupported() {
+	static int supported = -1;
+	if(supported < 0)
+		supported = isExtensionSupported("GL_EXT_unpack_subimage");
+	return supported;
+}
+
+// Repacked rows when the driver cannot step over the stride, GL thread only
+static std::vector<GLubyte> unpackStaging;
 
-//	return fb->grabDataPointer(fb,format,type);
+// glTexImage2D, or glTexSubImage2D at x,y when sub, into the bound texture.
+// The unpack state is put back as it was.
+static void unpackImage(bool sub,GLint x,GLint y,GLuint width,GLuint height,GLenum format,GLenum type,const GLvoid* pixels,
+		GLuint stride) {
+	const GLuint rowBytes = width * getPixelSize(format,type);
+	stride = stride ? stride : rowBytes;
+	GLint alignment = height > 1 ? getUnpackAlignment(rowBytes,stride) : 1;
+	bool rowLength = false;
+	if(pixels && !alignment) {
+		if(stride % getPixelSize(format,type) == 0 && isUnpackSubimageSupported()) {
+			glPixelStorei(GL_UNPACK_ROW_LENGTH_EXT, stride / getPixelSize(format,type));
+			rowLength = true;
+			alignment = 1;
+		}
+		else {
+			unpackStaging.resize((size_t)rowBytes * height);
+			copyRows((const GLubyte*)pixels,stride,&unpackStaging[0],rowBytes,rowBytes,height);
+			pixels = &unpackStaging[0];
+			alignment = getUnpackAlignment(rowBytes,rowBytes);
+		}
+	}
+	if(!alignment)
+		alignment = getUnpackAlignment(rowBytes,rowBytes);
+	GLint saved = 4;
+	glGetIntegerv(GL_UNPACK_ALIGNMENT, &saved);
+	if(alignment != saved)
+		glPixelStorei(GL_UNPACK_ALIGNMENT, alignment);
+	if(sub)
+		glTexSubImage2D(GL_TEXTURE_2D, 0, x, y, width, height, format, type, pixels);
+	else
+		glTexImage2D(GL_TEXTURE_2D, 0, format, width, height, 0, format, type, pixels);
+	if(alignment != saved)
+		glPixelStorei(GL_UNPACK_ALIGNMENT, saved);
+	if(rowLength)
+		glPixelStorei(GL_UNPACK_ROW_LENGTH_EXT, 0);
 }
 
-void initTexture(GLuint* texture,GLuint width,GLuint height,GLenum format,GLenum type,GLvoid* pixels) {
+static void setTextureParameters() {
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+}
+
+void initTexture(GLuint* texture,GLuint width,GLuint height,GLenum format,GLenum type,GLvoid* pixels,const char* owner) {
     glGenTextures(1, texture);
     CheckGlError("initTexture: glGenTextures");
 
     glBindTexture(GL_TEXTURE_2D, *texture);
-    Log("Texture ID %d",*texture);
+    LogDebug("Texture ID %d",*texture);
     CheckGlError("initTexture: glBindTexture");
 
-    if(pixels>0)
-    	glTexImage2D(GL_TEXTURE_2D, 0, format, width, height, 0, format, type, pixels);
-    else
-    	glTexImage2D(GL_TEXTURE_2D, 0, format, width, height, 0, format, type, 0);
+    unpackImage(false, 0, 0, width, height, format, type, pixels, 0);
     CheckGlError("initTexture: glTexImage2D");
+    gpuMemoryTrack(GPU_RESOURCE_TEXTURE, *texture, gpuMemoryGetTextureSize(width, height, format, type), owner);
 
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    setTextureParameters();
     CheckGlError("initTexture: glTexParameteri");
 
-    Log("****************************** initTexture: texture ID: %d", *texture);
+    LogDebug("****************************** initTexture: texture ID: %d", *texture);
+}
+
+void uploadTexture(GLuint* texture,GLuint width,GLuint height,GLenum format,GLenum type,const GLvoid* pixels,GLuint stride,
+		const char* owner) {
+	const bool created = !*texture;
+	if(created)
+		glGenTextures(1, texture);
+	glBindTexture(GL_TEXTURE_2D, *texture);
+	unpackImage(false,0,0,width,height,format,type,pixels,stride);
+	CheckGlError("uploadTexture: glTexImage2D");
+	gpuMemoryTrack(GPU_RESOURCE_TEXTURE, *texture, gpuMemoryGetTextureSize(width, height, format, type), owner);
+	if(created)
+		setTextureParameters();
+}
+
+void uploadSubTexture(GLuint texture,GLint x,GLint y,GLuint width,GLuint height,GLenum format,GLenum type,const GLvoid* pixels,
+		GLuint stride) {
+	glBindTexture(GL_TEXTURE_2D, texture);
+	unpackImage(true,x,y,width,height,format,type,pixels,stride);
+	CheckGlError("uploadSubTexture: glTexSubImage2D");
+}
+
+void deleteTexture(GLuint* texture) {
+	if(!*texture)
+		return;
+	gpuMemoryRelease(GPU_RESOURCE_TEXTURE, *texture);
+	glDeleteTextures(1, texture);
+	*texture = 0;
+}
+
+bool isExtensionSupported(const char* name) {
+	const char* extensions = (const char*)glGetString(GL_EXTENSIONS);
+	if(!extensions)
+		return false;
+	size_t length = strlen(name);
+	// GL_EXT_sRGB is also a prefix of GL_EXT_sRGB_write_control
+	for(const char* p = strstr(extensions, name); p; p = strstr(p + length, name)) {
+		if((p == extensions || p[-1] == ' ') && (p[length] == ' ' || p[length] == '\0'))
+			return true;
+	}
+	return false;
+}
+
+// Formats listed by the driver, GL_ETC1_RGB8_OES is also exposed as an extension string only
+bool isCompressedFormatSupported(GLenum internalFormat) {
+	GLint count = 0;
+	glGetIntegerv(GL_NUM_COMPRESSED_TEXTURE_FORMATS, &count);
+	if(count > 0) {
+		GLint* formats = new GLint[count];
+		glGetIntegerv(GL_COMPRESSED_TEXTURE_FORMATS, formats);
+		bool found = false;
+		for(GLint i=0;i<count && !found;i++)
+			found = (GLenum)formats[i] == internalFormat;
+		delete[] formats;
+		if(found)
+			return true;
+	}
+	if(internalFormat == GL_ETC1_RGB8_OES)
+		return isExtensionSupported("GL_OES_compressed_ETC1_RGB8_texture");
+	return false;
 }
 
+GLsizei getCompressedImageSize(GLenum internalFormat,GLuint width,GLuint height) {
+	GLsizei blocks = ((width + 3) / 4) * ((height + 3) / 4);
+	switch(internalFormat) {
+		case GL_ETC1_RGB8_OES:
+		case GL_COMPRESSED_RGB8_ETC2:
+		case GL_COMPRESSED_RGB8_PUNCHTHROUGH_ALPHA1_ETC2:
+			return blocks * 8;
+		case GL_COMPRESSED_RGBA8_ETC2_EAC:
+			return blocks * 16;
+		default:
+			LogError("getCompressedImageSize: unknown format 0x%x", internalFormat);
+			return 0;
+	}
+}
+
+bool initCompressedTexture(GLuint* texture,GLuint width,GLuint height,GLenum internalFormat,GLsizei imageSize,const GLvoid* data,
+		const char* owner) {
+	if(imageSize != getCompressedImageSize(internalFormat,width,height)) {
+		LogError("initCompressedTexture: expected %d bytes, got %d", getCompressedImageSize(internalFormat,width,height), imageSize);
+		return false;
+	}
+	glGenTextures(1, texture);
+	glBindTexture(GL_TEXTURE_2D, *texture);
+	glCompressedTexImage2D(GL_TEXTURE_2D, 0, internalFormat, width, height, 0, imageSize, data);
+	if(glGetError() != GL_NO_ERROR) {
+		LogError("initCompressedTexture: format 0x%x rejected", internalFormat);
+		glDeleteTextures(1, texture);
+		*texture = 0;
+		return false;
+	}
+	gpuMemoryTrack(GPU_RESOURCE_TEXTURE, *texture, imageSize, owner);
+
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+	CheckGlError("initCompressedTexture: glTexParameteri");
+	return true;
+}
+
+GLuint getPixelSize(GLenum format,GLenum type) {
+	GLuint channels;
+	switch(format){
+		case GL_LUMINANCE:
+		case GL_ALPHA:
+			channels = 1;
+			break;
+		case GL_LUMINANCE_ALPHA:
+			channels = 2;
+			break;
+		case GL_RGBA:
+		case GL_BGRA_EXT:
+		case GL_SRGB_ALPHA_EXT:
+			channels = 4;
+			break;
+		case GL_RGB:
+		default:
+			channels = 3;
+			break;
+	}
+	switch(type){
+		case GL_UNSIGNED_SHORT_5_6_5:
+		case GL_UNSIGNED_SHORT_4_4_4_4:
+		case GL_UNSIGNED_SHORT_5_5_5_1:
+			return 2;
+		case GL_UNSIGNED_BYTE:
+		default:
+			return channels;
+	}
+}
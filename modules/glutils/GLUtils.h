@@ -10,12 +10,56 @@
 
 #include <EGL/egl.h>
 #include <GLES2/gl2.h>
+#include <string>
 #include "Framebuffer.h"
 
+#ifndef GL_ETC1_RGB8_OES
+#define GL_ETC1_RGB8_OES 0x8D64
+#endif
+#ifndef GL_COMPRESSED_RGB8_ETC2
+#define GL_COMPRESSED_RGB8_ETC2 0x9274
+#define GL_COMPRESSED_RGB8_PUNCHTHROUGH_ALPHA1_ETC2 0x9276
+#define GL_COMPRESSED_RGBA8_ETC2_EAC 0x9278
+#endif
+#ifndef GL_SRGB_ALPHA_EXT
+#define GL_SRGB_EXT 0x8C40
+#define GL_SRGB_ALPHA_EXT 0x8C42
+#endif
+#ifndef GL_BGRA_EXT
+#define GL_BGRA_EXT 0x80E1
+#endif
+#ifndef GL_UNPACK_ROW_LENGTH_EXT
+#define GL_UNPACK_ROW_LENGTH_EXT 0x0CF2
+#endif
+
 
 	GLuint createProgram( const char* pVertexPath, const char* pFragmentPath );
+	// defines: "NAME" or "NAME=VALUE" entries separated by ';'
+	GLuint createProgram( const char* pVertexPath, const char* pFragmentPath, const char* defines );
+	std::string injectDefines( const char* pSource, GLint sourceSize, const char* defines );
 	GLuint CompileShader( GLenum shaderType, const char* pSource , GLint* fileSize );
-	GLvoid* scalePointer(float ratio,GLvoid* inPointer,GLuint width,GLuint height,GLenum format,GLenum type);
-	void initTexture(GLuint* texture,GLuint width,GLuint height,GLenum format = GL_RGB,GLenum type = GL_UNSIGNED_BYTE,GLvoid* pixels = 0);
+	GLuint getPixelSize(GLenum format,GLenum type);
+	// owner names the texture in gpuMemoryLogReport (GpuMemory.h). Tightly
+	// packed rows, whatever GL_UNPACK_ALIGNMENT is set to.
+	void initTexture(GLuint* texture,GLuint width,GLuint height,GLenum format = GL_RGB,GLenum type = GL_UNSIGNED_BYTE,GLvoid* pixels = 0,
+			const char* owner = "texture");
+	// Rows start stride bytes apart, 0 meaning tightly packed. Strides
+	// GL_UNPACK_ALIGNMENT can step go straight to the driver, others through
+	// GL_EXT_unpack_subimage or, without it, a packed copy. A 0 *texture is
+	// made as initTexture does. The unpack state is left as it was.
+	void uploadTexture(GLuint* texture,GLuint width,GLuint height,GLenum format,GLenum type,const GLvoid* pixels,GLuint stride = 0,
+			const char* owner = "texture");
+	void uploadSubTexture(GLuint texture,GLint x,GLint y,GLuint width,GLuint height,GLenum format,GLenum type,const GLvoid* pixels,
+			GLuint stride = 0);
+	// Largest GL_UNPACK_ALIGNMENT that steps rows of rowBytes stride bytes apart, 0 if none does
+	GLint getUnpackAlignment(GLuint rowBytes,GLuint stride);
+	// glDeleteTextures for textures made by initTexture or initCompressedTexture; zeroes *texture
+	void deleteTexture(GLuint* texture);
+	// Whole-token match against GL_EXTENSIONS
+	bool isExtensionSupported(const char* name);
+	bool isCompressedFormatSupported(GLenum internalFormat);
+	GLsizei getCompressedImageSize(GLenum internalFormat,GLuint width,GLuint height);
+	bool initCompressedTexture(GLuint* texture,GLuint width,GLuint height,GLenum internalFormat,GLsizei imageSize,const GLvoid* data,
+			const char* owner = "compressed texture");
 
 #endif /* GLUTILS_H_ */
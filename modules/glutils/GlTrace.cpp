@@ -0,0 +1,807 @@
+/*
+ * GlTrace.cpp
+ *
+ *  Created on: 19-10-2026
+ */
+
+#include "GlTrace.h"
+#include "GLUtils.h"
+#include "Timing.h"
+#include "logger.h"
+
+#ifdef GLUTILS_TRACE
+
+#include <pthread.h>
+#include <stdio.h>
+#include <string.h>
+#include <algorithm>
+#include <string>
+#include <vector>
+#include <zlib.h>
+
+// Smaller payloads are stored as they are
+#define GLTRACE_COMPRESS_MIN 256
+// Gen and Delete calls with more names are split over several records
+#define GLTRACE_MAX_NAMES 255
+
+struct AttribState {
+	bool enabled;
+	GLint size;
+	GLenum type;
+	GLboolean normalized;
+	GLsizei stride;
+	const GLvoid* pointer;
+	GLuint buffer;
+};
+
+static pthread_mutex_t traceMutex = PTHREAD_MUTEX_INITIALIZER;
+static FILE* traceFile = NULL;
+static volatile bool active = false;
+static double startMs;
+static unsigned int calls,frames,maxFrames;
+static size_t payloadBytes,storedBytes;
+static std::vector<Bytef> compressed;
+
+// Client state the payload sizes depend on, tracked while not capturing too
+static GLint unpackAlignment = 4, unpackRowLength = 0;
+static GLuint arrayBuffer = 0, elementBuffer = 0;
+static AttribState attribs[GLTRACE_MAX_ATTRIBS];
+
+static void writeRecord(int op,double start,const GLuint* words,int wordCount,const void* payload = NULL,size_t size = 0) {
+	double end = nowMs();
+	pthread_mutex_lock(&traceMutex);
+	if(traceFile) {
+		uint16_t opcode = op;
+		uint8_t counts[2] = { (uint8_t)wordCount, (uint8_t)(payload != NULL) };
+		double ns = (end - start) * 1e6;
+		uint32_t times[2] = { (uint32_t)((start - startMs) * 1000.0), ns < 4e9 ? (uint32_t)ns : 0xffffffffu };
+		fwrite(&opcode,sizeof(opcode),1,traceFile);
+		fwrite(counts,1,2,traceFile);
+		fwrite(times,sizeof(uint32_t),2,traceFile);
+		fwrite(words,sizeof(GLuint),wordCount,traceFile);
+		if(payload) {
+			uint32_t sizes[2] = { (uint32_t)size, (uint32_t)size };
+			const void* data = payload;
+			if(size >= GLTRACE_COMPRESS_MIN) {
+				uLongf length = compressBound(size);
+				compressed.resize(length);
+				if(compress2(&compressed[0],&length,(const Bytef*)payload,size,Z_BEST_SPEED) == Z_OK && length < size) {
+					sizes[1] = length;
+					data = &compressed[0];
+				}
+			}
+			fwrite(sizes,sizeof(uint32_t),2,traceFile);
+			fwrite(data,1,sizes[1],traceFile);
+			payloadBytes += sizes[0];
+			storedBytes += sizes[1];
+		}
+		calls++;
+	}
+	pthread_mutex_unlock(&traceMutex);
+}
+
+static inline GLuint floatBits(GLfloat value) {
+	GLuint bits;
+	memcpy(&bits,&value,sizeof(bits));
+	return bits;
+}
+
+static size_t typeSize(GLenum type) {
+	switch(type) {
+		case GL_BYTE:
+		case GL_UNSIGNED_BYTE:
+			return 1;
+		case GL_SHORT:
+		case GL_UNSIGNED_SHORT:
+			return 2;
+		default:
+			return 4;
+	}
+}
+
+// Bytes glTexImage2D reads for width x height pixels with the current
+// GL_UNPACK_ALIGNMENT and GL_UNPACK_ROW_LENGTH_EXT
+static size_t imageSize(GLsizei width,GLsizei height,GLenum format,GLenum type) {
+	if(width <= 0 || height <= 0)
+		return 0;
+	if(format == GL_SRGB_ALPHA_EXT)
+		format = GL_RGBA;
+	else if(format == GL_SRGB_EXT)
+		format = GL_RGB;
+	size_t row = (size_t)width * getPixelSize(format,type);
+	size_t stride = (size_t)(unpackRowLength ? unpackRowLength : width) * getPixelSize(format,type);
+	stride = (stride + unpackAlignment - 1) / unpackAlignment * unpackAlignment;
+	return stride * (height - 1) + row;
+}
+
+static void writeNames(int op,double start,GLsizei n,const GLuint* names) {
+	for(GLsizei i=0;i<n;i+=GLTRACE_MAX_NAMES)
+		writeRecord(op,start,names + i,std::min(n - i,GLTRACE_MAX_NAMES));
+}
+
+// The vertices [0,vertexCount) of every enabled attribute read from client memory
+static void writeClientArrays(GLuint vertexCount) {
+	if(!vertexCount)
+		return;
+	for(GLuint i=0;i<GLTRACE_MAX_ATTRIBS;i++) {
+		const AttribState& a = attribs[i];
+		if(!a.enabled || a.buffer || !a.pointer)
+			continue;
+		size_t element = a.size * typeSize(a.type);
+		size_t stride = a.stride ? a.stride : element;
+		GLuint words[] = { i, (GLuint)a.size, a.type, a.normalized, (GLuint)stride };
+		writeRecord(GLTRACE_OP_ClientArray,nowMs(),words,5,a.pointer,(vertexCount - 1) * stride + element);
+	}
+}
+
+bool glTraceStart(const char* path,GLuint surfaceWidth,GLuint surfaceHeight,unsigned int frameLimit) {
+	pthread_mutex_lock(&traceMutex);
+	if(traceFile) {
+		pthread_mutex_unlock(&traceMutex);
+		LogError("glTraceStart: already capturing");
+		return false;
+	}
+	FILE* file = fopen(path,"wb");
+	if(!file) {
+		pthread_mutex_unlock(&traceMutex);
+		LogError("glTraceStart: cannot open %s",path);
+		return false;
+	}
+	uint32_t header[3] = { GLTRACE_VERSION, surfaceWidth, surfaceHeight };
+	fwrite(GLTRACE_MAGIC,1,4,file);
+	fwrite(header,sizeof(uint32_t),3,file);
+	traceFile = file;
+	startMs = nowMs();
+	calls = frames = 0;
+	maxFrames = frameLimit;
+	payloadBytes = storedBytes = 0;
+	active = true;
+	pthread_mutex_unlock(&traceMutex);
+	Log("GL trace: capturing to %s",path);
+	return true;
+}
+
+void glTraceStop() {
+	pthread_mutex_lock(&traceMutex);
+	if(!traceFile) {
+		pthread_mutex_unlock(&traceMutex);
+		return;
+	}
+	active = false;
+	fclose(traceFile);
+	traceFile = NULL;
+	std::vector<Bytef>().swap(compressed);
+	unsigned int callCount = calls, frameCount = frames;
+	size_t payload = payloadBytes, stored = storedBytes;
+	pthread_mutex_unlock(&traceMutex);
+	Log("GL trace: %u calls over %u frames, payloads %.2f MB stored in %.2f MB",callCount,frameCount,
+			payload / 1048576.0,stored / 1048576.0);
+}
+
+bool glTraceIsActive() {
+	return active;
+}
+
+void glTraceFrame() {
+	if(!active)
+		return;
+	writeRecord(GLTRACE_OP_Frame,nowMs(),NULL,0);
+	pthread_mutex_lock(&traceMutex);
+	frames++;
+	bool done = maxFrames && frames >= maxFrames;
+	pthread_mutex_unlock(&traceMutex);
+	if(done)
+		glTraceStop();
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+// Wrappers: the real call first, so its duration excludes the recording
+
+void glTraceActiveTexture(GLenum texture) {
+	double start = nowMs();
+	(glActiveTexture)(texture);
+	if(!active)
+		return;
+	GLuint words[] = { texture };
+	writeRecord(GLTRACE_OP_ActiveTexture,start,words,1);
+}
+
+void glTraceAttachShader(GLuint program,GLuint shader) {
+	double start = nowMs();
+	(glAttachShader)(program,shader);
+	if(!active)
+		return;
+	GLuint words[] = { program, shader };
+	writeRecord(GLTRACE_OP_AttachShader,start,words,2);
+}
+
+void glTraceBindAttribLocation(GLuint program,GLuint index,const GLchar* name) {
+	double start = nowMs();
+	(glBindAttribLocation)(program,index,name);
+	if(!active)
+		return;
+	GLuint words[] = { program, index };
+	writeRecord(GLTRACE_OP_BindAttribLocation,start,words,2,name,strlen(name) + 1);
+}
+
+void glTraceBindBuffer(GLenum target,GLuint buffer) {
+	double start = nowMs();
+	(glBindBuffer)(target,buffer);
+	if(target == GL_ARRAY_BUFFER)
+		arrayBuffer = buffer;
+	else if(target == GL_ELEMENT_ARRAY_BUFFER)
+		elementBuffer = buffer;
+	if(!active)
+		return;
+	GLuint words[] = { target, buffer };
+	writeRecord(GLTRACE_OP_BindBuffer,start,words,2);
+}
+
+void glTraceBindFramebuffer(GLenum target,GLuint framebuffer) {
+	double start = nowMs();
+	(glBindFramebuffer)(target,framebuffer);
+	if(!active)
+		return;
+	GLuint words[] = { target, framebuffer };
+	writeRecord(GLTRACE_OP_BindFramebuffer,start,words,2);
+}
+
+void glTraceBindRenderbuffer(GLenum target,GLuint renderbuffer) {
+	double start = nowMs();
+	(glBindRenderbuffer)(target,renderbuffer);
+	if(!active)
+		return;
+	GLuint words[] = { target, renderbuffer };
+	writeRecord(GLTRACE_OP_BindRenderbuffer,start,words,2);
+}
+
+void glTraceBindTexture(GLenum target,GLuint texture) {
+	double start = nowMs();
+	(glBindTexture)(target,texture);
+	if(!active)
+		return;
+	GLuint words[] = { target, texture };
+	writeRecord(GLTRACE_OP_BindTexture,start,words,2);
+}
+
+void glTraceBlendFunc(GLenum sfactor,GLenum dfactor) {
+	double start = nowMs();
+	(glBlendFunc)(sfactor,dfactor);
+	if(!active)
+		return;
+	GLuint words[] = { sfactor, dfactor };
+	writeRecord(GLTRACE_OP_BlendFunc,start,words,2);
+}
+
+void glTraceBufferData(GLenum target,GLsizeiptr size,const GLvoid* data,GLenum usage) {
+	double start = nowMs();
+	(glBufferData)(target,size,data,usage);
+	if(!active)
+		return;
+	GLuint words[] = { target, (GLuint)size, usage };
+	writeRecord(GLTRACE_OP_BufferData,start,words,3,data,size);
+}
+
+void glTraceBufferSubData(GLenum target,GLintptr offset,GLsizeiptr size,const GLvoid* data) {
+	double start = nowMs();
+	(glBufferSubData)(target,offset,size,data);
+	if(!active)
+		return;
+	GLuint words[] = { target, (GLuint)offset, (GLuint)size };
+	writeRecord(GLTRACE_OP_BufferSubData,start,words,3,data,size);
+}
+
+GLenum glTraceCheckFramebufferStatus(GLenum target) {
+	double start = nowMs();
+	GLenum status = (glCheckFramebufferStatus)(target);
+	if(active) {
+		GLuint words[] = { target, status };
+		writeRecord(GLTRACE_OP_CheckFramebufferStatus,start,words,2);
+	}
+	return status;
+}
+
+void glTraceClear(GLbitfield mask) {
+	double start = nowMs();
+	(glClear)(mask);
+	if(!active)
+		return;
+	GLuint words[] = { mask };
+	writeRecord(GLTRACE_OP_Clear,start,words,1);
+}
+
+void glTraceClearColor(GLclampf red,GLclampf green,GLclampf blue,GLclampf alpha) {
+	double start = nowMs();
+	(glClearColor)(red,green,blue,alpha);
+	if(!active)
+		return;
+	GLuint words[] = { floatBits(red), floatBits(green), floatBits(blue), floatBits(alpha) };
+	writeRecord(GLTRACE_OP_ClearColor,start,words,4);
+}
+
+void glTraceCompileShader(GLuint shader) {
+	double start = nowMs();
+	(glCompileShader)(shader);
+	if(!active)
+		return;
+	GLuint words[] = { shader };
+	writeRecord(GLTRACE_OP_CompileShader,start,words,1);
+}
+
+void glTraceCompressedTexImage2D(GLenum target,GLint level,GLenum internalformat,GLsizei width,GLsizei height,
+		GLint border,GLsizei imageSize,const GLvoid* data) {
+	double start = nowMs();
+	(glCompressedTexImage2D)(target,level,internalformat,width,height,border,imageSize,data);
+	if(!active)
+		return;
+	GLuint words[] = { target, (GLuint)level, internalformat, (GLuint)width, (GLuint)height, (GLuint)border };
+	writeRecord(GLTRACE_OP_CompressedTexImage2D,start,words,6,data,imageSize);
+}
+
+GLuint glTraceCreateProgram() {
+	double start = nowMs();
+	GLuint program = (glCreateProgram)();
+	if(active) {
+		GLuint words[] = { program };
+		writeRecord(GLTRACE_OP_CreateProgram,start,words,1);
+	}
+	return program;
+}
+
+GLuint glTraceCreateShader(GLenum type) {
+	double start = nowMs();
+	GLuint shader = (glCreateShader)(type);
+	if(active) {
+		GLuint words[] = { type, shader };
+		writeRecord(GLTRACE_OP_CreateShader,start,words,2);
+	}
+	return shader;
+}
+
+void glTraceDeleteBuffers(GLsizei n,const GLuint* buffers) {
+	double start = nowMs();
+	(glDeleteBuffers)(n,buffers);
+	for(GLsizei i=0;i<n;i++) {
+		if(buffers[i] == arrayBuffer)
+			arrayBuffer = 0;
+		if(buffers[i] == elementBuffer)
+			elementBuffer = 0;
+	}
+	if(active)
+		writeNames(GLTRACE_OP_DeleteBuffers,start,n,buffers);
+}
+
+void glTraceDeleteFramebuffers(GLsizei n,const GLuint* framebuffers) {
+	double start = nowMs();
+	(glDeleteFramebuffers)(n,framebuffers);
+	if(active)
+		writeNames(GLTRACE_OP_DeleteFramebuffers,start,n,framebuffers);
+}
+
+void glTraceDeleteProgram(GLuint program) {
+	double start = nowMs();
+	(glDeleteProgram)(program);
+	if(!active)
+		return;
+	GLuint words[] = { program };
+	writeRecord(GLTRACE_OP_DeleteProgram,start,words,1);
+}
+
+void glTraceDeleteRenderbuffers(GLsizei n,const GLuint* renderbuffers) {
+	double start = nowMs();
+	(glDeleteRenderbuffers)(n,renderbuffers);
+	if(active)
+		writeNames(GLTRACE_OP_DeleteRenderbuffers,start,n,renderbuffers);
+}
+
+void glTraceDeleteShader(GLuint shader) {
+	double start = nowMs();
+	(glDeleteShader)(shader);
+	if(!active)
+		return;
+	GLuint words[] = { shader };
+	writeRecord(GLTRACE_OP_DeleteShader,start,words,1);
+}
+
+void glTraceDeleteTextures(GLsizei n,const GLuint* textures) {
+	double start = nowMs();
+	(glDeleteTextures)(n,textures);
+	if(active)
+		writeNames(GLTRACE_OP_DeleteTextures,start,n,textures);
+}
+
+void glTraceDisable(GLenum cap) {
+	double start = nowMs();
+	(glDisable)(cap);
+	if(!active)
+		return;
+	GLuint words[] = { cap };
+	writeRecord(GLTRACE_OP_Disable,start,words,1);
+}
+
+void glTraceDisableVertexAttribArray(GLuint index) {
+	double start = nowMs();
+	(glDisableVertexAttribArray)(index);
+	if(index < GLTRACE_MAX_ATTRIBS)
+		attribs[index].enabled = false;
+	if(!active)
+		return;
+	GLuint words[] = { index };
+	writeRecord(GLTRACE_OP_DisableVertexAttribArray,start,words,1);
+}
+
+void glTraceDrawArrays(GLenum mode,GLint first,GLsizei count) {
+	double start = nowMs();
+	(glDrawArrays)(mode,first,count);
+	if(!active)
+		return;
+	writeClientArrays(count > 0 ? first + count : 0);
+	GLuint words[] = { mode, (GLuint)first, (GLuint)count };
+	writeRecord(GLTRACE_OP_DrawArrays,start,words,3);
+}
+
+void glTraceDrawElements(GLenum mode,GLsizei count,GLenum type,const GLvoid* indices) {
+	double start = nowMs();
+	(glDrawElements)(mode,count,type,indices);
+	if(!active)
+		return;
+	if(elementBuffer) {
+		// the indices stay on the GPU, so client arrays cannot be sized and are not recorded
+		GLuint words[] = { mode, (GLuint)count, type, (GLuint)(size_t)indices };
+		writeRecord(GLTRACE_OP_DrawElements,start,words,4);
+		return;
+	}
+	GLuint vertexCount = 0;
+	for(GLsizei i=0;i<count;i++) {
+		GLuint index = type == GL_UNSIGNED_BYTE ? ((const GLubyte*)indices)[i] : ((const GLushort*)indices)[i];
+		vertexCount = std::max(vertexCount,index + 1);
+	}
+	writeClientArrays(vertexCount);
+	GLuint words[] = { mode, (GLuint)count, type, 0 };
+	writeRecord(GLTRACE_OP_DrawElements,start,words,4,indices,count * typeSize(type));
+}
+
+void glTraceEnable(GLenum cap) {
+	double start = nowMs();
+	(glEnable)(cap);
+	if(!active)
+		return;
+	GLuint words[] = { cap };
+	writeRecord(GLTRACE_OP_Enable,start,words,1);
+}
+
+void glTraceEnableVertexAttribArray(GLuint index) {
+	double start = nowMs();
+	(glEnableVertexAttribArray)(index);
+	if(index < GLTRACE_MAX_ATTRIBS)
+		attribs[index].enabled = true;
+	if(!active)
+		return;
+	GLuint words[] = { index };
+	writeRecord(GLTRACE_OP_EnableVertexAttribArray,start,words,1);
+}
+
+void glTraceFinish() {
+	double start = nowMs();
+	(glFinish)();
+	if(active)
+		writeRecord(GLTRACE_OP_Finish,start,NULL,0);
+}
+
+void glTraceFlush() {
+	double start = nowMs();
+	(glFlush)();
+	if(active)
+		writeRecord(GLTRACE_OP_Flush,start,NULL,0);
+}
+
+void glTraceFramebufferRenderbuffer(GLenum target,GLenum attachment,GLenum renderbuffertarget,GLuint renderbuffer) {
+	double start = nowMs();
+	(glFramebufferRenderbuffer)(target,attachment,renderbuffertarget,renderbuffer);
+	if(!active)
+		return;
+	GLuint words[] = { target, attachment, renderbuffertarget, renderbuffer };
+	writeRecord(GLTRACE_OP_FramebufferRenderbuffer,start,words,4);
+}
+
+void glTraceFramebufferTexture2D(GLenum target,GLenum attachment,GLenum textarget,GLuint texture,GLint level) {
+	double start = nowMs();
+	(glFramebufferTexture2D)(target,attachment,textarget,texture,level);
+	if(!active)
+		return;
+	GLuint words[] = { target, attachment, textarget, texture, (GLuint)level };
+	writeRecord(GLTRACE_OP_FramebufferTexture2D,start,words,5);
+}
+
+void glTraceGenBuffers(GLsizei n,GLuint* buffers) {
+	double start = nowMs();
+	(glGenBuffers)(n,buffers);
+	if(active)
+		writeNames(GLTRACE_OP_GenBuffers,start,n,buffers);
+}
+
+void glTraceGenFramebuffers(GLsizei n,GLuint* framebuffers) {
+	double start = nowMs();
+	(glGenFramebuffers)(n,framebuffers);
+	if(active)
+		writeNames(GLTRACE_OP_GenFramebuffers,start,n,framebuffers);
+}
+
+void glTraceGenRenderbuffers(GLsizei n,GLuint* renderbuffers) {
+	double start = nowMs();
+	(glGenRenderbuffers)(n,renderbuffers);
+	if(active)
+		writeNames(GLTRACE_OP_GenRenderbuffers,start,n,renderbuffers);
+}
+
+void glTraceGenTextures(GLsizei n,GLuint* textures) {
+	double start = nowMs();
+	(glGenTextures)(n,textures);
+	if(active)
+		writeNames(GLTRACE_OP_GenTextures,start,n,textures);
+}
+
+GLint glTraceGetUniformLocation(GLuint program,const GLchar* name) {
+	double start = nowMs();
+	GLint location = (glGetUniformLocation)(program,name);
+	if(active) {
+		// replay maps the device's locations to its own
+		GLuint words[] = { program, (GLuint)location };
+		writeRecord(GLTRACE_OP_GetUniformLocation,start,words,2,name,strlen(name) + 1);
+	}
+	return location;
+}
+
+void glTraceLinkProgram(GLuint program) {
+	double start = nowMs();
+	(glLinkProgram)(program);
+	if(!active)
+		return;
+	GLuint words[] = { program };
+	writeRecord(GLTRACE_OP_LinkProgram,start,words,1);
+}
+
+void glTracePixelStorei(GLenum pname,GLint param) {
+	double start = nowMs();
+	(glPixelStorei)(pname,param);
+	if(pname == GL_UNPACK_ALIGNMENT)
+		unpackAlignment = param;
+	else if(pname == GL_UNPACK_ROW_LENGTH_EXT)
+		unpackRowLength = param;
+	if(!active)
+		return;
+	GLuint words[] = { pname, (GLuint)param };
+	writeRecord(GLTRACE_OP_PixelStorei,start,words,2);
+}
+
+void glTraceReadPixels(GLint x,GLint y,GLsizei width,GLsizei height,GLenum format,GLenum type,GLvoid* pixels) {
+	double start = nowMs();
+	(glReadPixels)(x,y,width,height,format,type,pixels);
+	if(!active)
+		return;
+	GLuint words[] = { (GLuint)x, (GLuint)y, (GLuint)width, (GLuint)height, format, type };
+	writeRecord(GLTRACE_OP_ReadPixels,start,words,6);
+}
+
+void glTraceRenderbufferStorage(GLenum target,GLenum internalformat,GLsizei width,GLsizei height) {
+	double start = nowMs();
+	(glRenderbufferStorage)(target,internalformat,width,height);
+	if(!active)
+		return;
+	GLuint words[] = { target, internalformat, (GLuint)width, (GLuint)height };
+	writeRecord(GLTRACE_OP_RenderbufferStorage,start,words,4);
+}
+
+void glTraceScissor(GLint x,GLint y,GLsizei width,GLsizei height) {
+	double start = nowMs();
+	(glScissor)(x,y,width,height);
+	if(!active)
+		return;
+	GLuint words[] = { (GLuint)x, (GLuint)y, (GLuint)width, (GLuint)height };
+	writeRecord(GLTRACE_OP_Scissor,start,words,4);
+}
+
+void glTraceShaderSource(GLuint shader,GLsizei count,const GLchar* const* string,const GLint* length) {
+	double start = nowMs();
+	// older NDK headers declare the strings without the inner const
+	(glShaderSource)(shader,count,(const GLchar**)string,length);
+	if(!active)
+		return;
+	std::string source;
+	for(GLsizei i=0;i<count;i++) {
+		if(length && length[i] >= 0)
+			source.append(string[i],length[i]);
+		else
+			source.append(string[i]);
+	}
+	GLuint words[] = { shader };
+	writeRecord(GLTRACE_OP_ShaderSource,start,words,1,source.c_str(),source.size() + 1);
+}
+
+void glTraceTexImage2D(GLenum target,GLint level,GLint internalformat,GLsizei width,GLsizei height,GLint border,
+		GLenum format,GLenum type,const GLvoid* pixels) {
+	double start = nowMs();
+	(glTexImage2D)(target,level,internalformat,width,height,border,format,type,pixels);
+	if(!active)
+		return;
+	GLuint words[] = { target, (GLuint)level, (GLuint)internalformat, (GLuint)width, (GLuint)height, (GLuint)border,
+			format, type, (GLuint)unpackAlignment };
+	writeRecord(GLTRACE_OP_TexImage2D,start,words,9,pixels,pixels ? imageSize(width,height,format,type) : 0);
+}
+
+void glTraceTexParameteri(GLenum target,GLenum pname,GLint param) {
+	double start = nowMs();
+	(glTexParameteri)(target,pname,param);
+	if(!active)
+		return;
+	GLuint words[] = { target, pname, (GLuint)param };
+	writeRecord(GLTRACE_OP_TexParameteri,start,words,3);
+}
+
+void glTraceTexSubImage2D(GLenum target,GLint level,GLint xoffset,GLint yoffset,GLsizei width,GLsizei height,
+		GLenum format,GLenum type,const GLvoid* pixels) {
+	double start = nowMs();
+	(glTexSubImage2D)(target,level,xoffset,yoffset,width,height,format,type,pixels);
+	if(!active)
+		return;
+	GLuint words[] = { target, (GLuint)level, (GLuint)xoffset, (GLuint)yoffset, (GLuint)width, (GLuint)height,
+			format, type, (GLuint)unpackAlignment };
+	writeRecord(GLTRACE_OP_TexSubImage2D,start,words,9,pixels,imageSize(width,height,format,type));
+}
+
+void glTraceUniform1i(GLint location,GLint x) {
+	double start = nowMs();
+	(glUniform1i)(location,x);
+	if(!active)
+		return;
+	GLuint words[] = { (GLuint)location, (GLuint)x };
+	writeRecord(GLTRACE_OP_Uniform1i,start,words,2);
+}
+
+void glTraceUniform2f(GLint location,GLfloat x,GLfloat y) {
+	double start = nowMs();
+	(glUniform2f)(location,x,y);
+	if(!active)
+		return;
+	GLuint words[] = { (GLuint)location, floatBits(x), floatBits(y) };
+	writeRecord(GLTRACE_OP_Uniform2f,start,words,3);
+}
+
+// location, count; payload the values
+static void writeUniform(int op,double start,GLint location,GLsizei count,const void* values,size_t valueSize) {
+	GLuint words[] = { (GLuint)location, (GLuint)count };
+	writeRecord(op,start,words,2,values,count * valueSize);
+}
+
+void glTraceUniform1fv(GLint location,GLsizei count,const GLfloat* v) {
+	double start = nowMs();
+	(glUniform1fv)(location,count,v);
+	if(active)
+		writeUniform(GLTRACE_OP_Uniform1fv,start,location,count,v,sizeof(GLfloat));
+}
+
+void glTraceUniform2fv(GLint location,GLsizei count,const GLfloat* v) {
+	double start = nowMs();
+	(glUniform2fv)(location,count,v);
+	if(active)
+		writeUniform(GLTRACE_OP_Uniform2fv,start,location,count,v,2 * sizeof(GLfloat));
+}
+
+void glTraceUniform3fv(GLint location,GLsizei count,const GLfloat* v) {
+	double start = nowMs();
+	(glUniform3fv)(location,count,v);
+	if(active)
+		writeUniform(GLTRACE_OP_Uniform3fv,start,location,count,v,3 * sizeof(GLfloat));
+}
+
+void glTraceUniform4fv(GLint location,GLsizei count,const GLfloat* v) {
+	double start = nowMs();
+	(glUniform4fv)(location,count,v);
+	if(active)
+		writeUniform(GLTRACE_OP_Uniform4fv,start,location,count,v,4 * sizeof(GLfloat));
+}
+
+void glTraceUniform1iv(GLint location,GLsizei count,const GLint* v) {
+	double start = nowMs();
+	(glUniform1iv)(location,count,v);
+	if(active)
+		writeUniform(GLTRACE_OP_Uniform1iv,start,location,count,v,sizeof(GLint));
+}
+
+void glTraceUniform2iv(GLint location,GLsizei count,const GLint* v) {
+	double start = nowMs();
+	(glUniform2iv)(location,count,v);
+	if(active)
+		writeUniform(GLTRACE_OP_Uniform2iv,start,location,count,v,2 * sizeof(GLint));
+}
+
+void glTraceUniform3iv(GLint location,GLsizei count,const GLint* v) {
+	double start = nowMs();
+	(glUniform3iv)(location,count,v);
+	if(active)
+		writeUniform(GLTRACE_OP_Uniform3iv,start,location,count,v,3 * sizeof(GLint));
+}
+
+void glTraceUniform4iv(GLint location,GLsizei count,const GLint* v) {
+	double start = nowMs();
+	(glUniform4iv)(location,count,v);
+	if(active)
+		writeUniform(GLTRACE_OP_Uniform4iv,start,location,count,v,4 * sizeof(GLint));
+}
+
+// location, count, transpose; payload the matrices
+static void writeUniformMatrix(int op,double start,GLint location,GLsizei count,GLboolean transpose,const GLfloat* value,int size) {
+	GLuint words[] = { (GLuint)location, (GLuint)count, transpose };
+	writeRecord(op,start,words,3,value,count * size * size * sizeof(GLfloat));
+}
+
+void glTraceUniformMatrix2fv(GLint location,GLsizei count,GLboolean transpose,const GLfloat* value) {
+	double start = nowMs();
+	(glUniformMatrix2fv)(location,count,transpose,value);
+	if(active)
+		writeUniformMatrix(GLTRACE_OP_UniformMatrix2fv,start,location,count,transpose,value,2);
+}
+
+void glTraceUniformMatrix3fv(GLint location,GLsizei count,GLboolean transpose,const GLfloat* value) {
+	double start = nowMs();
+	(glUniformMatrix3fv)(location,count,transpose,value);
+	if(active)
+		writeUniformMatrix(GLTRACE_OP_UniformMatrix3fv,start,location,count,transpose,value,3);
+}
+
+void glTraceUniformMatrix4fv(GLint location,GLsizei count,GLboolean transpose,const GLfloat* value) {
+	double start = nowMs();
+	(glUniformMatrix4fv)(location,count,transpose,value);
+	if(active)
+		writeUniformMatrix(GLTRACE_OP_UniformMatrix4fv,start,location,count,transpose,value,4);
+}
+
+void glTraceUseProgram(GLuint program) {
+	double start = nowMs();
+	(glUseProgram)(program);
+	if(!active)
+		return;
+	GLuint words[] = { program };
+	writeRecord(GLTRACE_OP_UseProgram,start,words,1);
+}
+
+void glTraceVertexAttribPointer(GLuint index,GLint size,GLenum type,GLboolean normalized,GLsizei stride,const GLvoid* ptr) {
+	double start = nowMs();
+	(glVertexAttribPointer)(index,size,type,normalized,stride,ptr);
+	if(index < GLTRACE_MAX_ATTRIBS) {
+		AttribState state = { attribs[index].enabled, size, type, normalized, stride, ptr, arrayBuffer };
+		attribs[index] = state;
+	}
+	// client memory is recorded by the draws that read it
+	if(!active || !arrayBuffer)
+		return;
+	GLuint words[] = { index, (GLuint)size, type, normalized, (GLuint)stride, (GLuint)(size_t)ptr };
+	writeRecord(GLTRACE_OP_VertexAttribPointer,start,words,6);
+}
+
+void glTraceViewport(GLint x,GLint y,GLsizei width,GLsizei height) {
+	double start = nowMs();
+	(glViewport)(x,y,width,height);
+	if(!active)
+		return;
+	GLuint words[] = { (GLuint)x, (GLuint)y, (GLuint)width, (GLuint)height };
+	writeRecord(GLTRACE_OP_Viewport,start,words,4);
+}
+
+#else
+
+bool glTraceStart(const char*,GLuint,GLuint,unsigned int) {
+	return false;
+}
+
+void glTraceStop() {
+}
+
+bool glTraceIsActive() {
+	return false;
+}
+
+void glTraceFrame() {
+}
+
+#endif /* GLUTILS_TRACE */
@@ -0,0 +1,265 @@
+/*
+ * GlTrace.h
+ *
+ *  Created on: 19-10-2026
+ */
+
+#ifndef GLTRACE_H_
+#define GLTRACE_H_
+
+#include <GLES2/gl2.h>
+#include <stdint.h>
+
+/*
+ * GL command capture for offline analysis. Built with ndk-build
+ * GLUTILS_TRACE=1, every glutils and scale-buffer translation unit includes
+ * this header first (see modules/glutils/Android.mk) and the GL entry points
+ * listed at the end are routed through recording wrappers. Between
+ * glTraceStart and glTraceStop each call is written to a binary trace with
+ * its time on the device; texture, buffer, shader and client vertex array
+ * payloads go along, zlib compressed. tools/glreplay re-executes a trace on
+ * a headless context and times every call.
+ *
+ * The trace holds no initial state, so capture has to start before the
+ * objects it uses are made (with the context). Queries (glGet*) are not
+ * recorded, their results show up in the calls that follow. Calls from
+ * threads sharing the context (ShaderVariantCache) are serialized into the
+ * same trace. Without GLUTILS_TRACE nothing is redirected and glTraceStart
+ * returns false.
+ */
+
+bool glTraceStart(const char* path,GLuint surfaceWidth,GLuint surfaceHeight,unsigned int maxFrames = 0);
+void glTraceStop();
+bool glTraceIsActive();
+// Marks the end of a frame, after eglSwapBuffers; stops after maxFrames
+void glTraceFrame();
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+// File format, little endian as written by the device
+//
+// header:	"GLTR", uint32 version, uint32 surface width, uint32 surface height
+// record:	uint16 op, uint8 word count, uint8 has payload,
+//			uint32 microseconds since glTraceStart, uint32 nanoseconds the call took,
+//			uint32 words[word count] (GL arguments and returned names, floats as bits),
+//			payload: uint32 size, uint32 stored size, bytes[stored size], zlib
+//			compressed unless the stored size equals the size
+
+#define GLTRACE_MAGIC "GLTR"
+#define GLTRACE_VERSION 1
+#define GLTRACE_MAX_ATTRIBS 16
+
+#define GLTRACE_OPS(X) \
+	X(Frame)	/* end of frame marker */ \
+	X(ClientArray)	/* index, size, type, normalized, stride; payload the vertices of the next draw */ \
+	X(ActiveTexture) \
+	X(AttachShader) \
+	X(BindAttribLocation) \
+	X(BindBuffer) \
+	X(BindFramebuffer) \
+	X(BindRenderbuffer) \
+	X(BindTexture) \
+	X(BlendFunc) \
+	X(BufferData) \
+	X(BufferSubData) \
+	X(CheckFramebufferStatus) \
+	X(Clear) \
+	X(ClearColor) \
+	X(CompileShader) \
+	X(CompressedTexImage2D) \
+	X(CreateProgram) \
+	X(CreateShader) \
+	X(DeleteBuffers) \
+	X(DeleteFramebuffers) \
+	X(DeleteProgram) \
+	X(DeleteRenderbuffers) \
+	X(DeleteShader) \
+	X(DeleteTextures) \
+	X(Disable) \
+	X(DisableVertexAttribArray) \
+	X(DrawArrays) \
+	X(DrawElements) \
+	X(Enable) \
+	X(EnableVertexAttribArray) \
+	X(Finish) \
+	X(Flush) \
+	X(FramebufferRenderbuffer) \
+	X(FramebufferTexture2D) \
+	X(GenBuffers) \
+	X(GenFramebuffers) \
+	X(GenRenderbuffers) \
+	X(GenTextures) \
+	X(GetUniformLocation) \
+	X(LinkProgram) \
+	X(PixelStorei) \
+	X(ReadPixels) \
+	X(RenderbufferStorage) \
+	X(Scissor) \
+	X(ShaderSource) \
+	X(TexImage2D) \
+	X(TexParameteri) \
+	X(TexSubImage2D) \
+	X(Uniform1i) \
+	X(Uniform2f) \
+	X(Uniform1fv) \
+	X(Uniform2fv) \
+	X(Uniform3fv) \
+	X(Uniform4fv) \
+	X(Uniform1iv) \
+	X(Uniform2iv) \
+	X(Uniform3iv) \
+	X(Uniform4iv) \
+	X(UniformMatrix2fv) \
+	X(UniformMatrix3fv) \
+	X(UniformMatrix4fv) \
+	X(UseProgram) \
+	X(VertexAttribPointer) \
+	X(Viewport)
+
+#define GLTRACE_OP_ENUM(name) GLTRACE_OP_##name,
+enum GlTraceOp {
+	GLTRACE_OP_NONE,
+	GLTRACE_OPS(GLTRACE_OP_ENUM)
+	GLTRACE_OP_COUNT
+};
+#undef GLTRACE_OP_ENUM
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+// Recording wrappers
+
+#ifdef GLUTILS_TRACE
+
+void glTraceActiveTexture(GLenum texture);
+void glTraceAttachShader(GLuint program,GLuint shader);
+void glTraceBindAttribLocation(GLuint program,GLuint index,const GLchar* name);
+void glTraceBindBuffer(GLenum target,GLuint buffer);
+void glTraceBindFramebuffer(GLenum target,GLuint framebuffer);
+void glTraceBindRenderbuffer(GLenum target,GLuint renderbuffer);
+void glTraceBindTexture(GLenum target,GLuint texture);
+void glTraceBlendFunc(GLenum sfactor,GLenum dfactor);
+void glTraceBufferData(GLenum target,GLsizeiptr size,const GLvoid* data,GLenum usage);
+void glTraceBufferSubData(GLenum target,GLintptr offset,GLsizeiptr size,const GLvoid* data);
+GLenum glTraceCheckFramebufferStatus(GLenum target);
+void glTraceClear(GLbitfield mask);
+void glTraceClearColor(GLclampf red,GLclampf green,GLclampf blue,GLclampf alpha);
+void glTraceCompileShader(GLuint shader);
+void glTraceCompressedTexImage2D(GLenum target,GLint level,GLenum internalformat,GLsizei width,GLsizei height,
+		GLint border,GLsizei imageSize,const GLvoid* data);
+GLuint glTraceCreateProgram();
+GLuint glTraceCreateShader(GLenum type);
+void glTraceDeleteBuffers(GLsizei n,const GLuint* buffers);
+void glTraceDeleteFramebuffers(GLsizei n,const GLuint* framebuffers);
+void glTraceDeleteProgram(GLuint program);
+void glTraceDeleteRenderbuffers(GLsizei n,const GLuint* renderbuffers);
+void glTraceDeleteShader(GLuint shader);
+void glTraceDeleteTextures(GLsizei n,const GLuint* textures);
+void glTraceDisable(GLenum cap);
+void glTraceDisableVertexAttribArray(GLuint index);
+void glTraceDrawArrays(GLenum mode,GLint first,GLsizei count);
+void glTraceDrawElements(GLenum mode,GLsizei count,GLenum type,const GLvoid* indices);
+void glTraceEnable(GLenum cap);
+void glTraceEnableVertexAttribArray(GLuint index);
+void glTraceFinish();
+void glTraceFlush();
+void glTraceFramebufferRenderbuffer(GLenum target,GLenum attachment,GLenum renderbuffertarget,GLuint renderbuffer);
+void glTraceFramebufferTexture2D(GLenum target,GLenum attachment,GLenum textarget,GLuint texture,GLint level);
+void glTraceGenBuffers(GLsizei n,GLuint* buffers);
+void glTraceGenFramebuffers(GLsizei n,GLuint* framebuffers);
+void glTraceGenRenderbuffers(GLsizei n,GLuint* renderbuffers);
+void glTraceGenTextures(GLsizei n,GLuint* textures);
+GLint glTraceGetUniformLocation(GLuint program,const GLchar* name);
+void glTraceLinkProgram(GLuint program);
+void glTracePixelStorei(GLenum pname,GLint param);
+void glTraceReadPixels(GLint x,GLint y,GLsizei width,GLsizei height,GLenum format,GLenum type,GLvoid* pixels);
+void glTraceRenderbufferStorage(GLenum target,GLenum internalformat,GLsizei width,GLsizei height);
+void glTraceScissor(GLint x,GLint y,GLsizei width,GLsizei height);
+void glTraceShaderSource(GLuint shader,GLsizei count,const GLchar* const* string,const GLint* length);
+void glTraceTexImage2D(GLenum target,GLint level,GLint internalformat,GLsizei width,GLsizei height,GLint border,
+		GLenum format,GLenum type,const GLvoid* pixels);
+void glTraceTexParameteri(GLenum target,GLenum pname,GLint param);
+void glTraceTexSubImage2D(GLenum target,GLint level,GLint xoffset,GLint yoffset,GLsizei width,GLsizei height,
+		GLenum format,GLenum type,const GLvoid* pixels);
+void glTraceUniform1i(GLint location,GLint x);
+void glTraceUniform2f(GLint location,GLfloat x,GLfloat y);
+void glTraceUniform1fv(GLint location,GLsizei count,const GLfloat* v);
+void glTraceUniform2fv(GLint location,GLsizei count,const GLfloat* v);
+void glTraceUniform3fv(GLint location,GLsizei count,const GLfloat* v);
+void glTraceUniform4fv(GLint location,GLsizei count,const GLfloat* v);
+void glTraceUniform1iv(GLint location,GLsizei count,const GLint* v);
+void glTraceUniform2iv(GLint location,GLsizei count,const GLint* v);
+void glTraceUniform3iv(GLint location,GLsizei count,const GLint* v);
+void glTraceUniform4iv(GLint location,GLsizei count,const GLint* v);
+void glTraceUniformMatrix2fv(GLint location,GLsizei count,GLboolean transpose,const GLfloat* value);
+void glTraceUniformMatrix3fv(GLint location,GLsizei count,GLboolean transpose,const GLfloat* value);
+void glTraceUniformMatrix4fv(GLint location,GLsizei count,GLboolean transpose,const GLfloat* value);
+void glTraceUseProgram(GLuint program);
+void glTraceVertexAttribPointer(GLuint index,GLint size,GLenum type,GLboolean normalized,GLsizei stride,const GLvoid* ptr);
+void glTraceViewport(GLint x,GLint y,GLsizei width,GLsizei height);
+
+// Function-like, so (glTexImage2D)(...) still reaches the real entry point
+#define glActiveTexture(...) glTraceActiveTexture(__VA_ARGS__)
+#define glAttachShader(...) glTraceAttachShader(__VA_ARGS__)
+#define glBindAttribLocation(...) glTraceBindAttribLocation(__VA_ARGS__)
+#define glBindBuffer(...) glTraceBindBuffer(__VA_ARGS__)
+#define glBindFramebuffer(...) glTraceBindFramebuffer(__VA_ARGS__)
+#define glBindRenderbuffer(...) glTraceBindRenderbuffer(__VA_ARGS__)
+#define glBindTexture(...) glTraceBindTexture(__VA_ARGS__)
+#define glBlendFunc(...) glTraceBlendFunc(__VA_ARGS__)
+#define glBufferData(...) glTraceBufferData(__VA_ARGS__)
+#define glBufferSubData(...) glTraceBufferSubData(__VA_ARGS__)
+#define glCheckFramebufferStatus(...) glTraceCheckFramebufferStatus(__VA_ARGS__)
+#define glClear(...) glTraceClear(__VA_ARGS__)
+#define glClearColor(...) glTraceClearColor(__VA_ARGS__)
+#define glCompileShader(...) glTraceCompileShader(__VA_ARGS__)
+#define glCompressedTexImage2D(...) glTraceCompressedTexImage2D(__VA_ARGS__)
+#define glCreateProgram(...) glTraceCreateProgram(__VA_ARGS__)
+#define glCreateShader(...) glTraceCreateShader(__VA_ARGS__)
+#define glDeleteBuffers(...) glTraceDeleteBuffers(__VA_ARGS__)
+#define glDeleteFramebuffers(...) glTraceDeleteFramebuffers(__VA_ARGS__)
+#define glDeleteProgram(...) glTraceDeleteProgram(__VA_ARGS__)
+#define glDeleteRenderbuffers(...) glTraceDeleteRenderbuffers(__VA_ARGS__)
+#define glDeleteShader(...) glTraceDeleteShader(__VA_ARGS__)
+#define glDeleteTextures(...) glTraceDeleteTextures(__VA_ARGS__)
+#define glDisable(...) glTraceDisable(__VA_ARGS__)
+#define glDisableVertexAttribArray(...) glTraceDisableVertexAttribArray(__VA_ARGS__)
+#define glDrawArrays(...) glTraceDrawArrays(__VA_ARGS__)
+#define glDrawElements(...) glTraceDrawElements(__VA_ARGS__)
+#define glEnable(...) glTraceEnable(__VA_ARGS__)
+#define glEnableVertexAttribArray(...) glTraceEnableVertexAttribArray(__VA_ARGS__)
+#define glFinish(...) glTraceFinish(__VA_ARGS__)
+#define glFlush(...) glTraceFlush(__VA_ARGS__)
+#define glFramebufferRenderbuffer(...) glTraceFramebufferRenderbuffer(__VA_ARGS__)
+#define glFramebufferTexture2D(...) glTraceFramebufferTexture2D(__VA_ARGS__)
+#define glGenBuffers(...) glTraceGenBuffers(__VA_ARGS__)
+#define glGenFramebuffers(...) glTraceGenFramebuffers(__VA_ARGS__)
+#define glGenRenderbuffers(...) glTraceGenRenderbuffers(__VA_ARGS__)
+#define glGenTextures(...) glTraceGenTextures(__VA_ARGS__)
+#define glGetUniformLocation(...) glTraceGetUniformLocation(__VA_ARGS__)
+#define glLinkProgram(...) glTraceLinkProgram(__VA_ARGS__)
+#define glPixelStorei(...) glTracePixelStorei(__VA_ARGS__)
+#define glReadPixels(...) glTraceReadPixels(__VA_ARGS__)
+#define glRenderbufferStorage(...) glTraceRenderbufferStorage(__VA_ARGS__)
+#define glScissor(...) glTraceScissor(__VA_ARGS__)
+#define glShaderSource(...) glTraceShaderSource(__VA_ARGS__)
+#define glTexImage2D(...) glTraceTexImage2D(__VA_ARGS__)
+#define glTexParameteri(...) glTraceTexParameteri(__VA_ARGS__)
+#define glTexSubImage2D(...) glTraceTexSubImage2D(__VA_ARGS__)
+#define glUniform1i(...) glTraceUniform1i(__VA_ARGS__)
+#define glUniform2f(...) glTraceUniform2f(__VA_ARGS__)
+#define glUniform1fv(...) glTraceUniform1fv(__VA_ARGS__)
+#define glUniform2fv(...) glTraceUniform2fv(__VA_ARGS__)
+#define glUniform3fv(...) glTraceUniform3fv(__VA_ARGS__)
+#define glUniform4fv(...) glTraceUniform4fv(__VA_ARGS__)
+#define glUniform1iv(...) glTraceUniform1iv(__VA_ARGS__)
+#define glUniform2iv(...) glTraceUniform2iv(__VA_ARGS__)
+#define glUniform3iv(...) glTraceUniform3iv(__VA_ARGS__)
+#define glUniform4iv(...) glTraceUniform4iv(__VA_ARGS__)
+#define glUniformMatrix2fv(...) glTraceUniformMatrix2fv(__VA_ARGS__)
+#define glUniformMatrix3fv(...) glTraceUniformMatrix3fv(__VA_ARGS__)
+#define glUniformMatrix4fv(...) glTraceUniformMatrix4fv(__VA_ARGS__)
+#define glUseProgram(...) glTraceUseProgram(__VA_ARGS__)
+#define glVertexAttribPointer(...) glTraceVertexAttribPointer(__VA_ARGS__)
+#define glViewport(...) glTraceViewport(__VA_ARGS__)
+
+#endif /* GLUTILS_TRACE */
+
+#endif /* GLTRACE_H_ */
@@ -0,0 +1,171 @@
+/*
+ * GpuMemory.cpp
+ *
+ *  Created on: 19-10-2026
+ */
+
+#include "GpuMemory.h"
+#include "GLUtils.h"
+#include "logger.h"
+#include <algorithm>
+#include <map>
+#include <string>
+#include <utility>
+#include <vector>
+
+struct GpuAllocation {
+	size_t bytes;
+	const char* owner;
+};
+
+struct GpuEvictor {
+	GpuMemoryEvictor evict;
+	void* context;
+};
+
+typedef std::map<std::pair<int,GLuint>,GpuAllocation> AllocationMap;
+
+static AllocationMap allocations;
+static std::vector<GpuEvictor> evictors;
+static size_t used = 0;
+static size_t peak = 0;
+static size_t budget = (size_t)GPU_MEMORY_BUDGET_MB << 20;
+static unsigned int rejections = 0;
+static bool evicting = false;
+
+static const char* kindNames[] = { "texture", "renderbuffer", "framebuffer", "buffer" };
+
+void gpuMemoryTrack(GpuResourceKind kind,GLuint name,size_t bytes,const char* owner) {
+	if(!name)
+		return;
+	GpuAllocation& allocation = allocations[std::make_pair((int)kind,name)];
+	// a new record is zeroed by the map
+	used -= allocation.bytes;
+	allocation.bytes = bytes;
+	allocation.owner = owner ? owner : "unknown";
+	used += bytes;
+	if(used > peak)
+		peak = used;
+}
+
+void gpuMemoryRelease(GpuResourceKind kind,GLuint name) {
+	AllocationMap::iterator it = allocations.find(std::make_pair((int)kind,name));
+	if(it == allocations.end())
+		return;
+	used -= it->second.bytes;
+	allocations.erase(it);
+}
+
+size_t gpuMemoryGetSize(GpuResourceKind kind,GLuint name) {
+	AllocationMap::const_iterator it = allocations.find(std::make_pair((int)kind,name));
+	return it == allocations.end() ? 0 : it->second.bytes;
+}
+
+size_t gpuMemoryGetTextureSize(GLuint width,GLuint height,GLenum format,GLenum type) {
+	// same storage as their linear counterparts
+	if(format == GL_SRGB_ALPHA_EXT)
+		format = GL_RGBA;
+	else if(format == GL_SRGB_EXT)
+		format = GL_RGB;
+	return (size_t)width * height * getPixelSize(format,type);
+}
+
+size_t gpuMemoryGetRenderbufferSize(GLuint width,GLuint height,GLenum internalFormat) {
+	size_t pixelSize;
+	switch(internalFormat) {
+		case GL_STENCIL_INDEX8:
+			pixelSize = 1;
+			break;
+		case GL_RGB565:
+		case GL_RGBA4:
+		case GL_RGB5_A1:
+		case GL_DEPTH_COMPONENT16:
+			pixelSize = 2;
+			break;
+		default:
+			// 8 bit color and 24 bit depth formats come from extensions, 4 bytes either way
+			pixelSize = 4;
+			break;
+	}
+	return (size_t)width * height * pixelSize;
+}
+
+bool gpuMemoryReserve(size_t bytes,size_t released) {
+	if(!budget)
+		return true;
+	size_t after = used - std::min(released,used);
+	if(after + bytes <= budget)
+		return true;
+	// an evictor freeing its pool may call back in through Framebuffer's destructor
+	if(!evicting) {
+		evicting = true;
+		for(unsigned int i=0;i<evictors.size() && after + bytes > budget;i++) {
+			evictors[i].evict(evictors[i].context,after + bytes - budget);
+			after = used - std::min(released,used);
+		}
+		evicting = false;
+	}
+	if(after + bytes <= budget)
+		return true;
+	rejections++;
+	LogDebug("gpuMemoryReserve: %u KB refused, %u KB in use, budget %u KB",
+			(unsigned int)(bytes >> 10),(unsigned int)(after >> 10),(unsigned int)(budget >> 10));
+	return false;
+}
+
+void gpuMemoryAddEvictor(GpuMemoryEvictor evict,void* context) {
+	GpuEvictor evictor = { evict, context };
+	evictors.push_back(evictor);
+}
+
+void gpuMemoryRemoveEvictor(void* context) {
+	for(unsigned int i=0;i<evictors.size();) {
+		if(evictors[i].context == context)
+			evictors.erase(evictors.begin() + i);
+		else
+			i++;
+	}
+}
+
+void gpuMemorySetBudget(size_t bytes) {
+	budget = bytes;
+}
+
+size_t gpuMemoryGetBudget() {
+	return budget;
+}
+
+size_t gpuMemoryGetUsed() {
+	return used;
+}
+
+size_t gpuMemoryGetPeak() {
+	return peak;
+}
+
+void gpuMemoryResetPeak() {
+	peak = used;
+}
+
+unsigned int gpuMemoryGetRejections() {
+	return rejections;
+}
+
+struct OwnerTotal {
+	unsigned int count;
+	size_t bytes;
+};
+
+void gpuMemoryLogReport(const char* name) {
+	std::map<std::string,OwnerTotal> owners;
+	for(AllocationMap::const_iterator it = allocations.begin(); it != allocations.end(); ++it) {
+		std::string key = std::string(it->second.owner) + " " + kindNames[it->first.first];
+		OwnerTotal& total = owners[key];
+		total.count++;
+		total.bytes += it->second.bytes;
+	}
+	for(std::map<std::string,OwnerTotal>::const_iterator it = owners.begin(); it != owners.end(); ++it)
+		Log("%s: %s x%u, %.1f KB",name,it->first.c_str(),it->second.count,it->second.bytes / 1024.0);
+	Log("%s: %u resources, %.2f MB in use, peak %.2f MB, budget %.0f MB, %u refused",name,(unsigned int)allocations.size(),
+			used / 1048576.0,peak / 1048576.0,budget / 1048576.0,rejections);
+}
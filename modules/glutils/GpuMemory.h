@@ -0,0 +1,70 @@
+/*
+ * GpuMemory.h
+ *
+ *  Created on: 19-10-2026
+ */
+
+#ifndef GPUMEMORY_H_
+#define GPUMEMORY_H_
+
+#include <GLES2/gl2.h>
+#include <stddef.h>
+
+/*
+ * Bookkeeping for the GPU memory held by textures, renderbuffers,
+ * framebuffers and buffer objects. GLES2 cannot report what the driver
+ * really allocates, so sizes are estimated from dimensions and format (no
+ * padding, no mipmaps); what matters is that every allocation made through
+ * initTexture, initCompressedTexture, Framebuffer and SpriteBatch is
+ * recorded with its owner.
+ *
+ * The budget is advisory: gpuMemoryReserve is asked before large allocations
+ * and lets the caller fall back (Scene::scaleTexture scales on the CPU).
+ * GL thread only, like the resources themselves.
+ */
+
+// Default budget, ndk-build GPU_MEMORY_BUDGET_MB=... to change; 0 is unlimited
+#ifndef GPU_MEMORY_BUDGET_MB
+#define GPU_MEMORY_BUDGET_MB 256
+#endif
+
+enum GpuResourceKind {
+	GPU_RESOURCE_TEXTURE,
+	GPU_RESOURCE_RENDERBUFFER,
+	GPU_RESOURCE_FRAMEBUFFER,		// the object only, attachments are counted on their own
+	GPU_RESOURCE_BUFFER,
+	GPU_RESOURCE_KIND_COUNT
+};
+
+// Frees pooled resources the owner can rebuild on demand; returns the bytes released
+typedef size_t (*GpuMemoryEvictor)(void* context,size_t bytes);
+
+// Records name, replacing an earlier record of it (glTexImage2D on a live texture).
+// owner must outlive the record, string literals are expected.
+void gpuMemoryTrack(GpuResourceKind kind,GLuint name,size_t bytes,const char* owner);
+void gpuMemoryRelease(GpuResourceKind kind,GLuint name);
+// Recorded size of name, 0 if untracked
+size_t gpuMemoryGetSize(GpuResourceKind kind,GLuint name);
+
+size_t gpuMemoryGetTextureSize(GLuint width,GLuint height,GLenum format,GLenum type);
+size_t gpuMemoryGetRenderbufferSize(GLuint width,GLuint height,GLenum internalFormat);
+
+// True if bytes more fit the budget once released bytes are freed by the
+// caller. Pooled resources are evicted first when they do not; a refusal is
+// counted in gpuMemoryGetRejections.
+bool gpuMemoryReserve(size_t bytes,size_t released = 0);
+void gpuMemoryAddEvictor(GpuMemoryEvictor evictor,void* context);
+void gpuMemoryRemoveEvictor(void* context);
+
+void gpuMemorySetBudget(size_t bytes);
+size_t gpuMemoryGetBudget();
+size_t gpuMemoryGetUsed();
+size_t gpuMemoryGetPeak();
+// Peak back to what is in use now, to measure one workload
+void gpuMemoryResetPeak();
+unsigned int gpuMemoryGetRejections();
+
+// Logs the live allocations grouped by owner, then used, peak and budget
+void gpuMemoryLogReport(const char* name);
+
+#endif /* GPUMEMORY_H_ */
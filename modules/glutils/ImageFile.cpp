@@ -0,0 +1,445 @@
+/*
+ * ImageFile.cpp
+ *
+ *  Created on: 19-10-2026
+ */
+
+#include "ImageFile.h"
+#include "logger.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <ctype.h>
+#include <zlib.h>
+
+ImageFileFormat getImageFileFormat(const char* path) {
+	const char* dot = strrchr(path,'.');
+	if(!dot)
+		return IMAGE_FILE_UNKNOWN;
+	dot++;
+	if(!strcasecmp(dot,"ppm") || !strcasecmp(dot,"pgm") || !strcasecmp(dot,"pnm") || !strcasecmp(dot,"pam"))
+		return IMAGE_FILE_PPM;
+	if(!strcasecmp(dot,"png"))
+		return IMAGE_FILE_PNG;
+	if(!strcasecmp(dot,"jpg") || !strcasecmp(dot,"jpeg"))
+		return IMAGE_FILE_JPEG;
+	return IMAGE_FILE_UNKNOWN;
+}
+
+static const GLubyte pngSignature[8] = { 0x89, 'P', 'N', 'G', 0x0d, 0x0a, 0x1a, 0x0a };
+
+ImageFileFormat detectImageFileFormat(const GLubyte* data,size_t size) {
+	if(size >= 8 && !memcmp(data,pngSignature,8))
+		return IMAGE_FILE_PNG;
+	if(size >= 3 && data[0] == 0xff && data[1] == 0xd8 && data[2] == 0xff)
+		return IMAGE_FILE_JPEG;
+	if(size >= 2 && data[0] == 'P' && (data[1] == '5' || data[1] == '6' || data[1] == '7'))
+		return IMAGE_FILE_PPM;
+	return IMAGE_FILE_UNKNOWN;
+}
+
+GLenum getImageGlFormat(GLuint channels) {
+	switch(channels) {
+		case 1: return GL_LUMINANCE;
+		case 2: return GL_LUMINANCE_ALPHA;
+		case 3: return GL_RGB;
+		default: return GL_RGBA;
+	}
+}
+
+// Bytes of height rows of width pixels of pixelBytes each plus rowExtra.
+// Checked before anything is allocated from a header: size_t is 32 bits on
+// the ARM and x86 ABIs.
+static bool getImageBytes(GLuint width,GLuint height,GLuint pixelBytes,GLuint rowExtra,size_t* bytes) {
+	if(!width || !height || width > IMAGE_FILE_MAX_DIMENSION || height > IMAGE_FILE_MAX_DIMENSION)
+		return false;
+	// cannot wrap: width and pixelBytes (at most 8) are small
+	size_t row = (size_t)width * pixelBytes + rowExtra;
+	if(row > (size_t)-1 / height)
+		return false;
+	*bytes = row * height;
+	return true;
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+// PPM
+
+struct PpmReader {
+	const GLubyte* p;
+	const GLubyte* end;
+};
+
+// Next whitespace separated token, skipping '#' comments
+static bool readPpmToken(PpmReader& r,char* token,size_t size) {
+	for(;;) {
+		while(r.p < r.end && isspace(*r.p))
+			r.p++;
+		if(r.p < r.end && *r.p == '#') {
+			while(r.p < r.end && *r.p != '\n')
+				r.p++;
+			continue;
+		}
+		break;
+	}
+	size_t n = 0;
+	while(r.p < r.end && !isspace(*r.p) && n + 1 < size)
+		token[n++] = *r.p++;
+	token[n] = '\0';
+	return n > 0;
+}
+
+static bool readPpmNumber(PpmReader& r,GLuint* value) {
+	char token[16];
+	if(!readPpmToken(r,token,sizeof(token)) || !isdigit(token[0]))
+		return false;
+	*value = strtoul(token,NULL,10);
+	return true;
+}
+
+static bool decodePpm(const GLubyte* data,size_t size,DecodedImage* image) {
+	PpmReader r = { data + 2, data + size };
+	GLuint width = 0, height = 0, channels = 0, maxval = 0;
+	if(data[1] == '7') {
+		char key[32];
+		while(readPpmToken(r,key,sizeof(key)) && strcmp(key,"ENDHDR")) {
+			if(!strcmp(key,"TUPLTYPE")) {
+				readPpmToken(r,key,sizeof(key));
+				continue;
+			}
+			GLuint value;
+			if(!readPpmNumber(r,&value))
+				break;
+			if(!strcmp(key,"WIDTH"))
+				width = value;
+			else if(!strcmp(key,"HEIGHT"))
+				height = value;
+			else if(!strcmp(key,"DEPTH"))
+				channels = value;
+			else if(!strcmp(key,"MAXVAL"))
+				maxval = value;
+		}
+	}
+	else {
+		channels = data[1] == '5' ? 1 : 3;
+		if(!readPpmNumber(r,&width) || !readPpmNumber(r,&height) || !readPpmNumber(r,&maxval))
+			width = 0;
+	}
+	// a single whitespace byte separates the header from the samples
+	r.p++;
+	size_t bytes = 0;
+	if(channels < 1 || channels > 4 || maxval != 255 || !getImageBytes(width,height,channels,0,&bytes)) {
+		LogError("decodePpm: unsupported header %ux%u depth %u maxval %u",width,height,channels,maxval);
+		return false;
+	}
+	if(r.p > r.end || (size_t)(r.end - r.p) < bytes) {
+		LogError("decodePpm: truncated data");
+		return false;
+	}
+	image->width = width;
+	image->height = height;
+	image->channels = channels;
+	image->pixels = new GLubyte[bytes];
+	memcpy(image->pixels,r.p,bytes);
+	return true;
+}
+
+static void encodePpm(const DecodedImage& image,std::vector<GLubyte>& out) {
+	char header[128];
+	if(image.channels == 1 || image.channels == 3)
+		sprintf(header,"P%c\n%u %u\n255\n",image.channels == 1 ? '5' : '6',image.width,image.height);
+	else
+		sprintf(header,"P7\nWIDTH %u\nHEIGHT %u\nDEPTH %u\nMAXVAL 255\nTUPLTYPE %s\nENDHDR\n",image.width,image.height,
+				image.channels,image.channels == 2 ? "GRAYSCALE_ALPHA" : "RGB_ALPHA");
+	size_t length = strlen(header);
+	size_t bytes = (size_t)image.width * image.height * image.channels;
+	out.resize(length + bytes);
+	memcpy(&out[0],header,length);
+	memcpy(&out[length],image.pixels,bytes);
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+// PNG
+
+static inline GLuint readBigEndian(const GLubyte* p) {
+	return (p[0] << 24) | (p[1] << 16) | (p[2] << 8) | p[3];
+}
+
+static inline void writeBigEndian(GLubyte* p,GLuint value) {
+	p[0] = value >> 24;
+	p[1] = value >> 16;
+	p[2] = value >> 8;
+	p[3] = value;
+}
+
+static inline GLubyte paeth(int a,int b,int c) {
+	int p = a + b - c;
+	int pa = abs(p - a), pb = abs(p - b), pc = abs(p - c);
+	if(pa <= pb && pa <= pc)
+		return a;
+	return pb <= pc ? b : c;
+}
+
+// Reverses the per-row filters in place; rows are 1 filter byte + stride
+static bool unfilterPng(GLubyte* data,GLuint height,size_t stride,GLuint bpp) {
+	GLubyte* previous = NULL;
+	for(GLuint y=0;y<height;y++) {
+		GLubyte filter = data[y * (stride + 1)];
+		GLubyte* row = data + y * (stride + 1) + 1;
+		for(size_t i=0;i<stride;i++) {
+			int a = i >= bpp ? row[i - bpp] : 0;
+			int b = previous ? previous[i] : 0;
+			int c = previous && i >= bpp ? previous[i - bpp] : 0;
+			switch(filter) {
+				case 0: break;
+				case 1: row[i] += a; break;
+				case 2: row[i] += b; break;
+				case 3: row[i] += (a + b) >> 1; break;
+				case 4: row[i] += paeth(a,b,c); break;
+				default:
+					LogError("decodePng: bad filter %d in row %u",filter,y);
+					return false;
+			}
+		}
+		previous = row;
+	}
+	return true;
+}
+
+static bool decodePng(const GLubyte* data,size_t size,DecodedImage* image) {
+	GLuint width = 0, height = 0, depth = 0, colorType = 0, interlace = 0;
+	GLubyte palette[256][4];
+	GLuint paletteSize = 0;
+	bool paletteAlpha = false;
+	std::vector<GLubyte> compressed;
+
+	size_t pos = 8;
+	while(pos + 12 <= size) {
+		GLuint length = readBigEndian(data + pos);
+		const GLubyte* type = data + pos + 4;
+		const GLubyte* chunk = data + pos + 8;
+		if(length > size - pos - 12) {
+			LogError("decodePng: truncated chunk");
+			return false;
+		}
+		if(!memcmp(type,"IHDR",4) && length >= 13) {
+			width = readBigEndian(chunk);
+			height = readBigEndian(chunk + 4);
+			depth = chunk[8];
+			colorType = chunk[9];
+			interlace = chunk[12];
+		}
+		else if(!memcmp(type,"PLTE",4)) {
+			paletteSize = length / 3 > 256 ? 256 : length / 3;
+			for(GLuint i=0;i<paletteSize;i++) {
+				memcpy(palette[i],chunk + i * 3,3);
+				palette[i][3] = 255;
+			}
+		}
+		else if(!memcmp(type,"tRNS",4) && colorType == 3) {
+			for(GLuint i=0;i<length && i<paletteSize;i++)
+				palette[i][3] = chunk[i];
+			paletteAlpha = true;
+		}
+		else if(!memcmp(type,"IDAT",4)) {
+			compressed.insert(compressed.end(),chunk,chunk + length);
+		}
+		else if(!memcmp(type,"IEND",4)) {
+			break;
+		}
+		pos += length + 12;
+	}
+
+	static const GLuint samplesPerType[7] = { 1, 0, 3, 1, 2, 0, 4 };
+	GLuint samples = colorType < 7 ? samplesPerType[colorType] : 0;
+	bool supported = samples && !interlace && (colorType == 3 ? depth == 8 : (depth == 8 || depth == 16));
+	GLuint bpp = samples * depth / 8;
+	GLuint channels = colorType == 3 ? (paletteAlpha ? 4 : 3) : samples;
+	size_t filteredBytes = 0, bytes = 0;
+	if(!supported || !getImageBytes(width,height,bpp,1,&filteredBytes) || !getImageBytes(width,height,channels,0,&bytes) ||
+			compressed.empty() || (colorType == 3 && !paletteSize)) {
+		LogError("decodePng: unsupported image %ux%u depth %u color type %u interlace %u",width,height,depth,colorType,interlace);
+		return false;
+	}
+	// deflate expands at most about 1032 to 1, so a larger IHDR size is a
+	// corrupt header rather than an allocation worth attempting
+	if(filteredBytes / 1032 > compressed.size()) {
+		LogError("decodePng: %ux%u does not fit %u bytes of image data",width,height,(unsigned int)compressed.size());
+		return false;
+	}
+
+	size_t stride = (size_t)width * bpp;
+	uLongf rawSize = filteredBytes;
+	std::vector<GLubyte> raw(rawSize);
+	if(uncompress(&raw[0],&rawSize,&compressed[0],compressed.size()) != Z_OK || rawSize != raw.size()) {
+		LogError("decodePng: corrupt image data");
+		return false;
+	}
+	if(!unfilterPng(&raw[0],height,stride,bpp))
+		return false;
+
+	GLubyte* pixels = new GLubyte[bytes];
+	for(GLuint y=0;y<height;y++) {
+		const GLubyte* row = &raw[y * (stride + 1) + 1];
+		GLubyte* out = pixels + (size_t)y * width * channels;
+		if(colorType == 3) {
+			for(GLuint x=0;x<width;x++)
+				memcpy(out + x * channels,palette[row[x] < paletteSize ? row[x] : 0],channels);
+		}
+		else if(depth == 16) {
+			for(size_t i=0;i<(size_t)width * channels;i++)
+				out[i] = row[i * 2];
+		}
+		else {
+			memcpy(out,row,stride);
+		}
+	}
+	image->width = width;
+	image->height = height;
+	image->channels = channels;
+	image->pixels = pixels;
+	return true;
+}
+
+static void appendPngChunk(std::vector<GLubyte>& out,const char* type,const GLubyte* data,GLuint length) {
+	size_t pos = out.size();
+	out.resize(pos + length + 12);
+	writeBigEndian(&out[pos],length);
+	memcpy(&out[pos + 4],type,4);
+	if(length)
+		memcpy(&out[pos + 8],data,length);
+	uLong crc = crc32(0,&out[pos + 4],length + 4);
+	writeBigEndian(&out[pos + 8 + length],crc);
+}
+
+static bool encodePng(const DecodedImage& image,std::vector<GLubyte>& out,int level) {
+	static const GLubyte colorTypes[5] = { 0, 0, 4, 2, 6 };
+	const GLuint bpp = image.channels;
+	const size_t stride = (size_t)image.width * bpp;
+
+	// try every filter on each row and keep the one with the smallest
+	// sum of absolute (signed) residuals
+	std::vector<GLubyte> filtered((stride + 1) * image.height);
+	std::vector<GLubyte> candidate(stride);
+	for(GLuint y=0;y<image.height;y++) {
+		const GLubyte* row = image.pixels + y * stride;
+		const GLubyte* previous = y ? row - stride : NULL;
+		GLubyte* dst = &filtered[y * (stride + 1)];
+		unsigned long best = ~0ul;
+		for(int filter=0;filter<5;filter++) {
+			unsigned long sum = 0;
+			for(size_t i=0;i<stride;i++) {
+				int a = i >= bpp ? row[i - bpp] : 0;
+				int b = previous ? previous[i] : 0;
+				int c = previous && i >= bpp ? previous[i - bpp] : 0;
+				int predicted = 0;
+				switch(filter) {
+					case 1: predicted = a; break;
+					case 2: predicted = b; break;
+					case 3: predicted = (a + b) >> 1; break;
+					case 4: predicted = paeth(a,b,c); break;
+				}
+				GLubyte residual = row[i] - predicted;
+				candidate[i] = residual;
+				sum += residual < 128 ? residual : 256 - residual;
+			}
+			if(sum < best) {
+				best = sum;
+				dst[0] = filter;
+				memcpy(dst + 1,&candidate[0],stride);
+			}
+		}
+	}
+
+	uLongf compressedSize = compressBound(filtered.size());
+	std::vector<GLubyte> compressed(compressedSize);
+	if(compress2(&compressed[0],&compressedSize,&filtered[0],filtered.size(),level) != Z_OK) {
+		LogError("encodePng: compression failed");
+		return false;
+	}
+
+	GLubyte header[13];
+	writeBigEndian(header,image.width);
+	writeBigEndian(header + 4,image.height);
+	header[8] = 8;
+	header[9] = colorTypes[image.channels];
+	header[10] = header[11] = header[12] = 0;
+
+	out.assign(pngSignature,pngSignature + 8);
+	appendPngChunk(out,"IHDR",header,13);
+	appendPngChunk(out,"IDAT",&compressed[0],compressedSize);
+	appendPngChunk(out,"IEND",NULL,0);
+	return true;
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+
+bool decodeImage(const GLubyte* data,size_t size,DecodedImage* image) {
+	switch(detectImageFileFormat(data,size)) {
+		case IMAGE_FILE_PPM:
+			return decodePpm(data,size,image);
+		case IMAGE_FILE_PNG:
+			return decodePng(data,size,image);
+		case IMAGE_FILE_JPEG:
+			LogError("decodeImage: JPEG is not supported");
+			return false;
+		default:
+			LogError("decodeImage: unknown file format");
+			return false;
+	}
+}
+
+bool encodeImage(ImageFileFormat format,const DecodedImage& image,std::vector<GLubyte>& out,int pngLevel) {
+	if(image.channels < 1 || image.channels > 4 || !image.width || !image.height) {
+		LogError("encodeImage: bad image %ux%u with %u channels",image.width,image.height,image.channels);
+		return false;
+	}
+	switch(format) {
+		case IMAGE_FILE_PPM:
+			encodePpm(image,out);
+			return true;
+		case IMAGE_FILE_PNG:
+			return encodePng(image,out,pngLevel);
+		case IMAGE_FILE_JPEG:
+			LogError("encodeImage: JPEG is not supported");
+			return false;
+		default:
+			LogError("encodeImage: unknown file format");
+			return false;
+	}
+}
+
+bool readImageFile(const char* path,DecodedImage* image) {
+	FILE* file = fopen(path,"rb");
+	if(!file) {
+		LogError("readImageFile: cannot open %s",path);
+		return false;
+	}
+	std::vector<GLubyte> data;
+	GLubyte buffer[65536];
+	size_t n;
+	while((n = fread(buffer,1,sizeof(buffer),file)) > 0)
+		data.insert(data.end(),buffer,buffer + n);
+	fclose(file);
+	if(data.empty() || !decodeImage(&data[0],data.size(),image)) {
+		LogError("readImageFile: cannot decode %s",path);
+		return false;
+	}
+	return true;
+}
+
+bool writeImageFile(const char* path,const DecodedImage& image,int pngLevel) {
+	std::vector<GLubyte> data;
+	if(!encodeImage(getImageFileFormat(path),image,data,pngLevel))
+		return false;
+	FILE* file = fopen(path,"wb");
+	if(!file) {
+		LogError("writeImageFile: cannot create %s",path);
+		return false;
+	}
+	bool written = fwrite(&data[0],1,data.size(),file) == data.size();
+	written = fclose(file) == 0 && written;
+	if(!written)
+		LogError("writeImageFile: cannot write %s",path);
+	return written;
+}
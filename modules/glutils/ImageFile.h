@@ -0,0 +1,65 @@
+/*
+ * ImageFile.h
+ *
+ *  Created on: 19-10-2026
+ */
+
+#ifndef IMAGEFILE_H_
+#define IMAGEFILE_H_
+
+#include <GLES2/gl2.h>
+#include <stddef.h>
+#include <vector>
+
+/*
+ * Reading and writing images on local storage. No GL calls; the codecs work
+ * on any thread.
+ *
+ * PPM: binary P5 (gray), P6 (RGB) and P7 PAM (gray or RGB with alpha),
+ * maxval 255.
+ * PNG: 8 and 16 bit gray, gray-alpha, RGB and RGBA plus 8 bit palette,
+ * non-interlaced; 16 bit samples keep their high byte. Written as 8 bit with
+ * a per-row filter chosen by the minimum sum of absolute differences.
+ * JPEG: recognized but not supported, the NDK has no JPEG codec.
+ */
+enum ImageFileFormat {
+	IMAGE_FILE_UNKNOWN,
+	IMAGE_FILE_PPM,
+	IMAGE_FILE_PNG,
+	IMAGE_FILE_JPEG
+};
+
+// Widest and tallest image the decoders accept, the GL_MAX_TEXTURE_SIZE of
+// the largest GLES2 GPUs; bigger headers are taken as corrupt
+#define IMAGE_FILE_MAX_DIMENSION 16384
+
+/*
+ * Tightly packed 8 bit pixels with 1 (gray), 2 (gray-alpha), 3 (RGB) or
+ * 4 (RGBA) channels. pixels is allocated with new[].
+ */
+struct DecodedImage {
+	GLuint width,height;
+	GLuint channels;
+	GLubyte* pixels;
+};
+
+// From the extension: .ppm .pgm .pnm .pam, .png, .jpg .jpeg
+ImageFileFormat getImageFileFormat(const char* path);
+// From the first bytes of the file
+ImageFileFormat detectImageFileFormat(const GLubyte* data,size_t size);
+// GL_LUMINANCE, GL_LUMINANCE_ALPHA, GL_RGB or GL_RGBA
+GLenum getImageGlFormat(GLuint channels);
+
+/*
+ * Both return false and log the reason for malformed or unsupported input;
+ * the image is left untouched then.
+ */
+bool decodeImage(const GLubyte* data,size_t size,DecodedImage* image);
+// pngLevel is the zlib level, 1 is fastest
+bool encodeImage(ImageFileFormat format,const DecodedImage& image,std::vector<GLubyte>& out,int pngLevel = 6);
+
+bool readImageFile(const char* path,DecodedImage* image);
+// The format follows the extension of path
+bool writeImageFile(const char* path,const DecodedImage& image,int pngLevel = 6);
+
+#endif /* IMAGEFILE_H_ */
@@ -0,0 +1,75 @@
+/*
+ * ImageQuality.cpp
+ *
+ *  Created on: 19-10-2026
+ */
+
+#include "ImageQuality.h"
+#include <math.h>
+#include <stdint.h>
+#include <vector>
+
+#define SSIM_WINDOW 8
+#define SSIM_STEP 4
+
+double computePsnr(const GLubyte* a,const GLubyte* b,GLuint width,GLuint height,GLuint channels) {
+	size_t n = (size_t)width * height * channels;
+	if(n == 0)
+		return 100.0;
+	uint64_t sse = 0;
+	for(size_t i=0;i<n;i++) {
+		int d = (int)a[i] - (int)b[i];
+		sse += d * d;
+	}
+	if(sse == 0)
+		return 100.0;
+	double mse = (double)sse / n;
+	return 10.0 * log10(255.0 * 255.0 / mse);
+}
+
+static void extractLuma(const GLubyte* src,GLuint count,GLuint channels,std::vector<GLubyte>& luma) {
+	luma.resize(count);
+	for(GLuint i=0;i<count;i++) {
+		const GLubyte* p = src + i * channels;
+		luma[i] = channels >= 3 ? (77*p[0] + 150*p[1] + 29*p[2]) >> 8 : p[0];
+	}
+}
+
+double computeSsim(const GLubyte* a,const GLubyte* b,GLuint width,GLuint height,GLuint channels) {
+	if(width < SSIM_WINDOW || height < SSIM_WINDOW)
+		return computePsnr(a,b,width,height,channels) >= 100.0 ? 1.0 : 0.0;
+
+	std::vector<GLubyte> la,lb;
+	extractLuma(a,width*height,channels,la);
+	extractLuma(b,width*height,channels,lb);
+
+	const double c1 = (0.01 * 255) * (0.01 * 255);
+	const double c2 = (0.03 * 255) * (0.03 * 255);
+	const double n = SSIM_WINDOW * SSIM_WINDOW;
+	double total = 0.0;
+	int windows = 0;
+	for(GLuint y=0;y+SSIM_WINDOW<=height;y+=SSIM_STEP) {
+		for(GLuint x=0;x+SSIM_WINDOW<=width;x+=SSIM_STEP) {
+			uint32_t sa = 0, sb = 0;
+			uint64_t saa = 0, sbb = 0, sab = 0;
+			for(GLuint j=0;j<SSIM_WINDOW;j++) {
+				const GLubyte* pa = &la[(y+j)*width+x];
+				const GLubyte* pb = &lb[(y+j)*width+x];
+				for(GLuint i=0;i<SSIM_WINDOW;i++) {
+					sa += pa[i];
+					sb += pb[i];
+					saa += pa[i] * pa[i];
+					sbb += pb[i] * pb[i];
+					sab += pa[i] * pb[i];
+				}
+			}
+			double ma = sa / n, mb = sb / n;
+			double va = saa / n - ma * ma;
+			double vb = sbb / n - mb * mb;
+			double cov = sab / n - ma * mb;
+			total += ((2 * ma * mb + c1) * (2 * cov + c2)) / ((ma * ma + mb * mb + c1) * (va + vb + c2));
+			windows++;
+		}
+	}
+	return total / windows;
+}
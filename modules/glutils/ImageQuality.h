@@ -0,0 +1,24 @@
+/*
+ * ImageQuality.h
+ *
+ *  Created on: 19-10-2026
+ */
+
+#ifndef IMAGEQUALITY_H_
+#define IMAGEQUALITY_H_
+
+#include <GLES2/gl2.h>
+
+/*
+ * Full-reference quality metrics for two equally sized GL_UNSIGNED_BYTE
+ * images with tightly packed rows.
+ */
+
+// Peak signal to noise ratio over all channels in dB; 100 for identical images
+double computePsnr(const GLubyte* a,const GLubyte* b,GLuint width,GLuint height,GLuint channels);
+
+// Mean structural similarity of the luma channel over 8x8 windows, stepping
+// 4 pixels; 1.0 for identical images
+double computeSsim(const GLubyte* a,const GLubyte* b,GLuint width,GLuint height,GLuint channels);
+
+#endif /* IMAGEQUALITY_H_ */
@@ -0,0 +1,216 @@
+/*
+ * ImageStats.cpp
+ *
+ *  Created on: 19-10-2026
+ */
+
+#include "ImageStats.h"
+#include "Parallel.h"
+#include "PixelConvert.h"
+#include <pthread.h>
+#include <stdint.h>
+#include <string.h>
+#include <vector>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#elif defined(__ARM_NEON__) || defined(__ARM_NEON)
+#include <arm_neon.h>
+#define STATS_NEON
+#endif
+
+static void resetStats(ImageStats* stats,bool histogram) {
+	stats->pixelCount = 0;
+	stats->mean = 0.0f;
+	stats->min = 0;
+	stats->max = 0;
+	stats->hasHistogram = histogram;
+	if(histogram)
+		memset(stats->histogram,0,sizeof(stats->histogram));
+}
+
+void getImageStatsFromHistogram(ImageStats* stats) {
+	uint64_t sum = 0;
+	GLuint count = 0;
+	int first = -1, last = 0;
+	for(int i=0;i<IMAGE_STATS_BINS;i++) {
+		if(!stats->histogram[i])
+			continue;
+		if(first < 0)
+			first = i;
+		last = i;
+		count += stats->histogram[i];
+		sum += (uint64_t)stats->histogram[i] * i;
+	}
+	stats->pixelCount = count;
+	stats->mean = count ? (float)((double)sum / count) : 0.0f;
+	stats->min = first < 0 ? 0 : first;
+	stats->max = last;
+}
+
+void computeImageStatsScalar(const GLubyte* pixels,GLuint width,GLuint height,GLuint channels,ImageStats* stats,
+		bool histogram) {
+	resetStats(stats,histogram);
+	size_t count = (size_t)width * height;
+	if(!count)
+		return;
+	uint64_t sum = 0;
+	GLubyte mn = 255, mx = 0;
+	for(size_t i=0;i<count;i++) {
+		GLubyte luma = getPixelLuma(pixels + i * channels,channels);
+		sum += luma;
+		if(luma < mn)
+			mn = luma;
+		if(luma > mx)
+			mx = luma;
+		if(histogram)
+			stats->histogram[luma]++;
+	}
+	stats->pixelCount = count;
+	stats->mean = (float)((double)sum / count);
+	stats->min = mn;
+	stats->max = mx;
+}
+
+static void reduceLumaRow(const GLubyte* luma,GLuint width,uint64_t* sum,GLubyte* mn,GLubyte* mx) {
+	GLuint x = 0;
+	GLubyte lo = *mn, hi = *mx;
+	uint64_t total = 0;
+#if defined(__SSE2__)
+	if(width >= 16) {
+		const __m128i zero = _mm_setzero_si128();
+		__m128i vmin = _mm_set1_epi8((char)255), vmax = zero, vsum = zero;
+		for(;x+16<=width;x+=16) {
+			__m128i v = _mm_loadu_si128((const __m128i*)(luma + x));
+			vmin = _mm_min_epu8(vmin,v);
+			vmax = _mm_max_epu8(vmax,v);
+			vsum = _mm_add_epi64(vsum,_mm_sad_epu8(v,zero));
+		}
+		GLubyte lanes[2][16];
+		uint64_t sums[2];
+		_mm_storeu_si128((__m128i*)lanes[0],vmin);
+		_mm_storeu_si128((__m128i*)lanes[1],vmax);
+		_mm_storeu_si128((__m128i*)sums,vsum);
+		total = sums[0] + sums[1];
+		for(int i=0;i<16;i++) {
+			if(lanes[0][i] < lo)
+				lo = lanes[0][i];
+			if(lanes[1][i] > hi)
+				hi = lanes[1][i];
+		}
+	}
+#elif defined(STATS_NEON)
+	if(width >= 16) {
+		uint8x16_t vmin = vdupq_n_u8(255), vmax = vdupq_n_u8(0);
+		uint32x4_t vsum = vdupq_n_u32(0);
+		for(;x+16<=width;x+=16) {
+			uint8x16_t v = vld1q_u8(luma + x);
+			vmin = vminq_u8(vmin,v);
+			vmax = vmaxq_u8(vmax,v);
+			vsum = vpadalq_u16(vsum,vpaddlq_u8(v));
+		}
+		GLubyte lanes[2][16];
+		uint32_t sums[4];
+		vst1q_u8(lanes[0],vmin);
+		vst1q_u8(lanes[1],vmax);
+		vst1q_u32(sums,vsum);
+		total = (uint64_t)sums[0] + sums[1] + sums[2] + sums[3];
+		for(int i=0;i<16;i++) {
+			if(lanes[0][i] < lo)
+				lo = lanes[0][i];
+			if(lanes[1][i] > hi)
+				hi = lanes[1][i];
+		}
+	}
+#endif
+	for(;x<width;x++) {
+		total += luma[x];
+		if(luma[x] < lo)
+			lo = luma[x];
+		if(luma[x] > hi)
+			hi = luma[x];
+	}
+	*sum += total;
+	*mn = lo;
+	*mx = hi;
+}
+
+// Four interleaved tables so runs of equal values do not wait on each
+// other's increments
+static void countLumaRow(const GLubyte* luma,GLuint width,GLuint* bins) {
+	GLuint* h0 = bins;
+	GLuint* h1 = bins + IMAGE_STATS_BINS;
+	GLuint* h2 = bins + IMAGE_STATS_BINS*2;
+	GLuint* h3 = bins + IMAGE_STATS_BINS*3;
+	GLuint x = 0;
+	for(;x+4<=width;x+=4) {
+		h0[luma[x]]++;
+		h1[luma[x+1]]++;
+		h2[luma[x+2]]++;
+		h3[luma[x+3]]++;
+	}
+	for(;x<width;x++)
+		h0[luma[x]]++;
+}
+
+struct StatsContext {
+	const GLubyte* pixels;
+	GLuint width,channels;
+	bool histogram;
+	pthread_mutex_t mutex;
+	uint64_t sum;
+	GLubyte min,max;
+	GLuint* bins;
+};
+
+static void statsRows(int begin,int end,void* arg) {
+	StatsContext* ctx = (StatsContext*)arg;
+	std::vector<GLubyte> luma(ctx->width);
+	std::vector<GLuint> bins(ctx->histogram ? IMAGE_STATS_BINS * 4 : 0,0);
+	uint64_t sum = 0;
+	GLubyte mn = 255, mx = 0;
+	for(int y=begin;y<end;y++) {
+		convertToGray(ctx->pixels + (size_t)y * ctx->width * ctx->channels,&luma[0],ctx->width,ctx->channels);
+		// with a histogram the rest follows from it
+		if(ctx->histogram)
+			countLumaRow(&luma[0],ctx->width,&bins[0]);
+		else
+			reduceLumaRow(&luma[0],ctx->width,&sum,&mn,&mx);
+	}
+	pthread_mutex_lock(&ctx->mutex);
+	ctx->sum += sum;
+	if(mn < ctx->min)
+		ctx->min = mn;
+	if(mx > ctx->max)
+		ctx->max = mx;
+	for(GLuint i=0;i<bins.size();i++)
+		ctx->bins[i % IMAGE_STATS_BINS] += bins[i];
+	pthread_mutex_unlock(&ctx->mutex);
+}
+
+void computeImageStats(const GLubyte* pixels,GLuint width,GLuint height,GLuint channels,ImageStats* stats,bool histogram) {
+	resetStats(stats,histogram);
+	if(!width || !height)
+		return;
+	StatsContext ctx;
+	ctx.pixels = pixels;
+	ctx.width = width;
+	ctx.channels = channels;
+	ctx.histogram = histogram;
+	pthread_mutex_init(&ctx.mutex,NULL);
+	ctx.sum = 0;
+	ctx.min = 255;
+	ctx.max = 0;
+	ctx.bins = stats->histogram;
+	parallelFor(0,height,statsRows,&ctx,16);
+	pthread_mutex_destroy(&ctx.mutex);
+
+	if(histogram) {
+		getImageStatsFromHistogram(stats);
+		return;
+	}
+	stats->pixelCount = width * height;
+	stats->mean = (float)((double)ctx.sum / stats->pixelCount);
+	stats->min = ctx.min;
+	stats->max = ctx.max;
+}
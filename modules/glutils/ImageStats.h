@@ -0,0 +1,48 @@
+/*
+ * ImageStats.h
+ *
+ *  Created on: 19-10-2026
+ */
+
+#ifndef IMAGESTATS_H_
+#define IMAGESTATS_H_
+
+#include <GLES2/gl2.h>
+
+#define IMAGE_STATS_BINS 256
+
+/*
+ * Luma statistics of an image. Luma is (77 R + 150 G + 29 B) >> 8, as in
+ * computeSsim, or the first channel of 1 and 2 channel images.
+ */
+typedef struct
+{
+	GLuint pixelCount;
+	float mean;
+	GLubyte min;
+	GLubyte max;
+	bool hasHistogram;
+	GLuint histogram[IMAGE_STATS_BINS];	// pixels per luma value
+} ImageStats;
+
+inline GLubyte getPixelLuma(const GLubyte* pixel,GLuint channels) {
+	return channels >= 3 ? (77*pixel[0] + 150*pixel[1] + 29*pixel[2]) >> 8 : pixel[0];
+}
+
+/*
+ * Statistics of tightly packed GL_UNSIGNED_BYTE pixels with 1 to 4 channels.
+ * Luma comes from convertToGray (PixelConvert.h) and the min/max/sum
+ * reduction uses SSE2 or NEON when available; rows are split across
+ * parallelFor workers. Without a histogram
+ * hasHistogram is false and the bins are left alone.
+ */
+void computeImageStats(const GLubyte* pixels,GLuint width,GLuint height,GLuint channels,ImageStats* stats,bool histogram = true);
+
+// The same one pixel at a time, the reference for computeImageStats
+void computeImageStatsScalar(const GLubyte* pixels,GLuint width,GLuint height,GLuint channels,ImageStats* stats,
+		bool histogram = true);
+
+// Sets pixelCount, mean, min and max from the histogram
+void getImageStatsFromHistogram(ImageStats* stats);
+
+#endif /* IMAGESTATS_H_ */
@@ -0,0 +1,64 @@
+/*
+ * ImageTransform.cpp
+ *
+ *  Created on: 19-10-2026
+ */
+
+#include "ImageTransform.h"
+#include "matrices.h"
+
+// Sets m to the 2D affine map (u,v) = (a*s + b*t + c, d*s + e*t + f)
+static void setAffine(float* m,float a,float b,float c,float d,float e,float f) {
+	matrixSetIdentityM(m);
+	m[0] = a;
+	m[4] = b;
+	m[12] = c;
+	m[1] = d;
+	m[5] = e;
+	m[13] = f;
+}
+
+void setIdentityTransform(ImageTransform* transform,GLuint srcWidth,GLuint srcHeight) {
+	transform->x = 0;
+	transform->y = 0;
+	transform->width = srcWidth;
+	transform->height = srcHeight;
+	transform->rotation = ROTATE_0;
+	transform->flip = FLIP_NONE;
+}
+
+void getTransformedSize(const ImageTransform& transform,GLuint* width,GLuint* height) {
+	bool swap = transform.rotation == ROTATE_90 || transform.rotation == ROTATE_270;
+	*width = swap ? transform.height : transform.width;
+	*height = swap ? transform.width : transform.height;
+}
+
+void getTransformMatrix(const ImageTransform& transform,GLuint srcWidth,GLuint srcHeight,float* matrix) {
+	float crop[16],rotate[16],flip[16],tmp[16];
+
+	setAffine(crop,(float)transform.width / srcWidth,0.0f,(float)transform.x / srcWidth,
+			0.0f,(float)transform.height / srcHeight,(float)transform.y / srcHeight);
+
+	// output (s,t) -> crop (s,t) of the unrotated image
+	switch(transform.rotation) {
+		case ROTATE_90:
+			setAffine(rotate,0.0f,1.0f,0.0f,-1.0f,0.0f,1.0f);
+			break;
+		case ROTATE_180:
+			setAffine(rotate,-1.0f,0.0f,1.0f,0.0f,-1.0f,1.0f);
+			break;
+		case ROTATE_270:
+			setAffine(rotate,0.0f,-1.0f,1.0f,1.0f,0.0f,0.0f);
+			break;
+		case ROTATE_0:
+		default:
+			matrixSetIdentityM(rotate);
+			break;
+	}
+
+	setAffine(flip,transform.flip & FLIP_HORIZONTAL ? -1.0f : 1.0f,0.0f,transform.flip & FLIP_HORIZONTAL ? 1.0f : 0.0f,
+			0.0f,transform.flip & FLIP_VERTICAL ? -1.0f : 1.0f,transform.flip & FLIP_VERTICAL ? 1.0f : 0.0f);
+
+	matrixMultiplyMM(tmp,rotate,flip);
+	matrixMultiplyMM(matrix,crop,tmp);
+}
@@ -0,0 +1,57 @@
+/*
+ * ImageTransform.h
+ *
+ *  Created on: 19-10-2026
+ */
+
+#ifndef IMAGETRANSFORM_H_
+#define IMAGETRANSFORM_H_
+
+#include <GLES2/gl2.h>
+
+/*
+ * Crop, rotation and flip expressed as one affine matrix (4x4, column major,
+ * as in matrices.h) that maps normalized output coordinates (s,t) to
+ * normalized source coordinates (u,v). In both images (0,0) is the first
+ * pixel in memory and (1,1) the far corner of the last one, so an output
+ * pixel (i,j) samples the source at
+ *   (u,v) = M * ((i + 0.5) / outWidth, (j + 0.5) / outHeight)
+ * with GL_LINEAR, GL_CLAMP_TO_EDGE semantics. Any other affine matrix built
+ * with matrices.h can be used the same way.
+ */
+
+enum ImageRotation {
+	ROTATE_0,
+	ROTATE_90,		// clockwise
+	ROTATE_180,
+	ROTATE_270
+};
+
+enum ImageFlip {
+	FLIP_NONE = 0,
+	FLIP_HORIZONTAL = 1,
+	FLIP_VERTICAL = 2
+};
+
+typedef struct
+{
+	GLuint x;			// crop rectangle in source pixels
+	GLuint y;
+	GLuint width;
+	GLuint height;
+	ImageRotation rotation;
+	int flip;			// ImageFlip bits, applied after the rotation
+} ImageTransform;
+
+// Whole source, no rotation, no flip
+void setIdentityTransform(ImageTransform* transform,GLuint srcWidth,GLuint srcHeight);
+// Size after crop and rotation, before any scaling
+void getTransformedSize(const ImageTransform& transform,GLuint* width,GLuint* height);
+void getTransformMatrix(const ImageTransform& transform,GLuint srcWidth,GLuint srcHeight,float* matrix);
+
+static inline void transformPoint(const float* m,float s,float t,float* u,float* v) {
+	*u = m[0] * s + m[4] * t + m[12];
+	*v = m[1] * s + m[5] * t + m[13];
+}
+
+#endif /* IMAGETRANSFORM_H_ */
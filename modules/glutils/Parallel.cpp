@@ -0,0 +1,73 @@
+/*
+ * Parallel.cpp
+ *
+ *  Created on: 19-10-2026
+ */
+
+#include "Parallel.h"
+#include <pthread.h>
+#include <unistd.h>
+
+#define MAX_WORKERS 16
+
+struct ParallelChunk {
+	ParallelRangeFunc func;
+	void* ctx;
+	int begin,end;
+};
+
+static void* parallelChunkMain(void* arg) {
+	ParallelChunk* chunk = (ParallelChunk*)arg;
+	chunk->func(chunk->begin,chunk->end,chunk->ctx);
+	return NULL;
+}
+
+int getWorkerCount() {
+	static int workers = 0;
+	if(workers == 0) {
+		long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+		if(cpus < 1)
+			cpus = 1;
+		if(cpus > MAX_WORKERS)
+			cpus = MAX_WORKERS;
+		workers = cpus;
+	}
+	return workers;
+}
+
+void parallelFor(int begin,int end,ParallelRangeFunc func,void* ctx,int minChunk) {
+	int count = end - begin;
+	if(count <= 0)
+		return;
+	if(minChunk < 1)
+		minChunk = 1;
+
+	int chunks = getWorkerCount();
+	if(chunks > count / minChunk)
+		chunks = count / minChunk;
+	if(chunks <= 1) {
+		func(begin,end,ctx);
+		return;
+	}
+
+	ParallelChunk work[MAX_WORKERS];
+	pthread_t threads[MAX_WORKERS];
+	bool started[MAX_WORKERS];
+	for(int i=0;i<chunks;i++) {
+		work[i].func = func;
+		work[i].ctx = ctx;
+		work[i].begin = begin + (long long)count * i / chunks;
+		work[i].end = begin + (long long)count * (i + 1) / chunks;
+	}
+	for(int i=1;i<chunks;i++)
+		started[i] = pthread_create(&threads[i],NULL,parallelChunkMain,&work[i]) == 0;
+
+	func(work[0].begin,work[0].end,ctx);
+
+	for(int i=1;i<chunks;i++) {
+		if(started[i])
+			pthread_join(threads[i],NULL);
+		else
+			func(work[i].begin,work[i].end,ctx);
+	}
+}
@@ -0,0 +1,24 @@
+/*
+ * Parallel.h
+ *
+ *  Created on: 19-10-2026
+ */
+
+#ifndef PARALLEL_H_
+#define PARALLEL_H_
+
+typedef void (*ParallelRangeFunc)(int begin,int end,void* ctx);
+
+/*
+ * Number of threads parallelFor splits work across (online CPUs).
+ */
+int getWorkerCount();
+
+/*
+ * Splits [begin,end) into contiguous chunks of at least minChunk items and
+ * runs func on each chunk, one chunk per worker thread. The calling thread
+ * takes the first chunk; returns when all chunks are done.
+ */
+void parallelFor(int begin,int end,ParallelRangeFunc func,void* ctx,int minChunk = 1);
+
+#endif /* PARALLEL_H_ */
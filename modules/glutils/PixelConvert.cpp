@@ -0,0 +1,413 @@
+/*
+ * PixelConvert.cpp
+ *
+ *  Created on: 19-10-2026
+ */
+
+#include "PixelConvert.h"
+#include "ImageStats.h"
+#include <string.h>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#if defined(__SSSE3__)
+#include <tmmintrin.h>
+#define CONVERT_SSSE3
+#endif
+#elif defined(__ARM_NEON__) || defined(__ARM_NEON)
+#include <arm_neon.h>
+#define CONVERT_NEON
+#endif
+
+static const GLubyte rgbaToBgra[4] = { 2, 1, 0, 3 };
+
+#if defined(CONVERT_SSSE3)
+// 16 pixels of 3 bytes spread to 4 bytes through shuffle, the 4th byte set
+// from fill; the last load is shifted so no byte past the 48 is read
+static inline void expand16(const GLubyte* src,GLubyte* dst,__m128i shuffle,__m128i fill) {
+	__m128i p0 = _mm_loadu_si128((const __m128i*)src);
+	__m128i p1 = _mm_loadu_si128((const __m128i*)(src + 12));
+	__m128i p2 = _mm_loadu_si128((const __m128i*)(src + 24));
+	__m128i p3 = _mm_srli_si128(_mm_loadu_si128((const __m128i*)(src + 32)),4);
+	_mm_storeu_si128((__m128i*)dst,_mm_or_si128(_mm_shuffle_epi8(p0,shuffle),fill));
+	_mm_storeu_si128((__m128i*)(dst + 16),_mm_or_si128(_mm_shuffle_epi8(p1,shuffle),fill));
+	_mm_storeu_si128((__m128i*)(dst + 32),_mm_or_si128(_mm_shuffle_epi8(p2,shuffle),fill));
+	_mm_storeu_si128((__m128i*)(dst + 48),_mm_or_si128(_mm_shuffle_epi8(p3,shuffle),fill));
+}
+
+// 16 pixels of 4 bytes packed to 3 through shuffle, which leaves the top 4
+// bytes of each register zero
+static inline void pack16(const GLubyte* src,GLubyte* dst,__m128i shuffle) {
+	__m128i p0 = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i*)src),shuffle);
+	__m128i p1 = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i*)(src + 16)),shuffle);
+	__m128i p2 = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i*)(src + 32)),shuffle);
+	__m128i p3 = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i*)(src + 48)),shuffle);
+	_mm_storeu_si128((__m128i*)dst,_mm_or_si128(p0,_mm_slli_si128(p1,12)));
+	_mm_storeu_si128((__m128i*)(dst + 16),_mm_or_si128(_mm_srli_si128(p1,4),_mm_slli_si128(p2,8)));
+	_mm_storeu_si128((__m128i*)(dst + 32),_mm_or_si128(_mm_srli_si128(p2,8),_mm_slli_si128(p3,4)));
+}
+#endif
+
+void convertRgbToRgba(const GLubyte* src,GLubyte* dst,GLuint count) {
+	GLuint x = 0;
+#if defined(CONVERT_SSSE3)
+	const __m128i shuffle = _mm_setr_epi8(0,1,2,-1,3,4,5,-1,6,7,8,-1,9,10,11,-1);
+	const __m128i alpha = _mm_set1_epi32(0xff000000);
+	for(;x+16<=count;x+=16)
+		expand16(src + x*3,dst + x*4,shuffle,alpha);
+#elif defined(CONVERT_NEON)
+	for(;x+16<=count;x+=16) {
+		uint8x16x3_t in = vld3q_u8(src + x*3);
+		uint8x16x4_t out;
+		out.val[0] = in.val[0];
+		out.val[1] = in.val[1];
+		out.val[2] = in.val[2];
+		out.val[3] = vdupq_n_u8(255);
+		vst4q_u8(dst + x*4,out);
+	}
+#endif
+	for(;x<count;x++) {
+		dst[x*4] = src[x*3];
+		dst[x*4+1] = src[x*3+1];
+		dst[x*4+2] = src[x*3+2];
+		dst[x*4+3] = 255;
+	}
+}
+
+void convertRgbaToRgb(const GLubyte* src,GLubyte* dst,GLuint count) {
+	GLuint x = 0;
+#if defined(CONVERT_SSSE3)
+	const __m128i shuffle = _mm_setr_epi8(0,1,2,4,5,6,8,9,10,12,13,14,-1,-1,-1,-1);
+	for(;x+16<=count;x+=16)
+		pack16(src + x*4,dst + x*3,shuffle);
+#elif defined(CONVERT_NEON)
+	for(;x+16<=count;x+=16) {
+		uint8x16x4_t in = vld4q_u8(src + x*4);
+		uint8x16x3_t out;
+		out.val[0] = in.val[0];
+		out.val[1] = in.val[1];
+		out.val[2] = in.val[2];
+		vst3q_u8(dst + x*3,out);
+	}
+#endif
+	for(;x<count;x++) {
+		dst[x*3] = src[x*4];
+		dst[x*3+1] = src[x*4+1];
+		dst[x*3+2] = src[x*4+2];
+	}
+}
+
+void convertRgbToBgra(const GLubyte* src,GLubyte* dst,GLuint count) {
+	GLuint x = 0;
+#if defined(CONVERT_SSSE3)
+	const __m128i shuffle = _mm_setr_epi8(2,1,0,-1,5,4,3,-1,8,7,6,-1,11,10,9,-1);
+	const __m128i alpha = _mm_set1_epi32(0xff000000);
+	for(;x+16<=count;x+=16)
+		expand16(src + x*3,dst + x*4,shuffle,alpha);
+#elif defined(CONVERT_NEON)
+	for(;x+16<=count;x+=16) {
+		uint8x16x3_t in = vld3q_u8(src + x*3);
+		uint8x16x4_t out;
+		out.val[0] = in.val[2];
+		out.val[1] = in.val[1];
+		out.val[2] = in.val[0];
+		out.val[3] = vdupq_n_u8(255);
+		vst4q_u8(dst + x*4,out);
+	}
+#endif
+	for(;x<count;x++) {
+		dst[x*4] = src[x*3+2];
+		dst[x*4+1] = src[x*3+1];
+		dst[x*4+2] = src[x*3];
+		dst[x*4+3] = 255;
+	}
+}
+
+void convertBgraToRgb(const GLubyte* src,GLubyte* dst,GLuint count) {
+	GLuint x = 0;
+#if defined(CONVERT_SSSE3)
+	const __m128i shuffle = _mm_setr_epi8(2,1,0,6,5,4,10,9,8,14,13,12,-1,-1,-1,-1);
+	for(;x+16<=count;x+=16)
+		pack16(src + x*4,dst + x*3,shuffle);
+#elif defined(CONVERT_NEON)
+	for(;x+16<=count;x+=16) {
+		uint8x16x4_t in = vld4q_u8(src + x*4);
+		uint8x16x3_t out;
+		out.val[0] = in.val[2];
+		out.val[1] = in.val[1];
+		out.val[2] = in.val[0];
+		vst3q_u8(dst + x*3,out);
+	}
+#endif
+	for(;x<count;x++) {
+		dst[x*3] = src[x*4+2];
+		dst[x*3+1] = src[x*4+1];
+		dst[x*3+2] = src[x*4];
+	}
+}
+
+void swizzleRgba(const GLubyte* src,GLubyte* dst,GLuint count,const GLubyte order[4]) {
+	GLuint x = 0;
+#if defined(CONVERT_SSSE3)
+	GLubyte lanes[16];
+	for(int i=0;i<16;i++)
+		lanes[i] = (i & ~3) + (order[i & 3] & 3);
+	const __m128i shuffle = _mm_loadu_si128((const __m128i*)lanes);
+	for(;x+4<=count;x+=4)
+		_mm_storeu_si128((__m128i*)(dst + x*4),_mm_shuffle_epi8(_mm_loadu_si128((const __m128i*)(src + x*4)),shuffle));
+#elif defined(CONVERT_NEON)
+	for(;x+16<=count;x+=16) {
+		uint8x16x4_t in = vld4q_u8(src + x*4);
+		uint8x16x4_t out;
+		for(int i=0;i<4;i++)
+			out.val[i] = in.val[order[i] & 3];
+		vst4q_u8(dst + x*4,out);
+	}
+#endif
+	for(;x<count;x++) {
+		const GLubyte* p = src + x*4;
+		GLubyte* q = dst + x*4;
+		q[0] = p[order[0] & 3];
+		q[1] = p[order[1] & 3];
+		q[2] = p[order[2] & 3];
+		q[3] = p[order[3] & 3];
+	}
+}
+
+// Luma of 3 or 4 channel pixels with the weights of the channels in memory
+// order, which puts BGRA through the same code as RGBA
+static void grayRow(const GLubyte* src,GLubyte* dst,GLuint count,GLuint channels,int w0,int w1,int w2) {
+	GLuint x = 0;
+#if defined(__SSE2__)
+	const __m128i byteMask = _mm_set1_epi32(0xff);
+	const __m128i v0 = _mm_set1_epi16(w0), v1 = _mm_set1_epi16(w1), v2 = _mm_set1_epi16(w2);
+#if defined(CONVERT_SSSE3)
+	const __m128i expand = _mm_setr_epi8(0,1,2,-1,3,4,5,-1,6,7,8,-1,9,10,11,-1);
+	GLubyte spread[64];
+#endif
+	for(;x+16<=count;x+=16) {
+		const GLubyte* p = src + x*channels;
+#if defined(CONVERT_SSSE3)
+		if(channels == 3) {
+			expand16(p,spread,expand,_mm_setzero_si128());
+			p = spread;
+		}
+#else
+		if(channels == 3)
+			break;
+#endif
+		for(int half=0;half<2;half++) {
+			__m128i p0 = _mm_loadu_si128((const __m128i*)(p + half*32));
+			__m128i p1 = _mm_loadu_si128((const __m128i*)(p + half*32 + 16));
+			__m128i c0 = _mm_packs_epi32(_mm_and_si128(p0,byteMask),_mm_and_si128(p1,byteMask));
+			__m128i c1 = _mm_packs_epi32(_mm_and_si128(_mm_srli_epi32(p0,8),byteMask),_mm_and_si128(_mm_srli_epi32(p1,8),byteMask));
+			__m128i c2 = _mm_packs_epi32(_mm_and_si128(_mm_srli_epi32(p0,16),byteMask),_mm_and_si128(_mm_srli_epi32(p1,16),byteMask));
+			// the weighted sum stays below 65536, so wrapping 16 bit lanes hold it exactly
+			__m128i y = _mm_add_epi16(_mm_add_epi16(_mm_mullo_epi16(c0,v0),_mm_mullo_epi16(c1,v1)),_mm_mullo_epi16(c2,v2));
+			y = _mm_srli_epi16(y,8);
+			_mm_storel_epi64((__m128i*)(dst + x + half*8),_mm_packus_epi16(y,y));
+		}
+	}
+#elif defined(CONVERT_NEON)
+	const uint8x8_t v0 = vdup_n_u8(w0), v1 = vdup_n_u8(w1), v2 = vdup_n_u8(w2);
+	for(;x+8<=count;x+=8) {
+		uint8x8_t c0,c1,c2;
+		if(channels == 4) {
+			uint8x8x4_t px = vld4_u8(src + x*4);
+			c0 = px.val[0];
+			c1 = px.val[1];
+			c2 = px.val[2];
+		}
+		else {
+			uint8x8x3_t px = vld3_u8(src + x*3);
+			c0 = px.val[0];
+			c1 = px.val[1];
+			c2 = px.val[2];
+		}
+		uint16x8_t y = vmull_u8(c0,v0);
+		y = vmlal_u8(y,c1,v1);
+		y = vmlal_u8(y,c2,v2);
+		vst1_u8(dst + x,vshrn_n_u16(y,8));
+	}
+#endif
+	for(;x<count;x++) {
+		const GLubyte* p = src + x*channels;
+		dst[x] = (w0*p[0] + w1*p[1] + w2*p[2]) >> 8;
+	}
+}
+
+void convertToGray(const GLubyte* src,GLubyte* dst,GLuint count,GLuint channels) {
+	if(channels >= 3) {
+		grayRow(src,dst,count,channels,77,150,29);
+		return;
+	}
+	if(channels == 1) {
+		memcpy(dst,src,count);
+		return;
+	}
+	GLuint x = 0;
+#if defined(CONVERT_NEON)
+	for(;x+16<=count;x+=16)
+		vst1q_u8(dst + x,vld2q_u8(src + x*2).val[0]);
+#endif
+	for(;x<count;x++)
+		dst[x] = src[x*2];
+}
+
+void copyRows(const GLubyte* src,GLuint srcStride,GLubyte* dst,GLuint dstStride,GLuint rowBytes,GLuint rows) {
+	if(srcStride == rowBytes && dstStride == rowBytes) {
+		memcpy(dst,src,(size_t)rowBytes * rows);
+		return;
+	}
+	for(GLuint y=0;y<rows;y++)
+		memcpy(dst + (size_t)y * dstStride,src + (size_t)y * srcStride,rowBytes);
+}
+
+static bool isConvertible(GLenum format,bool source) {
+	switch(format) {
+		case GL_LUMINANCE_ALPHA:
+			return source;
+		case GL_LUMINANCE:
+		case GL_RGB:
+		case GL_RGBA:
+		case GL_BGRA_EXT:
+			return true;
+		default:
+			return false;
+	}
+}
+
+// RGBA of one pixel of format
+static inline void decodePixel(const GLubyte* p,GLenum format,GLubyte* rgba) {
+	switch(format) {
+		case GL_LUMINANCE:
+			rgba[0] = rgba[1] = rgba[2] = p[0];
+			rgba[3] = 255;
+			break;
+		case GL_LUMINANCE_ALPHA:
+			rgba[0] = rgba[1] = rgba[2] = p[0];
+			rgba[3] = p[1];
+			break;
+		case GL_RGB:
+			rgba[0] = p[0];
+			rgba[1] = p[1];
+			rgba[2] = p[2];
+			rgba[3] = 255;
+			break;
+		case GL_BGRA_EXT:
+			rgba[0] = p[2];
+			rgba[1] = p[1];
+			rgba[2] = p[0];
+			rgba[3] = p[3];
+			break;
+		default:
+			memcpy(rgba,p,4);
+			break;
+	}
+}
+
+static inline void encodePixel(const GLubyte* rgba,GLenum format,GLubyte* p) {
+	switch(format) {
+		case GL_LUMINANCE:
+			// gray pixels come back unchanged, (77 + 150 + 29) * l >> 8 == l
+			p[0] = getPixelLuma(rgba,3);
+			break;
+		case GL_RGB:
+			p[0] = rgba[0];
+			p[1] = rgba[1];
+			p[2] = rgba[2];
+			break;
+		case GL_BGRA_EXT:
+			p[0] = rgba[2];
+			p[1] = rgba[1];
+			p[2] = rgba[0];
+			p[3] = rgba[3];
+			break;
+		default:
+			memcpy(p,rgba,4);
+			break;
+	}
+}
+
+static void convertRowScalar(const GLubyte* src,GLenum srcFormat,GLubyte* dst,GLenum dstFormat,GLuint width) {
+	const GLuint srcSize = getPixelSize(srcFormat,GL_UNSIGNED_BYTE), dstSize = getPixelSize(dstFormat,GL_UNSIGNED_BYTE);
+	GLubyte rgba[4];
+	for(GLuint x=0;x<width;x++) {
+		decodePixel(src + x * srcSize,srcFormat,rgba);
+		encodePixel(rgba,dstFormat,dst + x * dstSize);
+	}
+}
+
+static void convertRow(const GLubyte* src,GLenum srcFormat,GLubyte* dst,GLenum dstFormat,GLuint width) {
+	if(srcFormat == dstFormat) {
+		memcpy(dst,src,width * getPixelSize(srcFormat,GL_UNSIGNED_BYTE));
+		return;
+	}
+	switch(dstFormat) {
+		case GL_LUMINANCE:
+			if(srcFormat == GL_BGRA_EXT)
+				grayRow(src,dst,width,4,29,150,77);
+			else
+				convertToGray(src,dst,width,getPixelSize(srcFormat,GL_UNSIGNED_BYTE));
+			return;
+		case GL_RGB:
+			if(srcFormat == GL_RGBA) {
+				convertRgbaToRgb(src,dst,width);
+				return;
+			}
+			if(srcFormat == GL_BGRA_EXT) {
+				convertBgraToRgb(src,dst,width);
+				return;
+			}
+			break;
+		case GL_RGBA:
+			if(srcFormat == GL_RGB) {
+				convertRgbToRgba(src,dst,width);
+				return;
+			}
+			if(srcFormat == GL_BGRA_EXT) {
+				swizzleRgba(src,dst,width,rgbaToBgra);
+				return;
+			}
+			break;
+		case GL_BGRA_EXT:
+			if(srcFormat == GL_RGB) {
+				convertRgbToBgra(src,dst,width);
+				return;
+			}
+			if(srcFormat == GL_RGBA) {
+				swizzleRgba(src,dst,width,rgbaToBgra);
+				return;
+			}
+			break;
+	}
+	// gray and gray-alpha sources
+	convertRowScalar(src,srcFormat,dst,dstFormat,width);
+}
+
+bool convertPixels(const GLubyte* src,GLuint srcStride,GLenum srcFormat,GLubyte* dst,GLuint dstStride,GLenum dstFormat,
+		GLuint width,GLuint height) {
+	if(!isConvertible(srcFormat,true) || !isConvertible(dstFormat,false))
+		return false;
+	const GLuint srcRow = width * getPixelSize(srcFormat,GL_UNSIGNED_BYTE), dstRow = width * getPixelSize(dstFormat,GL_UNSIGNED_BYTE);
+	srcStride = srcStride ? srcStride : srcRow;
+	dstStride = dstStride ? dstStride : dstRow;
+	if(srcFormat == dstFormat) {
+		copyRows(src,srcStride,dst,dstStride,srcRow,height);
+		return true;
+	}
+	for(GLuint y=0;y<height;y++)
+		convertRow(src + (size_t)y * srcStride,srcFormat,dst + (size_t)y * dstStride,dstFormat,width);
+	return true;
+}
+
+bool convertPixelsScalar(const GLubyte* src,GLuint srcStride,GLenum srcFormat,GLubyte* dst,GLuint dstStride,GLenum dstFormat,
+		GLuint width,GLuint height) {
+	if(!isConvertible(srcFormat,true) || !isConvertible(dstFormat,false))
+		return false;
+	srcStride = srcStride ? srcStride : width * getPixelSize(srcFormat,GL_UNSIGNED_BYTE);
+	dstStride = dstStride ? dstStride : width * getPixelSize(dstFormat,GL_UNSIGNED_BYTE);
+	for(GLuint y=0;y<height;y++)
+		convertRowScalar(src + (size_t)y * srcStride,srcFormat,dst + (size_t)y * dstStride,dstFormat,width);
+	return true;
+}
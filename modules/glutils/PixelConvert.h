@@ -0,0 +1,43 @@
+/*
+ * PixelConvert.h
+ *
+ *  Created on: 19-10-2026
+ */
+
+#ifndef PIXELCONVERT_H_
+#define PIXELCONVERT_H_
+
+#include "GLUtils.h"
+
+/*
+ * Conversions between the GL_UNSIGNED_BYTE layouts textures are uploaded
+ * and read back in. The row kernels take a pixel count and use SSSE3 or NEON
+ * when available (gray also SSE2), plain loops otherwise; source and
+ * destination must not overlap. Gray is luma as in ImageStats.h, or the
+ * first channel of 2 channel pixels.
+ */
+void convertRgbToRgba(const GLubyte* src,GLubyte* dst,GLuint count);
+void convertRgbaToRgb(const GLubyte* src,GLubyte* dst,GLuint count);
+void convertRgbToBgra(const GLubyte* src,GLubyte* dst,GLuint count);
+void convertBgraToRgb(const GLubyte* src,GLubyte* dst,GLuint count);
+// dst channel i is src channel order[i]; RGBA to BGRA and back is { 2, 1, 0, 3 }
+void swizzleRgba(const GLubyte* src,GLubyte* dst,GLuint count,const GLubyte order[4]);
+// channels 1 to 4, RGB order
+void convertToGray(const GLubyte* src,GLubyte* dst,GLuint count,GLuint channels);
+
+// rowBytes of each of rows rows; removes or inserts row padding
+void copyRows(const GLubyte* src,GLuint srcStride,GLubyte* dst,GLuint dstStride,GLuint rowBytes,GLuint rows);
+
+/*
+ * width x height pixels from srcFormat to dstFormat, each GL_LUMINANCE,
+ * GL_LUMINANCE_ALPHA (source only), GL_RGB, GL_RGBA or GL_BGRA_EXT. Strides
+ * are the bytes between row starts, 0 for tightly packed rows. False for
+ * pairs without a kernel.
+ */
+bool convertPixels(const GLubyte* src,GLuint srcStride,GLenum srcFormat,GLubyte* dst,GLuint dstStride,GLenum dstFormat,
+		GLuint width,GLuint height);
+// The same one pixel at a time, the reference for convertPixels
+bool convertPixelsScalar(const GLubyte* src,GLuint srcStride,GLenum srcFormat,GLubyte* dst,GLuint dstStride,GLenum dstFormat,
+		GLuint width,GLuint height);
+
+#endif /* PIXELCONVERT_H_ */
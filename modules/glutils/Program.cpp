@@ -0,0 +1,183 @@
+/*
+ * Program.cpp
+ *
+ *  Created on: 19-10-2026
+ */
+
+#include "Program.h"
+#include "logger.h"
+#include <string.h>
+#include <algorithm>
+
+GLuint Program::currentHandle = 0;
+
+template<typename T>
+static bool byName(const T& a,const T& b) {
+	return a.name < b.name;
+}
+
+// glGetActiveUniform reports arrays as "name[0]"
+static std::string baseName(const char* name) {
+	const char* bracket = strchr(name,'[');
+	return bracket ? std::string(name,bracket - name) : std::string(name);
+}
+
+Program::Program(GLuint handle):handle(handle),dirtyCount(0),uploads(0) {
+	GLint count = 0, maxLength = 0;
+	glGetProgramiv(handle, GL_ACTIVE_ATTRIBUTE_MAX_LENGTH, &maxLength);
+	GLint uniformMaxLength = 0;
+	glGetProgramiv(handle, GL_ACTIVE_UNIFORM_MAX_LENGTH, &uniformMaxLength);
+	std::vector<char> name(std::max(maxLength,uniformMaxLength) + 1);
+
+	glGetProgramiv(handle, GL_ACTIVE_ATTRIBUTES, &count);
+	for(GLint i=0;i<count;i++) {
+		Attribute a;
+		glGetActiveAttrib(handle, i, name.size(), NULL, &a.size, &a.type, &name[0]);
+		a.name = baseName(&name[0]);
+		a.location = glGetAttribLocation(handle, &name[0]);
+		attributes.push_back(a);
+	}
+	std::sort(attributes.begin(),attributes.end(),byName<Attribute>);
+
+	glGetProgramiv(handle, GL_ACTIVE_UNIFORMS, &count);
+	for(GLint i=0;i<count;i++) {
+		Uniform u;
+		GLint size;
+		glGetActiveUniform(handle, i, name.size(), NULL, &size, &u.type, &name[0]);
+		u.name = baseName(&name[0]);
+		u.location = glGetUniformLocation(handle, u.name.c_str());
+		// GL initializes every uniform to zero
+		u.dirty = false;
+		memset(u.ints,0,sizeof(u.ints));
+		memset(u.floats,0,sizeof(u.floats));
+		uniforms.push_back(u);
+	}
+	std::sort(uniforms.begin(),uniforms.end(),byName<Uniform>);
+	CheckGlError("Program: reflection");
+}
+
+Program::~Program() {
+	if(currentHandle == handle)
+		currentHandle = 0;
+	glDeleteProgram(handle);
+}
+
+GLuint Program::getHandle() {
+	return handle;
+}
+
+GLint Program::getAttribLocation(const char* name) {
+	for(unsigned int i=0;i<attributes.size();i++) {
+		if(attributes[i].name == name)
+			return attributes[i].location;
+	}
+	return -1;
+}
+
+Program::Uniform* Program::findUniform(const char* name) {
+	Uniform key;
+	key.name = name;
+	std::vector<Uniform>::iterator it = std::lower_bound(uniforms.begin(),uniforms.end(),key,byName<Uniform>);
+	return it != uniforms.end() && it->name == name ? &*it : NULL;
+}
+
+GLint Program::getUniformLocation(const char* name) {
+	Uniform* u = findUniform(name);
+	return u ? u->location : -1;
+}
+
+bool Program::hasUniform(const char* name) {
+	return findUniform(name) != NULL;
+}
+
+void Program::setUniform1i(const char* name,GLint value) {
+	Uniform* u = findUniform(name);
+	if(!u || u->ints[0] == value)
+		return;
+	u->ints[0] = value;
+	if(!u->dirty) {
+		u->dirty = true;
+		dirtyCount++;
+	}
+}
+
+void Program::setFloats(const char* name,const GLfloat* values,int count) {
+	Uniform* u = findUniform(name);
+	if(!u || !memcmp(u->floats,values,count * sizeof(GLfloat)))
+		return;
+	memcpy(u->floats,values,count * sizeof(GLfloat));
+	if(!u->dirty) {
+		u->dirty = true;
+		dirtyCount++;
+	}
+}
+
+void Program::setUniform1f(const char* name,GLfloat value) {
+	setFloats(name,&value,1);
+}
+
+void Program::setUniform2f(const char* name,GLfloat x,GLfloat y) {
+	GLfloat v[2] = { x, y };
+	setFloats(name,v,2);
+}
+
+void Program::setUniform3fv(const char* name,const GLfloat* value) {
+	setFloats(name,value,3);
+}
+
+void Program::setUniform4fv(const char* name,const GLfloat* value) {
+	setFloats(name,value,4);
+}
+
+void Program::setUniformMatrix3fv(const char* name,const GLfloat* value) {
+	setFloats(name,value,9);
+}
+
+void Program::setUniformMatrix4fv(const char* name,const GLfloat* value) {
+	setFloats(name,value,16);
+}
+
+void Program::upload(const Uniform& u) {
+	switch(u.type) {
+		case GL_FLOAT:			glUniform1fv(u.location, 1, u.floats); break;
+		case GL_FLOAT_VEC2:		glUniform2fv(u.location, 1, u.floats); break;
+		case GL_FLOAT_VEC3:		glUniform3fv(u.location, 1, u.floats); break;
+		case GL_FLOAT_VEC4:		glUniform4fv(u.location, 1, u.floats); break;
+		case GL_FLOAT_MAT2:		glUniformMatrix2fv(u.location, 1, GL_FALSE, u.floats); break;
+		case GL_FLOAT_MAT3:		glUniformMatrix3fv(u.location, 1, GL_FALSE, u.floats); break;
+		case GL_FLOAT_MAT4:		glUniformMatrix4fv(u.location, 1, GL_FALSE, u.floats); break;
+		case GL_INT_VEC2:
+		case GL_BOOL_VEC2:		glUniform2iv(u.location, 1, u.ints); break;
+		case GL_INT_VEC3:
+		case GL_BOOL_VEC3:		glUniform3iv(u.location, 1, u.ints); break;
+		case GL_INT_VEC4:
+		case GL_BOOL_VEC4:		glUniform4iv(u.location, 1, u.ints); break;
+		default:				glUniform1iv(u.location, 1, u.ints); break;	// int, bool, samplers
+	}
+	uploads++;
+}
+
+void Program::use() {
+	if(currentHandle != handle) {
+		glUseProgram(handle);
+		currentHandle = handle;
+	}
+	if(!dirtyCount)
+		return;
+	for(unsigned int i=0;i<uniforms.size();i++) {
+		if(uniforms[i].dirty) {
+			upload(uniforms[i]);
+			uniforms[i].dirty = false;
+		}
+	}
+	dirtyCount = 0;
+	CheckGlError("Program::use: glUniform");
+}
+
+unsigned int Program::getUploadCount() {
+	return uploads;
+}
+
+void Program::invalidateCurrent() {
+	currentHandle = 0;
+}
@@ -0,0 +1,84 @@
+/*
+ * Program.h
+ *
+ *  Created on: 19-10-2026
+ */
+
+#ifndef PROGRAM_H_
+#define PROGRAM_H_
+
+#include <GLES2/gl2.h>
+#include <string>
+#include <vector>
+
+/*
+ * Locations createProgram binds before linking, so every program built from
+ * the shared vertex shader uses the same vertex layout.
+ */
+enum {
+	ATTRIB_POSITION = 0,	// aPosition
+	ATTRIB_TEXCOORD = 1		// aTexCoord
+};
+
+/*
+ * A linked program with its active attributes and uniforms reflected once
+ * into a table sorted by name. Uniform setters only record values; use()
+ * makes the program current and uploads the uniforms whose value changed
+ * since the last upload. Setters on names the program does not use are
+ * ignored, so one set of calls fits every variant. Arrays are tracked by
+ * their first element. Owns the GL program.
+ */
+class Program {
+public:
+	explicit Program(GLuint handle);
+	virtual ~Program();
+
+	GLuint getHandle();
+	GLint getAttribLocation(const char* name);
+	GLint getUniformLocation(const char* name);
+	bool hasUniform(const char* name);
+
+	void setUniform1i(const char* name,GLint value);
+	void setUniform1f(const char* name,GLfloat value);
+	void setUniform2f(const char* name,GLfloat x,GLfloat y);
+	void setUniform3fv(const char* name,const GLfloat* value);
+	void setUniform4fv(const char* name,const GLfloat* value);
+	void setUniformMatrix3fv(const char* name,const GLfloat* value);
+	void setUniformMatrix4fv(const char* name,const GLfloat* value);
+
+	void use();
+	// Uniform uploads issued by use() since construction
+	unsigned int getUploadCount();
+	// Forget which program is current, e.g. after glUseProgram elsewhere
+	static void invalidateCurrent();
+private:
+	typedef struct
+	{
+		std::string name;
+		GLint location;
+		GLenum type;
+		GLint size;
+	} Attribute;
+	typedef struct
+	{
+		std::string name;
+		GLint location;
+		GLenum type;
+		bool dirty;
+		GLint ints[4];
+		GLfloat floats[16];
+	} Uniform;
+
+	Uniform* findUniform(const char* name);
+	void setFloats(const char* name,const GLfloat* values,int count);
+	void upload(const Uniform& uniform);
+
+	GLuint handle;
+	std::vector<Attribute> attributes;
+	std::vector<Uniform> uniforms;	// sorted by name
+	unsigned int dirtyCount,uploads;
+
+	static GLuint currentHandle;
+};
+
+#endif /* PROGRAM_H_ */
@@ -0,0 +1,346 @@
+/*
+ * RenderGraph.cpp
+ *
+ *  Created on: 19-10-2026
+ */
+
+#include "RenderGraph.h"
+#include "GpuMemory.h"
+#include "Program.h"
+#include "logger.h"
+#include <algorithm>
+#include <limits.h>
+
+RenderGraph::RenderGraph():compiled(false),allocatedBytes(0),unaliasedBytes(0),peakIntermediateBytes(0) {
+	gpuMemoryAddEvictor(evictPool,this);
+}
+
+RenderGraph::~RenderGraph() {
+	gpuMemoryRemoveEvictor(this);
+	for(unsigned int i=0;i<pool.size();i++)
+		delete pool[i].fb;
+}
+
+int RenderGraph::importTexture(const char* name,GLuint texture,GLuint width,GLuint height) {
+	Resource resource = { name, width, height, GL_RGBA, GL_UNSIGNED_BYTE, texture, true, false, -1, -1, -1 };
+	resources.push_back(resource);
+	compiled = false;
+	return resources.size() - 1;
+}
+
+int RenderGraph::createTarget(const char* name,GLuint width,GLuint height,GLenum format,GLenum type) {
+	Resource resource = { name, width, height, format, type, 0, false, false, -1, -1, -1 };
+	resources.push_back(resource);
+	compiled = false;
+	return resources.size() - 1;
+}
+
+int RenderGraph::addPass(const char* name,RenderPassBody* body) {
+	Pass pass;
+	pass.name = name;
+	pass.body = body;
+	pass.write = -1;
+	pass.live = false;
+	passes.push_back(pass);
+	compiled = false;
+	return passes.size() - 1;
+}
+
+void RenderGraph::read(int pass,int resource) {
+	if((int)passes[pass].reads.size() >= RENDER_GRAPH_MAX_INPUTS) {
+		LogError("RenderGraph: pass %s reads more than %d resources",passes[pass].name.c_str(),RENDER_GRAPH_MAX_INPUTS);
+		return;
+	}
+	passes[pass].reads.push_back(resource);
+	compiled = false;
+}
+
+void RenderGraph::write(int pass,int resource) {
+	Resource& r = resources[resource];
+	if(r.imported || r.writer >= 0 || passes[pass].write >= 0) {
+		LogError("RenderGraph: pass %s cannot write %s",passes[pass].name.c_str(),r.name.c_str());
+		return;
+	}
+	r.writer = pass;
+	passes[pass].write = resource;
+	compiled = false;
+}
+
+void RenderGraph::markOutput(int resource) {
+	resources[resource].output = true;
+	compiled = false;
+}
+
+size_t RenderGraph::getTargetBytes(const Resource& resource) {
+	return gpuMemoryGetTextureSize(resource.width,resource.height,resource.format,resource.type);
+}
+
+bool RenderGraph::validate() {
+	for(unsigned int p=0;p<passes.size();p++) {
+		const Pass& pass = passes[p];
+		if(pass.write < 0) {
+			LogError("RenderGraph: pass %s writes nothing",pass.name.c_str());
+			return false;
+		}
+		for(unsigned int i=0;i<pass.reads.size();i++) {
+			const Resource& r = resources[pass.reads[i]];
+			if(pass.reads[i] == pass.write) {
+				LogError("RenderGraph: pass %s reads the target it writes",pass.name.c_str());
+				return false;
+			}
+			if(!r.imported && r.writer < 0) {
+				LogError("RenderGraph: pass %s reads %s, which no pass writes",pass.name.c_str(),r.name.c_str());
+				return false;
+			}
+		}
+	}
+	return true;
+}
+
+// A pass lives if an output depends on what it writes
+void RenderGraph::cull() {
+	std::vector<int> stack;
+	for(unsigned int p=0;p<passes.size();p++)
+		passes[p].live = false;
+	for(unsigned int r=0;r<resources.size();r++) {
+		if(resources[r].output && resources[r].writer >= 0)
+			stack.push_back(resources[r].writer);
+	}
+	while(!stack.empty()) {
+		Pass& pass = passes[stack.back()];
+		stack.pop_back();
+		if(pass.live)
+			continue;
+		pass.live = true;
+		for(unsigned int i=0;i<pass.reads.size();i++) {
+			int writer = resources[pass.reads[i]].writer;
+			if(writer >= 0 && !passes[writer].live)
+				stack.push_back(writer);
+		}
+	}
+}
+
+// Kahn's algorithm, taking the earliest declared pass that is ready so
+// independent passes keep their declaration order
+bool RenderGraph::order() {
+	std::vector<int> waiting(passes.size(),0);
+	int live = 0;
+	for(unsigned int p=0;p<passes.size();p++) {
+		if(!passes[p].live)
+			continue;
+		live++;
+		for(unsigned int i=0;i<passes[p].reads.size();i++) {
+			if(resources[passes[p].reads[i]].writer >= 0)
+				waiting[p]++;
+		}
+	}
+	schedule.clear();
+	std::vector<bool> done(passes.size(),false);
+	while((int)schedule.size() < live) {
+		int next = -1;
+		for(unsigned int p=0;p<passes.size() && next < 0;p++) {
+			if(passes[p].live && !done[p] && waiting[p] == 0)
+				next = p;
+		}
+		if(next < 0) {
+			LogError("RenderGraph: the passes depend on each other in a cycle");
+			return false;
+		}
+		done[next] = true;
+		schedule.push_back(next);
+		for(unsigned int p=0;p<passes.size();p++) {
+			if(!passes[p].live || done[p])
+				continue;
+			for(unsigned int i=0;i<passes[p].reads.size();i++) {
+				if(resources[passes[p].reads[i]].writer == next)
+					waiting[p]--;
+			}
+		}
+	}
+	return true;
+}
+
+void RenderGraph::assignTargets() {
+	for(unsigned int r=0;r<resources.size();r++) {
+		resources[r].target = -1;
+		resources[r].lastUse = -1;
+	}
+	for(unsigned int s=0;s<schedule.size();s++) {
+		const Pass& pass = passes[schedule[s]];
+		for(unsigned int i=0;i<pass.reads.size();i++)
+			resources[pass.reads[i]].lastUse = s;
+		Resource& written = resources[pass.write];
+		written.lastUse = std::max(written.lastUse,(int)s);
+		if(written.output)
+			written.lastUse = INT_MAX;
+	}
+
+	// the resource in each pool entry while the schedule runs
+	std::vector<int> occupant(pool.size(),-1);
+	for(unsigned int t=0;t<pool.size();t++)
+		pool[t].used = false;
+	allocatedBytes = unaliasedBytes = peakIntermediateBytes = 0;
+	for(unsigned int s=0;s<schedule.size();s++) {
+		for(unsigned int t=0;t<occupant.size();t++) {
+			if(occupant[t] >= 0 && resources[occupant[t]].lastUse < (int)s)
+				occupant[t] = -1;
+		}
+		int id = passes[schedule[s]].write;
+		Resource& r = resources[id];
+		int target = -1;
+		for(unsigned int t=0;t<pool.size() && target < 0;t++) {
+			const Target& candidate = pool[t];
+			if(occupant[t] < 0 && candidate.width == r.width && candidate.height == r.height &&
+					candidate.format == r.format && candidate.type == r.type)
+				target = t;
+		}
+		if(target < 0) {
+			Target created = { NULL, r.width, r.height, r.format, r.type, false };
+			pool.push_back(created);
+			occupant.push_back(-1);
+			target = pool.size() - 1;
+		}
+		if(!pool[target].fb)
+			pool[target].fb = new Framebuffer(r.width,r.height,0,r.format,r.type,0,"RenderGraph");
+		if(!pool[target].used)
+			allocatedBytes += getTargetBytes(r);
+		pool[target].used = true;
+		occupant[target] = id;
+		r.target = target;
+		unaliasedBytes += getTargetBytes(r);
+
+		size_t intermediate = 0;
+		for(unsigned int t=0;t<occupant.size();t++) {
+			if(occupant[t] >= 0 && !resources[occupant[t]].output)
+				intermediate += getTargetBytes(resources[occupant[t]]);
+		}
+		peakIntermediateBytes = std::max(peakIntermediateBytes,intermediate);
+	}
+}
+
+bool RenderGraph::compile() {
+	compiled = false;
+	if(!validate())
+		return false;
+	cull();
+	if(!order())
+		return false;
+	assignTargets();
+	compiled = true;
+	return true;
+}
+
+bool RenderGraph::execute() {
+	if(!compiled && !compile())
+		return false;
+	for(unsigned int s=0;s<schedule.size();s++) {
+		const Pass& pass = passes[schedule[s]];
+		Framebuffer* fb = pool[resources[pass.write].target].fb;
+		RenderPassIO io;
+		io.inputCount = pass.reads.size();
+		for(int i=0;i<io.inputCount;i++) {
+			const Resource& input = resources[pass.reads[i]];
+			io.inputTextures[i] = input.imported ? input.texture : pool[input.target].fb->getTexture();
+			io.inputWidths[i] = input.width;
+			io.inputHeights[i] = input.height;
+		}
+		io.outputWidth = fb->getWidth();
+		io.outputHeight = fb->getHeight();
+
+		fb->bind();
+		fb->setViewPort();
+		pass.body->execute(io);
+		fb->unbind();
+		fb->recoverSavedViewPort();
+	}
+	return true;
+}
+
+Framebuffer* RenderGraph::getOutput(int resource) {
+	const Resource& r = resources[resource];
+	if(!compiled || !r.output || r.target < 0)
+		return NULL;
+	return pool[r.target].fb;
+}
+
+void RenderGraph::reset() {
+	resources.clear();
+	passes.clear();
+	schedule.clear();
+	compiled = false;
+	for(unsigned int t=0;t<pool.size();t++)
+		pool[t].used = false;
+}
+
+size_t RenderGraph::trimPool(size_t bytes) {
+	size_t freed = 0;
+	std::vector<Target> kept;
+	std::vector<int> moved(pool.size(),-1);
+	for(unsigned int t=0;t<pool.size();t++) {
+		if(pool[t].used || freed >= bytes) {
+			moved[t] = kept.size();
+			kept.push_back(pool[t]);
+		}
+		else if(pool[t].fb) {
+			freed += gpuMemoryGetTextureSize(pool[t].width,pool[t].height,pool[t].format,pool[t].type);
+			delete pool[t].fb;
+		}
+	}
+	pool.swap(kept);
+	for(unsigned int r=0;r<resources.size();r++) {
+		if(resources[r].target >= 0)
+			resources[r].target = moved[resources[r].target];
+	}
+	return freed;
+}
+
+size_t RenderGraph::evictPool(void* graph,size_t bytes) {
+	return ((RenderGraph*)graph)->trimPool(bytes);
+}
+
+int RenderGraph::getPassCount() {
+	return passes.size();
+}
+
+int RenderGraph::getExecutedPassCount() {
+	return compiled ? schedule.size() : 0;
+}
+
+int RenderGraph::getFramebufferCount() {
+	int count = 0;
+	for(unsigned int t=0;t<pool.size();t++)
+		count += pool[t].used;
+	return count;
+}
+
+size_t RenderGraph::getAllocatedBytes() {
+	return allocatedBytes;
+}
+
+size_t RenderGraph::getUnaliasedBytes() {
+	return unaliasedBytes;
+}
+
+size_t RenderGraph::getPeakIntermediateBytes() {
+	return peakIntermediateBytes;
+}
+
+void RenderGraph::logStats(const char* name) {
+	int targets = 0;
+	for(unsigned int r=0;r<resources.size();r++)
+		targets += resources[r].target >= 0;
+	Log("%s: %d passes, %d executed, %d culled; %d targets in %d framebuffers",name,getPassCount(),getExecutedPassCount(),
+			getPassCount() - getExecutedPassCount(),targets,getFramebufferCount());
+	Log("%s: %.2f MB allocated, %.2f MB without aliasing, peak intermediate %.2f MB",name,allocatedBytes / 1048576.0,
+			unaliasedBytes / 1048576.0,peakIntermediateBytes / 1048576.0);
+}
+
+void drawRenderPassQuad() {
+	static const GLfloat positions[] = { -1.0f, -1.0f, 1.0f, -1.0f, -1.0f, 1.0f, 1.0f, 1.0f };
+	static const GLfloat texCoords[] = { 0.0f, 0.0f, 1.0f, 0.0f, 0.0f, 1.0f, 1.0f, 1.0f };
+	glEnableVertexAttribArray(ATTRIB_POSITION);
+	glEnableVertexAttribArray(ATTRIB_TEXCOORD);
+	glVertexAttribPointer(ATTRIB_POSITION, 2, GL_FLOAT, GL_FALSE, 0, positions);
+	glVertexAttribPointer(ATTRIB_TEXCOORD, 2, GL_FLOAT, GL_FALSE, 0, texCoords);
+	glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
+}
@@ -0,0 +1,131 @@
+/*
+ * RenderGraph.h
+ *
+ *  Created on: 19-10-2026
+ */
+
+#ifndef RENDERGRAPH_H_
+#define RENDERGRAPH_H_
+
+#include <GLES2/gl2.h>
+#include <string>
+#include <vector>
+#include "Framebuffer.h"
+
+#define RENDER_GRAPH_MAX_INPUTS 4
+
+typedef struct
+{
+	int inputCount;
+	GLuint inputTextures[RENDER_GRAPH_MAX_INPUTS];
+	GLuint inputWidths[RENDER_GRAPH_MAX_INPUTS];
+	GLuint inputHeights[RENDER_GRAPH_MAX_INPUTS];
+	GLuint outputWidth;
+	GLuint outputHeight;
+} RenderPassIO;
+
+/*
+ * The drawing done by one pass. Called with the output bound and the
+ * viewport covering it; inputs come in the order they were read.
+ */
+class RenderPassBody {
+public:
+	virtual ~RenderPassBody() {}
+	virtual void execute(const RenderPassIO& io) = 0;
+};
+
+/*
+ * Multi-pass rendering without hand managed Framebuffers. Passes declare
+ * the resources they read and the one they write (GLES2 has a single color
+ * attachment); compile() then
+ *  - culls passes that do not lead to a resource marked as output,
+ *  - orders the rest so every resource is written before it is read,
+ *  - gives each transient target a pooled Framebuffer, reusing one whose
+ *    previous content has been read for the last time (same size, format
+ *    and type only: a GLES2 texture cannot be reshaped in place).
+ * The pool outlives reset(), so a graph rebuilt every frame allocates
+ * nothing once warm; unused pool entries are given up to the GPU memory
+ * budget (GpuMemory.h). GL thread only.
+ */
+class RenderGraph {
+public:
+	RenderGraph();
+	virtual ~RenderGraph();
+
+	// Declarations return ids, valid until reset()
+	int importTexture(const char* name,GLuint texture,GLuint width,GLuint height);
+	int createTarget(const char* name,GLuint width,GLuint height,GLenum format = GL_RGBA,GLenum type = GL_UNSIGNED_BYTE);
+	// body is not owned and must outlive execute()
+	int addPass(const char* name,RenderPassBody* body);
+	void read(int pass,int resource);
+	void write(int pass,int resource);
+	// Outputs keep their framebuffer after execute() and their passes alive
+	void markOutput(int resource);
+
+	bool compile();
+	// Compiles first if the graph changed
+	bool execute();
+	// Framebuffer holding an output after execute(), NULL otherwise
+	Framebuffer* getOutput(int resource);
+	// Forgets passes and resources, keeps the pooled framebuffers
+	void reset();
+	// Deletes pooled framebuffers the compiled graph does not use, stopping
+	// once bytes are freed; returns the bytes freed
+	size_t trimPool(size_t bytes = (size_t)-1);
+
+	int getPassCount();
+	int getExecutedPassCount();
+	int getFramebufferCount();
+	// Every framebuffer the compiled graph uses, aliased
+	size_t getAllocatedBytes();
+	// The same targets with a framebuffer each
+	size_t getUnaliasedBytes();
+	// Most bytes of non-output targets holding content still to be read
+	size_t getPeakIntermediateBytes();
+	void logStats(const char* name);
+private:
+	struct Resource {
+		std::string name;
+		GLuint width,height;
+		GLenum format,type;
+		GLuint texture;			// imported only
+		bool imported,output;
+		int writer;
+		int lastUse;			// position in order of the last reader
+		int target;				// index in pool
+	};
+	struct Pass {
+		std::string name;
+		RenderPassBody* body;
+		std::vector<int> reads;
+		int write;
+		bool live;
+	};
+	struct Target {
+		Framebuffer* fb;
+		GLuint width,height;
+		GLenum format,type;
+		bool used;				// by the compiled graph
+	};
+
+	static size_t evictPool(void* graph,size_t bytes);
+	size_t getTargetBytes(const Resource& resource);
+	bool validate();
+	void cull();
+	bool order();
+	void assignTargets();
+
+	std::vector<Resource> resources;
+	std::vector<Pass> passes;
+	std::vector<int> schedule;		// live passes in execution order
+	std::vector<Target> pool;
+	bool compiled;
+	size_t allocatedBytes,unaliasedBytes,peakIntermediateBytes;
+};
+
+// Two triangles over the viewport with texture coordinates covering the
+// input, texture row 0 landing on framebuffer row 0 so readbacks keep the
+// upload order. Uses ATTRIB_POSITION and ATTRIB_TEXCOORD (Program.h).
+void drawRenderPassQuad();
+
+#endif /* RENDERGRAPH_H_ */
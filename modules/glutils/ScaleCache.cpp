@@ -0,0 +1,378 @@
+/*
+ * ScaleCache.cpp
+ *
+ *  Created on: 19-10-2026
+ */
+
+#include "ScaleCache.h"
+#include "Timing.h"
+#include "logger.h"
+#include <dirent.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+// xxHash64
+
+static const uint64_t PRIME1 = 11400714785074694791ULL;
+static const uint64_t PRIME2 = 14029467366897019727ULL;
+static const uint64_t PRIME3 = 1609587929392839161ULL;
+static const uint64_t PRIME4 = 9650029242287828579ULL;
+static const uint64_t PRIME5 = 2870177450012600261ULL;
+
+static inline uint64_t rotl64(uint64_t x,int r) {
+	return (x << r) | (x >> (64 - r));
+}
+
+static inline uint64_t read64(const GLubyte* p) {
+	uint64_t v;
+	memcpy(&v,p,sizeof(v));
+	return v;
+}
+
+static inline uint32_t read32(const GLubyte* p) {
+	uint32_t v;
+	memcpy(&v,p,sizeof(v));
+	return v;
+}
+
+static inline uint64_t hashRound(uint64_t acc,uint64_t input) {
+	acc += input * PRIME2;
+	acc = rotl64(acc,31);
+	return acc * PRIME1;
+}
+
+static inline uint64_t mergeRound(uint64_t acc,uint64_t value) {
+	acc ^= hashRound(0,value);
+	return acc * PRIME1 + PRIME4;
+}
+
+uint64_t hash64(const void* data,size_t length,uint64_t seed) {
+	const GLubyte* p = (const GLubyte*)data;
+	const GLubyte* end = p + length;
+	uint64_t h;
+
+	if(length >= 32) {
+		uint64_t v1 = seed + PRIME1 + PRIME2;
+		uint64_t v2 = seed + PRIME2;
+		uint64_t v3 = seed;
+		uint64_t v4 = seed - PRIME1;
+		const GLubyte* limit = end - 32;
+		do {
+			v1 = hashRound(v1,read64(p));
+			v2 = hashRound(v2,read64(p + 8));
+			v3 = hashRound(v3,read64(p + 16));
+			v4 = hashRound(v4,read64(p + 24));
+			p += 32;
+		} while(p <= limit);
+		h = rotl64(v1,1) + rotl64(v2,7) + rotl64(v3,12) + rotl64(v4,18);
+		h = mergeRound(h,v1);
+		h = mergeRound(h,v2);
+		h = mergeRound(h,v3);
+		h = mergeRound(h,v4);
+	}
+	else {
+		h = seed + PRIME5;
+	}
+	h += length;
+
+	for(;p + 8 <= end;p += 8)
+		h = rotl64(h ^ hashRound(0,read64(p)),27) * PRIME1 + PRIME4;
+	if(p + 4 <= end) {
+		h = rotl64(h ^ (read32(p) * PRIME1),23) * PRIME2 + PRIME3;
+		p += 4;
+	}
+	for(;p < end;p++)
+		h = rotl64(h ^ (*p * PRIME5),11) * PRIME1;
+
+	h ^= h >> 33;
+	h *= PRIME2;
+	h ^= h >> 29;
+	h *= PRIME3;
+	h ^= h >> 32;
+	return h;
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+// ScaleCache
+
+static const uint32_t DISK_MAGIC = 0x31434353;	// "SCC1"
+
+typedef struct
+{
+	uint32_t magic;
+	uint32_t reserved;
+	uint64_t key;
+	uint64_t bytes;
+	double costMs;
+} DiskHeader;
+
+ScaleCache::ScaleCache(size_t memoryBudget,const char* directory,size_t diskBudget)
+		:memoryBudget(memoryBudget),memoryUsed(0),diskBudget(diskBudget),diskUsed(0) {
+	pthread_mutex_init(&mutex,NULL);
+	resetStats();
+	if(directory && diskBudget > 0) {
+		if(mkdir(directory,0700) != 0 && errno != EEXIST)
+			LogError("ScaleCache: cannot create %s: %s",directory,strerror(errno));
+		else {
+			diskDirectory = directory;
+			loadDiskIndex();
+		}
+	}
+}
+
+ScaleCache::~ScaleCache() {
+	for(std::list<MemoryEntry>::iterator it = memoryLru.begin();it != memoryLru.end();++it)
+		delete[] it->data;
+	for(std::map<ScaleKey,DiskEntry>::iterator it = diskIndex.begin();it != diskIndex.end();++it) {
+		if(it->second.mapped)
+			munmap(it->second.mapped,it->second.bytes + sizeof(DiskHeader));
+	}
+	pthread_mutex_destroy(&mutex);
+}
+
+ScaleKey ScaleCache::makeKey(const GLvoid* data,size_t bytes,GLuint width,GLuint height,GLenum format,GLenum type,float ratio,GLenum filter) {
+	double start = nowMs();
+	uint32_t params[6] = { width, height, format, type, 0, filter };
+	memcpy(&params[4],&ratio,sizeof(ratio));
+	ScaleKey key = hash64(data,bytes,hash64(params,sizeof(params)));
+
+	pthread_mutex_lock(&mutex);
+	hashMs += nowMs() - start;
+	pthread_mutex_unlock(&mutex);
+	return key;
+}
+
+GLubyte* ScaleCache::lookup(ScaleKey key,size_t* bytes) {
+	double start = nowMs();
+	GLubyte* result = NULL;
+	size_t size = 0;
+	double costMs = 0.0;
+
+	pthread_mutex_lock(&mutex);
+	lookups++;
+	std::map<ScaleKey,std::list<MemoryEntry>::iterator>::iterator found = memoryIndex.find(key);
+	if(found != memoryIndex.end()) {
+		memoryLru.splice(memoryLru.begin(),memoryLru,found->second);
+		size = found->second->bytes;
+		costMs = found->second->costMs;
+		result = new GLubyte[size];
+		memcpy(result,found->second->data,size);
+		memoryHits++;
+	}
+	else if(diskIndex.count(key)) {
+		DiskEntry& entry = diskIndex[key];
+		const GLubyte* data = mapDisk(key,entry);
+		if(data) {
+			size = entry.bytes;
+			costMs = entry.costMs;
+			result = new GLubyte[size];
+			memcpy(result,data,size);
+			diskHits++;
+		}
+	}
+	if(result)
+		savedMs += costMs - (nowMs() - start);
+	pthread_mutex_unlock(&mutex);
+
+	if(bytes)
+		*bytes = size;
+	return result;
+}
+
+void ScaleCache::store(ScaleKey key,const GLvoid* data,size_t bytes,double costMs) {
+	if(bytes > memoryBudget)
+		return;
+	GLubyte* copy = new GLubyte[bytes];
+	memcpy(copy,data,bytes);
+
+	pthread_mutex_lock(&mutex);
+	if(memoryIndex.count(key))
+		delete[] copy;
+	else
+		insertMemory(key,copy,bytes,costMs);
+	pthread_mutex_unlock(&mutex);
+}
+
+void ScaleCache::clear() {
+	pthread_mutex_lock(&mutex);
+	for(std::list<MemoryEntry>::iterator it = memoryLru.begin();it != memoryLru.end();++it)
+		delete[] it->data;
+	memoryLru.clear();
+	memoryIndex.clear();
+	memoryUsed = 0;
+	while(!diskLru.empty())
+		removeDisk(diskLru.back());
+	pthread_mutex_unlock(&mutex);
+}
+
+// Takes ownership of data; caller holds the mutex
+void ScaleCache::insertMemory(ScaleKey key,GLubyte* data,size_t bytes,double costMs) {
+	MemoryEntry entry = { key, data, bytes, costMs };
+	memoryLru.push_front(entry);
+	memoryIndex[key] = memoryLru.begin();
+	memoryUsed += bytes;
+
+	while(memoryUsed > memoryBudget) {
+		MemoryEntry& oldest = memoryLru.back();
+		spill(oldest);
+		memoryUsed -= oldest.bytes;
+		memoryIndex.erase(oldest.key);
+		delete[] oldest.data;
+		memoryLru.pop_back();
+	}
+}
+
+void ScaleCache::spill(const MemoryEntry& entry) {
+	if(diskDirectory.empty() || entry.bytes > diskBudget)
+		return;
+	std::map<ScaleKey,DiskEntry>::iterator found = diskIndex.find(entry.key);
+	if(found != diskIndex.end()) {
+		diskLru.splice(diskLru.begin(),diskLru,found->second.lru);
+		return;
+	}
+
+	while(diskUsed + entry.bytes > diskBudget && !diskLru.empty())
+		removeDisk(diskLru.back());
+
+	std::string path = getPath(entry.key);
+	FILE* file = fopen(path.c_str(),"wb");
+	if(!file) {
+		LogError("ScaleCache: cannot write %s",path.c_str());
+		return;
+	}
+	DiskHeader header = { DISK_MAGIC, 0, entry.key, entry.bytes, entry.costMs };
+	bool ok = fwrite(&header,sizeof(header),1,file) == 1 && fwrite(entry.data,1,entry.bytes,file) == entry.bytes;
+	ok = (fclose(file) == 0) && ok;
+	if(!ok) {
+		LogError("ScaleCache: short write to %s",path.c_str());
+		unlink(path.c_str());
+		return;
+	}
+
+	diskLru.push_front(entry.key);
+	DiskEntry diskEntry = { entry.bytes, entry.costMs, diskLru.begin(), NULL };
+	diskIndex[entry.key] = diskEntry;
+	diskUsed += entry.bytes;
+}
+
+// Returns the payload in the file's mapping, made on the first hit, or NULL
+// (and the entry is dropped) if the file is gone or damaged
+const GLubyte* ScaleCache::mapDisk(ScaleKey key,DiskEntry& entry) {
+	const size_t fileBytes = entry.bytes + sizeof(DiskHeader);
+	if(!entry.mapped) {
+		int fd = open(getPath(key).c_str(),O_RDONLY);
+		struct stat st;
+		if(fd >= 0 && fstat(fd,&st) == 0 && (size_t)st.st_size == fileBytes) {
+			void* mapped = mmap(NULL,fileBytes,PROT_READ,MAP_PRIVATE,fd,0);
+			const DiskHeader* header = (const DiskHeader*)mapped;
+			if(mapped != MAP_FAILED && header->magic == DISK_MAGIC && header->key == key && header->bytes == entry.bytes)
+				entry.mapped = mapped;
+			else if(mapped != MAP_FAILED)
+				munmap(mapped,fileBytes);
+		}
+		if(fd >= 0)
+			close(fd);
+	}
+
+	if(!entry.mapped) {
+		removeDisk(key);
+		return NULL;
+	}
+	diskLru.splice(diskLru.begin(),diskLru,entry.lru);
+	return (const GLubyte*)entry.mapped + sizeof(DiskHeader);
+}
+
+void ScaleCache::removeDisk(ScaleKey key) {
+	std::map<ScaleKey,DiskEntry>::iterator found = diskIndex.find(key);
+	if(found == diskIndex.end())
+		return;
+	if(found->second.mapped)
+		munmap(found->second.mapped,found->second.bytes + sizeof(DiskHeader));
+	unlink(getPath(key).c_str());
+	diskUsed -= found->second.bytes;
+	diskLru.erase(found->second.lru);
+	diskIndex.erase(found);
+}
+
+// Rebuilds the index from files left by a previous run, in directory order
+void ScaleCache::loadDiskIndex() {
+	DIR* dir = opendir(diskDirectory.c_str());
+	if(!dir)
+		return;
+	struct dirent* ent;
+	while((ent = readdir(dir)) != NULL) {
+		unsigned long long key;
+		char tail;
+		if(strlen(ent->d_name) != 20 || sscanf(ent->d_name,"%16llx.bi%c",&key,&tail) != 2 || tail != 'n')
+			continue;
+		std::string path = getPath(key);
+		FILE* file = fopen(path.c_str(),"rb");
+		if(!file)
+			continue;
+		DiskHeader header;
+		bool ok = fread(&header,sizeof(header),1,file) == 1 && header.magic == DISK_MAGIC && header.key == key;
+		fclose(file);
+		if(!ok || diskUsed + header.bytes > diskBudget) {
+			unlink(path.c_str());
+			continue;
+		}
+		diskLru.push_back(key);
+		DiskEntry entry = { header.bytes, header.costMs, --diskLru.end(), NULL };
+		diskIndex[key] = entry;
+		diskUsed += header.bytes;
+	}
+	closedir(dir);
+	Log("ScaleCache: %u entries, %u bytes on disk in %s",(unsigned int)diskIndex.size(),(unsigned int)diskUsed,diskDirectory.c_str());
+}
+
+std::string ScaleCache::getPath(ScaleKey key) {
+	char name[32];
+	snprintf(name,sizeof(name),"/%016llx.bin",(unsigned long long)key);
+	return diskDirectory + name;
+}
+
+const char* ScaleCache::getDiskDirectory() {
+	return diskDirectory.empty() ? NULL : diskDirectory.c_str();
+}
+
+unsigned int ScaleCache::getLookups() {
+	return lookups;
+}
+
+unsigned int ScaleCache::getMemoryHits() {
+	return memoryHits;
+}
+
+unsigned int ScaleCache::getDiskHits() {
+	return diskHits;
+}
+
+float ScaleCache::getHitRate() {
+	return lookups ? (float)(memoryHits + diskHits) / lookups : 0.0f;
+}
+
+double ScaleCache::getHashMs() {
+	return hashMs;
+}
+
+double ScaleCache::getSavedMs() {
+	return savedMs;
+}
+
+void ScaleCache::resetStats() {
+	lookups = memoryHits = diskHits = 0;
+	hashMs = savedMs = 0.0;
+}
+
+void ScaleCache::logStats(const char* name) {
+	pthread_mutex_lock(&mutex);
+	Log("%s: %u lookups, hit rate %.1f%% (memory %u, disk %u), hashing %.2f ms, saved %.2f ms, memory %u bytes, disk %u bytes",
+			name,lookups,getHitRate()*100.0f,memoryHits,diskHits,hashMs,savedMs,(unsigned int)memoryUsed,(unsigned int)diskUsed);
+	pthread_mutex_unlock(&mutex);
+}
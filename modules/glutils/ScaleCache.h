@@ -0,0 +1,90 @@
+/*
+ * ScaleCache.h
+ *
+ *  Created on: 19-10-2026
+ */
+
+#ifndef SCALECACHE_H_
+#define SCALECACHE_H_
+
+#include <GLES2/gl2.h>
+#include <pthread.h>
+#include <stdint.h>
+#include <stddef.h>
+#include <list>
+#include <map>
+#include <string>
+
+typedef uint64_t ScaleKey;
+
+// xxHash64 of length bytes
+uint64_t hash64(const void* data,size_t length,uint64_t seed = 0);
+
+/*
+ * Content addressed cache of scaled images. Keys hash the source bytes
+ * together with every parameter that changes the output. Entries live in an
+ * in-memory LRU; entries evicted from it spill to one file per key in
+ * diskDirectory (if given), which survives restarts. A file is mapped on its
+ * first hit and stays mapped until evicted, so a disk hit is one copy out of
+ * the page cache and is not moved back into memory. All methods are thread
+ * safe and make no GL calls.
+ */
+class ScaleCache {
+public:
+	ScaleCache(size_t memoryBudget,const char* diskDirectory = NULL,size_t diskBudget = 0);
+	virtual ~ScaleCache();
+
+	ScaleKey makeKey(const GLvoid* data,size_t bytes,GLuint width,GLuint height,GLenum format,GLenum type,float ratio,GLenum filter);
+	// Returns a copy of the cached result (free with delete[]) or NULL on a miss
+	GLubyte* lookup(ScaleKey key,size_t* bytes = NULL);
+	// costMs is the time the result took to produce, credited on every later hit
+	void store(ScaleKey key,const GLvoid* data,size_t bytes,double costMs);
+	void clear();
+
+	const char* getDiskDirectory();
+	unsigned int getLookups();
+	unsigned int getMemoryHits();
+	unsigned int getDiskHits();
+	float getHitRate();
+	double getHashMs();
+	double getSavedMs();
+	void resetStats();
+	void logStats(const char* name);
+private:
+	typedef struct
+	{
+		ScaleKey key;
+		GLubyte* data;
+		size_t bytes;
+		double costMs;
+	} MemoryEntry;
+	typedef struct
+	{
+		size_t bytes;
+		double costMs;
+		std::list<ScaleKey>::iterator lru;
+		void* mapped;		// the whole file, header first, NULL until hit
+	} DiskEntry;
+
+	void insertMemory(ScaleKey key,GLubyte* data,size_t bytes,double costMs);
+	void spill(const MemoryEntry& entry);
+	const GLubyte* mapDisk(ScaleKey key,DiskEntry& entry);
+	void removeDisk(ScaleKey key);
+	void loadDiskIndex();
+	std::string getPath(ScaleKey key);
+
+	pthread_mutex_t mutex;
+	size_t memoryBudget,memoryUsed;
+	std::list<MemoryEntry> memoryLru;		// most recent first
+	std::map<ScaleKey,std::list<MemoryEntry>::iterator> memoryIndex;
+
+	std::string diskDirectory;
+	size_t diskBudget,diskUsed;
+	std::list<ScaleKey> diskLru;
+	std::map<ScaleKey,DiskEntry> diskIndex;
+
+	unsigned int lookups,memoryHits,diskHits;
+	double hashMs,savedMs;
+};
+
+#endif /* SCALECACHE_H_ */
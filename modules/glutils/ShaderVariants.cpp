@@ -0,0 +1,224 @@
+/*
+ * ShaderVariants.cpp
+ *
+ *  Created on: 19-10-2026
+ */
+
+#include "ShaderVariants.h"
+#include "GLUtils.h"
+#include "Timing.h"
+#include "file.h"
+#include "logger.h"
+#include <stdio.h>
+#include <string.h>
+#include <algorithm>
+
+ShaderVariantCache::ShaderVariantCache():hits(0),misses(0),precompiled(0),compileMs(0.0),threadRunning(false) {
+	pthread_mutex_init(&mutex,NULL);
+}
+
+ShaderVariantCache::~ShaderVariantCache() {
+	waitForPrecompile();
+	for(std::map<std::string,Program*>::iterator it = programs.begin();it != programs.end();++it)
+		delete it->second;
+	pthread_mutex_destroy(&mutex);
+}
+
+void ShaderVariantCache::clear() {
+	waitForPrecompile();
+	pthread_mutex_lock(&mutex);
+	for(std::map<std::string,Program*>::iterator it = programs.begin();it != programs.end();++it)
+		delete it->second;
+	programs.clear();
+	pthread_mutex_unlock(&mutex);
+	Program::invalidateCurrent();
+}
+
+std::string ShaderVariantCache::makeKey(const char* vertexPath,const char* fragmentPath,const char* defines) {
+	std::vector<std::string> list;
+	const char* p = defines ? defines : "";
+	while(*p) {
+		const char* end = strchr(p,';');
+		if(!end)
+			end = p + strlen(p);
+		if(end > p)
+			list.push_back(std::string(p,end - p));
+		p = *end ? end + 1 : end;
+	}
+	std::sort(list.begin(),list.end());
+
+	std::string key = std::string(vertexPath) + "|" + fragmentPath + "|";
+	for(unsigned int i=0;i<list.size();i++)
+		key += (i ? ";" : "") + list[i];
+	return key;
+}
+
+Program* ShaderVariantCache::build(const char* vertexPath,const char* fragmentPath,const char* defines) {
+	double start = nowMs();
+	GLuint handle = createProgram(vertexPath,fragmentPath,defines);
+	Program* program = handle ? new Program(handle) : NULL;
+	double elapsed = nowMs() - start;
+	if(!program)
+		LogError("ShaderVariantCache: cannot build %s %s [%s]",vertexPath,fragmentPath,defines);
+
+	pthread_mutex_lock(&mutex);
+	compileMs += elapsed;
+	pthread_mutex_unlock(&mutex);
+	return program;
+}
+
+// Returns the program cached under key, adding program if there is none yet
+Program* ShaderVariantCache::publish(const std::string& key,Program* program) {
+	pthread_mutex_lock(&mutex);
+	std::map<std::string,Program*>::iterator found = programs.find(key);
+	if(found != programs.end()) {
+		// built concurrently by the other thread, keep the first one
+		delete program;
+		program = found->second;
+	}
+	else
+		programs[key] = program;
+	pthread_mutex_unlock(&mutex);
+	return program;
+}
+
+Program* ShaderVariantCache::getProgram(const char* vertexPath,const char* fragmentPath,const char* defines) {
+	std::string key = makeKey(vertexPath,fragmentPath,defines);
+	pthread_mutex_lock(&mutex);
+	std::map<std::string,Program*>::iterator found = programs.find(key);
+	if(found != programs.end()) {
+		hits++;
+		Program* program = found->second;
+		pthread_mutex_unlock(&mutex);
+		return program;
+	}
+	misses++;
+	pthread_mutex_unlock(&mutex);
+
+	Program* program = build(vertexPath,fragmentPath,defines);
+	return program ? publish(key,program) : NULL;
+}
+
+bool ShaderVariantCache::loadVariantList(const char* assetPath,std::vector<ShaderVariant>& variants) {
+	char* data = NULL;
+	unsigned int size = 0;
+	ReadFile(assetPath,&data,&size);
+	if(!data)
+		return false;
+
+	std::string text(data,size);
+	delete[] data;
+	size_t pos = 0;
+	while(pos < text.size()) {
+		size_t end = text.find('\n',pos);
+		if(end == std::string::npos)
+			end = text.size();
+		std::string line = text.substr(pos,end - pos);
+		pos = end + 1;
+		if(line.empty() || line[0] == '#')
+			continue;
+
+		char vertex[128],fragment[128],defines[256] = "";
+		if(sscanf(line.c_str(),"%127s %127s %255s",vertex,fragment,defines) >= 2) {
+			ShaderVariant variant;
+			variant.vertexPath = vertex;
+			variant.fragmentPath = fragment;
+			variant.defines = defines;
+			variants.push_back(variant);
+		}
+	}
+	return true;
+}
+
+bool ShaderVariantCache::precompile(EGLDisplay display,EGLConfig config,EGLContext shareContext,const std::vector<ShaderVariant>& variants) {
+	waitForPrecompile();
+	this->display = display;
+	this->config = config;
+	this->shareContext = shareContext;
+	pending = variants;
+	threadRunning = pthread_create(&thread,NULL,precompileThread,this) == 0;
+	if(!threadRunning)
+		LogError("ShaderVariantCache: cannot start the precompile thread");
+	return threadRunning;
+}
+
+void ShaderVariantCache::waitForPrecompile() {
+	if(threadRunning) {
+		pthread_join(thread,NULL);
+		threadRunning = false;
+	}
+}
+
+void* ShaderVariantCache::precompileThread(void* arg) {
+	((ShaderVariantCache*)arg)->runPrecompile();
+	return NULL;
+}
+
+void ShaderVariantCache::runPrecompile() {
+	const EGLint contextAttribs[] = { EGL_CONTEXT_CLIENT_VERSION, 2, EGL_NONE };
+	EGLContext context = eglCreateContext(display,config,shareContext,contextAttribs);
+	EGLSurface surface = EGL_NO_SURFACE;
+	const char* extensions = eglQueryString(display,EGL_EXTENSIONS);
+	if(!extensions || !strstr(extensions,"EGL_KHR_surfaceless_context")) {
+		const EGLint pbufferAttribs[] = { EGL_WIDTH, 1, EGL_HEIGHT, 1, EGL_NONE };
+		surface = eglCreatePbufferSurface(display,config,pbufferAttribs);
+	}
+	if(context == EGL_NO_CONTEXT || eglMakeCurrent(display,surface,surface,context) == EGL_FALSE) {
+		LogError("ShaderVariantCache: no background context (0x%x), variants compile on first use",eglGetError());
+	}
+	else {
+		double start = nowMs();
+		std::vector<std::pair<std::string,Program*> > built;
+		for(unsigned int i=0;i<pending.size();i++) {
+			const ShaderVariant& v = pending[i];
+			std::string key = makeKey(v.vertexPath.c_str(),v.fragmentPath.c_str(),v.defines.c_str());
+			pthread_mutex_lock(&mutex);
+			bool present = programs.count(key) > 0;
+			pthread_mutex_unlock(&mutex);
+			Program* program = present ? NULL : build(v.vertexPath.c_str(),v.fragmentPath.c_str(),v.defines.c_str());
+			if(program)
+				built.push_back(std::make_pair(key,program));
+		}
+		// programs must be complete before another context may see them
+		glFinish();
+		for(unsigned int i=0;i<built.size();i++)
+			publish(built[i].first,built[i].second);
+		eglMakeCurrent(display,EGL_NO_SURFACE,EGL_NO_SURFACE,EGL_NO_CONTEXT);
+		unsigned int count = built.size();
+
+		pthread_mutex_lock(&mutex);
+		precompiled += count;
+		pthread_mutex_unlock(&mutex);
+		Log("ShaderVariantCache: precompiled %u variants in %.2f ms",count,nowMs() - start);
+	}
+	if(surface != EGL_NO_SURFACE)
+		eglDestroySurface(display,surface);
+	if(context != EGL_NO_CONTEXT)
+		eglDestroyContext(display,context);
+}
+
+unsigned int ShaderVariantCache::getVariantCount() {
+	pthread_mutex_lock(&mutex);
+	unsigned int count = programs.size();
+	pthread_mutex_unlock(&mutex);
+	return count;
+}
+
+unsigned int ShaderVariantCache::getHits() {
+	return hits;
+}
+
+unsigned int ShaderVariantCache::getMisses() {
+	return misses;
+}
+
+double ShaderVariantCache::getCompileMs() {
+	return compileMs;
+}
+
+void ShaderVariantCache::logStats(const char* name) {
+	pthread_mutex_lock(&mutex);
+	Log("%s: %u variants (%u precompiled), %u hits, %u misses, %.2f ms compiling",
+			name,(unsigned int)programs.size(),precompiled,hits,misses,compileMs);
+	pthread_mutex_unlock(&mutex);
+}
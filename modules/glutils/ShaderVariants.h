@@ -0,0 +1,74 @@
+/*
+ * ShaderVariants.h
+ *
+ *  Created on: 19-10-2026
+ */
+
+#ifndef SHADERVARIANTS_H_
+#define SHADERVARIANTS_H_
+
+#include <EGL/egl.h>
+#include <GLES2/gl2.h>
+#include <pthread.h>
+#include "Program.h"
+#include <map>
+#include <string>
+#include <vector>
+
+typedef struct
+{
+	std::string vertexPath;
+	std::string fragmentPath;
+	std::string defines;		// "NAME" or "NAME=VALUE" entries separated by ';'
+} ShaderVariant;
+
+/*
+ * Programs compiled from one vertex/fragment pair with different sets of
+ * #defines. Variants are compiled on first use and cached by key (paths plus
+ * the sorted define list, so "A;B" and "B;A" are the same variant). A hot set
+ * listed in an asset file can be compiled up front on a background thread
+ * with its own EGL context sharing objects with the caller's.
+ * The cache owns the programs; delete it while a sharing context is current.
+ */
+class ShaderVariantCache {
+public:
+	ShaderVariantCache();
+	virtual ~ShaderVariantCache();
+
+	Program* getProgram(const char* vertexPath,const char* fragmentPath,const char* defines = "");
+
+	// Reads "vertexPath fragmentPath [defines]" lines from an asset
+	static bool loadVariantList(const char* assetPath,std::vector<ShaderVariant>& variants);
+	// Starts compiling the variants on a background thread; false if no thread could be started
+	bool precompile(EGLDisplay display,EGLConfig config,EGLContext shareContext,const std::vector<ShaderVariant>& variants);
+	void waitForPrecompile();
+	// Deletes every program, e.g. when the context is lost; variants are
+	// compiled again on first use. Counters are kept.
+	void clear();
+
+	unsigned int getVariantCount();
+	unsigned int getHits();
+	unsigned int getMisses();
+	double getCompileMs();
+	void logStats(const char* name);
+private:
+	static std::string makeKey(const char* vertexPath,const char* fragmentPath,const char* defines);
+	static void* precompileThread(void* arg);
+	void runPrecompile();
+	Program* build(const char* vertexPath,const char* fragmentPath,const char* defines);
+	Program* publish(const std::string& key,Program* program);
+
+	pthread_mutex_t mutex;
+	std::map<std::string,Program*> programs;
+	unsigned int hits,misses,precompiled;
+	double compileMs;
+
+	pthread_t thread;
+	bool threadRunning;
+	EGLDisplay display;
+	EGLConfig config;
+	EGLContext shareContext;
+	std::vector<ShaderVariant> pending;
+};
+
+#endif /* SHADERVARIANTS_H_ */
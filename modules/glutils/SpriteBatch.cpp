@@ -0,0 +1,145 @@
+/*
+ * SpriteBatch.cpp
+ *
+ *  Created on: 19-10-2026
+ */
+
+#include "SpriteBatch.h"
+#include "GpuMemory.h"
+#include "Program.h"
+#include "logger.h"
+#include <string.h>
+#include <algorithm>
+
+// Not a texture name, so the first run of a flush always binds
+#define NO_TEXTURE ((GLuint)-1)
+
+SpriteBatch::SpriteBatch(GLuint c):capacity(std::max(1u,std::min(c,(GLuint)SPRITE_BATCH_CAPACITY))),vertexBuffer(0),
+		indexBuffer(0),ringOffset(0),draws(0),binds(0),orphans(0) {
+}
+
+SpriteBatch::~SpriteBatch() {
+	releaseGlResources();
+}
+
+void SpriteBatch::add(GLuint texture,GLfloat x,GLfloat y,GLfloat width,GLfloat height,GLfloat u0,GLfloat v0,GLfloat u1,GLfloat v1) {
+	// counter-clockwise like Scene::triangleVerticesPNG, GL_CULL_FACE keeps it
+	SpriteVertex quad[4] = {
+		{ x, y, u0, v0 }, { x + width, y, u1, v0 }, { x + width, y + height, u1, v1 }, { x, y + height, u0, v1 }
+	};
+	keys.push_back(SpriteKey(texture,(GLuint)(vertices.size() / 4)));
+	vertices.insert(vertices.end(),quad,quad + 4);
+}
+
+GLuint SpriteBatch::getSpriteCount() {
+	return keys.size();
+}
+
+bool SpriteBatch::ensureBuffers() {
+	if(vertexBuffer)
+		return true;
+	std::vector<GLushort> indices(capacity * 6);
+	for(GLuint i=0;i<capacity;i++) {
+		GLushort first = i * 4;
+		GLushort quad[6] = { first, (GLushort)(first + 1), (GLushort)(first + 2), first, (GLushort)(first + 2), (GLushort)(first + 3) };
+		memcpy(&indices[i * 6],quad,sizeof(quad));
+	}
+	glGenBuffers(1, &indexBuffer);
+	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, indexBuffer);
+	glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(GLushort), &indices[0], GL_STATIC_DRAW);
+	gpuMemoryTrack(GPU_RESOURCE_BUFFER, indexBuffer, indices.size() * sizeof(GLushort), "SpriteBatch");
+
+	const size_t bytes = capacity * 4 * sizeof(SpriteVertex);
+	glGenBuffers(1, &vertexBuffer);
+	glBindBuffer(GL_ARRAY_BUFFER, vertexBuffer);
+	glBufferData(GL_ARRAY_BUFFER, bytes, NULL, GL_STREAM_DRAW);
+	gpuMemoryTrack(GPU_RESOURCE_BUFFER, vertexBuffer, bytes, "SpriteBatch");
+	ringOffset = 0;
+	CheckGlError("SpriteBatch::ensureBuffers");
+	return vertexBuffer && indexBuffer;
+}
+
+// Sprites chunk[0..count) go to the ring in that order, then one draw per
+// run of a texture
+void SpriteBatch::drawChunk(const SpriteKey* chunk,GLuint count,GLuint* boundTexture) {
+	if(ringOffset + count > capacity) {
+		// the draws still reading the old storage keep it, this call does not wait for them
+		glBufferData(GL_ARRAY_BUFFER, capacity * 4 * sizeof(SpriteVertex), NULL, GL_STREAM_DRAW);
+		ringOffset = 0;
+		orphans++;
+	}
+	staging.resize(count * 4);
+	for(GLuint i=0;i<count;i++)
+		memcpy(&staging[i * 4],&vertices[chunk[i].second * 4],4 * sizeof(SpriteVertex));
+	const size_t offset = ringOffset * 4 * sizeof(SpriteVertex);
+	glBufferSubData(GL_ARRAY_BUFFER, offset, staging.size() * sizeof(SpriteVertex), &staging[0]);
+	glVertexAttribPointer(ATTRIB_POSITION, 2, GL_FLOAT, GL_FALSE, sizeof(SpriteVertex), (const GLvoid*)offset);
+	glVertexAttribPointer(ATTRIB_TEXCOORD, 2, GL_FLOAT, GL_FALSE, sizeof(SpriteVertex), (const GLvoid*)(offset + 2 * sizeof(GLfloat)));
+
+	for(GLuint first=0;first<count;) {
+		GLuint end = first + 1;
+		while(end < count && chunk[end].first == chunk[first].first)
+			end++;
+		if(chunk[first].first != *boundTexture) {
+			glBindTexture(GL_TEXTURE_2D, chunk[first].first);
+			*boundTexture = chunk[first].first;
+			binds++;
+		}
+		glDrawElements(GL_TRIANGLES, (end - first) * 6, GL_UNSIGNED_SHORT, (const GLvoid*)(first * 6 * sizeof(GLushort)));
+		draws++;
+		first = end;
+	}
+	ringOffset += count;
+}
+
+GLuint SpriteBatch::flush(bool sortByTexture) {
+	draws = binds = 0;
+	if(keys.empty())
+		return 0;
+	if(ensureBuffers()) {
+		// by texture, then queue order within a texture
+		if(sortByTexture)
+			std::sort(keys.begin(),keys.end());
+		glBindBuffer(GL_ARRAY_BUFFER, vertexBuffer);
+		glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, indexBuffer);
+		glEnableVertexAttribArray(ATTRIB_POSITION);
+		glEnableVertexAttribArray(ATTRIB_TEXCOORD);
+		GLuint boundTexture = NO_TEXTURE;
+		for(GLuint first=0;first<keys.size();first+=capacity)
+			drawChunk(&keys[first],std::min(capacity,(GLuint)keys.size() - first),&boundTexture);
+		// client arrays drawn afterwards would be taken as offsets into a bound buffer
+		glBindBuffer(GL_ARRAY_BUFFER, 0);
+		glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+		glBindTexture(GL_TEXTURE_2D, 0);
+		CheckGlError("SpriteBatch::flush");
+	}
+	keys.clear();
+	vertices.clear();
+	return draws;
+}
+
+GLuint SpriteBatch::getDrawCount() {
+	return draws;
+}
+
+GLuint SpriteBatch::getBindCount() {
+	return binds;
+}
+
+unsigned int SpriteBatch::getOrphanCount() {
+	return orphans;
+}
+
+size_t SpriteBatch::releaseGlResources() {
+	size_t before = gpuMemoryGetUsed();
+	GLuint buffers[2] = { vertexBuffer, indexBuffer };
+	for(int i=0;i<2;i++) {
+		if(!buffers[i])
+			continue;
+		gpuMemoryRelease(GPU_RESOURCE_BUFFER, buffers[i]);
+		glDeleteBuffers(1, &buffers[i]);
+	}
+	vertexBuffer = indexBuffer = 0;
+	ringOffset = 0;
+	return before - gpuMemoryGetUsed();
+}
@@ -0,0 +1,78 @@
+/*
+ * SpriteBatch.h
+ *
+ *  Created on: 19-10-2026
+ */
+
+#ifndef SPRITEBATCH_H_
+#define SPRITEBATCH_H_
+
+#include <GLES2/gl2.h>
+#include <stddef.h>
+#include <utility>
+#include <vector>
+
+// Most sprites one vertex buffer holds: 4 vertices each keep the indices
+// within GL_UNSIGNED_SHORT
+#define SPRITE_BATCH_CAPACITY 16384
+
+typedef struct
+{
+	GLfloat x;
+	GLfloat y;
+	GLfloat u;
+	GLfloat v;
+} SpriteVertex;
+
+/*
+ * Textured quads queued during a frame and drawn with as few draws as the
+ * textures allow. flush() orders the sprites by texture, writes them into a
+ * streaming vertex buffer and issues one glDrawElements per texture run over
+ * a static index buffer. The vertex buffer is a ring: each flush writes
+ * after the previous one and the buffer is orphaned (glBufferData with no
+ * data) only when it is full, so the driver never waits on vertices a draw
+ * in flight still reads.
+ *
+ * Sprites go through the current program with the shared vertex layout
+ * (ATTRIB_POSITION, ATTRIB_TEXCOORD of Program.h). Sorting keeps the order
+ * of the sprites of one texture but not across textures, so overlapping
+ * sprites of different textures need flush(false). GL thread only.
+ */
+class SpriteBatch {
+public:
+	explicit SpriteBatch(GLuint capacity = SPRITE_BATCH_CAPACITY);
+	virtual ~SpriteBatch();
+
+	// x, y, width and height in clip coordinates (-1 to 1), (x, y) being the
+	// bottom left corner; u0, v0 is sampled there and u1, v1 at the top right
+	void add(GLuint texture,GLfloat x,GLfloat y,GLfloat width,GLfloat height,
+			GLfloat u0 = 0.0f,GLfloat v0 = 0.0f,GLfloat u1 = 1.0f,GLfloat v1 = 1.0f);
+	GLuint getSpriteCount();
+	// Draws the queued sprites, binding their textures on the active unit as
+	// GL_TEXTURE_2D, and empties the queue. Leaves no buffer or texture bound.
+	// Returns the draw calls issued.
+	GLuint flush(bool sortByTexture = true);
+	// Of the last flush
+	GLuint getDrawCount();
+	GLuint getBindCount();
+	// Times the vertex buffer was orphaned since construction
+	unsigned int getOrphanCount();
+	// Deletes the buffers, rebuilt on the next flush; returns the bytes freed
+	size_t releaseGlResources();
+private:
+	typedef std::pair<GLuint,GLuint> SpriteKey;		// texture, queue index
+
+	bool ensureBuffers();
+	void drawChunk(const SpriteKey* chunk,GLuint count,GLuint* boundTexture);
+
+	GLuint capacity;
+	std::vector<SpriteVertex> vertices;	// 4 per queued sprite
+	std::vector<SpriteKey> keys;
+	std::vector<SpriteVertex> staging;
+	GLuint vertexBuffer,indexBuffer;
+	GLuint ringOffset;				// first free sprite slot of the vertex buffer
+	GLuint draws,binds;
+	unsigned int orphans;
+};
+
+#endif /* SPRITEBATCH_H_ */
@@ -0,0 +1,251 @@
+/*
+ * TestPattern.cpp
+ *
+ *  Created on: 19-10-2026
+ */
+
+#include "TestPattern.h"
+#include "GLUtils.h"
+#include "Parallel.h"
+#include <math.h>
+#include <stdint.h>
+#include <string.h>
+
+#define ZONE_LUT_BITS 10
+#define ZONE_LUT_SIZE (1 << ZONE_LUT_BITS)
+
+struct PatternContext {
+	GLubyte* pixels;
+	TestPattern pattern;
+	GLuint width,height;
+	GLenum format,type;
+	GLuint rowBytes;
+	TestPatternParams params;
+
+	// per-column tables shared by all rows
+	GLubyte* rampX;
+	float* zoneX;
+	float zoneScale;
+	GLubyte zoneLut[ZONE_LUT_SIZE];
+};
+
+static inline uint32_t packColor(const GLubyte* c) {
+	uint32_t v;
+	memcpy(&v,c,4);
+	return v;
+}
+
+static void checkerboardRow(const PatternContext* ctx,GLuint y,uint32_t* row) {
+	uint32_t a = packColor(ctx->params.colorA);
+	uint32_t b = packColor(ctx->params.colorB);
+	GLuint cell = ctx->params.cellSize;
+	bool odd = (y / cell) & 1;
+	for(GLuint x=0;x<ctx->width;x+=cell) {
+		uint32_t c = odd ? b : a;
+		GLuint end = x + cell < ctx->width ? x + cell : ctx->width;
+		for(GLuint i=x;i<end;i++)
+			row[i] = c;
+		odd = !odd;
+	}
+}
+
+static void gradientRow(const PatternContext* ctx,GLuint y,GLubyte* row) {
+	GLubyte g = ctx->height > 1 ? y * 255 / (ctx->height - 1) : 0;
+	const GLubyte* r = ctx->rampX;
+	for(GLuint x=0;x<ctx->width;x++) {
+		row[4*x+0] = r[x];
+		row[4*x+1] = g;
+		row[4*x+2] = (r[x] + g) >> 1;
+		row[4*x+3] = 255;
+	}
+}
+
+static void zonePlateRow(const PatternContext* ctx,GLuint y,GLubyte* row) {
+	float dy = y + 0.5f - ctx->height * 0.5f;
+	float dy2 = dy * dy;
+	float scale = ctx->zoneScale;
+	const float* dx2 = ctx->zoneX;
+	for(GLuint x=0;x<ctx->width;x++) {
+		GLubyte v = ctx->zoneLut[(uint32_t)((dx2[x] + dy2) * scale) & (ZONE_LUT_SIZE - 1)];
+		row[4*x+0] = v;
+		row[4*x+1] = v;
+		row[4*x+2] = v;
+		row[4*x+3] = 255;
+	}
+}
+
+static void noiseRow(const PatternContext* ctx,GLuint y,uint32_t* row) {
+	// seed every row independently so the result does not depend on how rows are split across threads
+	uint32_t state = (ctx->params.seed ^ 0x9e3779b9u) + y * 0x85ebca6bu;
+	state ^= state >> 15;
+	state *= 0xc2b2ae35u;
+	if(state == 0)
+		state = 1;
+	for(GLuint x=0;x<ctx->width;x++) {
+		state ^= state << 13;
+		state ^= state >> 17;
+		state ^= state << 5;
+		row[x] = state;
+	}
+}
+
+static void packRow(const PatternContext* ctx,const GLubyte* rgba,GLubyte* dst) {
+	GLuint w = ctx->width;
+	if(ctx->type == GL_UNSIGNED_BYTE) {
+		switch(ctx->format) {
+			case GL_RGBA:
+				memcpy(dst,rgba,w*4);
+				break;
+			case GL_LUMINANCE:
+				for(GLuint x=0;x<w;x++)
+					dst[x] = (77*rgba[4*x] + 150*rgba[4*x+1] + 29*rgba[4*x+2]) >> 8;
+				break;
+			case GL_LUMINANCE_ALPHA:
+				for(GLuint x=0;x<w;x++) {
+					dst[2*x] = (77*rgba[4*x] + 150*rgba[4*x+1] + 29*rgba[4*x+2]) >> 8;
+					dst[2*x+1] = rgba[4*x+3];
+				}
+				break;
+			case GL_ALPHA:
+				for(GLuint x=0;x<w;x++)
+					dst[x] = rgba[4*x+3];
+				break;
+			case GL_RGB:
+			default:
+				for(GLuint x=0;x<w;x++) {
+					dst[3*x+0] = rgba[4*x+0];
+					dst[3*x+1] = rgba[4*x+1];
+					dst[3*x+2] = rgba[4*x+2];
+				}
+				break;
+		}
+		return;
+	}
+
+	uint16_t* out = (uint16_t*)dst;
+	switch(ctx->type) {
+		case GL_UNSIGNED_SHORT_5_6_5:
+			for(GLuint x=0;x<w;x++)
+				out[x] = ((rgba[4*x] >> 3) << 11) | ((rgba[4*x+1] >> 2) << 5) | (rgba[4*x+2] >> 3);
+			break;
+		case GL_UNSIGNED_SHORT_4_4_4_4:
+			for(GLuint x=0;x<w;x++)
+				out[x] = ((rgba[4*x] >> 4) << 12) | ((rgba[4*x+1] >> 4) << 8) | ((rgba[4*x+2] >> 4) << 4) | (rgba[4*x+3] >> 4);
+			break;
+		case GL_UNSIGNED_SHORT_5_5_5_1:
+		default:
+			for(GLuint x=0;x<w;x++)
+				out[x] = ((rgba[4*x] >> 3) << 11) | ((rgba[4*x+1] >> 3) << 6) | ((rgba[4*x+2] >> 3) << 1) | (rgba[4*x+3] >> 7);
+			break;
+	}
+}
+
+static void patternRows(int begin,int end,void* arg) {
+	const PatternContext* ctx = (const PatternContext*)arg;
+	uint32_t* row = new uint32_t[ctx->width];
+	GLubyte* dst = ctx->pixels + (size_t)begin * ctx->rowBytes;
+
+	for(int y=begin;y<end;y++,dst+=ctx->rowBytes) {
+		switch(ctx->pattern) {
+			case PATTERN_CHECKERBOARD:
+				// rows inside a cell are identical: copy the previous one
+				if(y != begin && y % ctx->params.cellSize != 0) {
+					memcpy(dst,dst - ctx->rowBytes,ctx->rowBytes);
+					continue;
+				}
+				checkerboardRow(ctx,y,row);
+				break;
+			case PATTERN_GRADIENT:
+				gradientRow(ctx,y,(GLubyte*)row);
+				break;
+			case PATTERN_ZONE_PLATE:
+				zonePlateRow(ctx,y,(GLubyte*)row);
+				break;
+			case PATTERN_NOISE:
+			default:
+				noiseRow(ctx,y,row);
+				break;
+		}
+		packRow(ctx,(const GLubyte*)row,dst);
+	}
+
+	delete[] row;
+}
+
+void setDefaultTestPatternParams(TestPatternParams* params) {
+	params->cellSize = 8;
+	memset(params->colorA,255,4);
+	params->colorB[0] = params->colorB[1] = params->colorB[2] = 0;
+	params->colorB[3] = 255;
+	params->maxFrequency = 0.5f;
+	params->seed = 1;
+}
+
+const char* getTestPatternName(TestPattern pattern) {
+	switch(pattern) {
+		case PATTERN_CHECKERBOARD:
+			return "checkerboard";
+		case PATTERN_GRADIENT:
+			return "gradient";
+		case PATTERN_ZONE_PLATE:
+			return "zoneplate";
+		case PATTERN_NOISE:
+			return "noise";
+		default:
+			return "unknown";
+	}
+}
+
+void fillTestPattern(GLubyte* pixels,TestPattern pattern,GLuint width,GLuint height,GLenum format,GLenum type,const TestPatternParams* params) {
+	if(width == 0 || height == 0)
+		return;
+
+	PatternContext* ctx = new PatternContext;
+	ctx->pixels = pixels;
+	ctx->pattern = pattern;
+	ctx->width = width;
+	ctx->height = height;
+	ctx->format = format;
+	ctx->type = type;
+	ctx->rowBytes = width * getPixelSize(format,type);
+	if(params)
+		ctx->params = *params;
+	else
+		setDefaultTestPatternParams(&ctx->params);
+	if(ctx->params.cellSize == 0)
+		ctx->params.cellSize = 1;
+	ctx->rampX = 0;
+	ctx->zoneX = 0;
+
+	if(pattern == PATTERN_GRADIENT) {
+		ctx->rampX = new GLubyte[width];
+		for(GLuint x=0;x<width;x++)
+			ctx->rampX[x] = width > 1 ? x * 255 / (width - 1) : 0;
+	}
+	else if(pattern == PATTERN_ZONE_PLATE) {
+		// phase = k*r^2 has local frequency k*r/pi cycles per pixel
+		float radius = (width > height ? width : height) * 0.5f;
+		float k = M_PI * ctx->params.maxFrequency / radius;
+		ctx->zoneScale = k * ZONE_LUT_SIZE / (2.0f * M_PI);
+		ctx->zoneX = new float[width];
+		for(GLuint x=0;x<width;x++) {
+			float dx = x + 0.5f - width * 0.5f;
+			ctx->zoneX[x] = dx * dx;
+		}
+		for(int i=0;i<ZONE_LUT_SIZE;i++)
+			ctx->zoneLut[i] = (GLubyte)(127.5f + 127.5f * cosf(2.0f * M_PI * i / ZONE_LUT_SIZE));
+	}
+
+	// rows are independent; keep chunks large enough to amortize thread startup
+	parallelFor(0,height,patternRows,ctx,64);
+
+	delete[] ctx->rampX;
+	delete[] ctx->zoneX;
+	delete ctx;
+}
+
+GLubyte* generateTestPattern(TestPattern pattern,GLuint width,GLuint height,GLenum format,GLenum type,const TestPatternParams* params) {
+	GLubyte* pixels = new GLubyte[width * height * getPixelSize(format,type)];
+	fillTestPattern(pixels,pattern,width,height,format,type,params);
+	return pixels;
+}
@@ -0,0 +1,46 @@
+/*
+ * TestPattern.h
+ *
+ *  Created on: 19-10-2026
+ */
+
+#ifndef TESTPATTERN_H_
+#define TESTPATTERN_H_
+
+#include <GLES2/gl2.h>
+
+enum TestPattern {
+	PATTERN_CHECKERBOARD,	// two-color cells of cellSize pixels
+	PATTERN_GRADIENT,		// red ramps left to right, green top to bottom, blue along the diagonal
+	PATTERN_ZONE_PLATE,		// concentric rings whose frequency grows to maxFrequency at the edge
+	PATTERN_NOISE,			// uniform noise in every channel including alpha, reproducible from seed
+	PATTERN_COUNT
+};
+
+struct TestPatternParams {
+	GLuint cellSize;
+	GLubyte colorA[4];
+	GLubyte colorB[4];
+	// cycles per pixel reached at half the longer image side; 0.5 is Nyquist
+	float maxFrequency;
+	unsigned int seed;
+};
+
+void setDefaultTestPatternParams(TestPatternParams* params);
+const char* getTestPatternName(TestPattern pattern);
+
+/*
+ * Supported formats are GL_RGB, GL_RGBA, GL_LUMINANCE and GL_LUMINANCE_ALPHA
+ * with GL_UNSIGNED_BYTE, plus the packed 16 bit types. Rows are tightly packed.
+ * Rows are generated in parallel; the output only depends on the arguments.
+ */
+void fillTestPattern(GLubyte* pixels,TestPattern pattern,GLuint width,GLuint height,GLenum format = GL_RGB,
+		GLenum type = GL_UNSIGNED_BYTE,const TestPatternParams* params = 0);
+
+/*
+ * Same as fillTestPattern, but allocates the buffer with new[].
+ */
+GLubyte* generateTestPattern(TestPattern pattern,GLuint width,GLuint height,GLenum format = GL_RGB,
+		GLenum type = GL_UNSIGNED_BYTE,const TestPatternParams* params = 0);
+
+#endif /* TESTPATTERN_H_ */
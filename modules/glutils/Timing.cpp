@@ -0,0 +1,63 @@
+/*
+ * Timing.cpp
+ *
+ *  Created on: 19-10-2026
+ */
+
+#include "Timing.h"
+#include "logger.h"
+#include <algorithm>
+#include <math.h>
+
+SampleStats::SampleStats():sorted(true),sum(0.0) {
+}
+
+void SampleStats::add(double sample) {
+	samples.push_back(sample);
+	sum += sample;
+	sorted = false;
+}
+
+void SampleStats::clear() {
+	samples.clear();
+	sum = 0.0;
+	sorted = true;
+}
+
+unsigned int SampleStats::count() const {
+	return samples.size();
+}
+
+double SampleStats::mean() const {
+	if(samples.empty())
+		return 0.0;
+	return sum / samples.size();
+}
+
+double SampleStats::min() const {
+	return percentile(0.0);
+}
+
+double SampleStats::max() const {
+	return percentile(100.0);
+}
+
+double SampleStats::percentile(double p) const {
+	if(samples.empty())
+		return 0.0;
+	if(!sorted) {
+		std::sort(samples.begin(),samples.end());
+		sorted = true;
+	}
+	int rank = (int)ceil(p / 100.0 * samples.size()) - 1;
+	if(rank < 0)
+		rank = 0;
+	if(rank >= (int)samples.size())
+		rank = samples.size() - 1;
+	return samples[rank];
+}
+
+void SampleStats::log(const char* name) const {
+	Log("%s: n %u mean %.3f p50 %.3f p90 %.3f p99 %.3f max %.3f",
+			name,count(),mean(),percentile(50),percentile(90),percentile(99),max());
+}
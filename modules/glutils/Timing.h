@@ -0,0 +1,47 @@
+/*
+ * Timing.h
+ *
+ *  Created on: 19-10-2026
+ */
+
+#ifndef TIMING_H_
+#define TIMING_H_
+
+#include <time.h>
+#include <vector>
+
+/*
+ * Monotonic wall clock in milliseconds, used for all benchmark and latency
+ * measurements.
+ */
+static inline double nowMs()
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec * 1000.0 + ts.tv_nsec / 1000000.0;
+}
+
+/*
+ * Collects timing samples and reports mean and percentiles.
+ */
+class SampleStats {
+public:
+	SampleStats();
+
+	void add(double sample);
+	void clear();
+	unsigned int count() const;
+	double mean() const;
+	double min() const;
+	double max() const;
+	// p in [0,100]; nearest-rank percentile
+	double percentile(double p) const;
+	// Logs "<name>: n mean p50 p90 p99 max" in a single line
+	void log(const char* name) const;
+private:
+	mutable std::vector<double> samples;
+	mutable bool sorted;
+	double sum;
+};
+
+#endif /* TIMING_H_ */
@@ -0,0 +1,350 @@
+/*
+ * YuvConvert.cpp
+ *
+ *  Created on: 19-10-2026
+ */
+
+#include "YuvConvert.h"
+#include "Parallel.h"
+#include <math.h>
+#include <string.h>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#elif defined(__ARM_NEON__) || defined(__ARM_NEON)
+#include <arm_neon.h>
+#define YUV_NEON
+#endif
+
+/*
+ * Integer form of the conversion matrix in 1/64 units, small enough for
+ * saturating 16 bit SIMD arithmetic.
+ */
+struct YuvCoefficients {
+	int yOffset;
+	int ky;
+	int kvr;
+	int kug,kvg;
+	int kub;
+};
+
+void getYuvToRgbMatrix(YuvColorSpace colorSpace,YuvRange range,float matrix[9],float offset[3]) {
+	float kr,kb;
+	if(colorSpace == YUV_BT709) {
+		kr = 0.2126f;
+		kb = 0.0722f;
+	}
+	else {
+		kr = 0.299f;
+		kb = 0.114f;
+	}
+	float kg = 1.0f - kr - kb;
+
+	float yScale = 1.0f, cScale = 1.0f;
+	offset[0] = 0.0f;
+	offset[1] = offset[2] = 128.0f / 255.0f;
+	if(range == YUV_RANGE_LIMITED) {
+		yScale = 255.0f / 219.0f;
+		cScale = 255.0f / 224.0f;
+		offset[0] = 16.0f / 255.0f;
+	}
+
+	// R = Y + 2(1-Kr) V, B = Y + 2(1-Kb) U, G from Y = Kr R + Kg G + Kb B
+	matrix[0] = yScale;
+	matrix[1] = 0.0f;
+	matrix[2] = 2.0f * (1.0f - kr) * cScale;
+	matrix[3] = yScale;
+	matrix[4] = -2.0f * (1.0f - kb) * kb / kg * cScale;
+	matrix[5] = -2.0f * (1.0f - kr) * kr / kg * cScale;
+	matrix[6] = yScale;
+	matrix[7] = 2.0f * (1.0f - kb) * cScale;
+	matrix[8] = 0.0f;
+}
+
+void getRgbToYuvMatrix(YuvColorSpace colorSpace,YuvRange range,float matrix[9],float offset[3]) {
+	float kr,kb;
+	if(colorSpace == YUV_BT709) {
+		kr = 0.2126f;
+		kb = 0.0722f;
+	}
+	else {
+		kr = 0.299f;
+		kb = 0.114f;
+	}
+	float kg = 1.0f - kr - kb;
+
+	float yScale = 1.0f, cScale = 1.0f;
+	offset[0] = 0.0f;
+	offset[1] = offset[2] = 128.0f / 255.0f;
+	if(range == YUV_RANGE_LIMITED) {
+		yScale = 219.0f / 255.0f;
+		cScale = 224.0f / 255.0f;
+		offset[0] = 16.0f / 255.0f;
+	}
+
+	// U = (B - Y) / 2(1-Kb), V = (R - Y) / 2(1-Kr)
+	float su = cScale / (2.0f * (1.0f - kb));
+	float sv = cScale / (2.0f * (1.0f - kr));
+	matrix[0] = kr * yScale;
+	matrix[1] = kg * yScale;
+	matrix[2] = kb * yScale;
+	matrix[3] = -kr * su;
+	matrix[4] = -kg * su;
+	matrix[5] = (1.0f - kb) * su;
+	matrix[6] = (1.0f - kr) * sv;
+	matrix[7] = -kg * sv;
+	matrix[8] = -kb * sv;
+}
+
+static void getYuvCoefficients(YuvColorSpace colorSpace,YuvRange range,YuvCoefficients* k) {
+	float m[9],offset[3];
+	getYuvToRgbMatrix(colorSpace,range,m,offset);
+	k->yOffset = (int)(offset[0] * 255.0f + 0.5f);
+	k->ky = (int)floorf(m[0] * 64.0f + 0.5f);
+	k->kvr = (int)floorf(m[2] * 64.0f + 0.5f);
+	k->kug = (int)floorf(-m[4] * 64.0f + 0.5f);
+	k->kvg = (int)floorf(-m[5] * 64.0f + 0.5f);
+	k->kub = (int)floorf(m[7] * 64.0f + 0.5f);
+}
+
+static inline GLubyte clampToByte(int v) {
+	return v < 0 ? 0 : (v > 255 ? 255 : v);
+}
+
+static inline void convertPixel(int y,int u,int v,const YuvCoefficients& k,GLubyte* dst) {
+	int yk = (y - k.yOffset) * k.ky;
+	u -= 128;
+	v -= 128;
+	dst[0] = clampToByte((yk + k.kvr * v + 32) >> 6);
+	dst[1] = clampToByte((yk - k.kug * u - k.kvg * v + 32) >> 6);
+	dst[2] = clampToByte((yk + k.kub * u + 32) >> 6);
+}
+
+#if defined(__SSE2__)
+// Converts 8 pixels; u and v hold one chroma sample per pixel in 16 bit lanes
+static inline void convert8Sse2(__m128i y,__m128i u,__m128i v,const YuvCoefficients& k,GLubyte* rgba) {
+	const __m128i zero = _mm_setzero_si128();
+	const __m128i bias = _mm_set1_epi16(128);
+	const __m128i round = _mm_set1_epi16(32);
+
+	__m128i yk = _mm_mullo_epi16(_mm_sub_epi16(_mm_unpacklo_epi8(y,zero),_mm_set1_epi16(k.yOffset)),_mm_set1_epi16(k.ky));
+	u = _mm_sub_epi16(u,bias);
+	v = _mm_sub_epi16(v,bias);
+
+	__m128i r = _mm_adds_epi16(yk,_mm_mullo_epi16(v,_mm_set1_epi16(k.kvr)));
+	__m128i g = _mm_subs_epi16(_mm_subs_epi16(yk,_mm_mullo_epi16(u,_mm_set1_epi16(k.kug))),_mm_mullo_epi16(v,_mm_set1_epi16(k.kvg)));
+	__m128i b = _mm_adds_epi16(yk,_mm_mullo_epi16(u,_mm_set1_epi16(k.kub)));
+	r = _mm_packus_epi16(_mm_srai_epi16(_mm_adds_epi16(r,round),6),zero);
+	g = _mm_packus_epi16(_mm_srai_epi16(_mm_adds_epi16(g,round),6),zero);
+	b = _mm_packus_epi16(_mm_srai_epi16(_mm_adds_epi16(b,round),6),zero);
+
+	__m128i rg = _mm_unpacklo_epi8(r,g);
+	__m128i ba = _mm_unpacklo_epi8(b,_mm_set1_epi8((char)0xff));
+	_mm_storeu_si128((__m128i*)rgba,_mm_unpacklo_epi16(rg,ba));
+	_mm_storeu_si128((__m128i*)(rgba + 16),_mm_unpackhi_epi16(rg,ba));
+}
+
+static inline __m128i loadLow64(const GLubyte* p) {
+	return _mm_loadl_epi64((const __m128i*)p);
+}
+
+static inline __m128i loadLow32(const GLubyte* p) {
+	int v;
+	memcpy(&v,p,4);
+	return _mm_cvtsi32_si128(v);
+}
+#endif
+
+#ifdef YUV_NEON
+static inline void convert8Neon(uint8x8_t y,uint8x8_t u,uint8x8_t v,const YuvCoefficients& k,GLubyte* dst,GLuint channels) {
+	int16x8_t yk = vmulq_n_s16(vsubq_s16(vreinterpretq_s16_u16(vmovl_u8(y)),vdupq_n_s16(k.yOffset)),k.ky);
+	int16x8_t uu = vsubq_s16(vreinterpretq_s16_u16(vmovl_u8(u)),vdupq_n_s16(128));
+	int16x8_t vv = vsubq_s16(vreinterpretq_s16_u16(vmovl_u8(v)),vdupq_n_s16(128));
+
+	uint8x8_t r = vqrshrun_n_s16(vqaddq_s16(yk,vmulq_n_s16(vv,k.kvr)),6);
+	uint8x8_t g = vqrshrun_n_s16(vqsubq_s16(vqsubq_s16(yk,vmulq_n_s16(uu,k.kug)),vmulq_n_s16(vv,k.kvg)),6);
+	uint8x8_t b = vqrshrun_n_s16(vqaddq_s16(yk,vmulq_n_s16(uu,k.kub)),6);
+	if(channels == 4) {
+		uint8x8x4_t px;
+		px.val[0] = r;
+		px.val[1] = g;
+		px.val[2] = b;
+		px.val[3] = vdup_n_u8(255);
+		vst4_u8(dst,px);
+	}
+	else {
+		uint8x8x3_t px;
+		px.val[0] = r;
+		px.val[1] = g;
+		px.val[2] = b;
+		vst3_u8(dst,px);
+	}
+}
+#endif
+
+struct YuvRowContext {
+	const YuvFrame* frame;
+	GLubyte* dst;
+	GLuint channels;
+	YuvCoefficients k;
+};
+
+static void convertRows(int begin,int end,void* arg) {
+	const YuvRowContext* ctx = (const YuvRowContext*)arg;
+	const YuvFrame& f = *ctx->frame;
+	const YuvCoefficients& k = ctx->k;
+	const GLuint c = ctx->channels;
+	const GLuint chromaWidth = (f.width + 1) / 2;
+	const bool planar = f.layout == YUV_I420;
+
+	for(int row=begin;row<end;row++) {
+		const GLubyte* yRow = f.y + (size_t)row * f.width;
+		const GLubyte* uRow;
+		const GLubyte* vRow;
+		if(planar) {
+			uRow = f.u + (size_t)(row / 2) * chromaWidth;
+			vRow = f.v + (size_t)(row / 2) * chromaWidth;
+		}
+		else {
+			const GLubyte* uvRow = f.u + (size_t)(row / 2) * chromaWidth * 2;
+			uRow = f.layout == YUV_NV12 ? uvRow : uvRow + 1;
+			vRow = f.layout == YUV_NV12 ? uvRow + 1 : uvRow;
+		}
+		GLubyte* d = ctx->dst + (size_t)row * f.width * c;
+		GLuint x = 0;
+
+#if defined(__SSE2__)
+		const __m128i zero = _mm_setzero_si128();
+		const __m128i lowHalf = _mm_set1_epi32(0xffff);
+		GLubyte rgba[32];
+		for(;x+8<=f.width;x+=8) {
+			__m128i u,v;
+			if(planar) {
+				u = _mm_unpacklo_epi8(loadLow32(uRow + x/2),zero);
+				v = _mm_unpacklo_epi8(loadLow32(vRow + x/2),zero);
+				u = _mm_unpacklo_epi16(u,u);
+				v = _mm_unpacklo_epi16(v,v);
+			}
+			else {
+				// 32 bit lanes hold one interleaved chroma pair each
+				__m128i uv = _mm_unpacklo_epi8(loadLow64(f.layout == YUV_NV12 ? uRow + x : vRow + x),zero);
+				__m128i first = _mm_and_si128(uv,lowHalf);
+				__m128i second = _mm_srli_epi32(uv,16);
+				first = _mm_or_si128(first,_mm_slli_epi32(first,16));
+				second = _mm_or_si128(second,_mm_slli_epi32(second,16));
+				u = f.layout == YUV_NV12 ? first : second;
+				v = f.layout == YUV_NV12 ? second : first;
+			}
+			if(c == 4) {
+				convert8Sse2(loadLow64(yRow + x),u,v,k,d + x*4);
+			}
+			else {
+				convert8Sse2(loadLow64(yRow + x),u,v,k,rgba);
+				GLubyte* out = d + x*3;
+				for(int i=0;i<8;i++) {
+					out[3*i+0] = rgba[4*i+0];
+					out[3*i+1] = rgba[4*i+1];
+					out[3*i+2] = rgba[4*i+2];
+				}
+			}
+		}
+#elif defined(YUV_NEON)
+		for(;x+16<=f.width;x+=16) {
+			uint8x16_t y = vld1q_u8(yRow + x);
+			uint8x8_t u,v;
+			if(planar) {
+				u = vld1_u8(uRow + x/2);
+				v = vld1_u8(vRow + x/2);
+			}
+			else {
+				uint8x8x2_t uv = vld2_u8(f.layout == YUV_NV12 ? uRow + x : vRow + x);
+				u = f.layout == YUV_NV12 ? uv.val[0] : uv.val[1];
+				v = f.layout == YUV_NV12 ? uv.val[1] : uv.val[0];
+			}
+			uint8x8x2_t ud = vzip_u8(u,u);
+			uint8x8x2_t vd = vzip_u8(v,v);
+			convert8Neon(vget_low_u8(y),ud.val[0],vd.val[0],k,d + x*c,c);
+			convert8Neon(vget_high_u8(y),ud.val[1],vd.val[1],k,d + (x+8)*c,c);
+		}
+#endif
+
+		const GLuint step = planar ? 1 : 2;
+		for(;x<f.width;x++) {
+			convertPixel(yRow[x],uRow[(x/2)*step],vRow[(x/2)*step],k,d + x*c);
+			if(c == 4)
+				d[x*4+3] = 255;
+		}
+	}
+}
+
+void convertYuvToRgb(const YuvFrame& frame,GLubyte* rgb,GLuint channels,YuvColorSpace colorSpace,YuvRange range) {
+	YuvRowContext ctx;
+	ctx.frame = &frame;
+	ctx.dst = rgb;
+	ctx.channels = channels == 4 ? 4 : 3;
+	getYuvCoefficients(colorSpace,range,&ctx.k);
+	parallelFor(0,frame.height,convertRows,&ctx,32);
+}
+
+struct I420RowContext {
+	const GLubyte* rgb;
+	GLuint width,height,channels;
+	GLubyte* y;
+	GLubyte* u;
+	GLubyte* v;
+	int m[9];	// 1/65536 units
+	int offset[3];
+};
+
+static void convertI420Rows(int begin,int end,void* arg) {
+	const I420RowContext* ctx = (const I420RowContext*)arg;
+	const GLuint c = ctx->channels;
+	const GLuint w = ctx->width;
+	const GLuint chromaWidth = (w + 1) / 2;
+	const int* m = ctx->m;
+
+	// each item is one chroma row, covering two luma rows
+	for(int cy=begin;cy<end;cy++) {
+		for(GLuint row=cy*2;row<cy*2+2 && row<ctx->height;row++) {
+			const GLubyte* s = ctx->rgb + (size_t)row * w * c;
+			GLubyte* d = ctx->y + (size_t)row * w;
+			for(GLuint x=0;x<w;x++,s+=c)
+				d[x] = clampToByte((m[0]*s[0] + m[1]*s[1] + m[2]*s[2] + ctx->offset[0] + 32768) >> 16);
+		}
+
+		const GLubyte* s0 = ctx->rgb + (size_t)(cy*2) * w * c;
+		const GLubyte* s1 = cy*2 + 1 < ctx->height ? s0 + w * c : s0;
+		GLubyte* du = ctx->u + (size_t)cy * chromaWidth;
+		GLubyte* dv = ctx->v + (size_t)cy * chromaWidth;
+		for(GLuint x=0;x<chromaWidth;x++) {
+			GLuint a = 2*x*c, b = (2*x+1 < w ? 2*x+1 : 2*x)*c;
+			// sums of four pixels: divide by 4 in the final shift
+			int r = s0[a] + s0[b] + s1[a] + s1[b];
+			int g = s0[a+1] + s0[b+1] + s1[a+1] + s1[b+1];
+			int bl = s0[a+2] + s0[b+2] + s1[a+2] + s1[b+2];
+			du[x] = clampToByte((m[3]*r + m[4]*g + m[5]*bl + 4*ctx->offset[1] + 131072) >> 18);
+			dv[x] = clampToByte((m[6]*r + m[7]*g + m[8]*bl + 4*ctx->offset[2] + 131072) >> 18);
+		}
+	}
+}
+
+void convertRgbToI420(const GLubyte* rgb,GLuint width,GLuint height,GLuint channels,GLubyte* i420,
+		YuvColorSpace colorSpace,YuvRange range) {
+	float m[9],offset[3];
+	getRgbToYuvMatrix(colorSpace,range,m,offset);
+
+	GLuint chromaWidth = (width + 1) / 2, chromaHeight = (height + 1) / 2;
+	I420RowContext ctx;
+	ctx.rgb = rgb;
+	ctx.width = width;
+	ctx.height = height;
+	ctx.channels = channels;
+	ctx.y = i420;
+	ctx.u = i420 + (size_t)width * height;
+	ctx.v = ctx.u + (size_t)chromaWidth * chromaHeight;
+	for(int i=0;i<9;i++)
+		ctx.m[i] = (int)floorf(m[i] * 65536.0f + 0.5f);
+	for(int i=0;i<3;i++)
+		ctx.offset[i] = (int)floorf(offset[i] * 255.0f * 65536.0f + 0.5f);
+	parallelFor(0,chromaHeight,convertI420Rows,&ctx,16);
+}
@@ -0,0 +1,66 @@
+/*
+ * YuvConvert.h
+ *
+ *  Created on: 19-10-2026
+ */
+
+#ifndef YUVCONVERT_H_
+#define YUVCONVERT_H_
+
+#include <GLES2/gl2.h>
+
+enum YuvLayout {
+	YUV_I420,	// Y plane, then U and V planes at half resolution
+	YUV_NV12,	// Y plane, then interleaved UV plane at half resolution
+	YUV_NV21	// Y plane, then interleaved VU plane at half resolution (Android camera default)
+};
+
+enum YuvColorSpace {
+	YUV_BT601,
+	YUV_BT709
+};
+
+enum YuvRange {
+	YUV_RANGE_LIMITED,	// Y in [16,235], UV in [16,240]
+	YUV_RANGE_FULL		// all components in [0,255]
+};
+
+/*
+ * One frame of 8 bit 4:2:0 YUV with tightly packed planes. Chroma planes are
+ * (width+1)/2 x (height+1)/2 samples; v is only used by YUV_I420, and for the
+ * semi-planar layouts u points at the interleaved plane.
+ */
+struct YuvFrame {
+	GLuint width,height;
+	YuvLayout layout;
+	const GLubyte* y;
+	const GLubyte* u;
+	const GLubyte* v;
+};
+
+/*
+ * Conversion for normalized components: rgb = matrix * (yuv - offset), with
+ * matrix stored row-major. Both the shader uniforms and the CPU converter
+ * are derived from this.
+ */
+void getYuvToRgbMatrix(YuvColorSpace colorSpace,YuvRange range,float matrix[9],float offset[3]);
+
+/*
+ * Inverse of getYuvToRgbMatrix: yuv = matrix * rgb + offset, row-major.
+ */
+void getRgbToYuvMatrix(YuvColorSpace colorSpace,YuvRange range,float matrix[9],float offset[3]);
+
+/*
+ * Converts a whole frame to tightly packed RGB (channels == 3) or RGBA with
+ * opaque alpha (channels == 4). Uses SSE2 or NEON when available.
+ */
+void convertYuvToRgb(const YuvFrame& frame,GLubyte* rgb,GLuint channels,YuvColorSpace colorSpace,YuvRange range);
+
+/*
+ * Converts tightly packed RGB or RGBA (channels 3 or 4) to I420 stored as
+ * Y, then U, then V plane. Chroma is the average of each 2x2 block.
+ */
+void convertRgbToI420(const GLubyte* rgb,GLuint width,GLuint height,GLuint channels,GLubyte* i420,
+		YuvColorSpace colorSpace,YuvRange range);
+
+#endif /* YUVCONVERT_H_ */
@@ -69,7 +69,7 @@ void ReadFile( const char* pFileName, char** ppContent, unsigned int* pSize )
         memcpy( *ppContent, pData, fileSize );
         *pSize = fileSize;
 
-        Log("File length %d",*pSize);
+        LogDebug("File length %d",*pSize);
         delete pData;
         
         // Close the file
@@ -11,9 +11,22 @@
 #include <android/log.h>
 #include <EGL/egl.h>
 #include <GLES2/gl2.h>
+#include "AsyncLog.h"
 
-#define  Log(...)  __android_log_print( ANDROID_LOG_INFO, "TextureLoader", __VA_ARGS__ )
-#define  LogError(...)  __android_log_print( ANDROID_LOG_ERROR, "TextureLoader", __VA_ARGS__ )
+// Levels below LOG_MIN_LEVEL compile to nothing (ndk-build LOG_MIN_LEVEL=1
+// keeps the per-call debug messages). Disabled calls still type-check their
+// arguments but are never evaluated.
+#ifndef LOG_MIN_LEVEL
+#define LOG_MIN_LEVEL LOG_LEVEL_INFO
+#endif
+
+#define LOG_AT(level, ...) do { if( LOG_MIN_LEVEL <= level ) logMessage( level, __VA_ARGS__ ); } while( 0 )
+
+#define  LogVerbose(...)  LOG_AT( LOG_LEVEL_VERBOSE, __VA_ARGS__ )
+#define  LogDebug(...)  LOG_AT( LOG_LEVEL_DEBUG, __VA_ARGS__ )
+#define  Log(...)  LOG_AT( LOG_LEVEL_INFO, __VA_ARGS__ )
+#define  LogWarn(...)  LOG_AT( LOG_LEVEL_WARN, __VA_ARGS__ )
+#define  LogError(...)  LOG_AT( LOG_LEVEL_ERROR, __VA_ARGS__ )
 
 static void CheckGlError( const char* pFunctionName )
 {
@@ -9,6 +9,7 @@
 #define MATRICES_H_
 
 #include <stdlib.h>
+#include <string.h>
 #include <math.h>
 
 #define PI 3.1415926f
@@ -19,13 +20,13 @@
 }
 #define I(_i, _j) ((_j)+4*(_i))
 
-void matrixSetIdentityM(float *m)
+static inline void matrixSetIdentityM(float *m)
 {
         memset((void*)m, 0, 16*sizeof(float));
         m[0] = m[5] = m[10] = m[15] = 1.0f;
 }
 
-void matrixSetRotateM(float *m, float a, float x, float y, float z)
+static inline void matrixSetRotateM(float *m, float a, float x, float y, float z)
 {
         float s, c;
 
@@ -69,7 +70,7 @@ void matrixSetRotateM(float *m, float a, float x, float y, float z)
         }
 }
 
-void matrixMultiplyMM(float *m, float *lhs, float *rhs)
+static inline void matrixMultiplyMM(float *m, float *lhs, float *rhs)
 {
         float t[16];
         int i,j;
@@ -94,7 +95,7 @@ void matrixMultiplyMM(float *m, float *lhs, float *rhs)
         memcpy(m, t, sizeof(t));
 }
 
-void matrixScaleM(float *m, float x, float y, float z)
+static inline void matrixScaleM(float *m, float x, float y, float z)
 {
 	int i;
         for (i = 0; i < 4; i++)
@@ -103,7 +104,7 @@ void matrixScaleM(float *m, float x, float y, float z)
         }
 }
 
-void matrixTranslateM(float *m, float x, float y, float z)
+static inline void matrixTranslateM(float *m, float x, float y, float z)
 {
 	int i;
         for (i = 0; i < 4; i++)
@@ -112,7 +113,7 @@ void matrixTranslateM(float *m, float x, float y, float z)
         }
 }
 
-void matrixRotateM(float *m, float a, float x, float y, float z)
+static inline void matrixRotateM(float *m, float a, float x, float y, float z)
 {
         float rot[16], res[16];
         matrixSetRotateM(rot, a, x, y, z);
@@ -120,7 +121,7 @@ void matrixRotateM(float *m, float a, float x, float y, float z)
         memcpy(m, res, 16*sizeof(float));
 }
 
-void matrixLookAtM(float *m,
+static inline void matrixLookAtM(float *m,
                 float eyeX, float eyeY, float eyeZ,
                 float cenX, float cenY, float cenZ,
                 float  upX, float  upY, float  upZ)
@@ -156,7 +157,7 @@ void matrixLookAtM(float *m,
         matrixTranslateM(m, -eyeX, -eyeY, -eyeZ);
 }
 
-void matrixFrustumM(float *m, float left, float right, float bottom, float top, float near, float far)
+static inline void matrixFrustumM(float *m, float left, float right, float bottom, float top, float near, float far)
 {
         float r_width  = 1.0f / (right - left);
         float r_height = 1.0f / (top - bottom);
@@ -21,11 +21,34 @@ LOCAL_CFLAGS        := -Werror  -g -DNDK_DEBUG=1
 LOCAL_MODULE    := native-activity
 LOCAL_SRC_FILES := main.cpp \
 				   Scene.cpp \
+				   FramePipeline.cpp \
+				   FilePipeline.cpp \
+				   AtlasScaler.cpp \
+				   StatsReducer.cpp \
+				   Benchmarks.cpp \
+				   QualityCheck.cpp \
 #					Framebuffer.cpp \
 #				   GLUtils.cpp \
 #				   file.cpp \
 				   
-LOCAL_LDLIBS := -llog -landroid -lEGL -lGLESv2
+# ndk-build SCALE_BENCHMARKS=1 runs the benchmarks once the display is up
+ifeq ($(SCALE_BENCHMARKS),1)
+LOCAL_CFLAGS        += -DSCALE_BENCHMARKS
+endif
+# ndk-build QUALITY_CHECK=1 runs the scaling quality regression checks
+ifeq ($(QUALITY_CHECK),1)
+LOCAL_CFLAGS        += -DQUALITY_CHECK
+endif
+# ndk-build DYNAMIC_RESOLUTION=1 renders the display path at the scale its
+# frame times allow, upscaled to the surface
+ifeq ($(DYNAMIC_RESOLUTION),1)
+LOCAL_CFLAGS        += -DDYNAMIC_RESOLUTION
+endif
+# ndk-build LOG_MIN_LEVEL=0 (verbose) or 1 (debug) compiles in the chattier logs
+ifdef LOG_MIN_LEVEL
+LOCAL_CFLAGS        += -DLOG_MIN_LEVEL=$(LOG_MIN_LEVEL)
+endif
+LOCAL_LDLIBS := -llog -landroid -lEGL -lGLESv2 -lz
 LOCAL_STATIC_LIBRARIES := android_native_app_glue glutils
 #LOCAL_SHARED_LIBRARIES := glutils
 include $(BUILD_SHARED_LIBRARY)
@@ -1,3 +1,4 @@
 APP_PLATFORM := android-14
 APP_OPTIM := debug
-APP_ABI := armeabi armeabi-v7a x86 
\ No newline at end of file
+APP_ABI := armeabi armeabi-v7a x86 
+APP_STL := gnustl_static
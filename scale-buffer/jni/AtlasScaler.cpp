@@ -0,0 +1,157 @@
+/*
+ * AtlasScaler.cpp
+ *
+ *  Created on: 19-10-2026
+ */
+
+#include "AtlasScaler.h"
+#include "CpuScaler.h"
+#include "logger.h"
+#include <string.h>
+
+static GLuint clampAtlasSize(GLuint size) {
+	GLint maxTexture = 0, maxViewport[2] = { 0, 0 };
+	glGetIntegerv(GL_MAX_TEXTURE_SIZE, &maxTexture);
+	glGetIntegerv(GL_MAX_VIEWPORT_DIMS, maxViewport);
+	if(maxTexture > 0 && size > (GLuint)maxTexture)
+		size = maxTexture;
+	if(maxViewport[0] > 0 && size > (GLuint)maxViewport[0])
+		size = maxViewport[0];
+	if(maxViewport[1] > 0 && size > (GLuint)maxViewport[1])
+		size = maxViewport[1];
+	return size;
+}
+
+AtlasScaler::AtlasScaler(Scene* s,GLenum f,GLuint size):
+		scene(s),format(f),atlasSize(clampAtlasSize(size)),
+		inputPacker(atlasSize,atlasSize),outputPacker(atlasSize,atlasSize),draws(0),fallbacks(0) {
+	pixelSize = getPixelSize(format,GL_UNSIGNED_BYTE);
+	initTexture(&inputTexture,atlasSize,atlasSize,format,GL_UNSIGNED_BYTE,0,"AtlasScaler");
+	glBindTexture(GL_TEXTURE_2D, 0);
+	output = new Framebuffer(atlasSize,atlasSize,0,format,GL_UNSIGNED_BYTE,0,"AtlasScaler");
+	inputPixels = new GLubyte[atlasSize*atlasSize*pixelSize];
+	outputPixels = new GLubyte[atlasSize*atlasSize*pixelSize];
+}
+
+AtlasScaler::~AtlasScaler() {
+	deleteTexture(&inputTexture);
+	delete output;
+	delete[] inputPixels;
+	delete[] outputPixels;
+}
+
+bool AtlasScaler::place(const AtlasImage& image,AtlasRect* in,AtlasRect* out) {
+	return inputPacker.insert(image.width + 2,image.height + 2,in) && outputPacker.insert(image.outWidth,image.outHeight,out);
+}
+
+void AtlasScaler::copyToInputAtlas(const AtlasImage& image,const AtlasRect& rect) {
+	const GLuint rowBytes = image.width * pixelSize;
+	const GLuint atlasRowBytes = atlasSize * pixelSize;
+	GLubyte* first = inputPixels + (rect.y + 1) * atlasRowBytes + rect.x * pixelSize;
+
+	for(GLuint y=0;y<image.height;y++) {
+		GLubyte* dst = first + y * atlasRowBytes;
+		const GLubyte* src = image.pixels + y * rowBytes;
+		memcpy(dst + pixelSize,src,rowBytes);
+		// replicate the edge columns into the border
+		memcpy(dst,src,pixelSize);
+		memcpy(dst + pixelSize + rowBytes,src + rowBytes - pixelSize,pixelSize);
+	}
+	// and the edge rows, corners included
+	memcpy(first - atlasRowBytes,first,rowBytes + 2*pixelSize);
+	memcpy(first + image.height * atlasRowBytes,first + (image.height - 1) * atlasRowBytes,rowBytes + 2*pixelSize);
+}
+
+void AtlasScaler::addQuad(const AtlasRect& in,const AtlasRect& out) {
+	const float size = atlasSize;
+	// source without its border
+	float s0 = (in.x + 1) / size, s1 = (in.x + 1 + in.width - 2) / size;
+	float t0 = (in.y + 1) / size, t1 = (in.y + 1 + in.height - 2) / size;
+	// output rows count from the bottom like glReadPixels, same as texture rows
+	float x0 = out.x / size * 2.0f - 1.0f, x1 = (out.x + out.width) / size * 2.0f - 1.0f;
+	float y0 = out.y / size * 2.0f - 1.0f, y1 = (out.y + out.height) / size * 2.0f - 1.0f;
+
+	// same winding as Scene::triangleVerticesPNG
+	TriangleVertex p[6] = { { x1, y1 }, { x0, y0 }, { x1, y0 }, { x0, y1 }, { x0, y0 }, { x1, y1 } };
+	TriangleVertex t[6] = { { s1, t1 }, { s0, t0 }, { s1, t0 }, { s0, t1 }, { s0, t0 }, { s1, t1 } };
+	positions.insert(positions.end(),p,p + 6);
+	texCoords.insert(texCoords.end(),t,t + 6);
+}
+
+void AtlasScaler::flush(AtlasImage* images) {
+	if(batch.empty())
+		return;
+
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+	glBindTexture(GL_TEXTURE_2D, inputTexture);
+	glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, atlasSize, inputPacker.getUsedHeight(), format, GL_UNSIGNED_BYTE, inputPixels);
+	CheckGlError("AtlasScaler::flush: glTexSubImage2D");
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+
+	output->bind();
+	output->setViewPort();
+	scene->drawBatch(inputTexture,&positions[0],&texCoords[0],positions.size(),atlasSize,atlasSize);
+	draws++;
+	output->unbind();
+	output->recoverSavedViewPort();
+
+	GLuint usedRows = outputPacker.getUsedHeight();
+	output->grabRows(outputPixels,0,usedRows);
+
+	const GLuint atlasRowBytes = atlasSize * pixelSize;
+	for(unsigned int i=0;i<batch.size();i++) {
+		AtlasImage& image = images[batch[i]];
+		const AtlasRect& rect = outputRects[i];
+		GLuint rowBytes = image.outWidth * pixelSize;
+		image.output = new GLubyte[image.outHeight * rowBytes];
+		for(GLuint y=0;y<image.outHeight;y++)
+			memcpy(image.output + y * rowBytes,outputPixels + (rect.y + y) * atlasRowBytes + rect.x * pixelSize,rowBytes);
+	}
+
+	batch.clear();
+	outputRects.clear();
+	positions.clear();
+	texCoords.clear();
+	inputPacker.reset();
+	outputPacker.reset();
+}
+
+void AtlasScaler::scale(AtlasImage* images,int count) {
+	for(int i=0;i<count;i++) {
+		AtlasImage& image = images[i];
+		image.output = NULL;
+		if(!image.width || !image.height || !image.outWidth || !image.outHeight)
+			continue;
+		if(image.width + 2 > atlasSize || image.height + 2 > atlasSize ||
+				image.outWidth > atlasSize || image.outHeight > atlasSize) {
+			image.output = new GLubyte[image.outWidth * image.outHeight * pixelSize];
+			scaleImageBilinear(image.pixels,image.width,image.height,image.output,image.outWidth,image.outHeight,pixelSize);
+			fallbacks++;
+			continue;
+		}
+
+		AtlasRect in,out;
+		if(!place(image,&in,&out)) {
+			flush(images);
+			place(image,&in,&out);
+		}
+		copyToInputAtlas(image,in);
+		addQuad(in,out);
+		batch.push_back(i);
+		outputRects.push_back(out);
+	}
+	flush(images);
+}
+
+int AtlasScaler::getDrawCount() {
+	return draws;
+}
+
+int AtlasScaler::getFallbackCount() {
+	return fallbacks;
+}
+
+void AtlasScaler::resetStats() {
+	draws = 0;
+	fallbacks = 0;
+}
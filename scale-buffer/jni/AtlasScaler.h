@@ -0,0 +1,68 @@
+/*
+ * AtlasScaler.h
+ *
+ *  Created on: 19-10-2026
+ */
+
+#ifndef ATLASSCALER_H_
+#define ATLASSCALER_H_
+
+#include <vector>
+#include "AtlasPacker.h"
+#include "Scene.h"
+
+typedef struct
+{
+	const GLubyte* pixels;	// tightly packed, in the scaler's format
+	GLuint width;
+	GLuint height;
+	GLuint outWidth;
+	GLuint outHeight;
+	GLubyte* output;		// set by AtlasScaler::scale, free with delete[]
+} AtlasImage;
+
+/*
+ * Scales many small images with one upload, one draw and one readback per
+ * atlas page instead of per image. Sources are packed with a one pixel
+ * replicated border so bilinear sampling behaves like GL_CLAMP_TO_EDGE on
+ * each image; results match Scene::scaleTexture. Images that do not fit a
+ * page are scaled on the CPU.
+ */
+class AtlasScaler {
+public:
+	AtlasScaler(Scene* scene,GLenum format = GL_RGBA,GLuint atlasSize = 2048);
+	virtual ~AtlasScaler();
+
+	void scale(AtlasImage* images,int count);
+
+	int getDrawCount();
+	int getFallbackCount();
+	void resetStats();
+private:
+	bool place(const AtlasImage& image,AtlasRect* in,AtlasRect* out);
+	void copyToInputAtlas(const AtlasImage& image,const AtlasRect& rect);
+	void addQuad(const AtlasRect& in,const AtlasRect& out);
+	void flush(AtlasImage* images);
+
+	Scene* scene;
+	GLenum format;
+	GLuint pixelSize;
+	GLuint atlasSize;
+
+	GLuint inputTexture;
+	Framebuffer* output;
+	GLubyte* inputPixels;
+	GLubyte* outputPixels;
+	AtlasPacker inputPacker;
+	AtlasPacker outputPacker;
+
+	std::vector<int> batch;
+	std::vector<AtlasRect> outputRects;
+	std::vector<TriangleVertex> positions;
+	std::vector<TriangleVertex> texCoords;
+
+	int draws;
+	int fallbacks;
+};
+
+#endif /* ATLASSCALER_H_ */
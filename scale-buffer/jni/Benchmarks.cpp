@@ -0,0 +1,1404 @@
+/*
+ * Benchmarks.cpp
+ *
+ *  Created on: 19-10-2026
+ */
+
+#include "Benchmarks.h"
+#include "FramePipeline.h"
+#include "FilePipeline.h"
+#include "AtlasScaler.h"
+#include "TestPattern.h"
+#include "CpuScaler.h"
+#include "YuvConvert.h"
+#include "ImageQuality.h"
+#include "ImageStats.h"
+#include "Etc1.h"
+#include "ColorSpace.h"
+#include "Parallel.h"
+#include "GLUtils.h"
+#include "GpuMemory.h"
+#include "Program.h"
+#include "RenderGraph.h"
+#include "StatsReducer.h"
+#include "SpriteBatch.h"
+#include "PixelConvert.h"
+#include "DynamicResolution.h"
+#include "Timing.h"
+#include "logger.h"
+#include <pthread.h>
+#include <stdio.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <string.h>
+#include <math.h>
+#include <string>
+
+static GLint maxTextureSize() {
+	GLint size = 0;
+	glGetIntegerv(GL_MAX_TEXTURE_SIZE, &size);
+	return size;
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+// Streaming
+
+struct StreamProducer {
+	FramePipeline* pipeline;
+	const GLubyte* frame;
+	int frames;
+};
+
+static void* streamProducerMain(void* arg) {
+	StreamProducer* producer = (StreamProducer*)arg;
+	for(int i=0;i<producer->frames;i++) {
+		if(!producer->pipeline->pushFrame(producer->frame))
+			break;
+	}
+	producer->pipeline->close();
+	return NULL;
+}
+
+static void benchmarkStream(Scene* scene,GLuint width,GLuint height,QueuePolicy policy,const char* name) {
+	if((GLint)width > maxTextureSize()) {
+		Log("%s: skipped, %ux%u exceeds GL_MAX_TEXTURE_SIZE",name,width,height);
+		return;
+	}
+	const int frames = 120;
+	GLubyte* frame = generateTestPattern(PATTERN_NOISE,width,height,GL_RGB);
+
+	FramePipeline pipeline(scene,width,height,0.5,GL_RGB,GL_UNSIGNED_BYTE,4,policy);
+	StreamProducer producer = { &pipeline, frame, frames };
+	pthread_t thread;
+	pthread_create(&thread,NULL,streamProducerMain,&producer);
+	while(!pipeline.isFinished())
+		pipeline.pump(NULL,true);
+	pthread_join(thread,NULL);
+
+	pipeline.logStats(name);
+	delete[] frame;
+}
+
+void benchmarkStreaming(Scene* scene) {
+	benchmarkStream(scene,1280,720,QUEUE_BLOCK,"stream 720p block");
+	benchmarkStream(scene,1920,1080,QUEUE_BLOCK,"stream 1080p block");
+	benchmarkStream(scene,3840,2160,QUEUE_BLOCK,"stream 4K block");
+	benchmarkStream(scene,1920,1080,QUEUE_DROP_OLDEST,"stream 1080p drop-oldest");
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+// Test patterns
+
+void benchmarkTestPatterns() {
+	const GLuint width = 7680, height = 4320;
+	GLubyte* pixels = new GLubyte[width*height*4];
+	for(int p=0;p<PATTERN_COUNT;p++) {
+		SampleStats stats;
+		for(int i=0;i<5;i++) {
+			double start = nowMs();
+			fillTestPattern(pixels,(TestPattern)p,width,height,GL_RGBA);
+			stats.add(nowMs() - start);
+		}
+		Log("pattern %s 8K RGBA: mean %.2f ms, %.2f MPix/s",getTestPatternName((TestPattern)p),
+				stats.mean(),width*height/(stats.mean()*1000.0));
+	}
+	delete[] pixels;
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+// YUV input
+
+void benchmarkYuv(Scene* scene) {
+	const GLuint width = 1920, height = 1080;
+	const float ratio = 0.5f;
+	const int runs = 10;
+	GLubyte* y = generateTestPattern(PATTERN_NOISE,width,height,GL_LUMINANCE);
+	GLubyte* vu = generateTestPattern(PATTERN_NOISE,width/2,height/2,GL_LUMINANCE_ALPHA);
+	GLubyte* rgb = new GLubyte[width*height*3];
+	GLubyte* out = new GLubyte[(GLuint)(width*ratio*height*ratio*3)];
+	YuvFrame frame = { width, height, YUV_NV21, y, vu, NULL };
+	SampleStats fused,cpuConvert,cpuOnly;
+
+	for(int i=0;i<runs;i++) {
+		double start = nowMs();
+		delete[] (GLubyte*)scene->scaleYuvTexture(ratio,frame);
+		fused.add(nowMs() - start);
+
+		start = nowMs();
+		convertYuvToRgb(frame,rgb,3,YUV_BT601,YUV_RANGE_LIMITED);
+		delete[] (GLubyte*)scene->scaleTexture(ratio,rgb,width,height,GL_RGB,GL_UNSIGNED_BYTE);
+		cpuConvert.add(nowMs() - start);
+
+		start = nowMs();
+		scaleYuvImageBilinear(frame,out,width*ratio,height*ratio,3,YUV_BT601,YUV_RANGE_LIMITED);
+		cpuOnly.add(nowMs() - start);
+	}
+	Log("yuv 1080p NV21 x%.2f",ratio);
+	fused.log("yuv gpu fused convert+scale");
+	cpuConvert.log("yuv cpu convert + gpu scale");
+	cpuOnly.log("yuv cpu convert + cpu scale");
+
+	delete[] out;
+	delete[] rgb;
+	delete[] vu;
+	delete[] y;
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+// I420 output
+
+void benchmarkI420Output(Scene* scene) {
+	const GLuint width = 1920, height = 1080;
+	const float ratio = 0.5f;
+	const int runs = 10;
+	GLubyte* source = generateTestPattern(PATTERN_NOISE,width,height,GL_RGB);
+	GLuint ow = width*ratio, oh = height*ratio;
+	GLubyte* i420 = new GLubyte[ow*oh*3/2];
+	SampleStats rgbPath,packedPath;
+
+	for(int i=0;i<runs;i++) {
+		double start = nowMs();
+		GLubyte* rgb = (GLubyte*)scene->scaleTexture(ratio,source,width,height,GL_RGB,GL_UNSIGNED_BYTE);
+		convertRgbToI420(rgb,ow,oh,3,i420,YUV_BT601,YUV_RANGE_LIMITED);
+		rgbPath.add(nowMs() - start);
+		delete[] rgb;
+
+		start = nowMs();
+		GLuint pw,ph;
+		delete[] scene->scaleTextureToI420(ratio,source,width,height,GL_RGB,GL_UNSIGNED_BYTE,&pw,&ph);
+		packedPath.add(nowMs() - start);
+	}
+	Log("i420 output 1080p x%.2f: readback %u bytes (RGB) vs %u bytes (packed)",ratio,ow*oh*3,ow*oh*3/2);
+	rgbPath.log("i420 rgb readback + cpu convert");
+	packedPath.log("i420 gpu packed readback");
+
+	delete[] i420;
+	delete[] source;
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+// Multi-output
+
+void benchmarkMultiOutput(Scene* scene) {
+	const GLuint width = 1920, height = 1080;
+	static const GLuint sizes[][2] = { { 1280, 720 }, { 960, 540 }, { 640, 360 }, { 320, 180 }, { 160, 90 } };
+	const int count = sizeof(sizes) / sizeof(sizes[0]);
+	const int runs = 10;
+	GLubyte* source = generateTestPattern(PATTERN_ZONE_PLATE,width,height,GL_RGB);
+	ScaleTarget targets[count];
+	SampleStats separate,independent,cascade;
+	double psnr[2] = { 0.0, 0.0 };
+
+	GLubyte* reference = new GLubyte[sizes[count-1][0]*sizes[count-1][1]*3];
+	scaleImageReference(source,width,height,reference,sizes[count-1][0],sizes[count-1][1],3);
+
+	for(int i=0;i<runs;i++) {
+		double start = nowMs();
+		for(int j=0;j<count;j++)
+			delete[] (GLubyte*)scene->scaleTexture((float)sizes[j][0]/width,source,width,height,GL_RGB,GL_UNSIGNED_BYTE);
+		separate.add(nowMs() - start);
+
+		for(int m=0;m<2;m++) {
+			for(int j=0;j<count;j++) {
+				targets[j].width = sizes[j][0];
+				targets[j].height = sizes[j][1];
+			}
+			start = nowMs();
+			scene->scaleTextureMulti(source,width,height,GL_RGB,GL_UNSIGNED_BYTE,targets,count,
+					m ? MULTI_SCALE_CASCADE : MULTI_SCALE_INDEPENDENT);
+			(m ? cascade : independent).add(nowMs() - start);
+			psnr[m] = computePsnr((GLubyte*)targets[count-1].pixels,reference,sizes[count-1][0],sizes[count-1][1],3);
+			for(int j=0;j<count;j++)
+				delete[] (GLubyte*)targets[j].pixels;
+		}
+	}
+	Log("multi-output 1080p -> %d sizes; smallest output psnr independent %.2f cascade %.2f",count,psnr[0],psnr[1]);
+	separate.log("multi-output separate scaleTexture calls");
+	independent.log("multi-output one upload, independent");
+	cascade.log("multi-output one upload, cascade");
+
+	delete[] reference;
+	delete[] source;
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+// Atlas batching
+
+void benchmarkAtlas(Scene* scene) {
+	const int icons = 10000, separateIcons = 1000;
+	const GLuint size = 64, outSize = 32;
+	const int variants = 16;
+	GLubyte* sources[variants];
+	for(int i=0;i<variants;i++) {
+		TestPatternParams params;
+		setDefaultTestPatternParams(&params);
+		params.seed = i + 1;
+		sources[i] = generateTestPattern((TestPattern)(i % PATTERN_COUNT),size,size,GL_RGBA,GL_UNSIGNED_BYTE,&params);
+	}
+
+	std::vector<AtlasImage> images(icons);
+	for(int i=0;i<icons;i++) {
+		AtlasImage image = { sources[i % variants], size, size, outSize, outSize, NULL };
+		images[i] = image;
+	}
+
+	AtlasScaler atlas(scene,GL_RGBA);
+	double start = nowMs();
+	atlas.scale(&images[0],icons);
+	double atlasMs = nowMs() - start;
+	for(int i=0;i<icons;i++)
+		delete[] images[i].output;
+
+	start = nowMs();
+	for(int i=0;i<separateIcons;i++)
+		delete[] (GLubyte*)scene->scaleTexture((float)outSize/size,sources[i % variants],size,size,GL_RGBA,GL_UNSIGNED_BYTE);
+	double separateMs = nowMs() - start;
+
+	Log("atlas %d icons %ux%u -> %ux%u: %.2f ms, %d draws, %.0f icons/s",
+			icons,size,size,outSize,outSize,atlasMs,atlas.getDrawCount(),icons*1000.0/atlasMs);
+	Log("atlas separate scaleTexture: %d icons %.2f ms, %d draws, %.0f icons/s",
+			separateIcons,separateMs,separateIcons,separateIcons*1000.0/separateMs);
+
+	for(int i=0;i<variants;i++)
+		delete[] sources[i];
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+// Compressed input
+
+static double timeUpload(GLenum internalFormat,GLenum type,const GLvoid* data,GLsizei imageSize,GLuint width,GLuint height) {
+	GLuint texture = 0;
+	double start = nowMs();
+	if(imageSize > 0) {
+		if(!initCompressedTexture(&texture,width,height,internalFormat,imageSize,data))
+			return -1.0;
+	}
+	else {
+		initTexture(&texture,width,height,internalFormat,type,(GLvoid*)data);
+	}
+	glFinish();
+	double elapsed = nowMs() - start;
+	deleteTexture(&texture);
+	return elapsed;
+}
+
+void benchmarkCompressed(Scene* scene) {
+	const GLuint width = 1920, height = 1080;
+	const float ratio = 0.5f;
+	const int runs = 10;
+	const GLuint ow = width * ratio, oh = height * ratio;
+	GLubyte* source = generateTestPattern(PATTERN_ZONE_PLATE,width,height,GL_RGB);
+
+	GLushort* rgb565 = new GLushort[width*height];
+	for(GLuint i=0;i<width*height;i++) {
+		const GLubyte* px = source + i * 3;
+		rgb565[i] = ((px[0] >> 3) << 11) | ((px[1] >> 2) << 5) | (px[2] >> 3);
+	}
+
+	const GLuint etcSize = etc1GetEncodedDataSize(width,height);
+	GLubyte* etc = new GLubyte[etcSize];
+	SampleStats encode,decode;
+	GLubyte* decoded = new GLubyte[width*height*3];
+	for(int i=0;i<runs;i++) {
+		double start = nowMs();
+		etc1EncodeImage(source,width,height,3,etc);
+		encode.add(nowMs() - start);
+		start = nowMs();
+		etc1DecodeImage(etc,decoded,width,height,3);
+		decode.add(nowMs() - start);
+	}
+	Log("etc1 1080p cpu round trip psnr %.2f, %.1f MPix/s encode on %d workers",
+			computePsnr(source,decoded,width,height,3),width*height/1000.0/encode.percentile(50),getWorkerCount());
+	encode.log("etc1 cpu encode 1080p");
+	decode.log("etc1 cpu decode 1080p");
+
+	GLubyte* reference = new GLubyte[ow*oh*3];
+	scaleImageReference(source,width,height,reference,ow,oh,3);
+
+	struct {
+		const char* name;
+		GLenum internalFormat;
+		GLenum type;
+		const GLvoid* data;
+		GLsizei imageSize;
+		GLuint bytes;
+	} formats[] = {
+		{ "rgb888", GL_RGB, GL_UNSIGNED_BYTE, source, 0, width*height*3 },
+		{ "rgb565", GL_RGB, GL_UNSIGNED_SHORT_5_6_5, rgb565, 0, width*height*2 },
+		{ "etc1", GL_ETC1_RGB8_OES, 0, etc, (GLsizei)etcSize, etcSize },
+		// ETC2 decoders accept ETC1 blocks unchanged
+		{ "etc2", GL_COMPRESSED_RGB8_ETC2, 0, etc, (GLsizei)etcSize, etcSize },
+	};
+	const int count = sizeof(formats) / sizeof(formats[0]);
+
+	for(int f=0;f<count;f++) {
+		if(formats[f].imageSize > 0 && !isCompressedFormatSupported(formats[f].internalFormat)) {
+			Log("compressed %s: not supported by the driver",formats[f].name);
+			continue;
+		}
+		SampleStats upload;
+		for(int i=0;i<runs;i++) {
+			double ms = timeUpload(formats[f].internalFormat,formats[f].type,formats[f].data,formats[f].imageSize,width,height);
+			if(ms >= 0.0)
+				upload.add(ms);
+		}
+
+		GLubyte* scaled;
+		if(formats[f].imageSize > 0) {
+			scaled = (GLubyte*)scene->scaleCompressedTexture(ratio,formats[f].data,formats[f].imageSize,width,height,formats[f].internalFormat);
+		}
+		else {
+			glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+			scaled = (GLubyte*)scene->scaleTexture(ratio,(GLvoid*)formats[f].data,width,height,formats[f].internalFormat,formats[f].type);
+			glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+		}
+		// 565 output follows the input type and is not comparable byte for byte
+		bool comparable = scaled && formats[f].type != GL_UNSIGNED_SHORT_5_6_5;
+		Log("compressed %s: %u bytes (%.2f bpp), scaled psnr %s%.2f",formats[f].name,formats[f].bytes,formats[f].bytes*8.0/(width*height),
+				comparable ? "" : "n/a ",comparable ? computePsnr(scaled,reference,ow,oh,3) : 0.0);
+		upload.log(formats[f].name);
+		delete[] scaled;
+	}
+
+	delete[] reference;
+	delete[] decoded;
+	delete[] etc;
+	delete[] rgb565;
+	delete[] source;
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+// Result cache
+
+void benchmarkCache(Scene* scene) {
+	const GLuint width = 1280, height = 720;
+	const int sources = 8, requests = 200;
+	static const float ratios[] = { 0.25f, 0.5f, 0.75f };
+	const int ratioCount = sizeof(ratios) / sizeof(ratios[0]);
+	GLubyte* images[sources];
+	for(int i=0;i<sources;i++) {
+		TestPatternParams params;
+		setDefaultTestPatternParams(&params);
+		params.seed = i + 1;
+		images[i] = generateTestPattern((TestPattern)(i % PATTERN_COUNT),width,height,GL_RGB,GL_UNSIGNED_BYTE,&params);
+	}
+
+	// The memory tier holds about a third of the distinct results so the
+	// disk tier gets exercised; it lives next to the app cache if there is one
+	std::string directory;
+	if(scene->getResultCache() && scene->getResultCache()->getDiskDirectory())
+		directory = std::string(scene->getResultCache()->getDiskDirectory()) + "/benchmark";
+	ScaleCache cache(8 << 20,directory.empty() ? NULL : directory.c_str(),64 << 20);
+	cache.clear();
+
+	ScaleCache* previous = scene->getResultCache();
+	SampleStats uncached,cached;
+	unsigned int seed = 1;
+	for(int i=0;i<requests;i++) {
+		seed = seed * 1103515245 + 12345;
+		int source = (seed >> 16) % sources;
+		float ratio = ratios[(seed >> 8) % ratioCount];
+
+		scene->setResultCache(NULL);
+		double start = nowMs();
+		delete[] (GLubyte*)scene->scaleTexture(ratio,images[source],width,height,GL_RGB,GL_UNSIGNED_BYTE);
+		uncached.add(nowMs() - start);
+
+		scene->setResultCache(&cache);
+		start = nowMs();
+		delete[] (GLubyte*)scene->scaleTexture(ratio,images[source],width,height,GL_RGB,GL_UNSIGNED_BYTE);
+		cached.add(nowMs() - start);
+	}
+	scene->setResultCache(previous);
+
+	Log("cache %d requests over %d distinct 720p results, hashing %.2f GB/s",requests,sources*ratioCount,
+			cache.getLookups()*width*height*3/1.0e6/cache.getHashMs());
+	cache.logStats("cache");
+	uncached.log("cache off scaleTexture");
+	cached.log("cache on scaleTexture");
+	cache.clear();
+
+	for(int i=0;i<sources;i++)
+		delete[] images[i];
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+// Dirty rectangles
+
+void benchmarkDirtyRect(Scene* scene) {
+	const GLuint width = 1920, height = 1080;
+	const float ratio = 0.5f;
+	const int runs = 20;
+	static const float areas[] = { 0.01f, 0.10f, 0.50f };
+	GLubyte* source = generateTestPattern(PATTERN_ZONE_PLATE,width,height,GL_RGB);
+	GLubyte* overlay = generateTestPattern(PATTERN_NOISE,width,height,GL_RGB);
+	GLubyte* frame = new GLubyte[width*height*3];
+
+	for(unsigned int a=0;a<sizeof(areas)/sizeof(areas[0]);a++) {
+		// centered rectangle with the source aspect ratio
+		DirtyRect rect;
+		rect.width = width * sqrtf(areas[a]);
+		rect.height = height * sqrtf(areas[a]);
+		rect.x = (width - rect.width) / 2;
+		rect.y = (height - rect.height) / 2;
+
+		SampleStats full,incremental;
+		GLubyte* output = NULL;
+		bool exact = true;
+		for(int i=0;i<runs;i++) {
+			// alternate between the plain source and the source with the overlay
+			memcpy(frame,source,width*height*3);
+			if(i & 1) {
+				for(GLuint y=rect.y;y<rect.y+rect.height;y++)
+					memcpy(frame + (y*width + rect.x)*3,overlay + (y*width + rect.x)*3,rect.width*3);
+			}
+
+			// the previous iteration left frame i-1 resident and its result in output
+			double start;
+			if(output) {
+				start = nowMs();
+				scene->updateScaledTexture(frame,&rect,1,output);
+				incremental.add(nowMs() - start);
+			}
+
+			start = nowMs();
+			GLubyte* reference = (GLubyte*)scene->scaleTexture(ratio,frame,width,height,GL_RGB,GL_UNSIGNED_BYTE);
+			full.add(nowMs() - start);
+			if(output)
+				exact = exact && memcmp(output,reference,(size_t)(width*ratio)*(size_t)(height*ratio)*3) == 0;
+			delete[] output;
+			output = reference;
+		}
+		delete[] output;
+
+		Log("dirty rect %.0f%% of 1080p x%.2f: incremental output %s full rescale",areas[a]*100.0f,ratio,exact ? "matches" : "DIFFERS from");
+		full.log("dirty rect full rescale");
+		incremental.log("dirty rect incremental");
+	}
+
+	delete[] frame;
+	delete[] overlay;
+	delete[] source;
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+// Crop, rotate and scale
+
+void benchmarkCropRotate(Scene* scene) {
+	const GLuint width = 1920, height = 1080;
+	const float ratio = 0.5f;
+	const int runs = 10;
+	GLubyte* source = generateTestPattern(PATTERN_ZONE_PLATE,width,height,GL_RGB);
+
+	ImageTransform transform;
+	transform.x = 320;
+	transform.y = 180;
+	transform.width = 1280;
+	transform.height = 720;
+	transform.rotation = ROTATE_90;
+	transform.flip = FLIP_HORIZONTAL;
+	float matrix[16];
+	getTransformMatrix(transform,width,height,matrix);
+	GLuint tw,th;
+	getTransformedSize(transform,&tw,&th);
+	const GLuint ow = tw * ratio, oh = th * ratio;
+
+	GLubyte* crop = new GLubyte[transform.width*transform.height*3];
+	GLubyte* cpu = new GLubyte[ow*oh*3];
+	GLubyte* gpu = NULL;
+	SampleStats onePass,twoPass,cpuPath;
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+	for(int i=0;i<runs;i++) {
+		// crop on the CPU, then the plain scale; no rotation yet
+		double start = nowMs();
+		for(GLuint y=0;y<transform.height;y++)
+			memcpy(crop + y*transform.width*3,source + ((transform.y + y)*width + transform.x)*3,transform.width*3);
+		delete[] (GLubyte*)scene->scaleTexture(ratio,crop,transform.width,transform.height,GL_RGB,GL_UNSIGNED_BYTE);
+		twoPass.add(nowMs() - start);
+
+		delete[] gpu;
+		start = nowMs();
+		gpu = (GLubyte*)scene->transformTexture(matrix,source,width,height,GL_RGB,GL_UNSIGNED_BYTE,ow,oh);
+		onePass.add(nowMs() - start);
+
+		start = nowMs();
+		transformImageBilinear(source,width,height,cpu,ow,oh,3,matrix);
+		cpuPath.add(nowMs() - start);
+	}
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+
+	Log("crop 1280x720 of 1080p, rotate 90, flip, x%.2f: gpu vs cpu psnr %.2f",ratio,computePsnr(gpu,cpu,ow,oh,3));
+	twoPass.log("crop on cpu + scaleTexture (no rotation)");
+	onePass.log("crop+rotate+scale gpu one pass");
+	cpuPath.log("crop+rotate+scale cpu");
+
+	delete[] gpu;
+	delete[] cpu;
+	delete[] crop;
+	delete[] source;
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+// Shader variants
+
+void benchmarkShaderVariants(Scene* scene) {
+	const GLuint width = 1920, height = 1080;
+	const float ratio = 0.25f;
+	const int runs = 10;
+	static const char* variants[] = { "", "FILTER_BOX", "SWIZZLE_BGR", "FILTER_BOX;SWIZZLE_BGR" };
+	const int count = sizeof(variants) / sizeof(variants[0]);
+	GLubyte* source = generateTestPattern(PATTERN_ZONE_PLATE,width,height,GL_RGBA);
+	GLubyte* reference = new GLubyte[(GLuint)(width*ratio)*(GLuint)(height*ratio)*4];
+	scaleImageReference(source,width,height,reference,width*ratio,height*ratio,4);
+	std::string previous = scene->getShaderDefines();
+
+	for(int v=0;v<count;v++) {
+		double start = nowMs();
+		scene->setShaderDefines(variants[v]);
+		double selectMs = nowMs() - start;
+
+		SampleStats stats;
+		GLubyte* output = NULL;
+		for(int i=0;i<runs;i++) {
+			delete[] output;
+			start = nowMs();
+			output = (GLubyte*)scene->scaleTexture(ratio,source,width,height,GL_RGBA,GL_UNSIGNED_BYTE);
+			stats.add(nowMs() - start);
+		}
+		Log("variant [%s]: selected in %.2f ms, psnr vs reference %.2f",variants[v],selectMs,
+				computePsnr(output,reference,width*ratio,height*ratio,4));
+		stats.log(variants[v][0] ? variants[v] : "default");
+		delete[] output;
+	}
+	scene->setShaderDefines(previous.c_str());
+	scene->getShaderCache()->logStats("shader variants");
+
+	// Switching among the variants on every draw: per-draw location queries
+	// and uniform calls against reflected programs with dirty tracking
+	static const GLfloat quad[] = { -1.0f, -1.0f, 1.0f, -1.0f, -1.0f, 1.0f, 1.0f, 1.0f };
+	const int draws = 2000;
+	Program* programs[count];
+	for(int v=0;v<count;v++)
+		programs[v] = scene->getShaderCache()->getProgram("shaders/vertexShader","shaders/fragmentShader",variants[v]);
+	Framebuffer target(64,64,0,GL_RGBA,GL_UNSIGNED_BYTE);
+	GLuint texture;
+	initTexture(&texture,64,64,GL_RGBA,GL_UNSIGNED_BYTE,source);
+	target.bind();
+	target.setViewPort();
+	glEnableVertexAttribArray(ATTRIB_POSITION);
+	glEnableVertexAttribArray(ATTRIB_TEXCOORD);
+	glVertexAttribPointer(ATTRIB_POSITION, 2, GL_FLOAT, GL_FALSE, 0, quad);
+	glVertexAttribPointer(ATTRIB_TEXCOORD, 2, GL_FLOAT, GL_FALSE, 0, quad);
+
+	for(int pass=0;pass<2;pass++) {
+		unsigned int uploads = 0;
+		for(int v=0;v<count;v++)
+			uploads -= programs[v]->getUploadCount();
+		glFinish();
+		double start = nowMs();
+		for(int i=0;i<draws;i++) {
+			Program* p = programs[i % count];
+			if(pass == 0) {
+				GLuint handle = p->getHandle();
+				glUseProgram(handle);
+				glUniform1i(glGetUniformLocation(handle, "sTexture"), 0);
+				GLint offset = glGetUniformLocation(handle, "uSampleOffset");
+				if(offset >= 0)
+					glUniform2f(offset, 0.25f / 64, 0.25f / 64);
+			}
+			else {
+				p->setUniform1i("sTexture", 0);
+				p->setUniform2f("uSampleOffset", 0.25f / 64, 0.25f / 64);
+				p->use();
+			}
+			glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
+		}
+		glFinish();
+		double elapsed = nowMs() - start;
+		if(pass == 0)
+			Program::invalidateCurrent();
+		for(int v=0;v<count;v++)
+			uploads += programs[v]->getUploadCount();
+		Log("variant switching %s: %d draws %.2f ms, %.2f us per draw%s",pass ? "Program" : "raw GL",draws,elapsed,elapsed*1000.0/draws,
+				pass ? "" : " (location queries every draw)");
+		if(pass)
+			Log("variant switching Program: %u uniform uploads for %d draws",uploads,draws);
+	}
+	target.unbind();
+	target.recoverSavedViewPort();
+	deleteTexture(&texture);
+
+	delete[] reference;
+	delete[] source;
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+// Color modes
+
+void benchmarkColorModes(Scene* scene) {
+	const GLuint width = 1024, height = 1024;
+	const float ratio = 0.37f;
+	const GLuint ow = width * ratio, oh = height * ratio;
+	const int runs = 10;
+	static const int modes[] = { COLOR_MODE_DIRECT, COLOR_MODE_LINEAR, COLOR_MODE_PREMULTIPLIED,
+			COLOR_MODE_LINEAR | COLOR_MODE_PREMULTIPLIED };
+	const int count = sizeof(modes) / sizeof(modes[0]);
+
+	// opaque white cells on transparent black: direct filtering leaves gray halos
+	TestPatternParams params;
+	setDefaultTestPatternParams(&params);
+	params.cellSize = 5;
+	memset(params.colorA,255,4);
+	memset(params.colorB,0,4);
+	GLubyte* source = generateTestPattern(PATTERN_CHECKERBOARD,width,height,GL_RGBA,GL_UNSIGNED_BYTE,&params);
+	// the correct result: filtered in linear light with premultiplied alpha
+	GLubyte* reference = new GLubyte[ow*oh*4];
+	scaleImageBilinearColor(source,width,height,reference,ow,oh,4,COLOR_MODE_LINEAR | COLOR_MODE_PREMULTIPLIED);
+	GLubyte* cpu = new GLubyte[ow*oh*4];
+	int previous = scene->getColorMode();
+	Log("color modes: GL_EXT_sRGB %s",isExtensionSupported("GL_EXT_sRGB") ? "used for linear" : "not supported, shader math");
+
+	for(int m=0;m<count;m++) {
+		if(!scene->setColorMode(modes[m])) {
+			LogError("color mode %s: no program",getColorModeName(modes[m]));
+			continue;
+		}
+		SampleStats gpuStats,cpuStats;
+		GLubyte* gpu = NULL;
+		for(int i=0;i<runs;i++) {
+			delete[] gpu;
+			double start = nowMs();
+			gpu = (GLubyte*)scene->scaleTexture(ratio,source,width,height,GL_RGBA,GL_UNSIGNED_BYTE);
+			gpuStats.add(nowMs() - start);
+
+			start = nowMs();
+			scaleImageBilinearColor(source,width,height,cpu,ow,oh,4,modes[m]);
+			cpuStats.add(nowMs() - start);
+		}
+		const char* name = getColorModeName(modes[m]);
+		Log("color mode %s: psnr vs linear+premultiplied gpu %.2f cpu %.2f, gpu vs cpu %.2f",name,
+				computePsnr(gpu,reference,ow,oh,4),computePsnr(cpu,reference,ow,oh,4),computePsnr(gpu,cpu,ow,oh,4));
+		gpuStats.log((std::string(name) + " gpu").c_str());
+		cpuStats.log((std::string(name) + " cpu").c_str());
+		delete[] gpu;
+	}
+	scene->setColorMode(previous);
+
+	// the standalone stages, for assets stored premultiplied
+	SampleStats premultiply,unpremultiply;
+	for(int i=0;i<runs;i++) {
+		double start = nowMs();
+		premultiplyAlpha(source,width*height);
+		premultiply.add(nowMs() - start);
+		start = nowMs();
+		unpremultiplyAlpha(source,width*height);
+		unpremultiply.add(nowMs() - start);
+	}
+	Log("premultiply %.0f MB/s, unpremultiply %.0f MB/s",width*height*4 / premultiply.mean() / 1000.0,
+			width*height*4 / unpremultiply.mean() / 1000.0);
+
+	delete[] cpu;
+	delete[] reference;
+	delete[] source;
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+// File pipeline
+
+// Generates the files once and keeps them: half PNG, half PPM, every
+// pattern, RGB and RGBA
+static bool prepareFileJobs(const char* dataDirectory,int fileCount,std::vector<FileJob>& jobs) {
+	if(!dataDirectory) {
+		Log("file pipeline: skipped, no data directory");
+		return false;
+	}
+	const GLuint width = 96, height = 96;
+	std::string input = std::string(dataDirectory) + "/pipeline-input";
+	std::string output = std::string(dataDirectory) + "/pipeline-output";
+	mkdir(input.c_str(),0700);
+
+	double start = nowMs();
+	int generated = 0;
+	for(int i=0;i<fileCount;i++) {
+		char name[64];
+		sprintf(name,"/%05d.%s",i,i % 2 ? "ppm" : "png");
+		std::string path = input + name;
+		if(access(path.c_str(),F_OK) == 0)
+			continue;
+		TestPatternParams params;
+		setDefaultTestPatternParams(&params);
+		params.seed = i + 1;
+		DecodedImage image = { width, height, (i / 2) % 2 ? 4u : 3u, NULL };
+		image.pixels = generateTestPattern((TestPattern)((i / 4) % PATTERN_COUNT),width,height,getImageGlFormat(image.channels),
+				GL_UNSIGNED_BYTE,&params);
+		writeImageFile(path.c_str(),image);
+		delete[] image.pixels;
+		generated++;
+	}
+	if(generated)
+		Log("file pipeline: generated %d files in %.2f s",generated,(nowMs() - start) / 1000.0);
+
+	FilePipeline::listDirectory(input.c_str(),output.c_str(),jobs);
+	if((int)jobs.size() > fileCount)
+		jobs.resize(fileCount);
+	return !jobs.empty();
+}
+
+void benchmarkFilePipeline(Scene* scene,const char* dataDirectory,int fileCount) {
+	std::vector<FileJob> jobs;
+	if(!prepareFileJobs(dataDirectory,fileCount,jobs))
+		return;
+
+	FilePipeline gpu(scene,0.5f,FILE_SCALE_GPU);
+	gpu.run(jobs);
+	gpu.logStats("file pipeline gpu");
+
+	FilePipeline cpu(scene,0.5f,FILE_SCALE_CPU);
+	cpu.run(jobs);
+	cpu.logStats("file pipeline cpu");
+
+	// a single thread per stage shows how much the overlap buys
+	FilePipeline serial(scene,0.5f,FILE_SCALE_GPU,1,1,1);
+	serial.run(jobs);
+	serial.logStats("file pipeline gpu 1 thread per stage");
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+// Logging
+
+void benchmarkLogging(Scene* scene,const char* dataDirectory) {
+	// cost of an enabled message on this thread, in bursts the ring can hold
+	const int bursts = 10, perBurst = 50;
+	double elapsed[2] = { 0.0, 0.0 };
+	for(int queued=0;queued<2;queued++) {
+		logSetSynchronous(!queued);
+		for(int b=0;b<bursts;b++) {
+			double start = nowMs();
+			for(int i=0;i<perBurst;i++)
+				Log("logging benchmark %d.%d",b,i);
+			elapsed[queued] += nowMs() - start;
+			logFlush();
+		}
+	}
+	logSetSynchronous(false);
+	const int messages = bursts * perBurst;
+	Log("logging: %.0f ns per message written at once, %.0f ns queued; LOG_MIN_LEVEL %d",
+			elapsed[0] * 1.0e6 / messages,elapsed[1] * 1.0e6 / messages,LOG_MIN_LEVEL);
+
+	// the 10k file batch with whatever this build logs per image; build with
+	// LOG_MIN_LEVEL=1 to get the per-call messages that used to be always on
+	std::vector<FileJob> jobs;
+	if(!prepareFileJobs(dataDirectory,10000,jobs))
+		return;
+	for(int queued=0;queued<2;queued++) {
+		logSetSynchronous(!queued);
+		FilePipeline pipeline(scene,0.5f,FILE_SCALE_GPU);
+		pipeline.run(jobs);
+		logSetSynchronous(false);
+		pipeline.logStats(queued ? "file pipeline, queued logging" : "file pipeline, logging written at once");
+	}
+	Log("logging: %u messages dropped so far",logGetDropped());
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+// GPU memory
+
+static void logGpuMemory(const char* name,size_t before) {
+	Log("gpu memory %s: peak %.2f MB, %.2f MB held before, %.2f MB after",name,gpuMemoryGetPeak() / 1048576.0,
+			before / 1048576.0,gpuMemoryGetUsed() / 1048576.0);
+}
+
+void benchmarkGpuMemory(Scene* scene) {
+	const GLuint width = 1920, height = 1080;
+	const int runs = 10;
+	GLubyte* source = generateTestPattern(PATTERN_ZONE_PLATE,width,height,GL_RGBA);
+
+	// peak while each workload runs, steady state once it is done
+	size_t before = gpuMemoryGetUsed();
+	gpuMemoryResetPeak();
+	delete[] (GLubyte*)scene->scaleTexture(0.5f,source,width,height,GL_RGBA,GL_UNSIGNED_BYTE);
+	logGpuMemory("scaleTexture 1080p RGBA x0.5",before);
+
+	before = gpuMemoryGetUsed();
+	gpuMemoryResetPeak();
+	ScaleTarget targets[3] = { { 1280, 720, NULL }, { 640, 360, NULL }, { 320, 180, NULL } };
+	scene->scaleTextureMulti(source,width,height,GL_RGBA,GL_UNSIGNED_BYTE,targets,3,MULTI_SCALE_CASCADE);
+	for(int i=0;i<3;i++)
+		delete[] (GLubyte*)targets[i].pixels;
+	logGpuMemory("multi-output 1080p RGBA, 3 sizes",before);
+
+	before = gpuMemoryGetUsed();
+	gpuMemoryResetPeak();
+	{
+		FramePipeline pipeline(scene,width,height,0.5f,GL_RGB);
+	}
+	logGpuMemory("stream 1080p pipeline",before);
+
+	before = gpuMemoryGetUsed();
+	gpuMemoryResetPeak();
+	{
+		AtlasScaler atlas(scene,GL_RGBA);
+	}
+	logGpuMemory("atlas 2048 RGBA",before);
+
+	// a budget too small for a 1080p source and output: the pools are
+	// evicted first, then scaleTexture runs on the CPU
+	size_t budget = gpuMemoryGetBudget();
+	unsigned int fallbacks = scene->getCpuFallbackCount();
+	SampleStats gpu,cpu;
+	for(int i=0;i<runs;i++) {
+		double start = nowMs();
+		delete[] (GLubyte*)scene->scaleTexture(1.0f,source,width,height,GL_RGBA,GL_UNSIGNED_BYTE);
+		gpu.add(nowMs() - start);
+	}
+	gpuMemorySetBudget(gpuMemoryGetUsed() - 2 * gpuMemoryGetTextureSize(width,height,GL_RGBA,GL_UNSIGNED_BYTE));
+	for(int i=0;i<runs;i++) {
+		double start = nowMs();
+		delete[] (GLubyte*)scene->scaleTexture(1.0f,source,width,height,GL_RGBA,GL_UNSIGNED_BYTE);
+		cpu.add(nowMs() - start);
+	}
+	gpuMemorySetBudget(budget);
+	Log("gpu memory budget: %u of %d scaleTexture calls fell back to the CPU",scene->getCpuFallbackCount() - fallbacks,runs);
+	gpu.log("gpu memory scaleTexture 1080p within budget");
+	cpu.log("gpu memory scaleTexture 1080p over budget");
+
+	gpuMemoryLogReport("gpu memory");
+	delete[] source;
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+// Render graph
+
+// One fragmentShader variant over the first input; blurStep in texels
+class ShaderPass : public RenderPassBody {
+public:
+	ShaderPass(Program* program,float blurX = 0.0f,float blurY = 0.0f):program(program),blurX(blurX),blurY(blurY) {}
+	void execute(const RenderPassIO& io) {
+		program->setUniform1i("sTexture", 0);
+		program->setUniform2f("uBlurStep", blurX / io.inputWidths[0], blurY / io.inputHeights[0]);
+		program->use();
+		glActiveTexture(GL_TEXTURE0);
+		glBindTexture(GL_TEXTURE_2D, io.inputTextures[0]);
+		drawRenderPassQuad();
+		glBindTexture(GL_TEXTURE_2D, 0);
+	}
+private:
+	Program* program;
+	float blurX,blurY;
+};
+
+void benchmarkRenderGraph(Scene* scene) {
+	const GLuint width = 1920, height = 1080;
+	const int frames = 20;
+	ShaderVariantCache* shaders = scene->getShaderCache();
+	Program* plain = shaders->getProgram("shaders/vertexShader","shaders/fragmentShader");
+	Program* blur = shaders->getProgram("shaders/vertexShader","shaders/fragmentShader","SEPARABLE_BLUR");
+	if(!plain || !blur) {
+		Log("render graph: skipped, no program");
+		return;
+	}
+	GLubyte* pixels = generateTestPattern(PATTERN_ZONE_PLATE,width,height,GL_RGBA);
+	GLuint source;
+	initTexture(&source,width,height,GL_RGBA,GL_UNSIGNED_BYTE,pixels,"benchmark");
+	glBindTexture(GL_TEXTURE_2D, 0);
+
+	// scale, blur along x, blur along y, scale again; the preview is never
+	// read, so its pass is culled
+	ShaderPass scale(plain), blurX(blur,1.0f,0.0f), blurY(blur,0.0f,1.0f), shrink(plain), preview(plain);
+	RenderGraph graph;
+	SampleStats stats;
+	int output = -1;
+	for(int i=0;i<frames;i++) {
+		double start = nowMs();
+		// declared every frame, as a caller building effects on the fly would
+		graph.reset();
+		int in = graph.importTexture("source",source,width,height);
+		int half = graph.createTarget("half",width/2,height/2);
+		int blurredX = graph.createTarget("blur x",width/2,height/2);
+		int blurred = graph.createTarget("blur xy",width/2,height/2);
+		int thumb = graph.createTarget("preview",width/8,height/8);
+		output = graph.createTarget("quarter",width/4,height/4);
+		int pass = graph.addPass("scale",&scale);
+		graph.read(pass,in);
+		graph.write(pass,half);
+		pass = graph.addPass("preview",&preview);
+		graph.read(pass,half);
+		graph.write(pass,thumb);
+		pass = graph.addPass("blur x",&blurX);
+		graph.read(pass,half);
+		graph.write(pass,blurredX);
+		pass = graph.addPass("blur y",&blurY);
+		graph.read(pass,blurredX);
+		graph.write(pass,blurred);
+		pass = graph.addPass("shrink",&shrink);
+		graph.read(pass,blurred);
+		graph.write(pass,output);
+		graph.markOutput(output);
+		graph.execute();
+		glFinish();
+		stats.add(nowMs() - start);
+	}
+	GLubyte* result = (GLubyte*)graph.getOutput(output)->grabDataPointer();
+	delete[] result;
+
+	graph.logStats("render graph 1080p blur chain");
+	stats.log("render graph 1080p blur chain, declare and run");
+	deleteTexture(&source);
+	delete[] pixels;
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+// Sharpen and dither
+
+struct PostScaleCase {
+	const char* name;
+	const char* defines;
+	GLenum outputType;
+	PostScaleOptions cpu;
+};
+
+void benchmarkSharpenDither(Scene* scene) {
+	const GLuint width = 1920, height = 1080;
+	const float ratio = 0.25f, amount = 0.5f;
+	const GLuint ow = width * ratio, oh = height * ratio;
+	const int runs = 10;
+	static const PostScaleCase cases[] = {
+		{ "plain", "", 0, { 0.0f, DITHER_NONE, false } },
+		{ "sharpen", "SHARPEN", 0, { amount, DITHER_NONE, false } },
+		{ "565", "", GL_UNSIGNED_SHORT_5_6_5, { 0.0f, DITHER_NONE, true } },
+		{ "565 ordered dither", "DITHER_ORDERED", GL_UNSIGNED_SHORT_5_6_5, { 0.0f, DITHER_ORDERED, true } },
+		{ "565 noise dither", "DITHER_NOISE", GL_UNSIGNED_SHORT_5_6_5, { 0.0f, DITHER_NOISE, true } },
+		{ "sharpen + 565 ordered dither", "SHARPEN;DITHER_ORDERED", GL_UNSIGNED_SHORT_5_6_5, { amount, DITHER_ORDERED, true } }
+	};
+	const int count = sizeof(cases) / sizeof(cases[0]);
+
+	// smooth ramps band the most in 5_6_5
+	GLubyte* source = generateTestPattern(PATTERN_GRADIENT,width,height,GL_RGB,GL_UNSIGNED_BYTE);
+	GLubyte* cpu = new GLubyte[ow*oh*3];
+	GLubyte* finished = new GLubyte[ow*oh*3];
+	std::string previous = scene->getShaderDefines();
+	float previousAmount = scene->getSharpenAmount();
+	GLenum previousType = scene->getOutputType();
+	scene->setSharpenAmount(amount);
+
+	for(int c=0;c<count;c++) {
+		const PostScaleCase& test = cases[c];
+		if(!scene->setShaderDefines(test.defines)) {
+			LogError("sharpen/dither %s: no program",test.name);
+			continue;
+		}
+		scene->setOutputType(test.outputType);
+		SampleStats gpuStats,cpuStats;
+		GLubyte* gpu = NULL;
+		for(int i=0;i<runs;i++) {
+			delete[] gpu;
+			double start = nowMs();
+			gpu = (GLubyte*)scene->scaleTexture(ratio,source,width,height,GL_RGB,GL_UNSIGNED_BYTE);
+			gpuStats.add(nowMs() - start);
+
+			start = nowMs();
+			scaleImageBilinearPost(source,width,height,cpu,ow,oh,3,test.cpu);
+			cpuStats.add(nowMs() - start);
+		}
+		if(gpu && !test.cpu.rgb565)
+			Log("sharpen/dither %s: psnr gpu vs cpu %.2f",test.name,computePsnr(gpu,cpu,ow,oh,3));
+		Log("sharpen/dither %s: gpu %.1f MPix/s, cpu %.1f MPix/s",test.name,
+				ow*oh / gpuStats.mean() / 1000.0,ow*oh / cpuStats.mean() / 1000.0);
+		gpuStats.log((std::string("sharpen/dither ") + test.name + " gpu").c_str());
+		cpuStats.log((std::string("sharpen/dither ") + test.name + " cpu").c_str());
+		delete[] gpu;
+	}
+
+	// what the fused stages replace: a plain scale, then a CPU pass over the readback
+	scene->setShaderDefines("");
+	scene->setOutputType(0);
+	SampleStats separate;
+	for(int i=0;i<runs;i++) {
+		double start = nowMs();
+		GLubyte* gpu = (GLubyte*)scene->scaleTexture(ratio,source,width,height,GL_RGB,GL_UNSIGNED_BYTE);
+		if(gpu)
+			scaleImageBilinearPost(gpu,ow,oh,finished,ow,oh,3,cases[count - 1].cpu);
+		separate.add(nowMs() - start);
+		delete[] gpu;
+	}
+	Log("sharpen/dither %s as a separate CPU pass: %.1f MPix/s",cases[count - 1].name,ow*oh / separate.mean() / 1000.0);
+	separate.log("sharpen/dither separate pass");
+
+	scene->setShaderDefines(previous.c_str());
+	scene->setSharpenAmount(previousAmount);
+	scene->setOutputType(previousType);
+	delete[] finished;
+	delete[] cpu;
+	delete[] source;
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+// Image statistics
+
+// The reduction rounds the mean to 1/256 per pass
+static bool sameStats(const ImageStats& a,const ImageStats& b) {
+	if(a.min != b.min || a.max != b.max || fabs(a.mean - b.mean) > 0.05f)
+		return false;
+	return !a.hasHistogram || !b.hasHistogram || !memcmp(a.histogram,b.histogram,sizeof(a.histogram));
+}
+
+void benchmarkImageStats(Scene* scene) {
+	// the histogram scatter takes 2048 rows in 2 blocks at 1080p, 3840 rows
+	// in 4 blocks at 2040x1800 and 257 rows at 480x270; no side is over 2048,
+	// past which some GPUs fetch the reduce texels imprecisely
+	static const GLuint sizes[][2] = { { 1920, 1080 }, { 2040, 1800 }, { 480, 270 } };
+	const int runs = 10;
+	StatsReducer reducer(scene->getShaderCache());
+	for(unsigned int s=0;s<sizeof(sizes)/sizeof(sizes[0]);s++) {
+		const GLuint w = sizes[s][0], h = sizes[s][1];
+		char name[64];
+		snprintf(name,sizeof(name),"image stats %ux%u",w,h);
+		GLubyte* pixels = generateTestPattern(PATTERN_ZONE_PLATE,w,h,GL_RGBA);
+		GLubyte* readback = new GLubyte[w*h*4];
+		Framebuffer fb(w,h,pixels,GL_RGBA,GL_UNSIGNED_BYTE,0,"benchmark");
+		ImageStats cpu,cpuHistogram,scalar,gpu,gpuHistogram;
+		SampleStats readbackStats,cpuStats,cpuHistogramStats,scalarStats,gpuStats,gpuHistogramStats;
+		bool reduced = true, histogram = true;
+		size_t reduceBytes = 0, histogramBytes = 0;
+		for(int i=0;i<runs;i++) {
+			double start = nowMs();
+			fb.grabData(readback);
+			readbackStats.add(nowMs() - start);
+
+			start = nowMs();
+			computeImageStats(readback,w,h,4,&cpu,false);
+			cpuStats.add(nowMs() - start);
+			start = nowMs();
+			computeImageStats(readback,w,h,4,&cpuHistogram,true);
+			cpuHistogramStats.add(nowMs() - start);
+			start = nowMs();
+			computeImageStatsScalar(readback,w,h,4,&scalar,true);
+			scalarStats.add(nowMs() - start);
+
+			// the readback inside waits for the passes, so this is the latency
+			start = nowMs();
+			reduced = reducer.reduce(fb.getTexture(),w,h,&gpu) && reduced;
+			gpuStats.add(nowMs() - start);
+			reduceBytes = reducer.getReadbackBytes();
+			start = nowMs();
+			histogram = reducer.computeHistogram(fb.getTexture(),w,h,&gpuHistogram) && histogram;
+			gpuHistogramStats.add(nowMs() - start);
+			histogramBytes = reducer.getReadbackBytes();
+		}
+
+		Log("%s: luma mean %.3f, min %d, max %d; vectorized %s the scalar reference",name,cpu.mean,cpu.min,cpu.max,
+				sameStats(cpuHistogram,scalar) && sameStats(cpu,scalar) ? "matches" : "differs from");
+		Log("%s: full readback %u bytes %.2f ms, then cpu %.2f ms, with histogram %.2f ms, scalar %.2f ms",name,w*h*4,
+				readbackStats.mean(),cpuStats.mean(),cpuHistogramStats.mean(),scalarStats.mean());
+		if(reduced)
+			Log("%s: gpu reduce %u bytes read back, %.2f ms, mean %.3f, %s the cpu",name,(unsigned int)reduceBytes,
+					gpuStats.mean(),gpu.mean,sameStats(gpu,cpu) ? "matches" : "differs from");
+		else
+			Log("%s: gpu reduce not supported",name);
+		if(histogram)
+			Log("%s: gpu histogram %u bytes read back, %.2f ms, %s the cpu",name,(unsigned int)histogramBytes,
+					gpuHistogramStats.mean(),sameStats(gpuHistogram,cpuHistogram) ? "matches" : "differs from");
+		else
+			Log("%s: gpu histogram not supported",name);
+		readbackStats.log((std::string(name) + " readback").c_str());
+		cpuHistogramStats.log((std::string(name) + " cpu histogram").c_str());
+		if(reduced)
+			gpuStats.log((std::string(name) + " gpu reduce").c_str());
+		if(histogram)
+			gpuHistogramStats.log((std::string(name) + " gpu histogram").c_str());
+		delete[] readback;
+		delete[] pixels;
+	}
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+// Sprite batching
+
+enum SpriteDrawMode {
+	SPRITES_SEPARATE,		// drawBatch per sprite
+	SPRITES_UNSORTED,		// SpriteBatch in queue order
+	SPRITES_SORTED			// SpriteBatch by texture
+};
+
+// A grid of count sprites over the target, the textures taken in turn so
+// that neighbours never share one
+static void drawSpriteFrame(Scene* scene,SpriteBatch* batch,SpriteDrawMode mode,const GLuint* textures,int textureCount,
+		int count,GLuint* draws) {
+	const int columns = (int)ceil(sqrt((double)count));
+	const float size = 2.0f / columns;
+	*draws = 0;
+	for(int i=0;i<count;i++) {
+		float x = (i % columns) * size - 1.0f, y = (i / columns) * size - 1.0f;
+		GLuint texture = textures[i % textureCount];
+		if(mode != SPRITES_SEPARATE) {
+			batch->add(texture,x,y,size,size);
+			continue;
+		}
+		// same winding as Scene::triangleVerticesPNG
+		TriangleVertex p[6] = { { x + size, y + size }, { x, y }, { x + size, y }, { x, y + size }, { x, y }, { x + size, y + size } };
+		TriangleVertex t[6] = { { 1.0f, 1.0f }, { 0.0f, 0.0f }, { 1.0f, 0.0f }, { 0.0f, 1.0f }, { 0.0f, 0.0f }, { 1.0f, 1.0f } };
+		scene->drawBatch(texture,p,t,6);
+		(*draws)++;
+	}
+	if(mode != SPRITES_SEPARATE)
+		*draws = scene->drawSprites(batch,mode == SPRITES_SORTED);
+}
+
+void benchmarkSpriteBatch(Scene* scene) {
+	static const int counts[] = { 1000, 10000 };
+	static const char* modeNames[] = { "separate", "batch unsorted", "batch sorted" };
+	const int textureCount = 16, frames = 30;
+	const GLuint size = 64, targetSize = 1024;
+	GLuint textures[textureCount];
+	for(int i=0;i<textureCount;i++) {
+		GLubyte* pixels = generateTestPattern((TestPattern)(i % PATTERN_COUNT),size,size,GL_RGBA);
+		initTexture(&textures[i],size,size,GL_RGBA,GL_UNSIGNED_BYTE,pixels,"benchmark");
+		delete[] pixels;
+	}
+	Framebuffer target(targetSize,targetSize,0,GL_RGBA,GL_UNSIGNED_BYTE,0,"benchmark");
+	std::vector<GLubyte> reference(targetSize*targetSize*4), output(targetSize*targetSize*4);
+	SpriteBatch batch;
+	glClearColor(0.0f, 0.0f, 0.0f, 1.0f);
+	for(int c=0;c<2;c++) {
+		const int count = counts[c];
+		for(int m=0;m<3;m++) {
+			char name[64];
+			snprintf(name,sizeof(name),"sprites %d %s",count,modeNames[m]);
+			SampleStats cpuStats,frameStats;
+			GLuint draws = 0;
+			target.bind();
+			target.setViewPort();
+			for(int i=0;i<frames;i++) {
+				glClear(GL_COLOR_BUFFER_BIT);
+				double start = nowMs();
+				drawSpriteFrame(scene,&batch,(SpriteDrawMode)m,textures,textureCount,count,&draws);
+				cpuStats.add(nowMs() - start);
+				glFinish();
+				frameStats.add(nowMs() - start);
+			}
+			target.unbind();
+			target.recoverSavedViewPort();
+			target.grabData(m ? &output[0] : &reference[0]);
+
+			Log("%s: %u draws, %u texture binds, cpu %.3f ms, frame %.3f ms per frame, %s",name,draws,
+					m ? batch.getBindCount() : draws,cpuStats.mean(),frameStats.mean(),
+					!m ? "reference" : output == reference ? "matches separate" : "differs from separate");
+			cpuStats.log((std::string(name) + " cpu").c_str());
+			frameStats.log((std::string(name) + " frame").c_str());
+		}
+	}
+	Log("sprites: vertex buffer orphaned %u times",batch.getOrphanCount());
+	for(int i=0;i<textureCount;i++)
+		deleteTexture(&textures[i]);
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+// Pixel conversion
+
+typedef struct
+{
+	const char* name;
+	GLenum srcFormat;
+	GLenum dstFormat;
+	GLuint srcPadding;		// bytes after each row
+	GLuint dstPadding;
+} ConvertCase;
+
+// Mean ms of runs convertPixels (or the scalar reference) calls
+static double timeConvert(const ConvertCase& c,const GLubyte* src,GLubyte* dst,GLuint width,GLuint height,bool scalar,int runs) {
+	const GLuint srcStride = width * getPixelSize(c.srcFormat,GL_UNSIGNED_BYTE) + c.srcPadding;
+	const GLuint dstStride = width * getPixelSize(c.dstFormat,GL_UNSIGNED_BYTE) + c.dstPadding;
+	SampleStats stats;
+	for(int i=0;i<runs;i++) {
+		double start = nowMs();
+		if(scalar)
+			convertPixelsScalar(src,srcStride,c.srcFormat,dst,dstStride,c.dstFormat,width,height);
+		else
+			convertPixels(src,srcStride,c.srcFormat,dst,dstStride,c.dstFormat,width,height);
+		stats.add(nowMs() - start);
+	}
+	return stats.mean();
+}
+
+// Mean ms of an upload of a fresh texture, finished
+static double timeTextureUpload(GLuint width,GLuint height,GLenum format,const GLubyte* pixels,GLuint stride,int runs) {
+	SampleStats stats;
+	for(int i=0;i<runs;i++) {
+		GLuint texture = 0;
+		double start = nowMs();
+		uploadTexture(&texture,width,height,format,GL_UNSIGNED_BYTE,pixels,stride,"benchmark");
+		glFinish();
+		stats.add(nowMs() - start);
+		deleteTexture(&texture);
+	}
+	return stats.mean();
+}
+
+void benchmarkPixelConvert() {
+	static const ConvertCase cases[] = {
+		{ "RGB to RGBA", GL_RGB, GL_RGBA, 0, 0 },
+		{ "RGBA to RGB", GL_RGBA, GL_RGB, 0, 0 },
+		{ "RGB to BGRA", GL_RGB, GL_BGRA_EXT, 0, 0 },
+		{ "BGRA to RGB", GL_BGRA_EXT, GL_RGB, 0, 0 },
+		{ "RGBA to BGRA", GL_RGBA, GL_BGRA_EXT, 0, 0 },
+		{ "RGB to gray", GL_RGB, GL_LUMINANCE, 0, 0 },
+		{ "RGBA to gray", GL_RGBA, GL_LUMINANCE, 0, 0 },
+		{ "RGBA padding removal", GL_RGBA, GL_RGBA, 256, 0 },
+		{ "RGB padding insertion", GL_RGB, GL_RGB, 0, 2 }
+	};
+	const GLuint width = 1918, height = 1080;
+	const int runs = 10;
+	const size_t bufferSize = (size_t)(width * 4 + 256) * height;
+	GLubyte* src = generateTestPattern(PATTERN_NOISE,width + 64,height,GL_RGBA);
+	GLubyte* dst = new GLubyte[bufferSize];
+	GLubyte* reference = new GLubyte[bufferSize];
+	for(unsigned int i=0;i<sizeof(cases)/sizeof(cases[0]);i++) {
+		const ConvertCase& c = cases[i];
+		const GLuint dstStride = width * getPixelSize(c.dstFormat,GL_UNSIGNED_BYTE) + c.dstPadding;
+		// bytes read and written, padding excluded
+		const double bytes = (double)width * height * (getPixelSize(c.srcFormat,GL_UNSIGNED_BYTE) + getPixelSize(c.dstFormat,GL_UNSIGNED_BYTE));
+		memset(dst,0,bufferSize);
+		memset(reference,0,bufferSize);
+		double ms = timeConvert(c,src,dst,width,height,false,runs);
+		double scalarMs = timeConvert(c,src,reference,width,height,true,runs);
+		Log("convert %s %ux%u: %.2f ms %.2f GB/s, scalar %.2f ms %.2f GB/s, %s",c.name,width,height,
+				ms,bytes / (ms * 1e6),scalarMs,bytes / (scalarMs * 1e6),
+				!memcmp(dst,reference,(size_t)dstStride * height) ? "matches" : "differs");
+	}
+
+	// an RGB row of 1918 pixels is not a multiple of 4 bytes
+	const GLuint rgbRow = width * 3;
+	Log("upload %ux%u RGB, GL_UNPACK_ALIGNMENT %d: %.2f ms",width,height,getUnpackAlignment(rgbRow,rgbRow),
+			timeTextureUpload(width,height,GL_RGB,src,0,runs));
+	SampleStats expandStats;
+	for(int i=0;i<runs;i++) {
+		GLuint texture = 0;
+		double start = nowMs();
+		convertRgbToRgba(src,dst,width * height);
+		uploadTexture(&texture,width,height,GL_RGBA,GL_UNSIGNED_BYTE,dst,0,"benchmark");
+		glFinish();
+		expandStats.add(nowMs() - start);
+		deleteTexture(&texture);
+	}
+	Log("upload %ux%u RGB expanded to RGBA first: %.2f ms",width,height,expandStats.mean());
+	// rows of a wider image, as a crop or a decoder with padded rows hands them over
+	Log("upload %ux%u RGBA from rows %u bytes apart: %.2f ms (GL_EXT_unpack_subimage %s), packed rows %.2f ms",width,height,
+			(width + 64) * 4,timeTextureUpload(width,height,GL_RGBA,src,(width + 64) * 4,runs),
+			isExtensionSupported("GL_EXT_unpack_subimage") ? "yes" : "no, repacked",timeTextureUpload(width,height,GL_RGBA,src,0,runs));
+
+	delete[] reference;
+	delete[] dst;
+	delete[] src;
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+// Dynamic resolution
+
+// One display frame on the headless backend: surface stands in for the
+// window, passes full viewport draws of the scene are the GPU load and
+// glFinish the swap. Returns the frame time in ms.
+static double drawLoadedFrame(Scene* scene,Framebuffer* surface,DynamicResolution* resolution,Program* upscale,int passes) {
+	double start = nowMs();
+	scene->ensureDisplay();
+	surface->bind();
+	surface->setViewPort();
+	bool scaled = resolution->begin(surface->getWidth(),surface->getHeight());
+	for(int i=0;i<passes;i++)
+		scene->draw();
+	if(scaled)
+		resolution->end(upscale);
+	surface->unbind();
+	surface->recoverSavedViewPort();
+	glFinish();
+	double ms = nowMs() - start;
+	resolution->addFrameTime(ms);
+	return ms;
+}
+
+void benchmarkDynamicResolution(Scene* scene) {
+	const GLuint width = 1920, height = 1080;
+	// light, loaded, light again
+	const int phaseFrames[3] = { 60, 180, 60 };
+	Program* upscale = scene->getShaderCache()->getProgram("shaders/vertexShader","shaders/fragmentShader");
+	std::string previous = scene->getShaderDefines();
+	if(!upscale || !scene->setShaderDefines("SHARPEN")) {
+		Log("dynamic resolution: skipped, no program");
+		scene->setShaderDefines(previous.c_str());
+		return;
+	}
+	Framebuffer surface(width,height,0,GL_RGBA,GL_UNSIGNED_BYTE,0,"benchmark");
+
+	// 60 Hz, or 2 passes on a GPU too slow for it; the loaded phase takes
+	// twice the target at full size, the light ones about half
+	DynamicResolution fixed(0.0);
+	fixed.setEnabled(false);
+	SampleStats pass;
+	for(int i=0;i<5;i++)
+		pass.add(drawLoadedFrame(scene,&surface,&fixed,upscale,1));
+	const double targetMs = std::max(1000.0 / 60.0,2.0 * pass.mean());
+	const int heavy = std::max(1,(int)ceil(2.0 * targetMs / pass.mean()));
+	const int passes[3] = { std::max(1,heavy / 4), heavy, std::max(1,heavy / 4) };
+	Log("dynamic resolution: %.2f ms a full size pass, %d passes loaded, %d light, target %.1f ms",
+			pass.mean(),heavy,passes[0],targetMs);
+
+	for(int mode=0;mode<2;mode++) {
+		DynamicResolution resolution(targetMs);
+		resolution.setEnabled(mode == 1);
+		SampleStats all,loaded;
+		double loadedScale = 0.0;
+		int over = 0;
+		for(int phase=0;phase<3;phase++) {
+			for(int i=0;i<phaseFrames[phase];i++) {
+				double ms = drawLoadedFrame(scene,&surface,&resolution,upscale,passes[phase]);
+				all.add(ms);
+				if(phase == 1) {
+					loaded.add(ms);
+					loadedScale += resolution.getScale();
+					over += ms > targetMs;
+				}
+			}
+		}
+		const char* name = mode ? "dynamic resolution on" : "dynamic resolution off";
+		all.log(name);
+		loaded.log((std::string(name) + ", loaded").c_str());
+		if(mode)
+			Log("%s: %.1f%% of loaded frames over target, mean scale %.2f loaded, %.2f at the end, %u changes",name,
+					100.0 * over / phaseFrames[1],loadedScale / phaseFrames[1],resolution.getScale(),resolution.getChangeCount());
+		else
+			Log("%s: %.1f%% of loaded frames over target",name,100.0 * over / phaseFrames[1]);
+	}
+
+	scene->setShaderDefines(previous.c_str());
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+
+void runBenchmarks(Scene* scene,const char* dataDirectory) {
+	Log("Benchmarks: start");
+	// measure the GPU path; benchmarkCache sets up its own cache
+	ScaleCache* cache = scene->getResultCache();
+	scene->setResultCache(NULL);
+	benchmarkTestPatterns();
+	benchmarkStreaming(scene);
+	benchmarkYuv(scene);
+	benchmarkI420Output(scene);
+	benchmarkMultiOutput(scene);
+	benchmarkAtlas(scene);
+	benchmarkCompressed(scene);
+	benchmarkDirtyRect(scene);
+	benchmarkCropRotate(scene);
+	benchmarkShaderVariants(scene);
+	benchmarkColorModes(scene);
+	benchmarkFilePipeline(scene,dataDirectory);
+	benchmarkLogging(scene,dataDirectory);
+	benchmarkGpuMemory(scene);
+	benchmarkRenderGraph(scene);
+	benchmarkSharpenDither(scene);
+	benchmarkImageStats(scene);
+	benchmarkSpriteBatch(scene);
+	benchmarkPixelConvert();
+	benchmarkDynamicResolution(scene);
+	scene->setResultCache(cache);
+	benchmarkCache(scene);
+	Log("Benchmarks: done");
+}
@@ -0,0 +1,55 @@
+/*
+ * Benchmarks.h
+ *
+ *  Created on: 19-10-2026
+ */
+
+#ifndef BENCHMARKS_H_
+#define BENCHMARKS_H_
+
+#include "Scene.h"
+
+/*
+ * Runs every benchmark on the current GL context and logs the results.
+ * Only called when the library is built with SCALE_BENCHMARKS=1. Benchmarks
+ * that need files keep them under dataDirectory and are skipped without one.
+ */
+void runBenchmarks(Scene* scene,const char* dataDirectory = NULL);
+
+void benchmarkStreaming(Scene* scene);
+void benchmarkTestPatterns();
+void benchmarkYuv(Scene* scene);
+void benchmarkI420Output(Scene* scene);
+void benchmarkMultiOutput(Scene* scene);
+void benchmarkAtlas(Scene* scene);
+void benchmarkCompressed(Scene* scene);
+void benchmarkDirtyRect(Scene* scene);
+void benchmarkCropRotate(Scene* scene);
+void benchmarkShaderVariants(Scene* scene);
+void benchmarkColorModes(Scene* scene);
+// Scales fileCount generated PNG and PPM files from dataDirectory/pipeline-input
+void benchmarkFilePipeline(Scene* scene,const char* dataDirectory,int fileCount = 10000);
+// Per-message cost and the file batch with logs written at once or queued
+void benchmarkLogging(Scene* scene,const char* dataDirectory);
+// Peak and steady-state GPU memory per workload, and scaleTexture over budget
+void benchmarkGpuMemory(Scene* scene);
+// A 4 pass blur chain through RenderGraph: passes run, culled, framebuffers aliased
+void benchmarkRenderGraph(Scene* scene);
+// scaleTexture and the CPU scaler with SHARPEN and DITHER_* fused in, 5_6_5
+// output, against a plain scale followed by a separate pass
+void benchmarkSharpenDither(Scene* scene);
+// Luma mean/min/max and histogram: full readback and the CPU, against the
+// StatsReducer passes reading back 4 bytes and 1 KB
+void benchmarkImageStats(Scene* scene);
+// 1k and 10k textured quads a frame: a draw per quad against SpriteBatch,
+// draw calls and CPU submission time per frame
+void benchmarkSpriteBatch(Scene* scene);
+// GB/s of each PixelConvert kernel against its scalar reference, and RGB
+// and strided uploads against converting or repacking first
+void benchmarkPixelConvert();
+// Frame time percentiles of a 1080p frame under an artificial GPU load
+// (repeated SHARPEN passes), with DynamicResolution off and on
+void benchmarkDynamicResolution(Scene* scene);
+void benchmarkCache(Scene* scene);
+
+#endif /* BENCHMARKS_H_ */
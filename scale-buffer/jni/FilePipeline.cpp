@@ -0,0 +1,279 @@
+/*
+ * FilePipeline.cpp
+ *
+ *  Created on: 19-10-2026
+ */
+
+#include "FilePipeline.h"
+#include "CpuScaler.h"
+#include "Parallel.h"
+#include "Timing.h"
+#include "logger.h"
+#include <dirent.h>
+#include <errno.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <algorithm>
+
+static const char* stageNames[] = { "decode", "scale", "encode" };
+
+FilePipeline::FilePipeline(Scene* s,float r,FileScaleBackend b,int decodeThreads,int encodeThreads,unsigned int capacity):
+		scene(s),ratio(r),backend(b),queueCapacity(capacity),jobs(NULL),decoded(NULL),scaled(NULL) {
+	int half = getWorkerCount() / 2;
+	if(half < 1)
+		half = 1;
+	threads[STAGE_DECODE] = decodeThreads > 0 ? decodeThreads : half;
+	threads[STAGE_SCALE] = 1;
+	threads[STAGE_ENCODE] = encodeThreads > 0 ? encodeThreads : half;
+	pthread_mutex_init(&mutex,NULL);
+	written = failed = 0;
+	decodedWaits = scaledWaits = 0;
+	pixelsIn = pixelsOut = 0;
+	for(int i=0;i<STAGE_COUNT;i++)
+		busyMs[i] = 0.0;
+	elapsedMs = 0.0;
+}
+
+FilePipeline::~FilePipeline() {
+	pthread_mutex_destroy(&mutex);
+}
+
+int FilePipeline::listDirectory(const char* inputDirectory,const char* outputDirectory,std::vector<FileJob>& jobs) {
+	DIR* dir = opendir(inputDirectory);
+	if(!dir) {
+		LogError("FilePipeline::listDirectory: cannot open %s",inputDirectory);
+		return 0;
+	}
+	if(mkdir(outputDirectory,0700) != 0 && errno != EEXIST)
+		LogError("FilePipeline::listDirectory: cannot create %s",outputDirectory);
+
+	std::vector<std::string> names;
+	struct dirent* entry;
+	while((entry = readdir(dir)) != NULL) {
+		ImageFileFormat format = getImageFileFormat(entry->d_name);
+		if(format == IMAGE_FILE_PPM || format == IMAGE_FILE_PNG)
+			names.push_back(entry->d_name);
+	}
+	closedir(dir);
+	std::sort(names.begin(),names.end());
+
+	for(unsigned int i=0;i<names.size();i++) {
+		FileJob job;
+		job.input = std::string(inputDirectory) + "/" + names[i];
+		job.output = std::string(outputDirectory) + "/" + names[i];
+		jobs.push_back(job);
+	}
+	return names.size();
+}
+
+void FilePipeline::addBusy(Stage stage,double ms) {
+	pthread_mutex_lock(&mutex);
+	busyMs[stage] += ms;
+	pthread_mutex_unlock(&mutex);
+}
+
+void FilePipeline::addFailure() {
+	pthread_mutex_lock(&mutex);
+	failed++;
+	pthread_mutex_unlock(&mutex);
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+// Stages
+
+// Gray and gray-alpha to RGB and RGBA
+static void widenGray(DecodedImage* image) {
+	const GLuint channels = image->channels + 2;
+	const size_t count = (size_t)image->width * image->height;
+	GLubyte* pixels = new GLubyte[count * channels];
+	for(size_t i=0;i<count;i++) {
+		const GLubyte* s = image->pixels + i * image->channels;
+		GLubyte* d = pixels + i * channels;
+		d[0] = d[1] = d[2] = s[0];
+		if(channels == 4)
+			d[3] = s[1];
+	}
+	delete[] image->pixels;
+	image->pixels = pixels;
+	image->channels = channels;
+}
+
+void* FilePipeline::decodeMain(void* arg) {
+	((FilePipeline*)arg)->decodeLoop();
+	return NULL;
+}
+
+void FilePipeline::decodeLoop() {
+	for(;;) {
+		pthread_mutex_lock(&mutex);
+		unsigned int job = nextJob;
+		if(job < jobs->size())
+			nextJob++;
+		pthread_mutex_unlock(&mutex);
+		if(job >= jobs->size())
+			break;
+
+		double start = nowMs();
+		WorkItem item;
+		item.job = job;
+		bool ok = readImageFile((*jobs)[job].input.c_str(),&item.image);
+		if(ok && backend == FILE_SCALE_GPU && item.image.channels < 3)
+			widenGray(&item.image);
+		addBusy(STAGE_DECODE,nowMs() - start);
+		if(!ok) {
+			addFailure();
+			continue;
+		}
+		pthread_mutex_lock(&mutex);
+		pixelsIn += (unsigned long long)item.image.width * item.image.height;
+		pthread_mutex_unlock(&mutex);
+		if(!decoded->push(item)) {
+			delete[] item.image.pixels;
+			break;
+		}
+	}
+	finishDecoder();
+}
+
+void FilePipeline::finishDecoder() {
+	pthread_mutex_lock(&mutex);
+	bool last = --activeDecoders == 0;
+	pthread_mutex_unlock(&mutex);
+	if(last)
+		decoded->close();
+}
+
+bool FilePipeline::scaleImage(const DecodedImage& in,DecodedImage* out) {
+	out->width = ratio * in.width;
+	out->height = ratio * in.height;
+	out->channels = in.channels;
+	if(!out->width || !out->height) {
+		LogError("FilePipeline: %ux%u scales to an empty image",in.width,in.height);
+		return false;
+	}
+	if(backend == FILE_SCALE_GPU) {
+		// the encoders take in.channels bytes per pixel, which a 5_6_5 output type would halve
+		const GLenum outputType = scene->getOutputType();
+		scene->setOutputType(0);
+		out->pixels = (GLubyte*)scene->scaleTexture(ratio,in.pixels,in.width,in.height,getImageGlFormat(in.channels),GL_UNSIGNED_BYTE);
+		scene->setOutputType(outputType);
+	}
+	else {
+		out->pixels = new GLubyte[(size_t)out->width * out->height * out->channels];
+		scaleImageBilinearColor(in.pixels,in.width,in.height,out->pixels,out->width,out->height,out->channels,
+				scene ? scene->getColorMode() : COLOR_MODE_DIRECT);
+	}
+	return out->pixels != NULL;
+}
+
+void* FilePipeline::scaleMain(void* arg) {
+	((FilePipeline*)arg)->scaleLoop();
+	return NULL;
+}
+
+void FilePipeline::scaleLoop() {
+	WorkItem item;
+	while(decoded->pop(&item)) {
+		double start = nowMs();
+		DecodedImage output;
+		bool ok = scaleImage(item.image,&output);
+		delete[] item.image.pixels;
+		addBusy(STAGE_SCALE,nowMs() - start);
+		if(!ok) {
+			addFailure();
+			continue;
+		}
+		pthread_mutex_lock(&mutex);
+		pixelsOut += (unsigned long long)output.width * output.height;
+		pthread_mutex_unlock(&mutex);
+		item.image = output;
+		if(!scaled->push(item))
+			delete[] item.image.pixels;
+	}
+	scaled->close();
+}
+
+void* FilePipeline::encodeMain(void* arg) {
+	((FilePipeline*)arg)->encodeLoop();
+	return NULL;
+}
+
+void FilePipeline::encodeLoop() {
+	WorkItem item;
+	while(scaled->pop(&item)) {
+		double start = nowMs();
+		// a fast zlib level, encoding tends to be the slowest stage
+		bool ok = writeImageFile((*jobs)[item.job].output.c_str(),item.image,3);
+		delete[] item.image.pixels;
+		addBusy(STAGE_ENCODE,nowMs() - start);
+		pthread_mutex_lock(&mutex);
+		if(ok)
+			written++;
+		else
+			failed++;
+		pthread_mutex_unlock(&mutex);
+	}
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+
+int FilePipeline::run(const std::vector<FileJob>& list) {
+	jobs = &list;
+	nextJob = 0;
+	activeDecoders = threads[STAGE_DECODE];
+	written = failed = 0;
+	pixelsIn = pixelsOut = 0;
+	for(int i=0;i<STAGE_COUNT;i++)
+		busyMs[i] = 0.0;
+	decoded = new BoundedQueue<WorkItem>(queueCapacity);
+	scaled = new BoundedQueue<WorkItem>(queueCapacity);
+
+	double start = nowMs();
+	std::vector<pthread_t> workers;
+	pthread_t thread;
+	for(int i=0;i<threads[STAGE_DECODE];i++) {
+		if(pthread_create(&thread,NULL,decodeMain,this) == 0)
+			workers.push_back(thread);
+		else
+			finishDecoder();
+	}
+	for(int i=0;i<threads[STAGE_ENCODE];i++) {
+		if(pthread_create(&thread,NULL,encodeMain,this) == 0)
+			workers.push_back(thread);
+	}
+	if(backend == FILE_SCALE_GPU) {
+		// decoded rows are tightly packed
+		glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+		scaleLoop();
+		glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+	}
+	else if(pthread_create(&thread,NULL,scaleMain,this) == 0) {
+		workers.push_back(thread);
+	}
+	else {
+		scaleLoop();
+	}
+	for(unsigned int i=0;i<workers.size();i++)
+		pthread_join(workers[i],NULL);
+	elapsedMs = nowMs() - start;
+
+	decodedWaits = decoded->getPushWaits();
+	scaledWaits = scaled->getPushWaits();
+	delete decoded;
+	delete scaled;
+	decoded = scaled = NULL;
+	jobs = NULL;
+	return written;
+}
+
+void FilePipeline::logStats(const char* name) {
+	double seconds = elapsedMs / 1000.0;
+	Log("%s: %u files written, %u failed in %.2f s, %.1f files/s, %.1f Mpix/s in, %.1f Mpix/s out",name,written,failed,seconds,
+			seconds > 0.0 ? written / seconds : 0.0,seconds > 0.0 ? pixelsIn / 1.0e6 / seconds : 0.0,
+			seconds > 0.0 ? pixelsOut / 1.0e6 / seconds : 0.0);
+	// utilization: busy time over the time the stage's threads existed
+	for(int i=0;i<STAGE_COUNT;i++)
+		Log("%s: %s %d thread(s) %.0f%% busy",name,stageNames[i],threads[i],
+				elapsedMs > 0.0 ? busyMs[i] * 100.0 / (elapsedMs * threads[i]) : 0.0);
+	Log("%s: decode blocked on a full queue %u times, scale %u times",name,decodedWaits,scaledWaits);
+}
@@ -0,0 +1,92 @@
+/*
+ * FilePipeline.h
+ *
+ *  Created on: 19-10-2026
+ */
+
+#ifndef FILEPIPELINE_H_
+#define FILEPIPELINE_H_
+
+#include <pthread.h>
+#include <string>
+#include <vector>
+#include "BoundedQueue.h"
+#include "ImageFile.h"
+#include "Scene.h"
+
+typedef struct
+{
+	std::string input;
+	std::string output;		// encoded in the format of its extension
+} FileJob;
+
+enum FileScaleBackend {
+	FILE_SCALE_GPU,		// Scene::scaleTexture on the thread calling run()
+	FILE_SCALE_CPU		// scaleImageBilinearColor on a worker thread
+};
+
+/*
+ * Scales image files to image files. Decode, scale and encode are separate
+ * stages connected by bounded queues: decode and encode each run on their
+ * own pool of threads, so while the GL thread scales one image the next ones
+ * are being decoded and the previous ones encoded. A full queue blocks the
+ * stage feeding it, which bounds memory to a few images per stage.
+ *
+ * Gray images are widened to RGB(A) for the GPU backend, since luminance
+ * textures are not color renderable, and keep the wider format on output.
+ */
+class FilePipeline {
+public:
+	// scene may be NULL for FILE_SCALE_CPU. Thread counts of 0 split the cores.
+	FilePipeline(Scene* scene,float ratio,FileScaleBackend backend = FILE_SCALE_GPU,
+			int decodeThreads = 0,int encodeThreads = 0,unsigned int queueCapacity = 8);
+	virtual ~FilePipeline();
+
+	// Adds a job for every PPM or PNG file in inputDirectory, written under
+	// the same name to outputDirectory, which is created if missing.
+	// Returns the number of jobs added.
+	static int listDirectory(const char* inputDirectory,const char* outputDirectory,std::vector<FileJob>& jobs);
+
+	// Processes every job and returns the number of files written. With
+	// FILE_SCALE_GPU it must be called on the GL thread.
+	int run(const std::vector<FileJob>& jobs);
+	void logStats(const char* name);
+private:
+	enum Stage { STAGE_DECODE, STAGE_SCALE, STAGE_ENCODE, STAGE_COUNT };
+	struct WorkItem {
+		unsigned int job;
+		DecodedImage image;
+	};
+
+	static void* decodeMain(void* arg);
+	static void* scaleMain(void* arg);
+	static void* encodeMain(void* arg);
+	void decodeLoop();
+	void scaleLoop();
+	void encodeLoop();
+	bool scaleImage(const DecodedImage& in,DecodedImage* out);
+	void addBusy(Stage stage,double ms);
+	void addFailure();
+	void finishDecoder();
+
+	Scene* scene;
+	float ratio;
+	FileScaleBackend backend;
+	int threads[STAGE_COUNT];
+	unsigned int queueCapacity;
+
+	const std::vector<FileJob>* jobs;
+	BoundedQueue<WorkItem>* decoded;
+	BoundedQueue<WorkItem>* scaled;
+	pthread_mutex_t mutex;
+	unsigned int nextJob;
+	int activeDecoders;
+
+	unsigned int written,failed;
+	unsigned int decodedWaits,scaledWaits;
+	double busyMs[STAGE_COUNT];
+	double elapsedMs;
+	unsigned long long pixelsIn,pixelsOut;
+};
+
+#endif /* FILEPIPELINE_H_ */
@@ -0,0 +1,221 @@
+/*
+ * FramePipeline.cpp
+ *
+ *  Created on: 19-10-2026
+ */
+
+#include "FramePipeline.h"
+#include "logger.h"
+#include <string.h>
+
+FramePipeline::FramePipeline(Scene* s,GLuint w,GLuint h,float ratio,GLenum f,GLenum t,unsigned int c,QueuePolicy p):
+		scene(s),width(w),height(h),format(f),type(t),capacity(c),policy(p),
+		nextSlot(0),inFlight(0),nextId(0),closed(false) {
+	outWidth = ratio*width;
+	outHeight = ratio*height;
+	frameSize = width*height*getPixelSize(format,type);
+	if(capacity < 1)
+		capacity = 1;
+
+	for(int i=0;i<DEPTH;i++) {
+		initTexture(&slots[i].texture,width,height,format,type,0,"FramePipeline");
+		slots[i].fb = new Framebuffer(outWidth,outHeight,0,format,type,0,"FramePipeline");
+		slots[i].busy = false;
+	}
+	glBindTexture(GL_TEXTURE_2D, 0);
+	readBuffer = new GLubyte[outWidth*outHeight*getPixelSize(format,type)];
+
+	pthread_mutex_init(&mutex,NULL);
+	pthread_cond_init(&notFull,NULL);
+	pthread_cond_init(&notEmpty,NULL);
+	resetStats();
+}
+
+FramePipeline::~FramePipeline() {
+	close();
+	for(int i=0;i<DEPTH;i++) {
+		deleteTexture(&slots[i].texture);
+		delete slots[i].fb;
+	}
+	while(!queue.empty()) {
+		delete[] queue.front().pixels;
+		queue.pop_front();
+	}
+	for(unsigned int i=0;i<freeBuffers.size();i++)
+		delete[] freeBuffers[i];
+	delete[] readBuffer;
+
+	pthread_cond_destroy(&notEmpty);
+	pthread_cond_destroy(&notFull);
+	pthread_mutex_destroy(&mutex);
+}
+
+GLubyte* FramePipeline::takeBuffer() {
+	// called with mutex held
+	if(freeBuffers.empty())
+		return new GLubyte[frameSize];
+	GLubyte* buffer = freeBuffers.back();
+	freeBuffers.pop_back();
+	return buffer;
+}
+
+void FramePipeline::recycleBuffer(GLubyte* buffer) {
+	// called with mutex held
+	freeBuffers.push_back(buffer);
+}
+
+bool FramePipeline::pushFrame(const GLvoid* pixels) {
+	pthread_mutex_lock(&mutex);
+	GLubyte* buffer = takeBuffer();
+	pthread_mutex_unlock(&mutex);
+
+	memcpy(buffer,pixels,frameSize);
+
+	pthread_mutex_lock(&mutex);
+	while(!closed && queue.size() >= capacity) {
+		if(policy == QUEUE_DROP_OLDEST) {
+			recycleBuffer(queue.front().pixels);
+			queue.pop_front();
+			dropped++;
+		}
+		else {
+			pthread_cond_wait(&notFull,&mutex);
+		}
+	}
+	if(closed) {
+		recycleBuffer(buffer);
+		pthread_mutex_unlock(&mutex);
+		return false;
+	}
+	QueuedFrame frame;
+	frame.pixels = buffer;
+	frame.id = nextId++;
+	frame.pushTime = nowMs();
+	if(pushed == 0)
+		firstPushTime = frame.pushTime;
+	pushed++;
+	queue.push_back(frame);
+	pthread_cond_signal(&notEmpty);
+	pthread_mutex_unlock(&mutex);
+	return true;
+}
+
+void FramePipeline::close() {
+	pthread_mutex_lock(&mutex);
+	closed = true;
+	pthread_cond_broadcast(&notFull);
+	pthread_cond_broadcast(&notEmpty);
+	pthread_mutex_unlock(&mutex);
+}
+
+bool FramePipeline::isFinished() {
+	pthread_mutex_lock(&mutex);
+	bool finished = closed && queue.empty() && inFlight == 0;
+	pthread_mutex_unlock(&mutex);
+	return finished;
+}
+
+void FramePipeline::submit(Slot& slot,const QueuedFrame& frame) {
+	glBindTexture(GL_TEXTURE_2D, slot.texture);
+	glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, width, height, format, type, frame.pixels);
+	CheckGlError("FramePipeline::submit: glTexSubImage2D");
+
+	slot.fb->bind();
+	slot.fb->setViewPort();
+	scene->draw(slot.texture,true);
+	slot.fb->unbind();
+	slot.fb->recoverSavedViewPort();
+
+	slot.busy = true;
+	slot.id = frame.id;
+	slot.pushTime = frame.pushTime;
+	inFlight++;
+}
+
+void FramePipeline::readBack(Slot& slot,FrameSink* sink) {
+	slot.fb->grabData(readBuffer);
+	slot.busy = false;
+	inFlight--;
+	completed++;
+
+	lastCompleteTime = nowMs();
+	double frameLatency = lastCompleteTime - slot.pushTime;
+	latency.add(frameLatency);
+	if(sink)
+		sink->onFrame(slot.id,readBuffer,frameLatency);
+}
+
+int FramePipeline::pump(FrameSink* sink,bool block) {
+	int delivered = 0;
+	for(;;) {
+		pthread_mutex_lock(&mutex);
+		if(block && delivered == 0) {
+			while(queue.empty() && !closed)
+				pthread_cond_wait(&notEmpty,&mutex);
+		}
+		if(queue.empty()) {
+			bool finished = closed;
+			pthread_mutex_unlock(&mutex);
+			// end of stream: nothing will push the in-flight frames out
+			if(finished)
+				delivered += flush(sink);
+			break;
+		}
+		QueuedFrame frame = queue.front();
+		queue.pop_front();
+		pthread_cond_signal(&notFull);
+		pthread_mutex_unlock(&mutex);
+
+		submit(slots[nextSlot],frame);
+		nextSlot = (nextSlot + 1) % DEPTH;
+
+		pthread_mutex_lock(&mutex);
+		recycleBuffer(frame.pixels);
+		pthread_mutex_unlock(&mutex);
+
+		// all slots busy: read back the oldest (frame N-2), which frees the
+		// slot the next frame goes into
+		if(inFlight == DEPTH) {
+			readBack(slots[nextSlot],sink);
+			delivered++;
+		}
+	}
+	return delivered;
+}
+
+int FramePipeline::flush(FrameSink* sink) {
+	int delivered = 0;
+	// oldest in-flight frame sits right after the most recently used slot
+	for(int i=0;i<DEPTH;i++) {
+		Slot& slot = slots[(nextSlot + i) % DEPTH];
+		if(slot.busy) {
+			readBack(slot,sink);
+			delivered++;
+		}
+	}
+	return delivered;
+}
+
+unsigned int FramePipeline::getOutputWidth() {
+	return outWidth;
+}
+
+unsigned int FramePipeline::getOutputHeight() {
+	return outHeight;
+}
+
+void FramePipeline::resetStats() {
+	pthread_mutex_lock(&mutex);
+	pushed = dropped = completed = 0;
+	firstPushTime = lastCompleteTime = 0.0;
+	latency.clear();
+	pthread_mutex_unlock(&mutex);
+}
+
+void FramePipeline::logStats(const char* name) {
+	double elapsed = lastCompleteTime - firstPushTime;
+	double fps = elapsed > 0.0 ? completed * 1000.0 / elapsed : 0.0;
+	Log("%s: %ux%u -> %ux%u pushed %u dropped %u completed %u fps %.2f",
+			name,width,height,outWidth,outHeight,pushed,dropped,completed,fps);
+	latency.log(name);
+}
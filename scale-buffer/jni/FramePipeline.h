@@ -0,0 +1,114 @@
+/*
+ * FramePipeline.h
+ *
+ *  Created on: 19-10-2026
+ */
+
+#ifndef FRAMEPIPELINE_H_
+#define FRAMEPIPELINE_H_
+
+#include <pthread.h>
+#include <deque>
+#include <vector>
+#include "GLUtils.h"
+#include "Timing.h"
+#include "Scene.h"
+
+/*
+ * What pushFrame does when the input queue is full.
+ */
+enum QueuePolicy {
+	QUEUE_BLOCK,		// producer waits until the GL thread consumes a frame (backpressure)
+	QUEUE_DROP_OLDEST	// oldest queued frame is discarded to make room
+};
+
+/*
+ * Receives scaled frames in push order. Pixels are only valid during the call.
+ */
+class FrameSink {
+public:
+	virtual ~FrameSink() {}
+	virtual void onFrame(unsigned int frameId,const GLubyte* pixels,double latencyMs) = 0;
+};
+
+/*
+ * Streaming scaler for a sequence of equally sized frames.
+ *
+ * Producers call pushFrame() from any thread. The GL thread calls pump(),
+ * which keeps up to DEPTH frames in flight: frame N is uploaded and rendered
+ * before frame N-2 is read back, so the glReadPixels stall of one frame
+ * overlaps with the upload and rendering of the two that follow it.
+ */
+class FramePipeline {
+public:
+	static const int DEPTH = 3;
+
+	FramePipeline(Scene* scene,GLuint width,GLuint height,float ratio,GLenum format = GL_RGB,GLenum type = GL_UNSIGNED_BYTE,
+			unsigned int queueCapacity = 4,QueuePolicy policy = QUEUE_BLOCK);
+	virtual ~FramePipeline();
+
+	// Copies pixels into the queue. Returns false once the pipeline is closed.
+	bool pushFrame(const GLvoid* pixels);
+	// Wakes blocked producers and makes pump() return once the queue drains
+	void close();
+	// GL thread only. Submits queued frames and delivers finished ones to sink.
+	// With block set, waits for a frame unless the pipeline is closed. Frames
+	// stay in flight until newer ones push them out, so call flush() when the
+	// stream pauses; a closed pipeline flushes itself once the queue drains.
+	// Returns the number of frames delivered.
+	int pump(FrameSink* sink,bool block = false);
+	// GL thread only. Reads back every frame still in flight.
+	int flush(FrameSink* sink);
+	// True once closed and every pushed frame has been delivered or dropped
+	bool isFinished();
+
+	unsigned int getOutputWidth();
+	unsigned int getOutputHeight();
+	void resetStats();
+	void logStats(const char* name);
+private:
+	struct QueuedFrame {
+		GLubyte* pixels;
+		unsigned int id;
+		double pushTime;
+	};
+	struct Slot {
+		GLuint texture;
+		Framebuffer* fb;
+		bool busy;
+		unsigned int id;
+		double pushTime;
+	};
+
+	void submit(Slot& slot,const QueuedFrame& frame);
+	void readBack(Slot& slot,FrameSink* sink);
+	GLubyte* takeBuffer();
+	void recycleBuffer(GLubyte* buffer);
+
+	Scene* scene;
+	GLuint width,height;
+	GLuint outWidth,outHeight;
+	GLenum format,type;
+	unsigned int frameSize;
+	unsigned int capacity;
+	QueuePolicy policy;
+
+	Slot slots[DEPTH];
+	unsigned int nextSlot;
+	unsigned int inFlight;
+	GLubyte* readBuffer;
+
+	pthread_mutex_t mutex;
+	pthread_cond_t notFull;
+	pthread_cond_t notEmpty;
+	std::deque<QueuedFrame> queue;
+	std::vector<GLubyte*> freeBuffers;
+	unsigned int nextId;
+	bool closed;
+
+	unsigned int pushed,dropped,completed;
+	double firstPushTime,lastCompleteTime;
+	SampleStats latency;
+};
+
+#endif /* FRAMEPIPELINE_H_ */
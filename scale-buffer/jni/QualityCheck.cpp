@@ -0,0 +1,153 @@
+/*
+ * QualityCheck.cpp
+ *
+ *  Created on: 19-10-2026
+ */
+
+#include "QualityCheck.h"
+#include "CpuScaler.h"
+#include "ImageQuality.h"
+#include "TestPattern.h"
+#include "Timing.h"
+#include "file.h"
+#include "logger.h"
+#include <math.h>
+#include <stdio.h>
+#include <string.h>
+#include <string>
+#include <vector>
+
+#define QUALITY_SOURCE_WIDTH 640
+#define QUALITY_SOURCE_HEIGHT 480
+#define QUALITY_RUNS 3
+
+struct QualityThreshold {
+	std::string path;
+	std::string pattern;
+	float ratio;
+	double minPsnr;
+	double minSsim;
+	double maxMs;
+};
+
+static void loadThresholds(const char* assetPath,std::vector<QualityThreshold>& thresholds) {
+	char* data = NULL;
+	unsigned int size = 0;
+	ReadFile(assetPath,&data,&size);
+	if(!data) {
+		LogError("QualityCheck: cannot read %s",assetPath);
+		return;
+	}
+	std::string text(data,size);
+	delete[] data;
+
+	size_t pos = 0;
+	while(pos < text.size()) {
+		size_t end = text.find('\n',pos);
+		if(end == std::string::npos)
+			end = text.size();
+		std::string line = text.substr(pos,end - pos);
+		pos = end + 1;
+		if(line.empty() || line[0] == '#')
+			continue;
+
+		char path[16],pattern[32];
+		QualityThreshold t;
+		if(sscanf(line.c_str(),"%15s %31s %f %lf %lf %lf",path,pattern,&t.ratio,&t.minPsnr,&t.minSsim,&t.maxMs) == 6) {
+			t.path = path;
+			t.pattern = pattern;
+			thresholds.push_back(t);
+		}
+	}
+}
+
+static const QualityThreshold* findThreshold(const std::vector<QualityThreshold>& thresholds,const char* path,const char* pattern,float ratio) {
+	for(unsigned int i=0;i<thresholds.size();i++) {
+		const QualityThreshold& t = thresholds[i];
+		if(t.path == path && t.pattern == pattern && fabsf(t.ratio - ratio) < 0.001f)
+			return &t;
+	}
+	return NULL;
+}
+
+static bool checkCase(const std::vector<QualityThreshold>& thresholds,const char* path,const char* pattern,float ratio,
+		const GLubyte* result,const GLubyte* reference,GLuint width,GLuint height,double ms) {
+	double psnr = computePsnr(result,reference,width,height,3);
+	double ssim = computeSsim(result,reference,width,height,3);
+	const QualityThreshold* t = findThreshold(thresholds,path,pattern,ratio);
+	if(!t) {
+		Log("QualityCheck: %s %s x%.2f psnr %.2f ssim %.4f time %.2f ms (no threshold)",path,pattern,ratio,psnr,ssim,ms);
+		return true;
+	}
+	bool pass = psnr >= t->minPsnr && ssim >= t->minSsim && ms <= t->maxMs;
+	if(pass)
+		Log("QualityCheck: PASS %s %s x%.2f psnr %.2f ssim %.4f time %.2f ms",path,pattern,ratio,psnr,ssim,ms);
+	else
+		LogError("QualityCheck: FAIL %s %s x%.2f psnr %.2f (min %.2f) ssim %.4f (min %.4f) time %.2f ms (max %.2f)",
+				path,pattern,ratio,psnr,t->minPsnr,ssim,t->minSsim,ms,t->maxMs);
+	return pass;
+}
+
+bool runQualityCheck(Scene* scene) {
+	static const float ratios[] = { 0.25f, 0.5f, 0.75f, 1.5f, 2.0f };
+	const int ratioCount = sizeof(ratios) / sizeof(ratios[0]);
+	const GLuint w = QUALITY_SOURCE_WIDTH, h = QUALITY_SOURCE_HEIGHT;
+
+	std::vector<QualityThreshold> thresholds;
+	loadThresholds("quality/thresholds",thresholds);
+
+	// timings and outputs must come from the GPU, not from earlier results,
+	// and be RGB like the reference
+	ScaleCache* cache = scene->getResultCache();
+	scene->setResultCache(NULL);
+	const GLenum outputType = scene->getOutputType();
+	scene->setOutputType(0);
+
+	int cases = 0, failures = 0;
+	for(int p=0;p<PATTERN_COUNT;p++) {
+		const char* pattern = getTestPatternName((TestPattern)p);
+		GLubyte* source = generateTestPattern((TestPattern)p,w,h,GL_RGB);
+
+		for(int r=0;r<ratioCount;r++) {
+			float ratio = ratios[r];
+			GLuint dw = ratio*w, dh = ratio*h;
+			GLubyte* reference = new GLubyte[dw*dh*3];
+			scaleImageReference(source,w,h,reference,dw,dh,3);
+
+			SampleStats gpuTime;
+			GLubyte* gpu = NULL;
+			for(int i=0;i<QUALITY_RUNS;i++) {
+				delete[] gpu;
+				double start = nowMs();
+				gpu = (GLubyte*)scene->scaleTexture(ratio,source,w,h,GL_RGB,GL_UNSIGNED_BYTE);
+				gpuTime.add(nowMs() - start);
+			}
+			if(!checkCase(thresholds,"gpu",pattern,ratio,gpu,reference,dw,dh,gpuTime.percentile(50)))
+				failures++;
+
+			SampleStats cpuTime;
+			GLubyte* cpu = new GLubyte[dw*dh*3];
+			for(int i=0;i<QUALITY_RUNS;i++) {
+				double start = nowMs();
+				scaleImageBilinear(source,w,h,cpu,dw,dh,3);
+				cpuTime.add(nowMs() - start);
+			}
+			if(!checkCase(thresholds,"cpu",pattern,ratio,cpu,reference,dw,dh,cpuTime.percentile(50)))
+				failures++;
+
+			cases += 2;
+			delete[] gpu;
+			delete[] cpu;
+			delete[] reference;
+		}
+		delete[] source;
+	}
+
+	if(failures)
+		LogError("QualityCheck: %d of %d cases failed",failures,cases);
+	else
+		Log("QualityCheck: all %d cases passed",cases);
+	scene->setResultCache(cache);
+	scene->setOutputType(outputType);
+	return failures == 0;
+}
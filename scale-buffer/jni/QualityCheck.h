@@ -0,0 +1,23 @@
+/*
+ * QualityCheck.h
+ *
+ *  Created on: 19-10-2026
+ */
+
+#ifndef QUALITYCHECK_H_
+#define QUALITYCHECK_H_
+
+#include "Scene.h"
+
+/*
+ * Scales every generated test pattern with each scaling path (GPU through
+ * Scene::scaleTexture, CPU through scaleImageBilinear), compares the results
+ * with scaleImageReference and checks PSNR, SSIM and time against the limits
+ * in assets/quality/thresholds. Every case is logged; failures go to
+ * LogError. Returns true when all cases pass.
+ * Called when the library is built with QUALITY_CHECK=1, and on a desktop
+ * host by tools/headless.
+ */
+bool runQualityCheck(Scene* scene);
+
+#endif /* QUALITYCHECK_H_ */
@@ -6,9 +6,16 @@
  */
 
 #include "Scene.h"
+#include "StatsReducer.h"
+#include "TestPattern.h"
+#include "CpuScaler.h"
+#include "Timing.h"
 #include "logger.h"
-#include <assert.h>
 #include <stdlib.h>
+#include <math.h>
+#include <string.h>
+#include <algorithm>
+
 TriangleVertex Scene::triangleVerticesPNG[] = {
 		{ 1.0f,  1.0f }, { -1.0f, -1.0f }, { 1.0f, -1.0f },
 		{ -1.0f, 1.0f }, { -1.0f, -1.0f }, { 1.0f,  1.0f }
@@ -19,56 +26,122 @@ TriangleVertex Scene::textureCoordsPNG[] = {
 		{ 0.0f, 0.0f }, { 0.0f, 1.0f }, { 1.0f, 0.0f }
 };
 
-Scene::Scene(int w,int h):width(w),height(h),scale(1.0),fb(0),textureHandle(0),checkboard_width(256),checkboard_height(256) {
+// glReadPixels returns the bottom row first, so offscreen rendering keeps
+// texture row 0 at the bottom to read back rows in upload order
+TriangleVertex Scene::textureCoordsFbo[] = {
+		{ 1.0f, 1.0f }, { 0.0f, 0.0f }, { 1.0f, 0.0f },
+		{ 0.0f, 1.0f }, { 0.0f, 0.0f }, { 1.0f, 1.0f }
+};
+
+Scene::Scene(int w,int h):program(NULL),externalSampler(false),width(w),height(h),scale(1.0),fb(0),textureHandle(0),resultCache(NULL),sourceResident(false),cpuFallbacks(0),statsReducer(NULL),statsReadbackBytes(0),colorMode(COLOR_MODE_DIRECT),sharpenAmount(0.5f),outputType(0),srgbSource(false),checkboard_width(256),checkboard_height(256) {
 	   // Initialize GL state.
 	//    glHint(GL_PEr, GL_FASTEST);
 	    glEnable(GL_CULL_FACE);
 	//    glShadeModel(GL_SH);
 	    glDisable(GL_DEPTH_TEST);
 
-	    // Init the shaders
-	//    gProgramHandle = createProgram( gVertexShader, gPixelShader );
-	    programHandle = createProgram( "shaders/vertexShader", "shaders/fragmentShader" );
-	    Log("Program handle %d",programHandle);
-	    if( !programHandle )
-	    {
-	        LogError( "Could not create program." );
-	        assert(0);
-	    }
-	//
-	    // Read attribute locations from the program
-	    aPositionHandle = glGetAttribLocation( programHandle, "aPosition" );
-	    Log("gaPositionHandle %d",aPositionHandle);
-	    CheckGlError( "glGetAttribLocation" );
-	//
-	    aTexCoordHandle = glGetAttribLocation( programHandle, "aTexCoord" );
-	    Log("gaTexCoordHandle %d",aTexCoordHandle);
-	    CheckGlError( "glGetAttribLocation" );
-
-	    aTexSamplerHandle = glGetUniformLocation( programHandle, "sTexture" );
-	    Log("gaTexSamplerHandle %d",aTexSamplerHandle);
-	    CheckGlError( "glGetUnitformLocation" );
-
-	    GLubyte* pixels = generateCheckBoardTextureData(checkboard_width,checkboard_height,3);
-
-
-	    GLubyte* resizedPointer = (GLubyte*)scaleTexture(1.0,pixels,checkboard_width,checkboard_height,GL_RGB,GL_UNSIGNED_BYTE);
-	    /*
-	     * Do whatever you want with resized texture data pointer
-	     */
-	    delete resizedPointer;
-	    delete pixels;
+	    memset(yuvTextures,0,sizeof(yuvTextures));
+	    memset(planeTargets,0,sizeof(planeTargets));
+	    memset(&displayed,0,sizeof(displayed));
+	    srgbSupported = isExtensionSupported( "GL_EXT_sRGB" );
+	    gpuMemoryAddEvictor( evictPools, this );
 	    glViewport(0,0,width,height);
-
 }
 
 Scene::~Scene() {
+	gpuMemoryRemoveEvictor(this);
+	releaseGlResources();
+	delete statsReducer;
+}
+
+void Scene::resize(int w,int h) {
+	width = w;
+	height = h;
+	glViewport(0,0,width,height);
+}
+
+void Scene::releaseGlResources() {
+	evictPools(this,(size_t)-1);
 	if(fb)
 		delete fb;
 	fb = NULL;
+	deleteTexture(&textureHandle);
+	sourceResident = false;
+	srgbSource = false;
+	program = NULL;
+	shaders.clear();
+}
+
+// The variant last selected, compiled again after releaseGlResources
+bool Scene::ensureProgram() {
+	if( program )
+		return true;
+	if( selectProgram( std::string( shaderDefines ).c_str(), colorMode, srgbSource ) )
+		return true;
+	LogError( "Could not create program." );
+	return false;
+}
+
+// The last scaleTexture result if the cache still has it, else the
+// checkerboard at the current scale, as shown before any scale call
+void Scene::restoreDisplay() {
+	if(displayed.key && resultCache) {
+		size_t bytes = 0;
+		GLubyte* pixels = resultCache->lookup(displayed.key,&bytes);
+		if(pixels && bytes == displayed.width*displayed.height*getPixelSize(displayed.format,displayed.type)) {
+			fb = new Framebuffer(displayed.width,displayed.height,pixels,displayed.format,displayed.type,displayed.textureFormat,"Scene output");
+			// the source is gone with the context: scaleUp and scaleDown go on from the result at 1x
+			loadTextureFromPointer(pixels,displayed.width,displayed.height,
+					displayed.textureFormat ? displayed.textureFormat : displayed.format,displayed.type);
+			scale = 1.0f;
+		}
+		delete[] pixels;
+		if(fb && fb->getTexture())
+			return;
+		delete fb;
+		fb = NULL;
+		LogDebug("Scene::restoreDisplay: the last result left the cache, showing the checkerboard");
+	}
+	displayed.key = 0;
+	const GLuint size = 256;
+	GLubyte* pixels = generateCheckBoardTextureData(size,size,GL_RGB);
+	loadTextureFromPointer(pixels,size,size,GL_RGB,GL_UNSIGNED_BYTE);
+	delete[] pixels;
+	GLuint scaled = std::max(1.0f,scale*size);
+	fb = new Framebuffer(scaled,scaled,0,GL_RGB,GL_UNSIGNED_BYTE,0,"Scene output");
+	renderTextureToFbo();
+}
+
+// The multi-output and I420 targets, the YUV planes and the stats targets
+// are rebuilt on demand; they go in that order until bytes are freed
+size_t Scene::evictPools(void* context,size_t bytes) {
+	Scene* scene = (Scene*)context;
+	const size_t before = gpuMemoryGetUsed();
+	while(!scene->multiTargets.empty() && before - gpuMemoryGetUsed() < bytes) {
+		delete scene->multiTargets.back();
+		scene->multiTargets.pop_back();
+	}
+	for(int i=0;i<3 && before - gpuMemoryGetUsed() < bytes;i++) {
+		delete scene->planeTargets[i];
+		scene->planeTargets[i] = NULL;
+		deleteTexture(&scene->yuvTextures[i]);
+	}
+	if(scene->statsReducer && before - gpuMemoryGetUsed() < bytes)
+		scene->statsReducer->releaseGlResources();
+	return before - gpuMemoryGetUsed();
+}
+
+void Scene::ensureDisplay() {
+    if( !fb )
+        restoreDisplay();
 }
 
-void Scene::draw(GLuint textureHandler) {
+void Scene::draw(GLuint textureHandler,bool toFramebuffer) {
+    if( !ensureProgram() )
+        return;
+    if( textureHandler == 0 && !fb )
+        restoreDisplay();
+
     glClearColor( 0.8f, 0.7f, 0.6f, 1.0f);
     CheckGlError( "glClearColor" );
 
@@ -76,74 +149,124 @@ void Scene::draw(GLuint textureHandler) {
     glClear( GL_DEPTH_BUFFER_BIT | GL_COLOR_BUFFER_BIT);
     CheckGlError( "glClear" );
 
-    // Select vertex/pixel shader
-    glUseProgram( programHandle );
+    // Set texture sampler
+    glActiveTexture( GL_TEXTURE0 );
+    program->setUniform1i( "sTexture", 0 );
+
+    if( program->hasUniform( "uSampleOffset" ) || program->hasUniform( "uOutputTexel" ) )
+    {
+        // output pixels in texture coordinates, the quad spans the whole viewport
+        GLint viewport[4];
+        glGetIntegerv( GL_VIEWPORT, viewport );
+        program->setUniform2f( "uSampleOffset", 0.25f / viewport[2], 0.25f / viewport[3] );
+        program->setUniform2f( "uOutputTexel", 1.0f / viewport[2], 1.0f / viewport[3] );
+    }
+    program->setUniform1f( "uSharpen", sharpenAmount );
+    if( program->hasUniform( "uDitherStep" ) )
+    {
+        // one step of the bound framebuffer: 1/31 and 1/63 for 5_6_5, 1/255 for 8 bits
+        static const GLenum channels[4] = { GL_RED_BITS, GL_GREEN_BITS, GL_BLUE_BITS, GL_ALPHA_BITS };
+        GLfloat step[4];
+        for( int i = 0; i < 4; i++ )
+        {
+            GLint bits = 0;
+            glGetIntegerv( channels[i], &bits );
+            step[i] = bits > 0 ? 1.0f / ( ( 1 << bits ) - 1 ) : 0.0f;
+        }
+        program->setUniform4fv( "uDitherStep", step );
+    }
+    // other textures keep the size set by the caller
+    if( textureHandler == 0 )
+        setTexelSize( fb->getWidth(), fb->getHeight() );
+    else if( textureHandler == textureHandle )
+        setTexelSize( checkboard_width, checkboard_height );
+
+    // Select vertex/pixel shader and upload changed uniforms
+    program->use();
     CheckGlError( "glUseProgram" );
 
+    // PNG //////////////////////////////////////////////////////////////////////////////////////////////////////
+
+//    glBindTexture( GL_TEXTURE_2D, fb.renderableTexture );
+    GLenum target = GL_TEXTURE_2D;
+    if(textureHandler) {
+    	target = externalSampler ? GL_TEXTURE_EXTERNAL_OES : GL_TEXTURE_2D;
+    	glBindTexture( target, textureHandler );
+    }
+    else {
+    	fb->bindTexture();
+    }
+
+    drawQuad( toFramebuffer );
 
-    CheckGlError( "glUniformMatrix4fv" );
+    glBindTexture( target, 0 );
+
+    glFlush();
+}
+
+void Scene::drawQuad(bool toFramebuffer) {
+    drawArrays( triangleVerticesPNG, toFramebuffer ? textureCoordsFbo : textureCoordsPNG, 6 );
+}
+
+// Every program binds aPosition and aTexCoord to the same locations at link time
+void Scene::drawArrays(const TriangleVertex* positions,const TriangleVertex* texCoords,GLsizei vertexCount) {
     // Enable vertex
-    glEnableVertexAttribArray( aPositionHandle );
+    glEnableVertexAttribArray( ATTRIB_POSITION );
     CheckGlError( "glEnableVertexAttribArray" );
 
     // Enable tex coords
-    glEnableVertexAttribArray( aTexCoordHandle );
+    glEnableVertexAttribArray( ATTRIB_TEXCOORD );
     CheckGlError( "glEnableVertexAttribArray" );
 
-    // Set texture sampler
-    glActiveTexture( GL_TEXTURE0 );
-
-    // Enable texture sampler
-    glUniform1i( aTexSamplerHandle, 0 );
-
-    // PNG //////////////////////////////////////////////////////////////////////////////////////////////////////
-
     // Set vertex position
-    glVertexAttribPointer( aPositionHandle, 2, GL_FLOAT, GL_FALSE, sizeof(TriangleVertex), triangleVerticesPNG );
+    glVertexAttribPointer( ATTRIB_POSITION, 2, GL_FLOAT, GL_FALSE, sizeof(TriangleVertex), positions );
     CheckGlError( "glVertexAttribPointer" );
 
-//     Set vertex texture coordinates
-    glVertexAttribPointer( aTexCoordHandle, 2, GL_FLOAT, GL_FALSE, sizeof(TriangleVertex), textureCoordsPNG );
+    // Set vertex texture coordinates
+    glVertexAttribPointer( ATTRIB_TEXCOORD, 2, GL_FLOAT, GL_FALSE, sizeof(TriangleVertex), texCoords );
     CheckGlError( "glVertexAttribPointer" );
 
-//    glBindTexture( GL_TEXTURE_2D, fb.renderableTexture );
-    if(textureHandler) {
-    	glBindTexture( GL_TEXTURE_2D, textureHandler );
-    }
-    else {
-    	fb->bindTexture();
-    }
+    glDrawArrays( GL_TRIANGLES, 0, vertexCount );
+}
 
-    glDrawArrays( GL_TRIANGLES, 0, 6 );
+void Scene::drawBatch(GLuint texture,const TriangleVertex* positions,const TriangleVertex* texCoords,GLsizei vertexCount,
+		GLuint textureWidth,GLuint textureHeight) {
+    if( !ensureProgram() )
+        return;
+    program->setUniform1i( "sTexture", 0 );
+    if( textureWidth && textureHeight )
+        setTexelSize( textureWidth, textureHeight );
+    else
+        setTexelSize( checkboard_width, checkboard_height );
+    program->use();
+    glActiveTexture( GL_TEXTURE0 );
+    glBindTexture( GL_TEXTURE_2D, texture );
 
-	fb->unbindTexture();
+    drawArrays( positions, texCoords, vertexCount );
 
-    glFlush();
+    glBindTexture( GL_TEXTURE_2D, 0 );
 }
 
-GLubyte* Scene::generateCheckBoardTextureData(GLuint width,GLuint height, GLuint format){
-    GLubyte* pixels = new GLubyte[3*width*height*sizeof(uint8_t)];
-    uint8_t color = 255;
-    int i;
-    for(i=0;i<height*format*width;i+=8*format)
-    {
-    	color = (color == 255) ? 0 : 255;
-    	if(i %(width*format*8) == 0)
-    	{
-    		color = (color == 255) ? 0 : 255;
-    	}
-    	memset(pixels+i,color,3*8);
+GLuint Scene::drawSprites(SpriteBatch* batch,bool sortByTexture) {
+    if( !ensureProgram() )
+        return 0;
+    program->setUniform1i( "sTexture", 0 );
+    setTexelSize( checkboard_width, checkboard_height );
+    program->use();
+    glActiveTexture( GL_TEXTURE0 );
+    return batch->flush( sortByTexture );
+}
 
-    }
-    return pixels;
+GLubyte* Scene::generateCheckBoardTextureData(GLuint width,GLuint height, GLenum format){
+	return generateTestPattern(PATTERN_CHECKERBOARD,width,height,format,GL_UNSIGNED_BYTE);
 }
 
 void Scene::renderTextureToFbo() {
 	fb->bind();
-	Log("Scene::renderTextureToFbo width %f height %f",checkboard_width*scale,checkboard_height*scale);
+	LogDebug("Scene::renderTextureToFbo width %f height %f",checkboard_width*scale,checkboard_height*scale);
     fb->setViewPort();
 
-    this->draw(textureHandle);
+    this->draw(textureHandle,true);
     // back to normal window-system-provided framebuffer
     glBindFramebuffer(GL_FRAMEBUFFER, 0); // unbind
     fb->unbind();
@@ -152,41 +275,536 @@ void Scene::renderTextureToFbo() {
 }
 
 void Scene::scaleUp() {
+	sourceResident = false;
 	scale += 0.05;
 	if(scale > 10.0)
 		scale = 2.0;
+	size_t bytes = gpuMemoryGetTextureSize(scale*checkboard_width,scale*checkboard_height,GL_RGB,GL_UNSIGNED_BYTE);
+	if(!gpuMemoryReserve(bytes,fb ? gpuMemoryGetSize(GPU_RESOURCE_TEXTURE,fb->getTexture()) : 0)) {
+		LogWarn("Scene::scaleUp: %.2fx does not fit the GPU memory budget",scale);
+		scale -= 0.05;
+		return;
+	}
+	displayed.key = 0;
 	if(fb)
 		delete fb;
-	fb = new Framebuffer(scale*checkboard_width,scale*checkboard_height,0,GL_RGB,GL_UNSIGNED_BYTE);
+	fb = new Framebuffer(scale*checkboard_width,scale*checkboard_height,0,GL_RGB,GL_UNSIGNED_BYTE,0,"Scene output");
 	renderTextureToFbo();
 }
 
 void Scene::scaleDown() {
+	sourceResident = false;
 	scale -= 0.05;
 	if(scale < 0.0)
 		scale = 0.0;
+	displayed.key = 0;
 	if(fb)
 		delete fb;
-	fb = new Framebuffer(scale*checkboard_width,scale*checkboard_height,0,GL_RGB,GL_UNSIGNED_BYTE);
+	fb = new Framebuffer(scale*checkboard_width,scale*checkboard_height,0,GL_RGB,GL_UNSIGNED_BYTE,0,"Scene output");
 	renderTextureToFbo();
 }
 
 void Scene::loadTextureFromPointer(GLvoid* data,GLuint width,GLuint height,GLenum format,GLenum type) {
-	if(textureHandle > 0)
-		glDeleteTextures(1,&textureHandle);
-	initTexture(&textureHandle,width,height,format,type,data);
+	deleteTexture(&textureHandle);
+	sourceResident = false;
+	setSrgbSource(format == GL_SRGB_ALPHA_EXT);
+	checkboard_width = width;
+	checkboard_height = height;
+	initTexture(&textureHandle,width,height,format,type,data,"Scene source");
 }
 
 GLvoid* Scene::scaleTexture(float ratio,GLvoid* data,GLuint w,GLuint h,GLenum f,GLenum t) {
+	ScaleKey key = 0;
+	double start = nowMs();
+	if(resultCache) {
+		// shader variants and the output type change the output as much as the filter does
+		uint64_t seed = hash64(&sharpenAmount,sizeof(sharpenAmount),colorMode | (uint64_t)outputType << 32);
+		GLenum filter = shaderDefines.empty() && !colorMode && !outputType ? GL_LINEAR : (GLenum)hash64(shaderDefines.data(),shaderDefines.size(),seed);
+		key = resultCache->makeKey(data,w*h*getPixelSize(f,t),w,h,f,t,ratio,filter);
+		GLvoid* cached = resultCache->lookup(key);
+		if(cached) {
+			sourceResident = false;
+			return cached;
+		}
+	}
+	const GLuint ow = ratio*w, oh = ratio*h;
+	const GLenum ot = getResultType(f,t);
+	GLvoid* resizedTextureData;
+	// the source and output textures replace the ones held now
+	size_t held = gpuMemoryGetSize(GPU_RESOURCE_TEXTURE,textureHandle) + (fb ? gpuMemoryGetSize(GPU_RESOURCE_TEXTURE,fb->getTexture()) : 0);
+	if(gpuMemoryReserve(gpuMemoryGetTextureSize(w,h,f,t) + gpuMemoryGetTextureSize(ow,oh,f,ot),held)) {
+		// the sampler decodes and the framebuffer encodes, no shader math needed
+		bool srgb = srgbSupported && (colorMode & COLOR_MODE_LINEAR) && f == GL_RGBA && t == GL_UNSIGNED_BYTE;
+		loadTextureFromPointer(data,w,h,srgb ? GL_SRGB_ALPHA_EXT : f,t);
+		scale = ratio;
+		LogDebug("Texture Loaded from pointer Tex width %f height %f",width*ratio,height*ratio);
+		if(fb)
+			delete fb;
+		fb = new Framebuffer(ow,oh,0,f,ot,srgb ? GL_SRGB_ALPHA_EXT : 0,"Scene output");
+		renderTextureToFbo();
+		resizedTextureData = fb->grabDataPointer();
+		sourceResident = true;
+		sourceFormat = f;
+		sourceType = t;
+		resultType = ot;
+		DisplayedResult result = { key, ow, oh, f, ot, srgb ? (GLenum)GL_SRGB_ALPHA_EXT : 0 };
+		displayed = result;
+	}
+	else {
+		sourceResident = false;
+		resizedTextureData = scaleTextureOnCpu(ratio,data,w,h,f,t);
+		if(!resizedTextureData)
+			return NULL;
+	}
+	if(resultCache)
+		resultCache->store(key,resizedTextureData,ow*oh*getPixelSize(f,ot),nowMs() - start);
+	return resizedTextureData;
+}
+
+GLvoid* Scene::scaleTextureOnCpu(float ratio,const GLvoid* data,GLuint w,GLuint h,GLenum f,GLenum t) {
+	if(t != GL_UNSIGNED_BYTE) {
+		LogError("Scene::scaleTexture: %ux%u does not fit the GPU memory budget and type 0x%x has no CPU fallback",w,h,t);
+		return NULL;
+	}
+	const GLuint ow = ratio*w, oh = ratio*h, channels = getPixelSize(f,t);
+	PostScaleOptions post = { 0.0f, DITHER_NONE, getResultType(f,t) == GL_UNSIGNED_SHORT_5_6_5 };
+	if(strstr(shaderDefines.c_str(),"SHARPEN"))
+		post.sharpen = sharpenAmount;
+	if(strstr(shaderDefines.c_str(),"DITHER_ORDERED"))
+		post.dither = DITHER_ORDERED;
+	else if(strstr(shaderDefines.c_str(),"DITHER_NOISE"))
+		post.dither = DITHER_NOISE;
+	GLubyte* pixels = new GLubyte[ow*oh*getPixelSize(f,getResultType(f,t))];
+	if(post.sharpen != 0.0f || post.dither || post.rgb565)
+		scaleImageBilinearPost((const GLubyte*)data,w,h,pixels,ow,oh,channels,post);
+	else
+		scaleImageBilinearColor((const GLubyte*)data,w,h,pixels,ow,oh,channels,colorMode);
+	cpuFallbacks++;
+	LogDebug("Scene::scaleTexture: %ux%u scaled on the CPU, over the GPU memory budget",w,h);
+	return pixels;
+}
+
+GLenum Scene::getResultType(GLenum f,GLenum t) {
+	return outputType && f == GL_RGB && t == GL_UNSIGNED_BYTE ? outputType : t;
+}
+
+unsigned int Scene::getCpuFallbackCount() {
+	return cpuFallbacks;
+}
+
+GLvoid* Scene::transformTexture(const float* matrix,GLvoid* data,GLuint w,GLuint h,GLenum f,GLenum t,GLuint outWidth,GLuint outHeight) {
 	loadTextureFromPointer(data,w,h,f,t);
+	scale = (float)outWidth / w;
+
+	// the offscreen quad corners are the normalized output coordinates,
+	// transforming them gives the source coordinates to sample
+	TriangleVertex texCoords[6];
+	for(int i=0;i<6;i++)
+		transformPoint(matrix,textureCoordsFbo[i].x,textureCoordsFbo[i].y,&texCoords[i].x,&texCoords[i].y);
+
+	displayed.key = 0;
+	if(fb)
+		delete fb;
+	fb = new Framebuffer(outWidth,outHeight,0,f,t,0,"Scene output");
+	fb->bind();
+	fb->setViewPort();
+	drawBatch(textureHandle,triangleVerticesPNG,texCoords,6);
+	fb->unbind();
+	fb->recoverSavedViewPort();
+	return fb->grabDataPointer();
+}
+
+GLvoid* Scene::cropRotateScaleTexture(float ratio,const ImageTransform& transform,GLvoid* data,GLuint w,GLuint h,
+		GLenum f,GLenum t,GLuint* outWidth,GLuint* outHeight) {
+	float matrix[16];
+	GLuint tw,th;
+	getTransformedSize(transform,&tw,&th);
+	getTransformMatrix(transform,w,h,matrix);
+	*outWidth = ratio * tw;
+	*outHeight = ratio * th;
+	return transformTexture(matrix,data,w,h,f,t,*outWidth,*outHeight);
+}
+
+bool Scene::updateScaledTexture(const GLvoid* data,const DirtyRect* rects,int count,GLvoid* output) {
+	if(!sourceResident || !fb) {
+		LogError("updateScaledTexture: no previous scaleTexture result");
+		return false;
+	}
+	// fb stops showing the cached result
+	displayed.key = 0;
+	const GLuint sw = checkboard_width, sh = checkboard_height;
+	const GLuint ow = fb->getWidth(), oh = fb->getHeight();
+	const GLuint pixelSize = getPixelSize(sourceFormat,sourceType);
+	// GL_LINEAR maps output pixel j to source texel (j+0.5)*sw/ow-0.5 and its
+	// right neighbour, so a texel range [a,b) affects outputs whose sample
+	// lands in [a-1,b); one extra pixel on each side absorbs rounding, one
+	// more covers the neighbours SHARPEN reads
+	const float rx = (float)ow / sw, ry = (float)oh / sh;
+	const GLint margin = program && program->hasUniform("uSharpen") ? 2 : 1;
+	std::vector<std::pair<GLint,GLint> > rows;
+
+	fb->bind();
+	fb->setViewPort();
+	glEnable(GL_SCISSOR_TEST);
+	for(int i=0;i<count;i++) {
+		DirtyRect r = rects[i];
+		if(r.x >= sw || r.y >= sh)
+			continue;
+		r.width = std::min(r.width,sw - r.x);
+		r.height = std::min(r.height,sh - r.y);
+		if(!r.width || !r.height)
+			continue;
+
+		// rect rows are a whole source row apart in data
+		const GLubyte* src = (const GLubyte*)data + (r.y * sw + r.x) * pixelSize;
+		uploadSubTexture(textureHandle,r.x,r.y,r.width,r.height,srgbSource ? GL_SRGB_ALPHA_EXT : sourceFormat,sourceType,src,sw * pixelSize);
+
+		GLint x0 = std::max(0,(GLint)ceilf((r.x - 0.5f) * rx - 0.5f) - margin);
+		GLint x1 = std::min((GLint)ow,(GLint)ceilf((r.x + r.width + 0.5f) * rx - 0.5f) + margin);
+		GLint y0 = std::max(0,(GLint)ceilf((r.y - 0.5f) * ry - 0.5f) - margin);
+		GLint y1 = std::min((GLint)oh,(GLint)ceilf((r.y + r.height + 0.5f) * ry - 0.5f) + margin);
+		if(x0 >= x1 || y0 >= y1)
+			continue;
+		glScissor(x0, y0, x1 - x0, y1 - y0);
+		draw(textureHandle,true);
+		rows.push_back(std::make_pair(y0,y1));
+	}
+	glDisable(GL_SCISSOR_TEST);
+	fb->unbind();
+	fb->recoverSavedViewPort();
+
+	// read each run of touched rows once
+	std::sort(rows.begin(),rows.end());
+	const GLuint rowBytes = ow * getPixelSize(sourceFormat,resultType);
+	for(unsigned int i=0;i<rows.size();) {
+		GLint first = rows[i].first, last = rows[i].second;
+		for(i++;i<rows.size() && rows[i].first <= last;i++)
+			last = std::max(last,rows[i].second);
+		fb->grabRows((GLubyte*)output + first * rowBytes,first,last - first);
+	}
+	return true;
+}
+
+bool Scene::setShaderDefines(const char* defines) {
+	return selectProgram( defines, colorMode, srgbSource );
+}
+
+const char* Scene::getShaderDefines() {
+	return shaderDefines.c_str();
+}
+
+bool Scene::setColorMode(int mode) {
+	return selectProgram( std::string( shaderDefines ).c_str(), mode, srgbSource );
+}
+
+int Scene::getColorMode() {
+	return colorMode;
+}
+
+void Scene::setSharpenAmount(float amount) {
+	sharpenAmount = amount;
+}
+
+float Scene::getSharpenAmount() {
+	return sharpenAmount;
+}
+
+bool Scene::setOutputType(GLenum type) {
+	if(type && type != GL_UNSIGNED_BYTE && type != GL_UNSIGNED_SHORT_5_6_5) {
+		LogError("Scene::setOutputType: type 0x%x is not supported",type);
+		return false;
+	}
+	outputType = type;
+	return true;
+}
+
+GLenum Scene::getOutputType() {
+	return outputType;
+}
+
+// The selected defines plus those the color mode needs; an sRGB source is
+// decoded by the sampler and encoded by the framebuffer instead
+bool Scene::selectProgram(const char* defines,int mode,bool srgb) {
+	std::string variant = defines;
+	if( ( mode & COLOR_MODE_LINEAR ) && !srgb )
+		variant += ";LINEAR_LIGHT";
+	if( mode & COLOR_MODE_PREMULTIPLIED )
+		variant += ";PREMULTIPLY_ALPHA";
+	Program* p = shaders.getProgram( "shaders/vertexShader", "shaders/fragmentShader", variant.c_str() );
+	if( !p )
+		return false;
+	program = p;
+	shaderDefines = defines;
+	colorMode = mode;
+	srgbSource = srgb;
+	externalSampler = strstr( defines, "EXTERNAL_SAMPLER" ) != NULL;
+	LogDebug("Program handle %d [%s]",program->getHandle(),variant.c_str());
+	return true;
+}
+
+void Scene::setSrgbSource(bool srgb) {
+	if( srgb != srgbSource && !selectProgram( std::string( shaderDefines ).c_str(), colorMode, srgb ) )
+		LogError( "Could not create program for the sRGB source." );
+}
+
+void Scene::setTexelSize(GLuint w,GLuint h) {
+	if( program && program->hasUniform( "uTexelSize" ) && w && h )
+		program->setUniform2f( "uTexelSize", 1.0f / w, 1.0f / h );
+}
+
+ShaderVariantCache* Scene::getShaderCache() {
+	return &shaders;
+}
+
+void Scene::setResultCache(ScaleCache* cache) {
+	if(cache != resultCache)
+		displayed.key = 0;
+	resultCache = cache;
+}
+
+ScaleCache* Scene::getResultCache() {
+	return resultCache;
+}
+
+GLvoid* Scene::scaleCompressedTexture(float ratio,const GLvoid* data,GLsizei imageSize,GLuint w,GLuint h,GLenum internalFormat,GLenum f,GLenum t) {
+	deleteTexture(&textureHandle);
+	sourceResident = false;
+	setSrgbSource(false);
+	if(!initCompressedTexture(&textureHandle,w,h,internalFormat,imageSize,data,"Scene source"))
+		return NULL;
 	checkboard_height = h;
 	checkboard_width = w;
 	scale = ratio;
-	Log("Texture Loaded from pointer Tex width %f height %f",width*ratio,height*ratio);
+	displayed.key = 0;
 	if(fb)
 		delete fb;
-	fb = new Framebuffer(ratio*w,ratio*h,0,f,t);
+	fb = new Framebuffer(ratio*w,ratio*h,0,f,t,0,"Scene output");
 	renderTextureToFbo();
-	GLvoid* resizedTextureData = fb->grabDataPointer();
-	return resizedTextureData;
+	return fb->grabDataPointer();
+}
+
+Program* Scene::getYuvProgram(bool planar) {
+	Program* p = shaders.getProgram( "shaders/vertexShader", "shaders/fragmentShaderYuv", planar ? "YUV_PLANAR" : "" );
+	if( !p )
+		LogError( "Could not create YUV program." );
+	return p;
+}
+
+static void uploadPlane(GLuint* texture,GLuint width,GLuint height,GLenum format,const GLubyte* data) {
+	uploadTexture(texture,width,height,format,GL_UNSIGNED_BYTE,data,0,"Scene YUV planes");
+}
+
+void Scene::loadYuvTextures(const YuvFrame& frame) {
+	GLuint chromaWidth = (frame.width + 1) / 2;
+	GLuint chromaHeight = (frame.height + 1) / 2;
+
+	uploadPlane(&yuvTextures[0],frame.width,frame.height,GL_LUMINANCE,frame.y);
+	if(frame.layout == YUV_I420) {
+		uploadPlane(&yuvTextures[1],chromaWidth,chromaHeight,GL_LUMINANCE,frame.u);
+		uploadPlane(&yuvTextures[2],chromaWidth,chromaHeight,GL_LUMINANCE,frame.v);
+	}
+	else {
+		// LUMINANCE_ALPHA puts the first byte of each pair in .r and the second in .a
+		uploadPlane(&yuvTextures[1],chromaWidth,chromaHeight,GL_LUMINANCE_ALPHA,frame.u);
+	}
+	glBindTexture(GL_TEXTURE_2D, 0);
+}
+
+GLvoid* Scene::scaleYuvTexture(float ratio,const YuvFrame& frame,YuvColorSpace colorSpace,YuvRange range,GLenum f,GLenum t) {
+	bool planar = frame.layout == YUV_I420;
+	Program* p = getYuvProgram(planar);
+	if(!p)
+		return NULL;
+	loadYuvTextures(frame);
+
+	float m[9],offset[3];
+	getYuvToRgbMatrix(colorSpace,range,m,offset);
+	if(frame.layout == YUV_NV21) {
+		// the shader reads (Y, first, second) chroma bytes: swap the U and V columns
+		for(int row=0;row<3;row++) {
+			float u = m[row*3+1];
+			m[row*3+1] = m[row*3+2];
+			m[row*3+2] = u;
+		}
+		float u = offset[1];
+		offset[1] = offset[2];
+		offset[2] = u;
+	}
+	// GLES2 does not accept transposed uniform matrices: store column-major
+	float columns[9] = { m[0], m[3], m[6], m[1], m[4], m[7], m[2], m[5], m[8] };
+
+	if(fb)
+		delete fb;
+	fb = new Framebuffer(ratio*frame.width,ratio*frame.height,0,f,t,0,"Scene output");
+	fb->bind();
+	fb->setViewPort();
+
+	p->setUniformMatrix3fv( "uYuvMatrix", columns );
+	p->setUniform3fv( "uYuvOffset", offset );
+	p->setUniform1i( "sTextureY", 0 );
+	p->setUniform1i( planar ? "sTextureU" : "sTextureUV", 1 );
+	p->setUniform1i( "sTextureV", 2 );
+	p->use();
+	for(int i=0;i<(planar ? 3 : 2);i++) {
+		glActiveTexture( GL_TEXTURE0 + i );
+		glBindTexture( GL_TEXTURE_2D, yuvTextures[i] );
+	}
+
+	drawQuad( true );
+
+	for(int i=(planar ? 2 : 1);i>=0;i--) {
+		glActiveTexture( GL_TEXTURE0 + i );
+		glBindTexture( GL_TEXTURE_2D, 0 );
+	}
+	fb->unbind();
+	fb->recoverSavedViewPort();
+
+	return fb->grabDataPointer();
+}
+
+Program* Scene::getPackProgram() {
+	Program* p = shaders.getProgram( "shaders/vertexShader", "shaders/fragmentShaderPackYuv" );
+	if( !p )
+		LogError( "Could not create YUV packing program." );
+	return p;
+}
+
+GLubyte* Scene::scaleTextureToI420(float ratio,GLvoid* data,GLuint w,GLuint h,GLenum f,GLenum t,
+		GLuint* outWidth,GLuint* outHeight,YuvColorSpace colorSpace,YuvRange range) {
+	// chroma rows pack 4 samples per texel, so luma width must be a multiple of 8
+	GLuint ow = (GLuint)(ratio*w) & ~7u;
+	GLuint oh = (GLuint)(ratio*h) & ~1u;
+	*outWidth = ow;
+	*outHeight = oh;
+	Program* p = getPackProgram();
+	if(!p || ow == 0 || oh == 0)
+		return NULL;
+
+	loadTextureFromPointer(data,w,h,f,t);
+
+	float m[9],offset[3];
+	getRgbToYuvMatrix(colorSpace,range,m,offset);
+	const GLuint planeWidth[3] = { ow/4, ow/8, ow/8 };
+	const GLuint planeHeight[3] = { oh, oh/2, oh/2 };
+	const float step[3] = { 1.0f/ow, 2.0f/ow, 2.0f/ow };
+
+	glActiveTexture( GL_TEXTURE0 );
+	glBindTexture( GL_TEXTURE_2D, textureHandle );
+	p->setUniform1i( "sTexture", 0 );
+
+	// issue all three passes before reading anything back
+	for(int i=0;i<3;i++) {
+		Framebuffer*& target = planeTargets[i];
+		if(target && (target->getWidth() != (int)planeWidth[i] || target->getHeight() != (int)planeHeight[i])) {
+			delete target;
+			target = NULL;
+		}
+		if(!target)
+			target = new Framebuffer(planeWidth[i],planeHeight[i],0,GL_RGBA,GL_UNSIGNED_BYTE,0,"Scene I420 planes");
+
+		target->bind();
+		target->setViewPort();
+		p->setUniform3fv( "uWeights", &m[i*3] );
+		p->setUniform1f( "uBias", offset[i] );
+		p->setUniform1f( "uStep", step[i] );
+		p->use();
+
+		drawQuad( true );
+
+		target->unbind();
+		target->recoverSavedViewPort();
+	}
+	glBindTexture( GL_TEXTURE_2D, 0 );
+
+	GLubyte* i420 = new GLubyte[ow*oh*3/2];
+	planeTargets[0]->grabData(i420);
+	planeTargets[1]->grabData(i420 + ow*oh);
+	planeTargets[2]->grabData(i420 + ow*oh + ow*oh/4);
+	return i420;
+}
+
+struct LargerTarget {
+	const ScaleTarget* targets;
+	bool operator()(int a,int b) const {
+		return targets[a].width * targets[a].height > targets[b].width * targets[b].height;
+	}
+};
+
+void Scene::scaleTextureMulti(GLvoid* data,GLuint w,GLuint h,GLenum f,GLenum t,
+		ScaleTarget* targets,int count,MultiScaleMode mode) {
+	loadTextureFromPointer(data,w,h,f,t);
+
+	// render order: largest first, so a cascade always shrinks
+	std::vector<int> order(count);
+	for(int i=0;i<count;i++)
+		order[i] = i;
+	if(mode == MULTI_SCALE_CASCADE) {
+		LargerTarget larger = { targets };
+		std::stable_sort(order.begin(),order.end(),larger);
+	}
+
+	for(unsigned int i=count;i<multiTargets.size();i++)
+		delete multiTargets[i];
+	multiTargets.resize(count,NULL);
+
+	GLuint source = textureHandle;
+	for(int i=0;i<count;i++) {
+		const ScaleTarget& target = targets[order[i]];
+		Framebuffer*& out = multiTargets[order[i]];
+		if(out && (out->getWidth() != (int)target.width || out->getHeight() != (int)target.height)) {
+			delete out;
+			out = NULL;
+		}
+		if(!out)
+			out = new Framebuffer(target.width,target.height,0,f,t,0,"Scene multi-output");
+
+		out->bind();
+		out->setViewPort();
+		if(source != textureHandle)
+			setTexelSize(targets[order[i-1]].width,targets[order[i-1]].height);
+		this->draw(source,true);
+		out->unbind();
+		out->recoverSavedViewPort();
+
+		if(mode == MULTI_SCALE_CASCADE)
+			source = out->getTexture();
+	}
+
+	GLuint pixelSize = getPixelSize(f,t);
+	for(int i=0;i<count;i++) {
+		targets[i].pixels = new GLubyte[targets[i].width * targets[i].height * pixelSize];
+		multiTargets[i]->grabData(targets[i].pixels);
+	}
+}
+
+bool Scene::computeOutputStats(ImageStats* stats,bool histogram) {
+	statsReadbackBytes = 0;
+	if(!fb)
+		return false;
+	const GLuint w = fb->getWidth(), h = fb->getHeight();
+	// an sRGB output would be sampled decoded
+	if(!srgbSource) {
+		if(!statsReducer)
+			statsReducer = new StatsReducer(&shaders);
+		bool reduced = histogram ? statsReducer->computeHistogram(fb->getTexture(),w,h,stats)
+				: statsReducer->reduce(fb->getTexture(),w,h,stats);
+		if(reduced) {
+			statsReadbackBytes = statsReducer->getReadbackBytes();
+			return true;
+		}
+	}
+	if(fb->getType() != GL_UNSIGNED_BYTE) {
+		LogError("Scene::computeOutputStats: type 0x%x needs the GPU reduction",fb->getType());
+		return false;
+	}
+	const GLuint channels = getPixelSize(fb->getFormat(),GL_UNSIGNED_BYTE);
+	GLubyte* pixels = (GLubyte*)fb->grabDataPointer();
+	computeImageStats(pixels,w,h,channels,stats,histogram);
+	statsReadbackBytes = w * h * channels;
+	delete[] pixels;
+	return true;
+}
+
+size_t Scene::getStatsReadbackBytes() {
+	return statsReadbackBytes;
 }
@@ -8,7 +8,22 @@
 #ifndef SCENE_H_
 #define SCENE_H_
 
+#include <vector>
 #include "GLUtils.h"
+#include "YuvConvert.h"
+#include "ScaleCache.h"
+#include "ImageTransform.h"
+#include "ShaderVariants.h"
+#include "ColorSpace.h"
+#include "GpuMemory.h"
+#include "ImageStats.h"
+#include "SpriteBatch.h"
+
+#ifndef GL_TEXTURE_EXTERNAL_OES
+#define GL_TEXTURE_EXTERNAL_OES 0x8D65
+#endif
+
+class StatsReducer;
 
 typedef struct
 {
@@ -17,31 +32,186 @@ typedef struct
 
 } TriangleVertex;
 
+enum MultiScaleMode {
+	MULTI_SCALE_INDEPENDENT,	// every output is sampled from the source
+	MULTI_SCALE_CASCADE			// each output is sampled from the next larger one
+};
+
+typedef struct
+{
+	GLuint width;
+	GLuint height;
+	GLvoid* pixels;		// set by scaleTextureMulti, free with delete[]
+} ScaleTarget;
+
+typedef struct
+{
+	GLuint x;
+	GLuint y;
+	GLuint width;
+	GLuint height;
+} DirtyRect;
+
 class Scene {
 public:
+	// Needs a current context but makes no GL objects: the program and the
+	// checkerboard shown by draw() are built on first use
 	Scene(int width,int height);
 	virtual ~Scene();
-	void draw(GLuint textureHandler = 0);
+	// New window size, e.g. when the surface is recreated for a kept context
+	void resize(int width,int height);
+	// Deletes every GL object the scene holds. After a context loss call it
+	// with no context current, so the deletes do nothing; the objects are
+	// built again on first use. draw() then shows the last scaleTexture
+	// result again if the result cache still holds it, else the checkerboard.
+	void releaseGlResources();
+	void draw(GLuint textureHandler = 0,bool toFramebuffer = false);
+	// Builds what draw() shows when there is nothing to show yet (a new
+	// scene or after releaseGlResources). draw() does it itself but
+	// leaves framebuffer 0 bound then, so call this before drawing into
+	// another framebuffer.
+	void ensureDisplay();
 	void renderTextureToFbo();
 	void scaleDown();
 	void scaleUp();
 	void loadTextureFromPointer(GLvoid* data,GLuint width, GLuint height,GLenum format,GLenum type);
+	// Falls back to scaleImageBilinearColor when the source and output
+	// textures do not fit the GPU memory budget; of the shader defines only
+	// SHARPEN and DITHER_* apply there (scaleImageBilinearPost, which ignores
+	// the color mode). GL_UNSIGNED_BYTE formats only, NULL for the others.
+	// The framebuffer shown by draw() is then left as it was. GL_RGB results
+	// take the type set by setOutputType.
 	GLvoid* scaleTexture(float ratio,GLvoid* data,GLuint width,GLuint height,GLenum format,GLenum type);
+	// scaleTexture calls that ran on the CPU for lack of GPU memory
+	unsigned int getCpuFallbackCount();
+	// scaleTexture consults the cache before any GL work; on a hit the
+	// framebuffer shown by draw() is left as it was. The scene does not own it.
+	void setResultCache(ScaleCache* cache);
+	ScaleCache* getResultCache();
+	// Selects the fragmentShader variant used by draw(), scaleTexture and
+	// friends: any of FILTER_BOX, SWIZZLE_BGR, SHARPEN, one of DITHER_ORDERED
+	// and DITHER_NOISE, and EXTERNAL_SAMPLER (textures passed to draw() are
+	// then bound as GL_TEXTURE_EXTERNAL_OES), ';' separated. FILTER_BOX and
+	// SHARPEN expect the quad to cover the viewport, which drawBatch's do not.
+	// Dithering follows the precision of the bound framebuffer.
+	bool setShaderDefines(const char* defines);
+	const char* getShaderDefines();
+	ShaderVariantCache* getShaderCache();
+	// ColorMode flags for the RGB(A) paths drawn with the fragmentShader variants.
+	// COLOR_MODE_LINEAR uses GL_EXT_sRGB textures for GL_RGBA sources in
+	// scaleTexture when the driver has them, shader math otherwise.
+	bool setColorMode(int mode);
+	int getColorMode();
+	// Unsharp mask amount of the SHARPEN variant, 0.5 by default
+	void setSharpenAmount(float amount);
+	float getSharpenAmount();
+	// Type scaleTexture renders and reads back GL_RGB, GL_UNSIGNED_BYTE sources
+	// as; 0 keeps the source type. GL_UNSIGNED_SHORT_5_6_5 halves the readback,
+	// DITHER_ORDERED or DITHER_NOISE keep its gradients from banding. The
+	// returned buffer then holds 2 bytes per pixel: every scaleTexture caller
+	// sizes and reads it by getPixelSize(format, result type), or sets 0
+	// around calls that need the source layout.
+	bool setOutputType(GLenum type);
+	GLenum getOutputType();
+	// Incremental form of the last scaleTexture call: data is the whole updated
+	// source (same size, format and type), rects the regions that changed and
+	// output the buffer scaleTexture returned. Only the changed regions are
+	// uploaded and redrawn, and only the output rows they touch are read back.
+	// Returns false when there is no matching previous scaleTexture result.
+	bool updateScaledTexture(const GLvoid* data,const DirtyRect* rects,int count,GLvoid* output);
+	// Uploads pre-compressed data (GL_ETC1_RGB8_OES, GL_COMPRESSED_RGB8_ETC2, ...)
+	// and scales it into an uncompressed format; NULL if the driver rejects it
+	GLvoid* scaleCompressedTexture(float ratio,const GLvoid* data,GLsizei imageSize,GLuint width,GLuint height,GLenum internalFormat,
+			GLenum format = GL_RGB,GLenum type = GL_UNSIGNED_BYTE);
+	// Samples the source through an ImageTransform.h matrix into an
+	// outWidth x outHeight image with a single draw and readback
+	GLvoid* transformTexture(const float* matrix,GLvoid* data,GLuint width,GLuint height,GLenum format,GLenum type,
+			GLuint outWidth,GLuint outHeight);
+	// Crop, rotate and flip, then scale the result by ratio; the output size
+	// is stored in outWidth/outHeight
+	GLvoid* cropRotateScaleTexture(float ratio,const ImageTransform& transform,GLvoid* data,GLuint width,GLuint height,
+			GLenum format,GLenum type,GLuint* outWidth,GLuint* outHeight);
+	// Converts and scales a 4:2:0 frame in a single pass; format is GL_RGB or GL_RGBA
+	GLvoid* scaleYuvTexture(float ratio,const YuvFrame& frame,YuvColorSpace colorSpace = YUV_BT601,YuvRange range = YUV_RANGE_LIMITED,
+			GLenum format = GL_RGB,GLenum type = GL_UNSIGNED_BYTE);
+	// Scales an RGB(A) image and returns it as I420 (Y, U, V planes), packing
+	// 4 samples per RGBA texel so only 1.5 bytes per pixel are read back.
+	// The output is ratio*width rounded down to a multiple of 8 by ratio*height
+	// rounded down to even; the actual size is stored in outWidth/outHeight.
+	GLubyte* scaleTextureToI420(float ratio,GLvoid* data,GLuint width,GLuint height,GLenum format,GLenum type,
+			GLuint* outWidth,GLuint* outHeight,YuvColorSpace colorSpace = YUV_BT601,YuvRange range = YUV_RANGE_LIMITED);
+	// Uploads the source once and renders every target size from it. All
+	// draws are issued before the first readback.
+	void scaleTextureMulti(GLvoid* data,GLuint width,GLuint height,GLenum format,GLenum type,
+			ScaleTarget* targets,int count,MultiScaleMode mode = MULTI_SCALE_INDEPENDENT);
+	// Draws vertexCount vertices (GL_TRIANGLES) sampling texture, without clearing.
+	// The texture size is needed by the color modes; 0 means the last source.
+	void drawBatch(GLuint texture,const TriangleVertex* positions,const TriangleVertex* texCoords,GLsizei vertexCount,
+			GLuint textureWidth = 0,GLuint textureHeight = 0);
+	// Flushes batch through the same program as drawBatch: one draw per
+	// texture instead of one per quad. Returns the draws issued.
+	GLuint drawSprites(SpriteBatch* batch,bool sortByTexture = true);
+	// Luma statistics of the framebuffer shown by draw(), e.g. the last
+	// scaleTexture result, without reading the image back when StatsReducer
+	// can run: 4 bytes for mean, min and max, 1 KB with the histogram.
+	// Otherwise the image is read back for computeImageStats.
+	bool computeOutputStats(ImageStats* stats,bool histogram = false);
+	// Bytes computeOutputStats read back last time
+	size_t getStatsReadbackBytes();
 private:
+	static size_t evictPools(void* scene,size_t bytes);
+	bool ensureProgram();
+	void restoreDisplay();
+	GLenum getResultType(GLenum format,GLenum type);
+	GLvoid* scaleTextureOnCpu(float ratio,const GLvoid* data,GLuint width,GLuint height,GLenum format,GLenum type);
+	bool selectProgram(const char* defines,int mode,bool srgb);
+	void setSrgbSource(bool srgb);
+	void setTexelSize(GLuint width,GLuint height);
+	void drawQuad(bool toFramebuffer);
+	void drawArrays(const TriangleVertex* positions,const TriangleVertex* texCoords,GLsizei vertexCount);
+	Program* getYuvProgram(bool planar);
+	void loadYuvTextures(const YuvFrame& frame);
+	Program* getPackProgram();
+
 	static TriangleVertex triangleVerticesPNG[];
 	static TriangleVertex textureCoordsPNG[];
+	static TriangleVertex textureCoordsFbo[];
 
-	GLuint programHandle;
-	GLuint aPositionHandle;
-	GLuint aTexCoordHandle;
-	GLuint aTexSamplerHandle;
+	Program* program;
+	bool externalSampler;
+	std::string shaderDefines;
+	int colorMode;
+	float sharpenAmount;
+	GLenum outputType;
+	bool srgbSupported;
+	bool srgbSource;				// textureHandle is GL_SRGB_ALPHA_EXT
+	ShaderVariantCache shaders;
 	GLuint textureHandle;
+	GLuint yuvTextures[3];
+	Framebuffer* planeTargets[3];
+	std::vector<Framebuffer*> multiTargets;
+	ScaleCache* resultCache;
+	bool sourceResident;			// textureHandle and fb hold the last scaleTexture
+	GLenum sourceFormat,sourceType;
+	GLenum resultType;				// of fb when sourceResident
+	unsigned int cpuFallbacks;
+	StatsReducer* statsReducer;
+	size_t statsReadbackBytes;
 
 	int width,height;
 	Framebuffer* fb;
+	// The scaleTexture result fb shows, found again in resultCache by
+	// restoreDisplay after a context loss; key is 0 when fb shows anything else
+	typedef struct
+	{
+		ScaleKey key;
+		GLuint width,height;
+		GLenum format,type,textureFormat;
+	} DisplayedResult;
+	DisplayedResult displayed;
 
 	float scale;
-	GLubyte* generateCheckBoardTextureData(GLuint width,GLuint height, GLuint format);
+	GLubyte* generateCheckBoardTextureData(GLuint width,GLuint height, GLenum format);
 	int checkboard_width,checkboard_height;
 };
 
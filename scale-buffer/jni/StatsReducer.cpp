@@ -0,0 +1,269 @@
+/*
+ * StatsReducer.cpp
+ *
+ *  Created on: 19-10-2026
+ */
+
+#include "StatsReducer.h"
+#include "GpuMemory.h"
+#include "RenderGraph.h"
+#include "logger.h"
+#include <string.h>
+#include <algorithm>
+
+// Whole image rows go into each draw of the scatter
+static GLuint getRowsPerDraw(GLuint width) {
+	return std::max(1u,(GLuint)STATS_POINTS_PER_DRAW / width);
+}
+
+StatsReducer::StatsReducer(ShaderVariantCache* s):shaders(s),supportChecked(false),highPrecision(false),vertexTextures(false),
+		maxRows(0),scatter(NULL),folded(NULL),indexBuffer(0),readbackBytes(0) {
+}
+
+StatsReducer::~StatsReducer() {
+	releaseGlResources();
+}
+
+void StatsReducer::checkSupport() {
+	if(supportChecked)
+		return;
+	GLint range[2] = { 0, 0 }, precision = 0, units = 0;
+	glGetShaderPrecisionFormat(GL_FRAGMENT_SHADER, GL_HIGH_FLOAT, range, &precision);
+	glGetIntegerv(GL_MAX_VERTEX_TEXTURE_IMAGE_UNITS, &units);
+	highPrecision = precision > 0;
+	vertexTextures = units > 0;
+
+	GLint maxTexture = 0, maxViewport[2] = { 0, 0 };
+	glGetIntegerv(GL_MAX_TEXTURE_SIZE, &maxTexture);
+	glGetIntegerv(GL_MAX_VIEWPORT_DIMS, maxViewport);
+	GLint size = std::min(maxTexture,(GLint)std::min(maxViewport[0],maxViewport[1]));
+	maxRows = std::min(STATS_MAX_HISTOGRAM_ROWS,(int)(size / IMAGE_STATS_BINS * std::min(size,STATS_HISTOGRAM_BLOCK_ROWS)));
+	supportChecked = true;
+	Log("StatsReducer: highp fragments %s, %d vertex texture units",highPrecision ? "yes" : "no",units);
+}
+
+bool StatsReducer::isReduceSupported() {
+	checkSupport();
+	return highPrecision;
+}
+
+bool StatsReducer::isHistogramSupported() {
+	checkSupport();
+	return vertexTextures;
+}
+
+// The passes read single texels at their centers, which GL_LINEAR may blend
+// with neighbours on GPUs with few subtexel bits
+static void setFilter(GLuint texture,GLint minFilter,GLint magFilter) {
+	glBindTexture(GL_TEXTURE_2D, texture);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, minFilter);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, magFilter);
+}
+
+// Samples texture nearest until the returned filters are set back
+static void sampleNearest(GLuint texture,GLint filters[2]) {
+	glBindTexture(GL_TEXTURE_2D, texture);
+	glGetTexParameteriv(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, &filters[0]);
+	glGetTexParameteriv(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, &filters[1]);
+	setFilter(texture,GL_NEAREST,GL_NEAREST);
+}
+
+Framebuffer* StatsReducer::getTarget(Framebuffer** slot,GLuint width,GLuint height) {
+	if(*slot && (GLuint)(*slot)->getWidth() == width && (GLuint)(*slot)->getHeight() == height)
+		return *slot;
+	delete *slot;
+	*slot = new Framebuffer(width,height,0,GL_RGBA,GL_UNSIGNED_BYTE,0,"StatsReducer");
+	setFilter((*slot)->getTexture(),GL_NEAREST,GL_NEAREST);
+	glBindTexture(GL_TEXTURE_2D, 0);
+	return *slot;
+}
+
+bool StatsReducer::reduce(GLuint texture,GLuint width,GLuint height,ImageStats* stats) {
+	readbackBytes = 0;
+	if(!isReduceSupported() || !width || !height)
+		return false;
+	Program* first = shaders->getProgram("shaders/vertexShader","shaders/fragmentShaderReduce","FIRST_PASS");
+	Program* next = shaders->getProgram("shaders/vertexShader","shaders/fragmentShaderReduce");
+	if(!first || !next)
+		return false;
+
+	GLuint w = width, h = height, input = texture;
+	float span = 1.0f;
+	unsigned int level = 0;
+	GLint filters[2];
+	glActiveTexture(GL_TEXTURE0);
+	sampleNearest(texture,filters);
+	do {
+		GLuint ow = (w + 1) / 2, oh = (h + 1) / 2;
+		if(levels.size() <= level)
+			levels.push_back(NULL);
+		Framebuffer* target = getTarget(&levels[level],ow,oh);
+		Program* program = level ? next : first;
+		program->setUniform1i("sTexture", 0);
+		program->setUniform2f("uInputSize", w, h);
+		program->setUniform2f("uSourceSize", width, height);
+		program->setUniform1f("uInputSpan", span);
+		program->use();
+		glBindTexture(GL_TEXTURE_2D, input);
+		target->bind();
+		target->setViewPort();
+		drawRenderPassQuad();
+		target->unbind();
+		target->recoverSavedViewPort();
+		input = target->getTexture();
+		w = ow;
+		h = oh;
+		span *= 2.0f;
+		level++;
+	} while(w > 1 || h > 1);
+	setFilter(texture,filters[0],filters[1]);
+	glBindTexture(GL_TEXTURE_2D, 0);
+	CheckGlError("StatsReducer::reduce");
+
+	GLubyte result[4];
+	levels[level - 1]->grabData(result);
+	readbackBytes = sizeof(result);
+	stats->pixelCount = width * height;
+	stats->mean = (result[0] * 256 + result[1]) / 256.0f;
+	stats->min = result[2];
+	stats->max = result[3];
+	stats->hasHistogram = false;
+	return true;
+}
+
+bool StatsReducer::drawPoints(Program* program,GLuint width,GLuint height,GLint rows) {
+	GLint attrib = program->getAttribLocation("aIndex");
+	if(attrib < 0)
+		return false;
+	if(!indexBuffer) {
+		std::vector<GLfloat> indices(STATS_POINTS_PER_DRAW);
+		for(int i=0;i<STATS_POINTS_PER_DRAW;i++)
+			indices[i] = i;
+		glGenBuffers(1, &indexBuffer);
+		glBindBuffer(GL_ARRAY_BUFFER, indexBuffer);
+		glBufferData(GL_ARRAY_BUFFER, indices.size() * sizeof(GLfloat), &indices[0], GL_STATIC_DRAW);
+		gpuMemoryTrack(GPU_RESOURCE_BUFFER, indexBuffer, indices.size() * sizeof(GLfloat), "StatsReducer");
+	}
+	else
+		glBindBuffer(GL_ARRAY_BUFFER, indexBuffer);
+	// the quads leave client arrays of 4 vertices enabled, which some
+	// drivers would read past their end
+	glDisableVertexAttribArray(ATTRIB_POSITION);
+	glDisableVertexAttribArray(ATTRIB_TEXCOORD);
+	glEnableVertexAttribArray(attrib);
+	glVertexAttribPointer(attrib, 1, GL_FLOAT, GL_FALSE, 0, 0);
+	const GLuint rowsPerDraw = getRowsPerDraw(width);
+	GLuint cell = 0;
+	for(GLuint y=0;y<height;y+=rowsPerDraw) {
+		GLuint points = std::min(rowsPerDraw,height - y) * width;
+		program->setUniform1f("uFirstRow", y);
+		program->setUniform1f("uFirstCell", cell % rows);
+		program->use();
+		glDrawArrays(GL_POINTS, 0, points);
+		cell += (points + 3) / 4;
+	}
+	glDisableVertexAttribArray(attrib);
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+	CheckGlError("StatsReducer::drawPoints");
+	return true;
+}
+
+bool StatsReducer::computeHistogram(GLuint texture,GLuint width,GLuint height,ImageStats* stats) {
+	readbackBytes = 0;
+	if(!isHistogramSupported() || !width || !height || width > (GLuint)STATS_POINTS_PER_DRAW)
+		return false;
+	// cells of 4 points, a partial one ending each draw
+	const GLuint rowsPerDraw = getRowsPerDraw(width), draws = (height + rowsPerDraw - 1) / rowsPerDraw;
+	const GLuint cells = draws * ((rowsPerDraw * width + 3) / 4);
+	const GLint rows = (cells + 254) / 255;
+	if(rows > maxRows) {
+		LogWarn("StatsReducer: %ux%u needs %d histogram rows, at most %d fit",width,height,rows,maxRows);
+		return false;
+	}
+	Program* scatterProgram = shaders->getProgram("shaders/vertexShaderHistogram","shaders/fragmentShaderHistogram");
+	Program* fold = highPrecision ? shaders->getProgram("shaders/vertexShader","shaders/fragmentShaderHistogramFold") : NULL;
+	if(!scatterProgram || (highPrecision && !fold))
+		return false;
+
+	const GLint blockRows = std::min(rows,STATS_HISTOGRAM_BLOCK_ROWS), blocks = (rows + blockRows - 1) / blockRows;
+	Framebuffer* target = getTarget(&scatter,IMAGE_STATS_BINS * blocks,blockRows);
+	target->bind();
+	target->setViewPort();
+	glClearColor(0.0f, 0.0f, 0.0f, 0.0f);
+	glClear(GL_COLOR_BUFFER_BIT);
+	GLint filters[2];
+	glActiveTexture(GL_TEXTURE0);
+	sampleNearest(texture,filters);
+	scatterProgram->setUniform1i("sTexture", 0);
+	scatterProgram->setUniform2f("uInputSize", width, height);
+	scatterProgram->setUniform1f("uRows", rows);
+	scatterProgram->setUniform1f("uBlockRows", blockRows);
+	scatterProgram->setUniform1f("uBlocks", blocks);
+	glEnable(GL_BLEND);
+	glBlendFunc(GL_ONE, GL_ONE);
+	bool drawn = drawPoints(scatterProgram,width,height,rows);
+	glDisable(GL_BLEND);
+	target->unbind();
+	target->recoverSavedViewPort();
+	setFilter(texture,filters[0],filters[1]);
+	if(!drawn) {
+		glBindTexture(GL_TEXTURE_2D, 0);
+		LogError("StatsReducer: the histogram program has no aIndex");
+		return false;
+	}
+
+	stats->hasHistogram = true;
+	if(fold) {
+		Framebuffer* result = getTarget(&folded,IMAGE_STATS_BINS,1);
+		fold->setUniform1i("sTexture", 0);
+		fold->setUniform1f("uRows", rows);
+		fold->setUniform1f("uBlockRows", blockRows);
+		fold->setUniform1f("uBlocks", blocks);
+		fold->use();
+		glBindTexture(GL_TEXTURE_2D, target->getTexture());
+		result->bind();
+		result->setViewPort();
+		drawRenderPassQuad();
+		result->unbind();
+		result->recoverSavedViewPort();
+		glBindTexture(GL_TEXTURE_2D, 0);
+
+		GLubyte counts[IMAGE_STATS_BINS * 4];
+		result->grabData(counts);
+		readbackBytes = sizeof(counts);
+		for(int i=0;i<IMAGE_STATS_BINS;i++)
+			stats->histogram[i] = counts[i*4] | counts[i*4+1] << 8 | counts[i*4+2] << 16;
+	}
+	else {
+		// mediump cannot count past 2048; sum the cells here
+		glBindTexture(GL_TEXTURE_2D, 0);
+		std::vector<GLubyte> cells((size_t)IMAGE_STATS_BINS * blocks * blockRows * 4);
+		target->grabData(&cells[0]);
+		readbackBytes = cells.size();
+		memset(stats->histogram,0,sizeof(stats->histogram));
+		for(size_t i=0;i<cells.size()/4;i++)
+			stats->histogram[i % IMAGE_STATS_BINS] += cells[i*4] + cells[i*4+1] + cells[i*4+2] + cells[i*4+3];
+	}
+	getImageStatsFromHistogram(stats);
+	return true;
+}
+
+size_t StatsReducer::getReadbackBytes() {
+	return readbackBytes;
+}
+
+size_t StatsReducer::releaseGlResources() {
+	size_t before = gpuMemoryGetUsed();
+	for(unsigned int i=0;i<levels.size();i++)
+		delete levels[i];
+	levels.clear();
+	delete scatter;
+	delete folded;
+	scatter = folded = NULL;
+	if(indexBuffer) {
+		gpuMemoryRelease(GPU_RESOURCE_BUFFER, indexBuffer);
+		glDeleteBuffers(1, &indexBuffer);
+	}
+	indexBuffer = 0;
+	return before - gpuMemoryGetUsed();
+}
@@ -0,0 +1,72 @@
+/*
+ * StatsReducer.h
+ *
+ *  Created on: 19-10-2026
+ */
+
+#ifndef STATSREDUCER_H_
+#define STATSREDUCER_H_
+
+#include <vector>
+#include "Framebuffer.h"
+#include "ImageStats.h"
+#include "ShaderVariants.h"
+
+// Pixels drawn per glDrawArrays of the histogram scatter
+#define STATS_POINTS_PER_DRAW 262144
+// Rows of the scatter target fragmentShaderHistogramFold can sum, its
+// MAX_BLOCKS * BLOCK_ROWS
+#define STATS_MAX_HISTOGRAM_ROWS 4096
+// Rows past this go to another block of 256 columns: taller targets are not
+// sampled exactly at texel centers on every GPU
+#define STATS_HISTOGRAM_BLOCK_ROWS 1024
+
+/*
+ * ImageStats of a texture computed on the GPU, reading back a few bytes
+ * instead of the image:
+ *  - reduce(): mean, min and max through half size passes down to 1x1
+ *    (shaders/fragmentShaderReduce), 4 bytes read back. The mean keeps 8
+ *    fractional bits per pass.
+ *  - computeHistogram(): one point per pixel scattered into a 256 x rows
+ *    RGBA target (in blocks of 1024 rows side by side) with additive
+ *    blending, each 8 bit cell counting up to 255
+ *    pixels, then the rows folded into a 256x1 target of 24 bit counts: 1 KB
+ *    read back. Mean, min and max follow exactly from the bins.
+ * Both need highp in fragment shaders; without it the histogram reads the
+ * scatter target back and folds it on the CPU. The histogram needs vertex
+ * texture fetch. Results match computeImageStats; benchmarkImageStats checks
+ * it from one block to four. GL thread only.
+ */
+class StatsReducer {
+public:
+	explicit StatsReducer(ShaderVariantCache* shaders);
+	virtual ~StatsReducer();
+
+	bool isReduceSupported();
+	bool isHistogramSupported();
+	// texture is sampled with GL_TEXTURE_2D at texel centers, any RGB(A) or
+	// luminance format; false if the GPU path cannot run
+	bool reduce(GLuint texture,GLuint width,GLuint height,ImageStats* stats);
+	bool computeHistogram(GLuint texture,GLuint width,GLuint height,ImageStats* stats);
+	// Bytes glReadPixels returned during the last call
+	size_t getReadbackBytes();
+	// Deletes the targets and the point buffer, rebuilt on the next call;
+	// returns the bytes freed
+	size_t releaseGlResources();
+private:
+	void checkSupport();
+	Framebuffer* getTarget(Framebuffer** slot,GLuint width,GLuint height);
+	bool drawPoints(Program* program,GLuint width,GLuint height,GLint rows);
+
+	ShaderVariantCache* shaders;
+	bool supportChecked;
+	bool highPrecision,vertexTextures;
+	GLint maxRows;
+	std::vector<Framebuffer*> levels;
+	Framebuffer* scatter;
+	Framebuffer* folded;
+	GLuint indexBuffer;
+	size_t readbackBytes;
+};
+
+#endif /* STATSREDUCER_H_ */
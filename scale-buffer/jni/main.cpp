@@ -24,14 +24,24 @@
 #include <android_native_app_glue.h>
 
 #include <assert.h>
+#include <stdio.h>
+#include <string.h>
+#include <string>
 #include "file.h"
 #include "matrices.h"
 #include "Framebuffer.h"
 #include "Scene.h"
+#include "Benchmarks.h"
+#include "QualityCheck.h"
+#include "Timing.h"
+#include "GlTrace.h"
+#include "DynamicResolution.h"
 #include "logger.h"
 
 const int   TEXTURE_WIDTH   = 256;  // NOTE: texture size cannot be larger than
 const int   TEXTURE_HEIGHT  = 256;  // the rendering window size in non-FBO mode
+const unsigned int TRACE_FRAMES = 300;  // frames captured by GLUTILS_TRACE builds
+const double FRAME_TARGET_MS = 17.5;    // 60 Hz and some slack, held by DYNAMIC_RESOLUTION builds
 
 Scene * p;
 
@@ -56,6 +66,7 @@ struct engine {
     EGLDisplay display;
     EGLSurface surface;
     EGLContext context;
+    EGLConfig config;
     int32_t width;
     int32_t height;
     struct saved_state state;
@@ -63,15 +74,21 @@ struct engine {
 //    GLuint renderableTexture,framebufferObject;
 //    struct framebuffer fb;
     Scene* sc;
+    ScaleCache* cache;
+    double resumeStart;		// until the first frame after a window is shown
+    const char* resumeKind;
+    DynamicResolution* resolution;	// NULL draws at the surface size
+    double lastSwap;		// 0 until a frame of the current window was shown
 };
 
 
 /**
- * Initialize an EGL context for the current display.
+ * Initialize EGL and create a context, unless one outlived the last window.
  */
-static int engine_init_display(struct engine* engine) {
-    // initialize OpenGL ES and EGL
-	int i,j;
+static int engine_init_context(struct engine* engine) {
+    if (engine->context != EGL_NO_CONTEXT) {
+        return 0;
+    }
     /*
      * Here specify the attributes of the desired configuration.
      * Below, we select an EGLConfig with at least 8 bits per color
@@ -87,50 +104,154 @@ static int engine_init_display(struct engine* engine) {
     };
     const EGLint context_attrib_list [] = {EGL_CONTEXT_CLIENT_VERSION, 2, EGL_NONE};
 
-    EGLint w, h, dummy, format;
-    EGLint numConfigs;
-    EGLConfig config;
-    EGLSurface surface;
-    EGLContext context;
+    if (engine->display == EGL_NO_DISPLAY) {
+        EGLint numConfigs;
+        EGLDisplay display = eglGetDisplay(EGL_DEFAULT_DISPLAY);
+
+        eglInitialize(display, 0, 0);
+
+        /* Here, the application chooses the configuration it desires. In this
+         * sample, we have a very simplified selection process, where we pick
+         * the first EGLConfig that matches our criteria */
+        eglChooseConfig(display, attribs, &engine->config, 1, &numConfigs);
+        engine->display = display;
+    }
+
+    engine->context = eglCreateContext(engine->display, engine->config, NULL, context_attrib_list);
+    if (engine->context == EGL_NO_CONTEXT) {
+        LogError("Unable to eglCreateContext");
+        return -1;
+    }
+    // the program current in the old context means nothing in this one
+    Program::invalidateCurrent();
+    return 0;
+}
+
+/**
+ * Forget a lost context. The scene deletes its objects while no context is
+ * current, so the deletes do nothing, and builds them again on first use.
+ */
+static void engine_lose_context(struct engine* engine) {
+    // the traced names die with the context
+    glTraceStop();
+    eglMakeCurrent(engine->display, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+    if (engine->sc) {
+        engine->sc->releaseGlResources();
+    }
+    if (engine->resolution) {
+        engine->resolution->releaseGlResources();
+    }
+    eglDestroyContext(engine->display, engine->context);
+    engine->context = EGL_NO_CONTEXT;
+}
 
-    EGLDisplay display = eglGetDisplay(EGL_DEFAULT_DISPLAY);
+/**
+ * Leave the outcome of the quality check where a test harness can read it:
+ * quality-check.result in the internal data directory, "passed" or "FAILED".
+ */
+static void engine_write_quality_result(struct engine* engine, bool passed) {
+    if (!engine->app->activity->internalDataPath) {
+        return;
+    }
+    std::string path = std::string(engine->app->activity->internalDataPath) + "/quality-check.result";
+    FILE* file = fopen(path.c_str(), "w");
+    if (!file) {
+        LogError("Unable to write %s", path.c_str());
+        return;
+    }
+    fputs(passed ? "passed\n" : "FAILED\n", file);
+    fclose(file);
+}
 
-    eglInitialize(display, 0, 0);
+/**
+ * Create a window surface and make it current. The context and the scene
+ * are kept across windows, so resuming only recreates the surface.
+ */
+static int engine_init_display(struct engine* engine) {
+    EGLint w, h, format;
+    EGLSurface surface;
 
-    /* Here, the application chooses the configuration it desires. In this
-     * sample, we have a very simplified selection process, where we pick
-     * the first EGLConfig that matches our criteria */
-    eglChooseConfig(display, attribs, &config, 1, &numConfigs);
+    bool coldStart = !engine->sc;
+    bool newContext = engine->context == EGL_NO_CONTEXT;
+    engine->resumeStart = nowMs();
+    engine->resumeKind = coldStart ? "cold start" : newContext ? "context lost" : "context kept";
+    if (engine_init_context(engine) != 0) {
+        return -1;
+    }
 
     /* EGL_NATIVE_VISUAL_ID is an attribute of the EGLConfig that is
      * guaranteed to be accepted by ANativeWindow_setBuffersGeometry().
      * As soon as we picked a EGLConfig, we can safely reconfigure the
      * ANativeWindow buffers to match, using EGL_NATIVE_VISUAL_ID. */
-    eglGetConfigAttrib(display, config, EGL_NATIVE_VISUAL_ID, &format);
+    eglGetConfigAttrib(engine->display, engine->config, EGL_NATIVE_VISUAL_ID, &format);
 
     ANativeWindow_setBuffersGeometry(engine->app->window, 0, 0, format);
 
-    surface = eglCreateWindowSurface(display, config, engine->app->window, NULL);
-    context = eglCreateContext(display, config, NULL, context_attrib_list);
+    surface = eglCreateWindowSurface(engine->display, engine->config, engine->app->window, NULL);
 
-    if (eglMakeCurrent(display, surface, surface, context) == EGL_FALSE) {
-        Log("Unable to eglMakeCurrent");
-        return -1;
+    if (eglMakeCurrent(engine->display, surface, surface, engine->context) == EGL_FALSE) {
+        if (eglGetError() != EGL_CONTEXT_LOST || !engine->sc) {
+            LogError("Unable to eglMakeCurrent");
+            eglDestroySurface(engine->display, surface);
+            return -1;
+        }
+        // e.g. a power event while paused; everything is rebuilt lazily
+        LogWarn("EGL context lost while the window was away");
+        engine_lose_context(engine);
+        engine->resumeKind = "context lost";
+        newContext = true;
+        if (engine_init_context(engine) != 0 ||
+                eglMakeCurrent(engine->display, surface, surface, engine->context) == EGL_FALSE) {
+            LogError("Unable to eglMakeCurrent");
+            eglDestroySurface(engine->display, surface);
+            return -1;
+        }
     }
 
-    eglQuerySurface(display, surface, EGL_WIDTH, &w);
-    eglQuerySurface(display, surface, EGL_HEIGHT, &h);
+    eglQuerySurface(engine->display, surface, EGL_WIDTH, &w);
+    eglQuerySurface(engine->display, surface, EGL_HEIGHT, &h);
 
-    engine->display = display;
-    engine->context = context;
     engine->surface = surface;
     engine->width = w;
     engine->height = h;
     engine->state.angle = 0;
-
-    engine->sc = new Scene(w,h);
-    p = engine->sc;
-    engine->sc->renderTextureToFbo();
+    engine->lastSwap = 0.0;
+
+    if (engine->sc) {
+        engine->sc->resize(w,h);
+    } else {
+#ifdef GLUTILS_TRACE
+        // a trace holds no initial state, so it starts before the scene makes anything
+        if (engine->app->activity->internalDataPath) {
+            std::string tracePath = std::string(engine->app->activity->internalDataPath) + "/session.gltr";
+            glTraceStart(tracePath.c_str(), w, h, TRACE_FRAMES);
+        }
+#endif
+        engine->sc = new Scene(w,h);
+        p = engine->sc;
+        engine->sc->setResultCache(engine->cache);
+    }
+    if (newContext) {
+        std::vector<ShaderVariant> variants;
+        if (ShaderVariantCache::loadVariantList("shaders/variants", variants))
+            engine->sc->getShaderCache()->precompile(engine->display, engine->config, engine->context, variants);
+    }
+    if (coldStart) {
+#ifdef QUALITY_CHECK
+        bool passed = runQualityCheck(engine->sc);
+        engine_write_quality_result(engine, passed);
+        if (!passed) {
+            // a regression must not look like a run that merely logged errors
+            LogError("Quality check FAILED, finishing the activity");
+            ANativeActivity_finish(engine->app->activity);
+        } else {
+            Log("Quality check passed");
+        }
+#endif
+#ifdef SCALE_BENCHMARKS
+        runBenchmarks(engine->sc, engine->app->activity->internalDataPath);
+#endif
+    }
     engine->animating = 1;
     return 0;
 }
@@ -139,35 +260,117 @@ static int engine_init_display(struct engine* engine) {
  * Just the current frame in the display.
  */
 static void engine_draw_frame(struct engine* engine) {
-    if (engine->display == NULL) {
+    if (engine->surface == EGL_NO_SURFACE) {
         // No display.
-    	Log("No Display");
+    	LogDebug("No Display");
         return;
     }
 
+    // the scene goes to the offscreen target at the scale the frame times
+    // allow, then is stretched over the surface; the display is rebuilt
+    // first, which would bind the window instead of the target
+    engine->sc->ensureDisplay();
+    bool scaled = engine->resolution && engine->resolution->begin(engine->width, engine->height);
     engine->sc->draw();
-    eglSwapBuffers(engine->display, engine->surface);
+    if (scaled) {
+        engine->resolution->end(engine->sc->getShaderCache()->getProgram("shaders/vertexShader", "shaders/fragmentShader"));
+    }
+    if (eglSwapBuffers(engine->display, engine->surface) == EGL_FALSE) {
+        if (eglGetError() == EGL_CONTEXT_LOST) {
+            LogWarn("EGL context lost");
+            eglMakeCurrent(engine->display, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+            eglDestroySurface(engine->display, engine->surface);
+            engine->surface = EGL_NO_SURFACE;
+            engine_lose_context(engine);
+            engine_init_display(engine);
+        }
+        return;
+    }
+    glTraceFrame();
+    double now = nowMs();
+    if (engine->resolution && engine->lastSwap > 0.0) {
+        engine->resolution->addFrameTime(now - engine->lastSwap);
+    }
+    engine->lastSwap = now;
+    if (engine->resumeStart > 0.0) {
+        Log("First frame %.1f ms after the window was shown (%s)", nowMs() - engine->resumeStart, engine->resumeKind);
+        engine->resumeStart = 0.0;
+    }
 }
 
 /**
- * Tear down the EGL context currently associated with the display.
+ * Release the window surface. The context and the scene stay for the next window.
  */
 static void engine_term_display(struct engine* engine) {
     if (engine->display != EGL_NO_DISPLAY) {
-    	delete engine->sc;
         eglMakeCurrent(engine->display, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
-        if (engine->context != EGL_NO_CONTEXT) {
-            eglDestroyContext(engine->display, engine->context);
-        }
         if (engine->surface != EGL_NO_SURFACE) {
             eglDestroySurface(engine->display, engine->surface);
         }
-        eglTerminate(engine->display);
     }
     engine->animating = 0;
+    engine->surface = EGL_NO_SURFACE;
+    if (engine->resolution) {
+        Log("Dynamic resolution: scale %.2f, %u changes", engine->resolution->getScale(), engine->resolution->getChangeCount());
+    }
+}
+
+/**
+ * Make the context current to delete objects in it once the window surface
+ * is gone: with no surface where EGL_KHR_surfaceless_context allows, else on
+ * a 1x1 pbuffer returned in *pbuffer for the caller to destroy.
+ */
+static bool engine_make_current_without_window(struct engine* engine, EGLSurface* pbuffer) {
+    *pbuffer = EGL_NO_SURFACE;
+    const char* extensions = eglQueryString(engine->display, EGL_EXTENSIONS);
+    if (extensions && strstr(extensions, "EGL_KHR_surfaceless_context") &&
+            eglMakeCurrent(engine->display, EGL_NO_SURFACE, EGL_NO_SURFACE, engine->context)) {
+        return true;
+    }
+    const EGLint attribs[] = { EGL_WIDTH, 1, EGL_HEIGHT, 1, EGL_NONE };
+    *pbuffer = eglCreatePbufferSurface(engine->display, engine->config, attribs);
+    if (*pbuffer != EGL_NO_SURFACE &&
+            eglMakeCurrent(engine->display, *pbuffer, *pbuffer, engine->context)) {
+        return true;
+    }
+    return false;
+}
+
+/**
+ * Tear down the scene and the EGL context. The scene's objects are deleted
+ * while the context is still current, so what GpuMemory records as freed is
+ * freed.
+ */
+static void engine_term_context(struct engine* engine) {
+    glTraceStop();
+    EGLSurface pbuffer = EGL_NO_SURFACE;
+    if (engine->display != EGL_NO_DISPLAY && engine->sc) {
+        if (engine->context != EGL_NO_CONTEXT && engine->surface == EGL_NO_SURFACE &&
+                !engine_make_current_without_window(engine, &pbuffer)) {
+            LogWarn("Unable to make the context current, its objects go with it");
+        }
+        engine->sc->getShaderCache()->waitForPrecompile();
+        engine->sc->getShaderCache()->logStats("shader variants");
+        if (engine->resolution) {
+            engine->resolution->releaseGlResources();
+        }
+        gpuMemoryLogReport("gpu memory");
+        delete engine->sc;
+        engine->sc = NULL;
+        p = NULL;
+    }
+    engine_term_display(engine);
+    if (engine->display != EGL_NO_DISPLAY) {
+        if (pbuffer != EGL_NO_SURFACE) {
+            eglDestroySurface(engine->display, pbuffer);
+        }
+        if (engine->context != EGL_NO_CONTEXT) {
+            eglDestroyContext(engine->display, engine->context);
+        }
+        eglTerminate(engine->display);
+    }
     engine->display = EGL_NO_DISPLAY;
     engine->context = EGL_NO_CONTEXT;
-    engine->surface = EGL_NO_SURFACE;
 }
 
 /**
@@ -221,6 +424,10 @@ static void engine_handle_cmd(struct android_app* app, int32_t cmd) {
             // The window is being hidden or closed, clean it up.
             engine_term_display(engine);
             break;
+        case APP_CMD_LOW_MEMORY:
+            // what is holding GPU memory when the system runs short
+            gpuMemoryLogReport("gpu memory, low memory warning");
+            break;
         case APP_CMD_GAINED_FOCUS:
 
             break;
@@ -229,6 +436,8 @@ static void engine_handle_cmd(struct android_app* app, int32_t cmd) {
             // Also stop animating.
             engine->animating = 0;
             engine_draw_frame(engine);
+            // the idle time until the next frame is no frame time
+            engine->lastSwap = 0.0;
             break;
     }
 }
@@ -250,6 +459,17 @@ void android_main(struct android_app* state) {
     state->onInputEvent = engine_handle_input;
     engine.app = state;
     SetAssetManager(engine.app->activity->assetManager);
+    // Scaled results outlive the GL context; spilled entries persist across runs.
+    // internalDataPath is NULL on some 2.3 devices, the cache is memory only there.
+    if (state->activity->internalDataPath) {
+        std::string cacheDirectory = std::string(state->activity->internalDataPath) + "/scale-cache";
+        engine.cache = new ScaleCache(32 << 20, cacheDirectory.c_str(), 128 << 20);
+    } else {
+        engine.cache = new ScaleCache(32 << 20);
+    }
+#ifdef DYNAMIC_RESOLUTION
+    engine.resolution = new DynamicResolution(FRAME_TARGET_MS);
+#endif
     // Prepare to monitor accelerometer
 
     if (state->savedState != NULL) {
@@ -278,7 +498,10 @@ void android_main(struct android_app* state) {
 
             // Check if we are exiting.
             if (state->destroyRequested != 0) {
-                engine_term_display(&engine);
+                engine_term_context(&engine);
+                delete engine.cache;
+                delete engine.resolution;
+                logShutdown();
                 return;
             }
         }
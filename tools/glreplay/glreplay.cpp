@@ -0,0 +1,522 @@
+/*
+ * glreplay.cpp
+ *
+ *  Created on: 19-10-2026
+ */
+
+/*
+ * Re-executes a trace captured by a GLUTILS_TRACE build (GlTrace.h) on a
+ * headless EGL context, Mesa's surfaceless platform when there is no
+ * display, and reports the time of every kind of call and of every frame.
+ * Payloads are decompressed before the clock starts.
+ *
+ * glreplay [-n runs] [-f] [-c] trace.gltr
+ *   -n  replays the trace runs times, each on a fresh context (default 1)
+ *   -f  glFinish after every call, so GPU work is charged to the call issuing it
+ *   -c  glGetError after every call and prints the calls that fail
+ *
+ * External (GL_TEXTURE_EXTERNAL_OES) textures replay as empty 2D textures.
+ */
+
+#include "GlTrace.h"
+#include <EGL/egl.h>
+#include <EGL/eglext.h>
+#include <GLES2/gl2.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <zlib.h>
+#include <algorithm>
+#include <map>
+#include <string>
+#include <utility>
+#include <vector>
+
+#ifndef GL_TEXTURE_EXTERNAL_OES
+#define GL_TEXTURE_EXTERNAL_OES 0x8D65
+#endif
+
+#define OP_NAME(name) #name,
+static const char* opNames[] = { "None", GLTRACE_OPS(OP_NAME) };
+#undef OP_NAME
+
+struct Record {
+	int op;
+	uint32_t timeUs;
+	uint32_t durationNs;
+	std::vector<GLuint> words;
+	bool hasPayload;
+	std::vector<GLubyte> payload;
+};
+
+struct Trace {
+	GLuint width,height;
+	std::vector<Record> records;
+	size_t payloadBytes,storedBytes;
+	unsigned int frames;
+};
+
+struct OpStats {
+	unsigned int count;
+	double replayMs;
+	double maxMs;
+	double deviceMs;
+};
+
+// Names and locations as captured on the device, mapped to this context's
+struct ReplayState {
+	std::map<GLuint,GLuint> textures,buffers,framebuffers,renderbuffers,programs,shaders;
+	std::map<std::pair<GLuint,GLint>,GLint> locations;
+	GLuint program;
+	GLuint arrayBuffer;
+	std::vector<GLubyte> clientArrays[GLTRACE_MAX_ATTRIBS];
+	std::vector<GLubyte> readback;
+};
+
+static double nowMs() {
+	struct timespec now;
+	clock_gettime(CLOCK_MONOTONIC,&now);
+	return now.tv_sec * 1000.0 + now.tv_nsec / 1000000.0;
+}
+
+static std::string opName(int op) {
+	if(op <= 0 || op >= GLTRACE_OP_COUNT)
+		return "unknown";
+	return op >= GLTRACE_OP_ActiveTexture ? std::string("gl") + opNames[op] : opNames[op];
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+// Loading
+
+static bool readBytes(FILE* file,void* data,size_t size) {
+	return fread(data,1,size,file) == size;
+}
+
+static bool loadTrace(const char* path,Trace& trace) {
+	FILE* file = fopen(path,"rb");
+	if(!file) {
+		fprintf(stderr,"glreplay: cannot open %s\n",path);
+		return false;
+	}
+	char magic[4];
+	uint32_t header[3];
+	if(!readBytes(file,magic,4) || memcmp(magic,GLTRACE_MAGIC,4) || !readBytes(file,header,sizeof(header))) {
+		fprintf(stderr,"glreplay: %s is not a GL trace\n",path);
+		fclose(file);
+		return false;
+	}
+	if(header[0] != GLTRACE_VERSION) {
+		fprintf(stderr,"glreplay: %s is version %u, this build reads %u\n",path,header[0],GLTRACE_VERSION);
+		fclose(file);
+		return false;
+	}
+	trace.width = header[1];
+	trace.height = header[2];
+	trace.payloadBytes = trace.storedBytes = 0;
+	trace.frames = 0;
+
+	std::vector<GLubyte> stored;
+	for(;;) {
+		uint16_t op;
+		uint8_t counts[2];
+		uint32_t times[2];
+		if(!readBytes(file,&op,sizeof(op)))
+			break;
+		Record record;
+		if(!readBytes(file,counts,2) || !readBytes(file,times,sizeof(times))) {
+			fprintf(stderr,"glreplay: truncated record %u\n",(unsigned int)trace.records.size());
+			break;
+		}
+		record.op = op;
+		record.timeUs = times[0];
+		record.durationNs = times[1];
+		record.words.resize(counts[0]);
+		record.hasPayload = counts[1] != 0;
+		if(counts[0] && !readBytes(file,&record.words[0],counts[0] * sizeof(GLuint)))
+			break;
+		if(record.hasPayload) {
+			uint32_t sizes[2];
+			if(!readBytes(file,sizes,sizeof(sizes)))
+				break;
+			record.payload.resize(sizes[0]);
+			stored.resize(sizes[1]);
+			if(sizes[1] && !readBytes(file,&stored[0],sizes[1]))
+				break;
+			if(sizes[0] == sizes[1]) {
+				if(sizes[0])
+					memcpy(&record.payload[0],&stored[0],sizes[0]);
+			}
+			else {
+				uLongf length = sizes[0];
+				if(uncompress(&record.payload[0],&length,&stored[0],sizes[1]) != Z_OK || length != sizes[0]) {
+					fprintf(stderr,"glreplay: corrupt payload in record %u\n",(unsigned int)trace.records.size());
+					fclose(file);
+					return false;
+				}
+			}
+			trace.payloadBytes += sizes[0];
+			trace.storedBytes += sizes[1];
+		}
+		if(record.op == GLTRACE_OP_Frame)
+			trace.frames++;
+		trace.records.push_back(record);
+	}
+	fclose(file);
+	return true;
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+// Context
+
+struct Context {
+	EGLDisplay display;
+	EGLSurface surface;
+	EGLContext context;
+};
+
+static EGLDisplay openDisplay() {
+	EGLDisplay display = eglGetDisplay(EGL_DEFAULT_DISPLAY);
+	if(display != EGL_NO_DISPLAY && eglInitialize(display,NULL,NULL))
+		return display;
+	// no window system: Mesa renders without one
+	const char* extensions = eglQueryString(EGL_NO_DISPLAY,EGL_EXTENSIONS);
+	PFNEGLGETPLATFORMDISPLAYEXTPROC getPlatformDisplay =
+			(PFNEGLGETPLATFORMDISPLAYEXTPROC)eglGetProcAddress("eglGetPlatformDisplayEXT");
+	if(!extensions || !strstr(extensions,"EGL_MESA_platform_surfaceless") || !getPlatformDisplay)
+		return EGL_NO_DISPLAY;
+	display = getPlatformDisplay(EGL_PLATFORM_SURFACELESS_MESA,EGL_DEFAULT_DISPLAY,NULL);
+	if(display == EGL_NO_DISPLAY || !eglInitialize(display,NULL,NULL))
+		return EGL_NO_DISPLAY;
+	return display;
+}
+
+static bool createContext(Context& ctx,GLuint width,GLuint height) {
+	const EGLint configAttribs[] = {
+			EGL_SURFACE_TYPE, EGL_PBUFFER_BIT,
+			EGL_RENDERABLE_TYPE, EGL_OPENGL_ES2_BIT,
+			EGL_RED_SIZE, 8, EGL_GREEN_SIZE, 8, EGL_BLUE_SIZE, 8,
+			EGL_NONE };
+	const EGLint surfaceAttribs[] = { EGL_WIDTH, (EGLint)std::max(width,1u), EGL_HEIGHT, (EGLint)std::max(height,1u), EGL_NONE };
+	const EGLint contextAttribs[] = { EGL_CONTEXT_CLIENT_VERSION, 2, EGL_NONE };
+	EGLConfig config;
+	EGLint count = 0;
+	if(!eglChooseConfig(ctx.display,configAttribs,&config,1,&count) || !count) {
+		fprintf(stderr,"glreplay: no GLES2 pbuffer config\n");
+		return false;
+	}
+	eglBindAPI(EGL_OPENGL_ES_API);
+	ctx.surface = eglCreatePbufferSurface(ctx.display,config,surfaceAttribs);
+	ctx.context = eglCreateContext(ctx.display,config,EGL_NO_CONTEXT,contextAttribs);
+	if(ctx.surface == EGL_NO_SURFACE || ctx.context == EGL_NO_CONTEXT ||
+			!eglMakeCurrent(ctx.display,ctx.surface,ctx.surface,ctx.context)) {
+		fprintf(stderr,"glreplay: cannot create the context (0x%x)\n",eglGetError());
+		return false;
+	}
+	return true;
+}
+
+static void destroyContext(Context& ctx) {
+	eglMakeCurrent(ctx.display,EGL_NO_SURFACE,EGL_NO_SURFACE,EGL_NO_CONTEXT);
+	if(ctx.context != EGL_NO_CONTEXT)
+		eglDestroyContext(ctx.display,ctx.context);
+	if(ctx.surface != EGL_NO_SURFACE)
+		eglDestroySurface(ctx.display,ctx.surface);
+	ctx.context = EGL_NO_CONTEXT;
+	ctx.surface = EGL_NO_SURFACE;
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+// Replay
+
+static GLuint mapName(const std::map<GLuint,GLuint>& names,GLuint name) {
+	std::map<GLuint,GLuint>::const_iterator it = names.find(name);
+	return it == names.end() ? name : it->second;
+}
+
+static GLint mapLocation(const ReplayState& state,GLuint location) {
+	if((GLint)location < 0)
+		return location;
+	std::map<std::pair<GLuint,GLint>,GLint>::const_iterator it = state.locations.find(std::make_pair(state.program,(GLint)location));
+	return it == state.locations.end() ? (GLint)location : it->second;
+}
+
+static GLenum mapTarget(GLenum target) {
+	return target == GL_TEXTURE_EXTERNAL_OES ? GL_TEXTURE_2D : target;
+}
+
+static float wordFloat(GLuint word) {
+	float value;
+	memcpy(&value,&word,sizeof(value));
+	return value;
+}
+
+typedef void (GL_APIENTRY *GenFunc)(GLsizei n,GLuint* names);
+typedef void (GL_APIENTRY *DeleteFunc)(GLsizei n,const GLuint* names);
+
+static void genNames(const Record& r,std::map<GLuint,GLuint>& names,GenFunc gen) {
+	for(unsigned int i=0;i<r.words.size();i++) {
+		GLuint name = 0;
+		gen(1,&name);
+		names[r.words[i]] = name;
+	}
+}
+
+static void deleteNames(const Record& r,std::map<GLuint,GLuint>& names,DeleteFunc del) {
+	for(unsigned int i=0;i<r.words.size();i++) {
+		GLuint name = mapName(names,r.words[i]);
+		del(1,&name);
+		names.erase(r.words[i]);
+	}
+}
+
+static void execute(const Record& r,ReplayState& s) {
+	const GLuint* w = r.words.empty() ? NULL : &r.words[0];
+	const GLvoid* p = r.hasPayload && !r.payload.empty() ? &r.payload[0] : NULL;
+	switch(r.op) {
+		case GLTRACE_OP_ClientArray:
+			if(w[0] < GLTRACE_MAX_ATTRIBS) {
+				s.clientArrays[w[0]] = r.payload;
+				glBindBuffer(GL_ARRAY_BUFFER,0);
+				glVertexAttribPointer(w[0],w[1],w[2],w[3],w[4],s.clientArrays[w[0]].empty() ? NULL : &s.clientArrays[w[0]][0]);
+				glBindBuffer(GL_ARRAY_BUFFER,s.arrayBuffer);
+			}
+			break;
+		case GLTRACE_OP_ActiveTexture:			glActiveTexture(w[0]); break;
+		case GLTRACE_OP_AttachShader:			glAttachShader(mapName(s.programs,w[0]),mapName(s.shaders,w[1])); break;
+		case GLTRACE_OP_BindAttribLocation:		glBindAttribLocation(mapName(s.programs,w[0]),w[1],(const GLchar*)p); break;
+		case GLTRACE_OP_BindBuffer:
+			glBindBuffer(w[0],mapName(s.buffers,w[1]));
+			if(w[0] == GL_ARRAY_BUFFER)
+				s.arrayBuffer = mapName(s.buffers,w[1]);
+			break;
+		case GLTRACE_OP_BindFramebuffer:		glBindFramebuffer(w[0],mapName(s.framebuffers,w[1])); break;
+		case GLTRACE_OP_BindRenderbuffer:		glBindRenderbuffer(w[0],mapName(s.renderbuffers,w[1])); break;
+		case GLTRACE_OP_BindTexture:			glBindTexture(mapTarget(w[0]),mapName(s.textures,w[1])); break;
+		case GLTRACE_OP_BlendFunc:				glBlendFunc(w[0],w[1]); break;
+		case GLTRACE_OP_BufferData:				glBufferData(w[0],w[1],p,w[2]); break;
+		case GLTRACE_OP_BufferSubData:			glBufferSubData(w[0],w[1],w[2],p); break;
+		case GLTRACE_OP_CheckFramebufferStatus:	glCheckFramebufferStatus(w[0]); break;
+		case GLTRACE_OP_Clear:					glClear(w[0]); break;
+		case GLTRACE_OP_ClearColor:				glClearColor(wordFloat(w[0]),wordFloat(w[1]),wordFloat(w[2]),wordFloat(w[3])); break;
+		case GLTRACE_OP_CompileShader:			glCompileShader(mapName(s.shaders,w[0])); break;
+		case GLTRACE_OP_CompressedTexImage2D:
+			glCompressedTexImage2D(mapTarget(w[0]),w[1],w[2],w[3],w[4],w[5],r.payload.size(),p);
+			break;
+		case GLTRACE_OP_CreateProgram:			s.programs[w[0]] = glCreateProgram(); break;
+		case GLTRACE_OP_CreateShader:			s.shaders[w[1]] = glCreateShader(w[0]); break;
+		case GLTRACE_OP_DeleteBuffers:			deleteNames(r,s.buffers,glDeleteBuffers); break;
+		case GLTRACE_OP_DeleteFramebuffers:		deleteNames(r,s.framebuffers,glDeleteFramebuffers); break;
+		case GLTRACE_OP_DeleteProgram:
+			glDeleteProgram(mapName(s.programs,w[0]));
+			s.programs.erase(w[0]);
+			break;
+		case GLTRACE_OP_DeleteRenderbuffers:	deleteNames(r,s.renderbuffers,glDeleteRenderbuffers); break;
+		case GLTRACE_OP_DeleteShader:
+			glDeleteShader(mapName(s.shaders,w[0]));
+			s.shaders.erase(w[0]);
+			break;
+		case GLTRACE_OP_DeleteTextures:			deleteNames(r,s.textures,glDeleteTextures); break;
+		case GLTRACE_OP_Disable:				glDisable(w[0]); break;
+		case GLTRACE_OP_DisableVertexAttribArray:	glDisableVertexAttribArray(w[0]); break;
+		case GLTRACE_OP_DrawArrays:				glDrawArrays(w[0],w[1],w[2]); break;
+		case GLTRACE_OP_DrawElements:			glDrawElements(w[0],w[1],w[2],p ? p : (const GLvoid*)(size_t)w[3]); break;
+		case GLTRACE_OP_Enable:					glEnable(w[0]); break;
+		case GLTRACE_OP_EnableVertexAttribArray:	glEnableVertexAttribArray(w[0]); break;
+		case GLTRACE_OP_Finish:					glFinish(); break;
+		case GLTRACE_OP_Flush:					glFlush(); break;
+		case GLTRACE_OP_FramebufferRenderbuffer:
+			glFramebufferRenderbuffer(w[0],w[1],w[2],mapName(s.renderbuffers,w[3]));
+			break;
+		case GLTRACE_OP_FramebufferTexture2D:
+			glFramebufferTexture2D(w[0],w[1],mapTarget(w[2]),mapName(s.textures,w[3]),w[4]);
+			break;
+		case GLTRACE_OP_GenBuffers:				genNames(r,s.buffers,glGenBuffers); break;
+		case GLTRACE_OP_GenFramebuffers:		genNames(r,s.framebuffers,glGenFramebuffers); break;
+		case GLTRACE_OP_GenRenderbuffers:		genNames(r,s.renderbuffers,glGenRenderbuffers); break;
+		case GLTRACE_OP_GenTextures:			genNames(r,s.textures,glGenTextures); break;
+		case GLTRACE_OP_GetUniformLocation:
+			s.locations[std::make_pair(w[0],(GLint)w[1])] = glGetUniformLocation(mapName(s.programs,w[0]),(const GLchar*)p);
+			break;
+		case GLTRACE_OP_LinkProgram:			glLinkProgram(mapName(s.programs,w[0])); break;
+		case GLTRACE_OP_PixelStorei:			glPixelStorei(w[0],w[1]); break;
+		case GLTRACE_OP_ReadPixels:
+			// 4 bytes a pixel and a pack alignment of rows cover every format
+			s.readback.resize(((size_t)w[2] * 4 + 8) * w[3]);
+			glReadPixels(w[0],w[1],w[2],w[3],w[4],w[5],&s.readback[0]);
+			break;
+		case GLTRACE_OP_RenderbufferStorage:	glRenderbufferStorage(w[0],w[1],w[2],w[3]); break;
+		case GLTRACE_OP_Scissor:				glScissor(w[0],w[1],w[2],w[3]); break;
+		case GLTRACE_OP_ShaderSource: {
+			const GLchar* source = (const GLchar*)p;
+			glShaderSource(mapName(s.shaders,w[0]),1,&source,NULL);
+			break;
+		}
+		case GLTRACE_OP_TexImage2D:
+			glPixelStorei(GL_UNPACK_ALIGNMENT,w[8]);
+			glTexImage2D(mapTarget(w[0]),w[1],w[2],w[3],w[4],w[5],w[6],w[7],p);
+			break;
+		case GLTRACE_OP_TexParameteri:			glTexParameteri(mapTarget(w[0]),w[1],w[2]); break;
+		case GLTRACE_OP_TexSubImage2D:
+			glPixelStorei(GL_UNPACK_ALIGNMENT,w[8]);
+			glTexSubImage2D(mapTarget(w[0]),w[1],w[2],w[3],w[4],w[5],w[6],w[7],p);
+			break;
+		case GLTRACE_OP_Uniform1i:				glUniform1i(mapLocation(s,w[0]),w[1]); break;
+		case GLTRACE_OP_Uniform2f:				glUniform2f(mapLocation(s,w[0]),wordFloat(w[1]),wordFloat(w[2])); break;
+		case GLTRACE_OP_Uniform1fv:				glUniform1fv(mapLocation(s,w[0]),w[1],(const GLfloat*)p); break;
+		case GLTRACE_OP_Uniform2fv:				glUniform2fv(mapLocation(s,w[0]),w[1],(const GLfloat*)p); break;
+		case GLTRACE_OP_Uniform3fv:				glUniform3fv(mapLocation(s,w[0]),w[1],(const GLfloat*)p); break;
+		case GLTRACE_OP_Uniform4fv:				glUniform4fv(mapLocation(s,w[0]),w[1],(const GLfloat*)p); break;
+		case GLTRACE_OP_Uniform1iv:				glUniform1iv(mapLocation(s,w[0]),w[1],(const GLint*)p); break;
+		case GLTRACE_OP_Uniform2iv:				glUniform2iv(mapLocation(s,w[0]),w[1],(const GLint*)p); break;
+		case GLTRACE_OP_Uniform3iv:				glUniform3iv(mapLocation(s,w[0]),w[1],(const GLint*)p); break;
+		case GLTRACE_OP_Uniform4iv:				glUniform4iv(mapLocation(s,w[0]),w[1],(const GLint*)p); break;
+		case GLTRACE_OP_UniformMatrix2fv:		glUniformMatrix2fv(mapLocation(s,w[0]),w[1],w[2],(const GLfloat*)p); break;
+		case GLTRACE_OP_UniformMatrix3fv:		glUniformMatrix3fv(mapLocation(s,w[0]),w[1],w[2],(const GLfloat*)p); break;
+		case GLTRACE_OP_UniformMatrix4fv:		glUniformMatrix4fv(mapLocation(s,w[0]),w[1],w[2],(const GLfloat*)p); break;
+		case GLTRACE_OP_UseProgram:
+			s.program = w[0];
+			glUseProgram(mapName(s.programs,w[0]));
+			break;
+		case GLTRACE_OP_VertexAttribPointer:
+			glVertexAttribPointer(w[0],w[1],w[2],w[3],w[4],(const GLvoid*)(size_t)w[5]);
+			break;
+		case GLTRACE_OP_Viewport:				glViewport(w[0],w[1],w[2],w[3]); break;
+		default:
+			break;
+	}
+}
+
+static double percentile(std::vector<double> samples,double p) {
+	if(samples.empty())
+		return 0.0;
+	std::sort(samples.begin(),samples.end());
+	size_t rank = (size_t)(p / 100.0 * samples.size() + 0.999999);
+	return samples[std::min(std::max(rank,(size_t)1),samples.size()) - 1];
+}
+
+static void logFrames(const char* name,const std::vector<double>& frames) {
+	if(frames.empty())
+		return;
+	double sum = 0.0;
+	for(unsigned int i=0;i<frames.size();i++)
+		sum += frames[i];
+	printf("%s: %u frames, mean %.3f ms, p50 %.3f, p90 %.3f, p99 %.3f, max %.3f\n",name,(unsigned int)frames.size(),
+			sum / frames.size(),percentile(frames,50),percentile(frames,90),percentile(frames,99),percentile(frames,100));
+}
+
+struct ByReplayTime {
+	const std::vector<OpStats>* stats;
+	bool operator()(int a,int b) const { return (*stats)[a].replayMs > (*stats)[b].replayMs; }
+};
+
+static void usage() {
+	fprintf(stderr,"usage: glreplay [-n runs] [-f] [-c] trace.gltr\n");
+}
+
+int main(int argc,char** argv) {
+	int runs = 1;
+	bool finishEach = false, checkErrors = false;
+	const char* path = NULL;
+	for(int i=1;i<argc;i++) {
+		if(!strcmp(argv[i],"-n") && i + 1 < argc)
+			runs = std::max(1,atoi(argv[++i]));
+		else if(!strcmp(argv[i],"-f"))
+			finishEach = true;
+		else if(!strcmp(argv[i],"-c"))
+			checkErrors = true;
+		else if(argv[i][0] != '-' && !path)
+			path = argv[i];
+		else {
+			usage();
+			return 2;
+		}
+	}
+	if(!path) {
+		usage();
+		return 2;
+	}
+
+	Trace trace;
+	if(!loadTrace(path,trace))
+		return 1;
+	printf("%s: %ux%u, %u calls, %u frames, payloads %.2f MB stored in %.2f MB\n",path,trace.width,trace.height,
+			(unsigned int)trace.records.size(),trace.frames,trace.payloadBytes / 1048576.0,trace.storedBytes / 1048576.0);
+
+	Context ctx;
+	ctx.display = openDisplay();
+	ctx.surface = EGL_NO_SURFACE;
+	ctx.context = EGL_NO_CONTEXT;
+	if(ctx.display == EGL_NO_DISPLAY) {
+		fprintf(stderr,"glreplay: no EGL display\n");
+		return 1;
+	}
+
+	OpStats zero = { 0, 0.0, 0.0, 0.0 };
+	std::vector<OpStats> stats(GLTRACE_OP_COUNT,zero);
+	std::vector<double> allFrames;
+	unsigned int errors = 0;
+	for(int run=0;run<runs;run++) {
+		if(!createContext(ctx,trace.width,trace.height))
+			return 1;
+		if(run == 0)
+			printf("renderer: %s, %s\n",glGetString(GL_RENDERER),glGetString(GL_VERSION));
+		ReplayState state;
+		state.program = 0;
+		state.arrayBuffer = 0;
+		std::vector<double> frames;
+		double frameMs = 0.0, runStart = nowMs();
+		for(unsigned int i=0;i<trace.records.size();i++) {
+			const Record& r = trace.records[i];
+			if(r.op == GLTRACE_OP_Frame) {
+				frames.push_back(frameMs);
+				frameMs = 0.0;
+				continue;
+			}
+			double start = nowMs();
+			execute(r,state);
+			if(finishEach)
+				glFinish();
+			double ms = nowMs() - start;
+			frameMs += ms;
+			if(r.op > 0 && r.op < GLTRACE_OP_COUNT) {
+				OpStats& op = stats[r.op];
+				op.count++;
+				op.replayMs += ms;
+				op.maxMs = std::max(op.maxMs,ms);
+				op.deviceMs += r.durationNs / 1e6;
+			}
+			if(checkErrors) {
+				GLenum error = glGetError();
+				if(error != GL_NO_ERROR && errors++ < 50)
+					fprintf(stderr,"call %u %s: GL error 0x%x\n",i,opName(r.op).c_str(),error);
+			}
+		}
+		glFinish();
+		printf("run %d: %.2f ms\n",run + 1,nowMs() - runStart);
+		logFrames("  frames",frames);
+		allFrames.insert(allFrames.end(),frames.begin(),frames.end());
+		destroyContext(ctx);
+	}
+	if(runs > 1)
+		logFrames("all runs",allFrames);
+
+	std::vector<int> order;
+	for(int op=1;op<GLTRACE_OP_COUNT;op++) {
+		if(stats[op].count)
+			order.push_back(op);
+	}
+	ByReplayTime byTime = { &stats };
+	std::sort(order.begin(),order.end(),byTime);
+	// counts and totals per run, the device time as captured
+	printf("%-28s %8s %12s %10s %10s %12s\n","call","count","replay ms","mean us","max us","device ms");
+	for(unsigned int i=0;i<order.size();i++) {
+		const OpStats& op = stats[order[i]];
+		printf("%-28s %8u %12.3f %10.2f %10.2f %12.3f\n",opName(order[i]).c_str(),op.count / runs,op.replayMs / runs,
+				op.replayMs * 1000.0 / op.count,op.maxMs * 1000.0,op.deviceMs / runs);
+	}
+	if(checkErrors)
+		printf("%u GL errors\n",errors);
+	eglTerminate(ctx.display);
+	return 0;
+}
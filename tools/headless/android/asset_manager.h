@@ -0,0 +1,37 @@
+/*
+ * asset_manager.h
+ *
+ *  Created on: 19-10-2026
+ */
+
+#ifndef HOST_ANDROID_ASSET_MANAGER_H_
+#define HOST_ANDROID_ASSET_MANAGER_H_
+
+/*
+ * Host stand-in for the NDK's <android/asset_manager.h>, enough for
+ * file.cpp: assets are the files under the directory a manager was opened
+ * on, see hostOpenAssetManager.
+ */
+#include <sys/types.h>
+#include <stddef.h>
+
+typedef struct AAssetManager AAssetManager;
+typedef struct AAsset AAsset;
+
+enum {
+	AASSET_MODE_UNKNOWN = 0,
+	AASSET_MODE_RANDOM,
+	AASSET_MODE_STREAMING,
+	AASSET_MODE_BUFFER
+};
+
+AAsset* AAssetManager_open(AAssetManager* manager,const char* fileName,int mode);
+off_t AAsset_getLength(AAsset* asset);
+int AAsset_read(AAsset* asset,void* buffer,size_t count);
+void AAsset_close(AAsset* asset);
+
+// The assets under directory; NULL when it cannot be opened
+AAssetManager* hostOpenAssetManager(const char* directory);
+void hostCloseAssetManager(AAssetManager* manager);
+
+#endif /* HOST_ANDROID_ASSET_MANAGER_H_ */
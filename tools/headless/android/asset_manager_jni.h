@@ -0,0 +1,13 @@
+/*
+ * asset_manager_jni.h
+ *
+ *  Created on: 19-10-2026
+ */
+
+#ifndef HOST_ANDROID_ASSET_MANAGER_JNI_H_
+#define HOST_ANDROID_ASSET_MANAGER_JNI_H_
+
+// Host stand-in: there is no Java side to take a manager from
+#include "asset_manager.h"
+
+#endif /* HOST_ANDROID_ASSET_MANAGER_JNI_H_ */
@@ -0,0 +1,43 @@
+/*
+ * log.h
+ *
+ *  Created on: 19-10-2026
+ */
+
+#ifndef HOST_ANDROID_LOG_H_
+#define HOST_ANDROID_LOG_H_
+
+/*
+ * Host stand-in for the NDK's <android/log.h>, enough for AsyncLog.cpp:
+ * messages go to stderr with their priority.
+ */
+#include <stdio.h>
+#include <stdarg.h>
+
+enum android_LogPriority {
+	ANDROID_LOG_UNKNOWN = 0,
+	ANDROID_LOG_DEFAULT,
+	ANDROID_LOG_VERBOSE,
+	ANDROID_LOG_DEBUG,
+	ANDROID_LOG_INFO,
+	ANDROID_LOG_WARN,
+	ANDROID_LOG_ERROR,
+	ANDROID_LOG_FATAL,
+	ANDROID_LOG_SILENT
+};
+
+static inline int __android_log_write(int priority,const char* tag,const char* message) {
+	static const char levels[] = "??VDIWEFS";
+	return fprintf(stderr,"%c/%s: %s\n",levels[priority >= 0 && priority <= ANDROID_LOG_SILENT ? priority : 0],tag,message);
+}
+
+static inline int __android_log_print(int priority,const char* tag,const char* format,...) {
+	char message[1024];
+	va_list args;
+	va_start(args,format);
+	vsnprintf(message,sizeof(message),format,args);
+	va_end(args);
+	return __android_log_write(priority,tag,message);
+}
+
+#endif /* HOST_ANDROID_LOG_H_ */
@@ -0,0 +1,212 @@
+/*
+ * headless.cpp
+ *
+ *  Created on: 19-10-2026
+ */
+
+/*
+ * Runs the scale-buffer checks on a headless EGL context, Mesa's
+ * surfaceless platform when there is no display, so they can gate a
+ * desktop or CI build without a device. glutils and the scene build
+ * unchanged; the stand-ins under android/ send the log to stderr and read
+ * the assets from a directory.
+ *
+ * headless [-a assets] quality|dynamic-resolution
+ *   quality             runQualityCheck (QualityCheck.h) against
+ *                       assets/quality/thresholds
+ *   dynamic-resolution  benchmarkDynamicResolution (Benchmarks.h): frame time
+ *                       percentiles under an artificial GPU load, controller
+ *                       off and on
+ *   -a                  the assets directory (default: assets, as run from
+ *                       scale-buffer)
+ *
+ * Exits with 0 when the check passes or the benchmark ran, 1 when the check
+ * fails and 2 when nothing can run.
+ */
+
+#include "Scene.h"
+#include "QualityCheck.h"
+#include "Benchmarks.h"
+#include "AsyncLog.h"
+#include "file.h"
+#include <EGL/egl.h>
+#include <EGL/eglext.h>
+#include <GLES2/gl2.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <string>
+
+#define SURFACE_SIZE 256
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+// Assets
+
+struct AAssetManager {
+	std::string directory;
+};
+
+struct AAsset {
+	FILE* file;
+	off_t length;
+};
+
+AAssetManager* hostOpenAssetManager(const char* directory) {
+	FILE* check = fopen((std::string(directory) + "/shaders/vertexShader").c_str(),"rb");
+	if(!check)
+		return NULL;
+	fclose(check);
+	AAssetManager* manager = new AAssetManager;
+	manager->directory = directory;
+	return manager;
+}
+
+void hostCloseAssetManager(AAssetManager* manager) {
+	delete manager;
+}
+
+AAsset* AAssetManager_open(AAssetManager* manager,const char* fileName,int mode) {
+	FILE* file = fopen((manager->directory + "/" + fileName).c_str(),"rb");
+	if(!file)
+		return NULL;
+	AAsset* asset = new AAsset;
+	asset->file = file;
+	fseek(file,0,SEEK_END);
+	asset->length = ftell(file);
+	fseek(file,0,SEEK_SET);
+	return asset;
+}
+
+off_t AAsset_getLength(AAsset* asset) {
+	return asset->length;
+}
+
+int AAsset_read(AAsset* asset,void* buffer,size_t count) {
+	return fread(buffer,1,count,asset->file);
+}
+
+void AAsset_close(AAsset* asset) {
+	fclose(asset->file);
+	delete asset;
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+// Context
+
+struct Context {
+	EGLDisplay display;
+	EGLSurface surface;
+	EGLContext context;
+};
+
+static EGLDisplay openDisplay() {
+	EGLDisplay display = eglGetDisplay(EGL_DEFAULT_DISPLAY);
+	if(display != EGL_NO_DISPLAY && eglInitialize(display,NULL,NULL))
+		return display;
+	// no window system: Mesa renders without one
+	const char* extensions = eglQueryString(EGL_NO_DISPLAY,EGL_EXTENSIONS);
+	PFNEGLGETPLATFORMDISPLAYEXTPROC getPlatformDisplay =
+			(PFNEGLGETPLATFORMDISPLAYEXTPROC)eglGetProcAddress("eglGetPlatformDisplayEXT");
+	if(!extensions || !strstr(extensions,"EGL_MESA_platform_surfaceless") || !getPlatformDisplay)
+		return EGL_NO_DISPLAY;
+	display = getPlatformDisplay(EGL_PLATFORM_SURFACELESS_MESA,EGL_DEFAULT_DISPLAY,NULL);
+	if(display == EGL_NO_DISPLAY || !eglInitialize(display,NULL,NULL))
+		return EGL_NO_DISPLAY;
+	return display;
+}
+
+static bool createContext(Context& ctx) {
+	const EGLint configAttribs[] = {
+			EGL_SURFACE_TYPE, EGL_PBUFFER_BIT,
+			EGL_RENDERABLE_TYPE, EGL_OPENGL_ES2_BIT,
+			EGL_RED_SIZE, 8, EGL_GREEN_SIZE, 8, EGL_BLUE_SIZE, 8,
+			EGL_NONE };
+	const EGLint surfaceAttribs[] = { EGL_WIDTH, SURFACE_SIZE, EGL_HEIGHT, SURFACE_SIZE, EGL_NONE };
+	const EGLint contextAttribs[] = { EGL_CONTEXT_CLIENT_VERSION, 2, EGL_NONE };
+	EGLConfig config;
+	EGLint count = 0;
+	if(!eglChooseConfig(ctx.display,configAttribs,&config,1,&count) || !count) {
+		fprintf(stderr,"headless: no GLES2 pbuffer config\n");
+		return false;
+	}
+	eglBindAPI(EGL_OPENGL_ES_API);
+	ctx.surface = eglCreatePbufferSurface(ctx.display,config,surfaceAttribs);
+	ctx.context = eglCreateContext(ctx.display,config,EGL_NO_CONTEXT,contextAttribs);
+	if(ctx.surface == EGL_NO_SURFACE || ctx.context == EGL_NO_CONTEXT ||
+			!eglMakeCurrent(ctx.display,ctx.surface,ctx.surface,ctx.context)) {
+		fprintf(stderr,"headless: cannot create the context (0x%x)\n",eglGetError());
+		return false;
+	}
+	return true;
+}
+
+static void destroyContext(Context& ctx) {
+	eglMakeCurrent(ctx.display,EGL_NO_SURFACE,EGL_NO_SURFACE,EGL_NO_CONTEXT);
+	if(ctx.context != EGL_NO_CONTEXT)
+		eglDestroyContext(ctx.display,ctx.context);
+	if(ctx.surface != EGL_NO_SURFACE)
+		eglDestroySurface(ctx.display,ctx.surface);
+	eglTerminate(ctx.display);
+}
+
+///////////////////////////////////////////////////////////////////////////////////////////////////
+
+static void usage() {
+	fprintf(stderr,"usage: headless [-a assets] quality|dynamic-resolution\n");
+}
+
+int main(int argc,char** argv) {
+	const char* assets = "assets";
+	const char* command = NULL;
+	for(int i=1;i<argc;i++) {
+		if(!strcmp(argv[i],"-a") && i + 1 < argc)
+			assets = argv[++i];
+		else if(argv[i][0] != '-' && !command)
+			command = argv[i];
+		else {
+			usage();
+			return 2;
+		}
+	}
+	if(!command || (strcmp(command,"quality") && strcmp(command,"dynamic-resolution"))) {
+		usage();
+		return 2;
+	}
+
+	AAssetManager* manager = hostOpenAssetManager(assets);
+	if(!manager) {
+		fprintf(stderr,"headless: no shaders under %s\n",assets);
+		return 2;
+	}
+	SetAssetManager(manager);
+	// the log lines interleave with the GL driver's own output in order
+	logSetSynchronous(true);
+
+	Context ctx;
+	ctx.display = openDisplay();
+	ctx.surface = EGL_NO_SURFACE;
+	ctx.context = EGL_NO_CONTEXT;
+	if(ctx.display == EGL_NO_DISPLAY) {
+		fprintf(stderr,"headless: no EGL display\n");
+		return 2;
+	}
+	if(!createContext(ctx))
+		return 2;
+	printf("renderer: %s, %s\n",glGetString(GL_RENDERER),glGetString(GL_VERSION));
+
+	Scene* scene = new Scene(SURFACE_SIZE,SURFACE_SIZE);
+	bool passed = true;
+	if(!strcmp(command,"quality"))
+		passed = runQualityCheck(scene);
+	else
+		benchmarkDynamicResolution(scene);
+	delete scene;
+	destroyContext(ctx);
+	logShutdown();
+	hostCloseAssetManager(manager);
+	if(strcmp(command,"quality"))
+		printf("%s: done\n",command);
+	else
+		printf("%s: %s\n",command,passed ? "passed" : "FAILED");
+	return passed ? 0 : 1;
+}